@@ -3,6 +3,7 @@ include(CheckIncludeFile)
 
 check_include_file( malloc.h    HAVE_MALLOC_H   )
 check_include_file( stat.h      HAVE_STAT_H     )
+check_include_file( sys/mman.h  HAVE_SYS_MMAN_H )
 check_include_file( sys/stat.h  HAVE_SYS_STAT_H )
 check_include_file( unistd.h    HAVE_UNISTD_H   )
 
@@ -13,11 +14,17 @@ check_function_exists( drand48     HAVE_DRAND48    )
 check_function_exists( cbrt        HAVE_CBRT       )
 check_function_exists( getpagesize HAVE_GETPAGESIZE)
 check_function_exists( mallinfo    HAVE_MALLINFO   )
+check_function_exists( malloc_usable_size HAVE_MALLOC_USABLE_SIZE )
 check_function_exists( mallopt     HAVE_MALLOPT    )
 check_function_exists( mstats      HAVE_MSTATS     )
 check_function_exists( srand48     HAVE_SRAND48    )
 check_function_exists( strcasecmp  HAVE_STRCASECMP )
 
+# Library checks
+if (CMAKE_USE_PTHREADS_INIT)
+    set(HAVE_PTHREAD 1)
+endif (CMAKE_USE_PTHREADS_INIT)
+
 # Type checks
 # The function check_size_type also checks if the type exists
 # and sets HAVE_${VARIABLE} accordingly.
@@ -29,6 +29,7 @@ __declspec(dllimport) int GvExitOnUsage;
 #endif
 
 #include <stdlib.h>
+#include <signal.h>
 #include <time.h>
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
@@ -38,9 +39,24 @@ static GVC_t *Gvc;
 static graph_t * G;
 
 #ifndef _WIN32
+static volatile sig_atomic_t InLayout, Interrupted;
+
+/* cancelled:
+ * Polled by layouts: stop refining once interrupted.
+ */
+static int cancelled(void *data)
+{
+    return Interrupted;
+}
+
 static void intr(int s)
 {
-/* if interrupted we try to produce a partial rendering before exiting */
+/* if first interrupted during a layout, let it finish early with what it
+ * has; otherwise we try to produce a partial rendering before exiting */
+    if (InLayout && !Interrupted) {
+	Interrupted = 1;
+	return;
+    }
     if (G)
 	gvRenderJobs(Gvc, G);
 /* Note that we don't call gvFinalize() so that we don't start event-driven
@@ -92,6 +108,20 @@ static graph_t *create_test_graph(void)
     return g;
 }
 
+/* layout:
+ * Lay out g with the engine from the command line.
+ */
+static void layout(graph_t * g)
+{
+#ifndef _WIN32
+    InLayout = 1;
+#endif
+    gvLayoutJobs(Gvc, g);
+#ifndef _WIN32
+    InLayout = 0;
+#endif
+}
+
 int main(int argc, char **argv)
 {
     graph_t *prev = NULL;
@@ -103,6 +133,7 @@ int main(int argc, char **argv)
 #ifndef _WIN32
     signal(SIGUSR1, gvToggle);
     signal(SIGINT, intr);
+    gvSetLayoutCancel(Gvc, cancelled, NULL);
 #ifndef NO_FPERR
     signal(SIGFPE, fperr);
 #endif
@@ -120,7 +151,7 @@ int main(int argc, char **argv)
 	}
     }
     else if ((G = gvPluginsGraph(Gvc))) {
-	    gvLayoutJobs(Gvc, G);  /* take layout engine from command line */
+	    layout(G);
 	    gvRenderJobs(Gvc, G);
     }
     else {
@@ -129,12 +160,17 @@ int main(int argc, char **argv)
 		gvFreeLayout(Gvc, prev);
 		agclose(prev);
 	    }
-	    gvLayoutJobs(Gvc, G);  /* take layout engine from command line */
+	    layout(G);
 	    gvRenderJobs(Gvc, G);
             gvFinalize(Gvc);
 	    r = agreseterrors();
 	    rc = MAX(rc,r);
 	    prev = G;
+#ifndef _WIN32
+	    /* as before, an interrupt ends the run after the current graph */
+	    if (Interrupted)
+		break;
+#endif
 	}
     }
     r = gvFreeContext(Gvc);
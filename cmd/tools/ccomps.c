@@ -900,6 +900,7 @@ int main(int argc, char *argv[])
     int r = 0;
     init(argc, argv);
     newIngraph(&ig, Files, gread);
+    ingPrefetch(&ig, 8, agclose);
 
     while ((g = nextGraph(&ig)) != 0) {
 	r += process(g, chkGraphName(g));
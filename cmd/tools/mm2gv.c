@@ -222,7 +222,6 @@ static Agraph_t *makeDotGraph(SparseMatrix A, char *name, int dim,
 {
     Agraph_t *g;
     Agnode_t *n;
-    Agnode_t *h;
     Agedge_t *e;
     int i, j;
     agxbuf xb;
@@ -233,6 +232,9 @@ static Agraph_t *makeDotGraph(SparseMatrix A, char *name, int dim,
     int *ja = A->ja;
     real *val = (real *) (A->a);
     Agnode_t **arr = N_NEW(A->m, Agnode_t *);
+    char **names, *namebuf;
+    Agnode_t **tails, **heads;
+    Agedge_t **edges;
     real *color = NULL;
     char cstring[8];
 
@@ -271,13 +273,20 @@ static Agraph_t *makeDotGraph(SparseMatrix A, char *name, int dim,
 	agattr(g, AGRAPH, "label", agxbuse (&xb));
     }
 
+    names = N_NEW(A->m, char *);
+    namebuf = N_NEW(A->m * 12, char);
     for (i = 0; i < A->m; i++) {
-	sprintf(buf, "%d", i);
-	n = agnode(g, buf, 1);
+	names[i] = namebuf + i * 12;
+	sprintf(names[i], "%d", i);
+    }
+    agnodes_bulk(g, A->m, names, arr);
+    for (i = 0; i < A->m; i++) {
+	n = arr[i];
 	agbindrec(n, "nodeinfo", sizeof(Agnodeinfo_t), TRUE);
 	ND_id(n) = i;
-	arr[i] = n;
     }
+    FREE(names);
+    FREE(namebuf);
 
     if (with_color) {
 	real maxdist = 0.;
@@ -329,12 +338,20 @@ static Agraph_t *makeDotGraph(SparseMatrix A, char *name, int dim,
 	}
     }
 
-    i = 0;
-    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
-	i = ND_id(n);
+    tails = N_NEW(ia[A->m], Agnode_t *);
+    heads = N_NEW(ia[A->m], Agnode_t *);
+    edges = N_NEW(ia[A->m], Agedge_t *);
+    for (i = 0; i < A->m; i++) {
+	for (j = ia[i]; j < ia[i + 1]; j++) {
+	    tails[j] = arr[i];
+	    heads[j] = arr[ja[j]];
+	}
+    }
+    agedges_bulk(g, ia[A->m], tails, heads, NULL, edges);
+
+    for (i = 0; i < A->m; i++) {
 	for (j = ia[i]; j < ia[i + 1]; j++) {
-	    h = arr[ja[j]];
-	    e = agedge(g, n, h, NULL, 1);
+	    e = edges[j];
 	    if (with_val && val) {
 		sprintf(buf, "%f", val[j]);
 		agxset(e, sym, buf);
@@ -350,6 +367,9 @@ static Agraph_t *makeDotGraph(SparseMatrix A, char *name, int dim,
     agxbfree (&xb);
     FREE(color);
     FREE(arr);
+    FREE(tails);
+    FREE(heads);
+    FREE(edges);
     return g;
 }
 
@@ -138,6 +138,7 @@ int main(int argc, char **argv)
 
     init(argc, argv);
     newIngraph(&ig, Files, gread);
+    ingPrefetch(&ig, 8, agclose);
 
     while ((g = nextGraph(&ig)) != 0) {
 	if (agisdirected(g))
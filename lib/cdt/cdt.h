@@ -71,6 +71,7 @@ struct _dtdata_s
 	int		loop;	/* number of nested loops		*/
 	int		minp;	/* min path before splay, always even	*/
 				/* for hash dt, > 0: fixed table size 	*/
+	int		ndel;	/* deleted slots in an open hash table	*/
 };
 
 /* structure to hold methods that manipulate an object */
@@ -127,7 +128,8 @@ struct _dtstat_s
 #define DT_STACK	0000040	/* stack: insert/delete at top		*/
 #define DT_QUEUE	0000100	/* queue: insert at top, delete at tail	*/
 #define DT_DEQUE	0000200 /* deque: insert at top, append at tail	*/
-#define DT_METHODS	0000377	/* all currently supported methods	*/
+#define DT_OAHASH	0000400	/* set in an open addressing hash table	*/
+#define DT_METHODS	0000777	/* all currently supported methods	*/
 
 /* asserts to dtdisc() */
 #define DT_SAMECMP	0000001	/* compare methods equivalent		*/
@@ -174,6 +176,7 @@ extern Dtmethod_t*	Dtlist;
 extern Dtmethod_t*	Dtstack;
 extern Dtmethod_t*	Dtqueue;
 extern Dtmethod_t*	Dtdeque;
+extern Dtmethod_t*	Dtoahash;
 
 /* compatibility stuff; will go away */
 #ifndef KPVDEL
@@ -213,6 +216,7 @@ extern void*		dtrenew(Dt_t*, void*);
 extern int		dtsize(Dt_t*);
 extern int		dtstat(Dt_t*, Dtstat_t*, int);
 extern unsigned int	dtstrhash(unsigned int, void*, int);
+extern unsigned int	dtwordhash(unsigned int, void*, int);
 
 #undef extern
 
@@ -54,7 +54,7 @@ Dtdisc_t* dtdisc(Dt_t* dt, Dtdisc_t* disc, int type)
 			goto done;
 		else	goto dt_renew;
 	}
-	else if(dt->data->type&(DT_SET|DT_BAG))
+	else if(dt->data->type&(DT_SET|DT_BAG|DT_OAHASH))
 	{	if((type&DT_SAMEHASH) && (type&DT_SAMECMP))
 			goto done;
 		else	goto dt_renew;
@@ -68,7 +68,12 @@ Dtdisc_t* dtdisc(Dt_t* dt, Dtdisc_t* disc, int type)
 		dt->data->here = NIL(Dtlink_t*);
 		dt->data->size = 0;
 
-		if(dt->data->type&(DT_SET|DT_BAG))
+		if(dt->data->type&DT_OAHASH)
+		{	memset(dt->data->htab, 0,
+				dt->data->ntab*(sizeof(Dtlink_t*)+1));
+			dt->data->ndel = 0;
+		}
+		else if(dt->data->type&(DT_SET|DT_BAG))
 		{	reg Dtlink_t	**s, **ends;
 			ends = (s = dt->data->htab) + dt->data->ntab;
 			while(s < ends)
@@ -81,7 +86,7 @@ Dtdisc_t* dtdisc(Dt_t* dt, Dtdisc_t* disc, int type)
 			if(!(type&DT_SAMEHASH))	/* new hash value */
 			{	k = (char*)_DTOBJ(r,disc->link);
 				k = _DTKEY((void*)k,disc->key,disc->size);
-				r->hash = _DTHSH(dt,k,disc,disc->size);
+				r->hash = DTHSH(dt,k,disc,disc->size);
 			}
 			(void)(*searchf)(dt,(void*)r,DT_RENEW);
 			r = t;
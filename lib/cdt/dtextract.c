@@ -11,6 +11,11 @@ Dtlink_t* dtextract(reg Dt_t* dt)
 
 	if(dt->data->type&(DT_OSET|DT_OBAG) )
 		list = dt->data->here;
+	else if(dt->data->type&DT_OAHASH)
+	{	list = dtflatten(dt);
+		memset(dt->data->htab, 0, dt->data->ntab*(sizeof(Dtlink_t*)+1));
+		dt->data->ndel = 0;
+	}
 	else if(dt->data->type&(DT_SET|DT_BAG))
 	{	list = dtflatten(dt);
 		for(ends = (s = dt->data->htab) + dt->data->ntab; s < ends; ++s)
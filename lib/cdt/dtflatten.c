@@ -15,7 +15,24 @@ Dtlink_t* dtflatten(Dt_t* dt)
 		return dt->data->here;
 
 	list = last = NIL(Dtlink_t*);
-	if(dt->data->type&(DT_SET|DT_BAG))
+	if(dt->data->type&DT_OAHASH)
+	{	/* the table is left as it is */
+		reg unsigned char	*tg;
+		reg int		i;
+
+		tg = dt->data->ntab > 0 ? OATAGS(dt->data) : NIL(unsigned char*);
+		for(i = 0; i < dt->data->ntab; ++i)
+		{	if(tg[i] > OA_DEL)
+			{	t = dt->data->htab[i];
+				if(last)
+					last = last->right = t;
+				else	list = last = t;
+			}
+		}
+		if(last)
+			last->right = NIL(Dtlink_t*);
+	}
+	else if(dt->data->type&(DT_SET|DT_BAG))
 	{	for(ends = (s = dt->data->htab) + dt->data->ntab; s < ends; ++s)
 		{	if((t = *s) )
 			{	if(last)
@@ -38,6 +38,19 @@
 #define HLOAD(s)	((s) << 1)
 #define HINDEX(n,h)	((h)&((n)-1))
 
+/* open hash tables: ntab links followed by ntab tag bytes */
+#define OASLOT		(16)
+#define OALOAD(n)	((n) - ((n) >> 2))
+#define OATAGS(d)	((unsigned char*)((d)->htab + (d)->ntab))
+#define OA_EMPTY	0
+#define OA_DEL		1
+#define OATAG(h)	((unsigned char)(0x80 | ((h) >> 25)))
+
+/* hash of a key for the dictionary's method */
+#define DTHSH(dt,ky,dc,sz) \
+		(((dt)->data->type&DT_OAHASH) && !(dc)->hashf ? \
+		 dtwordhash(0,ky,sz) : _DTHSH(dt,ky,dc,sz) )
+
 #define UNFLATTEN(dt) \
 		((dt->data->type&DT_FLATTEN) ? dtrestore(dt,NIL(Dtlink_t*)) : 0)
 
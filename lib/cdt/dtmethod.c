@@ -25,10 +25,11 @@ Dtmethod_t* dtmethod(Dt_t* dt, Dtmethod_t* meth)
 
 	if(dt->data->type&(DT_LIST|DT_STACK|DT_QUEUE) )
 		dt->data->head = NIL(Dtlink_t*);
-	else if(dt->data->type&(DT_SET|DT_BAG) )
+	else if(dt->data->type&(DT_SET|DT_BAG|DT_OAHASH) )
 	{	if(dt->data->ntab > 0)
 			(*dt->memoryf)(dt,(void*)dt->data->htab,0,disc);
 		dt->data->ntab = 0;
+		dt->data->ndel = 0;
 		dt->data->htab = NIL(Dtlink_t**);
 	}
 
@@ -61,6 +62,8 @@ Dtmethod_t* dtmethod(Dt_t* dt, Dtmethod_t* meth)
 	{	int	rehash;
 		if((meth->type&(DT_SET|DT_BAG)) && !(oldmeth->type&(DT_SET|DT_BAG)))
 			rehash = 1;
+		else if((meth->type^oldmeth->type)&DT_OAHASH)
+			rehash = 1; /* it may hash strings differently */
 		else	rehash = 0;
 
 		dt->data->size = dt->data->loop = 0;
@@ -69,7 +72,7 @@ Dtmethod_t* dtmethod(Dt_t* dt, Dtmethod_t* meth)
 			if(rehash)
 			{	reg void* key = _DTOBJ(list,disc->link);
 				key = _DTKEY(key,disc->key,disc->size);
-				list->hash = _DTHSH(dt,key,disc,disc->size);
+				list->hash = DTHSH(dt,key,disc,disc->size);
 			}
 			(void)(*meth->searchf)(dt,(void*)list,DT_RENEW);
 			list = r;
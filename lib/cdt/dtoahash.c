@@ -0,0 +1,339 @@
+#include	"dthdr.h"
+
+/*	Hash table with open addressing.
+**	The table is an array of links followed by an array of tag bytes,
+**	one per slot. A tag is empty, deleted, or a few bits of the hash of
+**	the object in the slot, so that a probe sequence is mostly a scan
+**	of the tags and objects are only compared when their tags match.
+**	Collisions are resolved by linear probing; deleted slots are reused
+**	by insertions and cleared when the table is rebuilt.
+**
+**	dt:	dictionary
+**	obj:	what to look for
+**	type:	type of search
+*/
+
+/* oaslot: find the slot holding a key, or -1.
+** The first free slot on the way is returned in *ins if ins is given.
+*/
+static int oaslot(Dt_t* dt, void* key, uint hsh, int* ins)
+{
+	reg Dtlink_t	**s;
+	reg unsigned char	*tg, tag;
+	reg int		i, n, lk, sz, ky;
+	reg void	*k;
+	reg Dtcompar_f	cmpf;
+	reg Dtdisc_t*	disc;
+
+	if(ins)
+		*ins = -1;
+	if((n = dt->data->ntab) <= 0)
+		return -1;
+
+	disc = dt->disc; _DTDSC(disc,ky,sz,lk,cmpf);
+	s = dt->data->htab;
+	tg = OATAGS(dt->data);
+	tag = OATAG(hsh);
+	for(i = HINDEX(n,hsh);; i = HINDEX(n,i+1))
+	{	if(tg[i] == tag)
+		{	if(s[i]->hash == hsh)
+			{	k = _DTOBJ(s[i],lk); k = _DTKEY(k,ky,sz);
+				if(_DTCMP(dt,key,k,disc,cmpf,sz) == 0)
+					return i;
+			}
+		}
+		else if(tg[i] == OA_DEL)
+		{	if(ins && *ins < 0)
+				*ins = i;
+		}
+		else if(tg[i] == OA_EMPTY)
+		{	if(ins && *ins < 0)
+				*ins = i;
+			return -1;
+		}
+	}
+}
+
+/* oalink: find the slot holding a given link, or -1 */
+static int oalink(Dtdata_t* data, Dtlink_t* t)
+{
+	reg int		i, n;
+	reg unsigned char	*tg;
+
+	if((n = data->ntab) <= 0)
+		return -1;
+	tg = OATAGS(data);
+	for(i = HINDEX(n,t->hash); tg[i] != OA_EMPTY; i = HINDEX(n,i+1))
+		if(data->htab[i] == t)
+			return i;
+	return -1;
+}
+
+/* oaput: put a link in the first free slot of its probe sequence */
+static void oaput(Dtdata_t* data, Dtlink_t* t)
+{
+	reg int		i, n = data->ntab;
+	reg unsigned char	*tg = OATAGS(data);
+
+	for(i = HINDEX(n,t->hash); tg[i] > OA_DEL; i = HINDEX(n,i+1))
+		;
+	if(tg[i] == OA_DEL)
+		data->ndel -= 1;
+	data->htab[i] = t;
+	tg[i] = OATAG(t->hash);
+}
+
+/* rebuild the table, dropping deleted slots and making room to grow */
+static int dtoatab(Dt_t* dt)
+{
+	reg Dtlink_t	**s, **olds;
+	reg unsigned char	*oldtg;
+	reg int		i, n, oldn;
+	int		k;
+
+	/* a rebuilt table is at most half full */
+	if((oldn = dt->data->ntab) == 0)
+	{	n = OASLOT; k = 0;
+		if(dt->disc->eventf &&
+		   (*dt->disc->eventf)(dt, DT_HASHSIZE, &k, dt->disc) > 0 && k > 0)
+		{	while(n < k)
+				n = HRESIZE(n);
+		}
+	}
+	else	n = oldn;
+	while(dt->data->size + 1 > n/2)
+		n = HRESIZE(n);
+
+	if(!(s = (Dtlink_t**)(*dt->memoryf)
+		(dt,NIL(void*),n*(sizeof(Dtlink_t*)+1),dt->disc)) )
+		return -1;
+	memset(s, 0, n*(sizeof(Dtlink_t*)+1));
+
+	olds = dt->data->htab;
+	oldtg = oldn > 0 ? OATAGS(dt->data) : NIL(unsigned char*);
+	dt->data->htab = s;
+	dt->data->ntab = n;
+	dt->data->ndel = 0;
+	for(i = 0; i < oldn; ++i)
+		if(oldtg[i] > OA_DEL)
+			oaput(dt->data,olds[i]);
+	if(oldn > 0)
+		(*dt->memoryf)(dt,(void*)olds,0,dt->disc);
+	return 0;
+}
+
+static void* dtoahash(Dt_t* dt, reg void* obj, int type)
+{
+	reg Dtlink_t	*t, *r, **s;
+	reg unsigned char	*tg;
+	reg void	*key;
+	reg uint	hsh = 0;
+	reg int		i, n, lk, sz, ky;
+	int		j;
+	reg Dtdisc_t*	disc;
+
+	UNFLATTEN(dt);
+
+	/* initialize discipline data */
+	disc = dt->disc;
+	ky = disc->key; sz = disc->size; lk = disc->link;
+	dt->type &= ~DT_FOUND;
+	s = dt->data->htab;
+	n = dt->data->ntab;
+	tg = n > 0 ? OATAGS(dt->data) : NIL(unsigned char*);
+
+	if(!obj)
+	{	if(type&(DT_NEXT|DT_PREV))
+			goto end_walk;
+
+		if(dt->data->size <= 0 || !(type&(DT_CLEAR|DT_FIRST|DT_LAST)) )
+			return NIL(void*);
+
+		if(type&DT_CLEAR)
+		{	/* clean out all objects */
+			for(i = 0; i < n; ++i)
+			{	if(tg[i] > OA_DEL)
+				{	t = s[i];
+					if(disc->freef)
+						(*disc->freef)(dt,_DTOBJ(t,lk),disc);
+					if(disc->link < 0)
+						(*dt->memoryf)(dt,(void*)t,0,disc);
+				}
+			}
+			memset(s, 0, n*(sizeof(Dtlink_t*)+1));
+			dt->data->here = NIL(Dtlink_t*);
+			dt->data->size = 0;
+			dt->data->ndel = 0;
+			dt->data->loop = 0;
+			return NIL(void*);
+		}
+		else	/* computing the first/last object */
+		{	if(type&DT_LAST)
+			{	for(i = n-1; i >= 0; --i)
+					if(tg[i] > OA_DEL)
+						break;
+			}
+			else
+			{	for(i = 0; i < n; ++i)
+					if(tg[i] > OA_DEL)
+						break;
+			}
+			t = (i >= 0 && i < n) ? s[i] : NIL(Dtlink_t*);
+
+			dt->data->loop += 1;
+			dt->data->here = t;
+			return t ? _DTOBJ(t,lk) : NIL(void*);
+		}
+	}
+
+	r = NIL(Dtlink_t*);
+	if(type&(DT_MATCH|DT_SEARCH|DT_INSERT|DT_ATTACH) )
+	{	key = (type&DT_MATCH) ? obj : _DTKEY(obj,ky,sz);
+		hsh = DTHSH(dt,key,disc,sz);
+		i = oaslot(dt,key,hsh,&j);
+	}
+	else if(type&(DT_RENEW|DT_VSEARCH) )
+	{	r = (Dtlink_t*)obj;
+		obj = _DTOBJ(r,lk);
+		key = _DTKEY(obj,ky,sz);
+		hsh = r->hash;
+		i = oaslot(dt,key,hsh,&j);
+	}
+	else /*if(type&(DT_DELETE|DT_DETACH|DT_NEXT|DT_PREV))*/
+	{	if((t = dt->data->here) && _DTOBJ(t,lk) == obj)
+			i = oalink(dt->data,t);
+		else
+		{	key = _DTKEY(obj,ky,sz);
+			hsh = DTHSH(dt,key,disc,sz);
+			i = oaslot(dt,key,hsh,NIL(int*));
+		}
+	}
+
+	t = i >= 0 ? s[i] : NIL(Dtlink_t*);
+	if(t) /* found matching object */
+		dt->type |= DT_FOUND;
+
+	if(type&(DT_MATCH|DT_SEARCH|DT_VSEARCH))
+	{	if(!t)
+			return NIL(void*);
+		dt->data->here = t;
+		return _DTOBJ(t,lk);
+	}
+	else if(type&(DT_INSERT|DT_ATTACH))
+	{	if(t)
+		{	dt->data->here = t;
+			return _DTOBJ(t,lk);
+		}
+
+		if(disc->makef && (type&DT_INSERT) &&
+		   !(obj = (*disc->makef)(dt,obj,disc)) )
+			return NIL(void*);
+		if(lk >= 0)
+			r = _DTLNK(obj,lk);
+		else
+		{	r = (Dtlink_t*)(*dt->memoryf)
+				(dt,NIL(void*),sizeof(Dthold_t),disc);
+			if(r)
+				((Dthold_t*)r)->obj = obj;
+			else
+			{	if(disc->makef && disc->freef && (type&DT_INSERT))
+					(*disc->freef)(dt,obj,disc);
+				return NIL(void*);
+			}
+		}
+		r->hash = hsh;
+
+		/* insert object */
+	do_insert:
+		if(j < 0 || (tg[j] == OA_EMPTY &&
+		   dt->data->size + dt->data->ndel + 1 > OALOAD(n)) )
+		{	if(dtoatab(dt) < 0)
+			{	if(disc->freef && (type&DT_INSERT))
+					(*disc->freef)(dt,obj,disc);
+				if(disc->link < 0)
+					(*dt->memoryf)(dt,(void*)r,0,disc);
+				return NIL(void*);
+			}
+			oaput(dt->data,r);
+		}
+		else
+		{	if(tg[j] == OA_DEL)
+				dt->data->ndel -= 1;
+			s[j] = r;
+			tg[j] = OATAG(r->hash);
+		}
+		dt->data->size += 1;
+		dt->data->here = r;
+		return obj;
+	}
+	else if(type&DT_NEXT)
+	{	t = NIL(Dtlink_t*);
+		if(i >= 0)
+		{	for(i += 1; i < n; ++i)
+				if(tg[i] > OA_DEL)
+				{	t = s[i];
+					break;
+				}
+		}
+		goto done_adj;
+	}
+	else if(type&DT_PREV)
+	{	t = NIL(Dtlink_t*);
+		if(i >= 0)
+		{	for(i -= 1; i >= 0; --i)
+				if(tg[i] > OA_DEL)
+				{	t = s[i];
+					break;
+				}
+		}
+	done_adj:
+		if(!(dt->data->here = t) )
+		{ end_walk:
+			if((dt->data->loop -= 1) < 0)
+				dt->data->loop = 0;
+			return NIL(void*);
+		}
+		else
+		{	dt->data->type |= DT_WALK;
+			return _DTOBJ(t,lk);
+		}
+	}
+	else if(type&DT_RENEW)
+	{	if(!t)
+			goto do_insert;
+		else
+		{	if(disc->freef)
+				(*disc->freef)(dt,obj,disc);
+			if(disc->link < 0)
+				(*dt->memoryf)(dt,(void*)r,0,disc);
+			return _DTOBJ(t,lk);
+		}
+	}
+	else /*if(type&(DT_DELETE|DT_DETACH))*/
+	{	/* take an element out of the dictionary */
+		if(!t)
+			return NIL(void*);
+		if(tg[HINDEX(n,i+1)] == OA_EMPTY)
+			tg[i] = OA_EMPTY;	/* ends a probe sequence */
+		else
+		{	tg[i] = OA_DEL;
+			dt->data->ndel += 1;
+		}
+		s[i] = NIL(Dtlink_t*);
+		obj = _DTOBJ(t,lk);
+		dt->data->size -= 1;
+		dt->data->here = NIL(Dtlink_t*);
+		if(disc->freef && (type&DT_DELETE))
+			(*disc->freef)(dt,obj,disc);
+		if(disc->link < 0)
+			(*dt->memoryf)(dt,(void*)t,0,disc);
+		return obj;
+	}
+}
+
+static Dtmethod_t	_Dtoahash = { dtoahash, DT_OAHASH };
+Dtmethod_t* Dtoahash = &_Dtoahash;
+
+#ifdef NoF
+NoF(dtoahash)
+#endif
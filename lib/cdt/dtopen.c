@@ -69,6 +69,7 @@ Dt_t* dtopen(Dtdisc_t* disc, Dtmethod_t* meth)
 	data->htab = NIL(Dtlink_t**);
 	data->ntab = data->size = data->loop = 0;
 	data->minp = 0;
+	data->ndel = 0;
 
 done:
 	dt->data = data;
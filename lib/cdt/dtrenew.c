@@ -33,6 +33,19 @@ void* dtrenew(Dt_t* dt, reg void* obj)
 			}
 		}
 	}
+	else if(dt->data->type&DT_OAHASH)
+	{	reg int	i, n = dt->data->ntab;
+		reg unsigned char	*tg = OATAGS(dt->data);
+
+		for(i = HINDEX(n,e->hash); dt->data->htab[i] != e; i = HINDEX(n,i+1))
+			;
+		dt->data->htab[i] = NIL(Dtlink_t*);
+		tg[i] = OA_DEL;
+		dt->data->ndel += 1;
+		key = _DTKEY(obj,disc->key,disc->size);
+		e->hash = DTHSH(dt,key,disc,disc->size);
+		dt->data->here = NIL(Dtlink_t*);
+	}
 	else /*if(dt->data->type&(DT_SET|DT_BAG))*/
 	{	s = dt->data->htab + HINDEX(dt->data->ntab,e->hash);
 		if((t = *s) == e)
@@ -26,9 +26,11 @@ int dtrestore(reg Dt_t* dt, reg Dtlink_t* list)
 	}
 	dt->data->type &= ~DT_FLATTEN;
 
-	if(dt->data->type&(DT_SET|DT_BAG))
+	if(dt->data->type&(DT_SET|DT_BAG|DT_OAHASH))
 	{	dt->data->here = NIL(Dtlink_t*);
-		if(type) /* restoring a flattened dictionary */
+		if(type && (dt->data->type&DT_OAHASH))
+			; /* flattening left the table as it was */
+		else if(type) /* restoring a flattened dictionary */
 		{	for(ends = (s = dt->data->htab) + dt->data->ntab; s < ends; ++s)
 			{	if((t = *s) )
 				{	*s = list;
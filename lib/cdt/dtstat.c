@@ -36,6 +36,25 @@ static void dthstat(reg Dtdata_t* data, Dtstat_t* ds, reg int* count)
 	}
 }
 
+/* for open hash tables, count objects by the length of their probe */
+static void dtostat(reg Dtdata_t* data, Dtstat_t* ds, reg int* count)
+{
+	reg unsigned char*	tg = OATAGS(data);
+	reg int		h, n, k;
+
+	for(h = data->ntab-1; h >= 0; --h)
+	{	if(tg[h] <= OA_DEL)
+			continue;
+		k = HINDEX(data->ntab,data->htab[h]->hash);
+		n = HINDEX(data->ntab,h - k) + 1;
+		if(count)
+			count[n] += 1;
+		else if(n > ds->dt_max)
+			ds->dt_max = n;
+	}
+	ds->dt_n = ds->dt_max;
+}
+
 int dtstat(reg Dt_t* dt, Dtstat_t* ds, int all)
 {
 	reg int		i;
@@ -51,7 +70,22 @@ int dtstat(reg Dt_t* dt, Dtstat_t* ds, int all)
 	if(!all)
 		return 0;
 
-	if(dt->data->type&(DT_SET|DT_BAG))
+	if(dt->data->type&DT_OAHASH)
+	{	if(dt->data->ntab > 0)
+			dtostat(dt->data,ds,NIL(int*));
+		if(ds->dt_max+1 > Size)
+		{	if(Size > 0)
+				free(Count);
+			if(!(Count = (int*)malloc((ds->dt_max+1)*sizeof(int))) )
+				return -1;
+			Size = ds->dt_max+1;
+		}
+		for(i = ds->dt_max; i >= 0; --i)
+			Count[i] = 0;
+		if(dt->data->ntab > 0)
+			dtostat(dt->data,ds,Count);
+	}
+	else if(dt->data->type&(DT_SET|DT_BAG))
 	{	dthstat(dt->data,ds,NIL(int*));
 		if(ds->dt_max+1 > Size)
 		{	if(Size > 0)
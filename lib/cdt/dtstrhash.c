@@ -31,3 +31,37 @@ uint dtstrhash(reg uint h, void* args, reg int n)
 	}
 	return (h+n)*DT_PRIME;
 }
+
+/* Hashing a string a machine word at a time.
+** Each 8-byte word of the string is mixed into a 64-bit accumulator
+** with one multiplication, and the accumulator is folded to an
+** unsigned int at the end. If n <= 0, the string is null-terminated.
+** Words are loaded in native byte order, so the values, though not the
+** quality, of the hash depend on the machine. This is the default hash
+** of Dtoahash.
+*/
+#define WH_MUL	0x9E3779B97F4A7C15ULL
+
+uint dtwordhash(uint h, void* args, int n)
+{
+	reg unsigned char*	s = (unsigned char*)args;
+	reg unsigned long long	a;
+	unsigned long long	w;
+	reg size_t		len, i;
+
+	len = n <= 0 ? strlen((char*)s) : (size_t)n;
+	a = (unsigned long long)h ^ (len * WH_MUL);
+	for(i = len; i >= 8; i -= 8, s += 8)
+	{	memcpy(&w, s, 8);
+		a = (a ^ w) * WH_MUL;
+		a ^= a >> 29;
+	}
+	if(i > 0)
+	{	w = 0;
+		memcpy(&w, s, i);
+		a = (a ^ w) * WH_MUL;
+		a ^= a >> 29;
+	}
+	a *= WH_MUL;
+	return (uint)(a ^ (a >> 32));
+}
@@ -15,14 +15,23 @@
 #include <cghdr.h>
 
 #define MAX(a,b)	((a)>(b)?(a):(b))
-static agerrlevel_t agerrno;		/* Last error level */
+#ifndef va_copy
+#define va_copy(dst,src)	memcpy(&(dst), &(src), sizeof(va_list))
+#endif
+
+/* The error level and the function receiving messages are set for the
+ * whole program. The record of errors reported is kept by each thread,
+ * so that threads parsing or laying out different graphs see only their
+ * own errors.
+ */
 static agerrlevel_t agerrlevel = AGWARN;	/* Report errors >= agerrlevel */
-static int agmaxerr;
-
-static long aglast;		/* Last message */
-static FILE *agerrout;		/* Message file */
 static agusererrf usererrf;     /* User-set error function */
 
+static AGTLS agerrlevel_t agerrno;		/* Last error level */
+static AGTLS int agmaxerr;
+static AGTLS char *aglastmsg;	/* Last message not reported */
+static AGTLS size_t aglastlen, aglastsz;
+
 agusererrf
 agseterrf (agusererrf newf)
 {
@@ -40,66 +49,85 @@ agerrlevel_t agseterr(agerrlevel_t lvl)
 
 char *aglasterr()
 {
-    long endpos;
-    long len;
     char *buf;
 
-    if (!agerrout)
+    if (!aglastmsg)
 	return 0;
-    fflush(agerrout);
-    endpos = ftell(agerrout);
-    len = endpos - aglast;
-    buf = (char*)malloc(len + 1);
-    fseek(agerrout, aglast, SEEK_SET);
-    fread(buf, sizeof(char), len, agerrout);
-    buf[len] = '\0';
-    fseek(agerrout, endpos, SEEK_SET);
-
+    buf = (char*)malloc(aglastlen + 1);
+    if (buf) {
+	memcpy(buf, aglastmsg, aglastlen);
+	buf[aglastlen] = '\0';
+    }
     return buf;
 }
 
+/* vformat:
+ * Format a message into buf of size *szp, growing it as needed.
+ * Returns the length of the message, or -1 on failure.
+ */
+static int vformat(char **bufp, size_t *szp, size_t off, const char *fmt,
+		   va_list args)
+{
+    va_list args2;
+    char *np;
+    int n;
+
+    va_copy(args2, args);
+    n = vsnprintf(*bufp ? *bufp + off : NULL, *bufp ? *szp - off : 0,
+		  fmt, args2);
+    va_end(args2);
+    if (n < 0)
+	return -1;
+    if (!*bufp || (off + (size_t) n >= *szp)) {
+	size_t sz = MAX(2 * *szp, off + n + 1);
+	if ((np = (char*)realloc(*bufp, sz)) == NULL)
+	    return -1;
+	*bufp = np;
+	*szp = sz;
+	va_copy(args2, args);
+	vsnprintf(*bufp + off, *szp - off, fmt, args2);
+	va_end(args2);
+    }
+    return n;
+}
+
 /* userout:
  * Report messages using a user-supplied write function 
  */
 static void
 userout (agerrlevel_t level, const char *fmt, va_list args)
 {
-    static char* buf;
-    static int bufsz = 1024;
-    char* np;
+    char sbuf[1024];
+    char* buf = sbuf;
+    size_t bufsz = sizeof(sbuf);
+    va_list args2;
     int n;
 
-    if (!buf) {
-	buf = (char*)malloc(bufsz);
-	if (!buf) {
-	    fputs("userout: could not allocate memory\n", stderr );
-	    return;
-	}
-    }
-
     if (level != AGPREV) {
 	usererrf ((level == AGERR) ? "Error" : "Warning");
 	usererrf (": ");
     }
 
-    while (1) {
-	n = vsnprintf(buf, bufsz, fmt, args);
-	if ((n > -1) && (n < bufsz)) {
-	    usererrf (buf);
-	    break;
-	}
-	bufsz = MAX(bufsz*2,n+1);
-	if ((np = (char*)realloc(buf, bufsz)) == NULL) {
-	    fputs("userout: could not allocate memory\n", stderr );
-	    return;
-	}
+    va_copy(args2, args);
+    n = vsnprintf(buf, bufsz, fmt, args2);
+    va_end(args2);
+    if ((n > -1) && ((size_t)n >= bufsz)) {
+	buf = NULL;
+	bufsz = 0;
+	n = vformat(&buf, &bufsz, 0, fmt, args);
     }
-    va_end(args);
+    if (n < 0)
+	fputs("userout: could not allocate memory\n", stderr );
+    else
+	usererrf (buf);
+    if (buf != sbuf)
+	free(buf);
 }
 
 static int agerr_va(agerrlevel_t level, const char *fmt, va_list args)
 {
     agerrlevel_t lvl;
+    int n;
 
     /* Use previous error level if continuation message;
      * Convert AGMAX to AGERROR;
@@ -121,20 +149,19 @@ static int agerr_va(agerrlevel_t level, const char *fmt, va_list args)
 	    if (level != AGPREV)
 		fprintf(stderr, "%s: ", (level == AGERR) ? "Error" : "Warning");
 	    vfprintf(stderr, fmt, args);
-	    va_end(args);
 	}
 	return 0;
     }
 
-    if (!agerrout) {
-	agerrout = tmpfile();
-	if (!agerrout)
-	    return 1;
-    }
-
+    /* Otherwise keep the message for aglasterr; a continuation
+     * is appended to the message it continues.
+     */
     if (level != AGPREV)
-	aglast = ftell(agerrout);
-    vfprintf(agerrout, fmt, args);
+	aglastlen = 0;
+    n = vformat(&aglastmsg, &aglastsz, aglastlen, fmt, args);
+    if (n < 0)
+	return 1;
+    aglastlen += n;
     return 0;
 }
 
@@ -30,22 +30,38 @@ Dtdisc_t AgDataDictDisc = {
     NIL(Dtmake_f),
     freesym,
     NIL(Dtcompar_f),
-    NIL(Dthash_f)
+    NIL(Dthash_f),
+    agdictobjmem,
+    NIL(Dtevent_f)
 };
 
 static char DataDictName[] = "_AG_datadict";
 static void init_all_attrs(Agraph_t * g);
+static void tvinvalidate(Agraph_t * g);
 static Agdesc_t ProtoDesc = { 1, 0, 1, 0, 1, 1 };
 static Agraph_t *ProtoGraph;
 
+/* Root graphs copy their initial attributes from ProtoGraph, possibly on
+ * several threads at once. Reading a Dttree dictionary reorganizes it, so
+ * new graphs copy from a flat list of ProtoGraph's symbols instead, which
+ * is rebuilt whenever a prototype attribute is declared or updated.
+ * Such declarations must precede any concurrent use of the library.
+ */
+typedef struct {
+    Agsym_t **sym;
+    int n;
+} protosyms_t;
+
+static protosyms_t ProtoSyms[3];	/* graph, node, edge */
+
 Agdatadict_t *agdatadict(Agraph_t * g, int cflag)
 {
     Agdatadict_t *rv;
-    rv = (Agdatadict_t *) aggetrec(g, DataDictName, FALSE);
+    rv = (Agdatadict_t *) aggetrecslot(g, AGDICTSLOT);
     if (rv || !cflag)
 	return rv;
     init_all_attrs(g);
-    rv = (Agdatadict_t *) aggetrec(g, DataDictName, FALSE);
+    rv = (Agdatadict_t *) aggetrecslot(g, AGDICTSLOT);
     return rv;
 }
 
@@ -76,10 +92,41 @@ Dict_t *agdictof(Agraph_t * g, int kind)
     return dict;
 }
 
+static int protokind(int kind)
+{
+    return (kind == AGINEDGE) ? AGOUTEDGE : kind;
+}
+
+static void protosnapshot(int kind)
+{
+    protosyms_t *ps = &ProtoSyms[protokind(kind)];
+    Dict_t *d;
+    Agsym_t *sym;
+    int i;
+
+    d = agdictof(ProtoGraph, kind);
+    ps->sym = realloc(ps->sym, (dtsize(d) + 1) * sizeof(Agsym_t *));
+    i = 0;
+    for (sym = (Agsym_t *) dtfirst(d); sym; sym = (Agsym_t *) dtnext(d, sym))
+	ps->sym[i++] = sym;
+    ps->n = i;
+}
+
+static Agsym_t *protosym(int kind, char *name)
+{
+    protosyms_t *ps = &ProtoSyms[protokind(kind)];
+    int i;
+
+    for (i = 0; i < ps->n; i++)
+	if (streq(ps->sym[i]->name, name))
+	    return ps->sym[i];
+    return NILsym;
+}
+
 Agsym_t *agnewsym(Agraph_t * g, char *name, char *value, int id, int kind)
 {
     Agsym_t *sym;
-    sym = agalloc(g, sizeof(Agsym_t));
+    sym = agmemalloc(g, sizeof(Agsym_t), AGMEM_ATTR);
     sym->kind = kind;
     sym->name = agstrdup(g, name);
     sym->defval = agstrdup(g, value);
@@ -87,13 +134,15 @@ Agsym_t *agnewsym(Agraph_t * g, char *name, char *value, int id, int kind)
     return sym;
 }
 
-static void agcopydict(Dict_t * src, Dict_t * dest, Agraph_t * g, int kind)
+static void agcopydict(Dict_t * dest, Agraph_t * g, int kind)
 {
+    protosyms_t *ps = &ProtoSyms[protokind(kind)];
     Agsym_t *sym, *newsym;
+    int i;
 
     assert(dtsize(dest) == 0);
-    for (sym = (Agsym_t *) dtfirst(src); sym;
-	 sym = (Agsym_t *) dtnext(src, sym)) {
+    for (i = 0; i < ps->n; i++) {
+	sym = ps->sym[i];
 	newsym = agnewsym(g, sym->name, sym->defval, sym->id, kind);
 	newsym->print = sym->print;
 	newsym->fixed = sym->fixed;
@@ -121,10 +170,9 @@ static Agdatadict_t *agmakedatadict(Agraph_t * g)
 	if (ProtoGraph && (g != ProtoGraph)) {
 	    /* it's not ok to dtview here for several reasons. the proto
 	       graph could change, and the sym indices don't match */
-	    parent_dd = agdatadict(ProtoGraph, FALSE);
-	    agcopydict(parent_dd->dict.n, dd->dict.n, g, AGNODE);
-	    agcopydict(parent_dd->dict.e, dd->dict.e, g, AGEDGE);
-	    agcopydict(parent_dd->dict.g, dd->dict.g, g, AGRAPH);
+	    agcopydict(dd->dict.n, g, AGNODE);
+	    agcopydict(dd->dict.e, g, AGEDGE);
+	    agcopydict(dd->dict.g, g, AGRAPH);
 	}
     }
     return dd;
@@ -193,7 +241,8 @@ static Agrec_t *agmakeattrs(Agraph_t * context, void *obj)
 	sz = topdictsize(obj);
 	if (sz < MINATTR)
 	    sz = MINATTR;
-	rec->str = agalloc(agraphof(obj), (size_t) sz * sizeof(char *));
+	rec->str = agmemalloc(agraphof(obj), (size_t) sz * sizeof(char *),
+			      AGMEM_ATTR);
 	/* doesn't call agxset() so no obj-modified callbacks occur */
 	for (sym = (Agsym_t *) dtfirst(datadict); sym;
 	     sym = (Agsym_t *) dtnext(datadict, sym))
@@ -213,7 +262,7 @@ static void freeattr(Agobj_t * obj, Agattr_t * attr)
     sz = topdictsize(obj);
     for (i = 0; i < sz; i++)
 	agstrfree(g, attr->str[i]);
-    agfree(g, attr->str);
+    agmemfree(g, attr->str, AGMEM_ATTR);
 }
 
 static void freesym(Dict_t * d, void * obj, Dtdisc_t * disc)
@@ -225,12 +274,22 @@ static void freesym(Dict_t * d, void * obj, Dtdisc_t * disc)
     NOTUSED(disc);
     agstrfree(Ag_G_global, sym->name);
     agstrfree(Ag_G_global, sym->defval);
-    agfree(Ag_G_global, sym);
+    agmemfree(Ag_G_global, sym->tcache, AGMEM_ATTR);
+    agmemfree(Ag_G_global, sym, AGMEM_ATTR);
 }
 
 Agattr_t *agattrrec(void *obj)
 {
-    return (Agattr_t *) aggetrec(obj, AgDataRecName, FALSE);
+    return (Agattr_t *) aggetrecslot(obj, AGDATASLOT);
+}
+
+/* agattrslots:
+ * Reserve the fixed record slots of a new root graph.
+ */
+void agattrslots(Agraph_t * g)
+{
+    agrecslot(g, AgDataRecName);	/* AGDATASLOT */
+    agrecslot(g, DataDictName);	/* AGDICTSLOT */
 }
 
 
@@ -241,12 +300,10 @@ static void addattr(Agraph_t * g, Agobj_t * obj, Agsym_t * sym)
     attr = (Agattr_t *) agattrrec(obj);
     assert(attr != NIL(Agattr_t *));
     if (sym->id >= MINATTR)
-	attr->str = (char **) AGDISC(g, mem)->resize(AGCLOS(g, mem),
-						     attr->str,
-						     sym->id *
-						     sizeof(char *),
-						     (sym->id +
-						      1) * sizeof(char *));
+	attr->str = (char **) agmemresize(g, attr->str,
+					  sym->id * sizeof(char *),
+					  (sym->id + 1) * sizeof(char *),
+					  AGMEM_ATTR);
     attr->str[sym->id] = agstrdup(g, sym->defval);
     /* agmethod_upd(g,obj,sym);  JCE and GN didn't like this. */
 }
@@ -269,6 +326,7 @@ static Agsym_t *setattr(Agraph_t * g, int kind, char *name, char *value)
     if (lsym) {			/* update old local definiton */
 	agstrfree(g, lsym->defval);
 	lsym->defval = agstrdup(g, value);
+	tvinvalidate(g);
 	rv = lsym;
     } else {
 	psym = agdictsym(ldict, name);	/* search with viewpath up to root */
@@ -326,9 +384,13 @@ Agsym_t *agattr(Agraph_t * g, int kind, char *name, char *value)
     Agsym_t *rv;
 
     if (g == 0) {
+	if (value == 0)
+	    return protosym(kind, name);
 	if (ProtoGraph == 0)
 	    ProtoGraph = agopen(0, ProtoDesc, 0);
-	g = ProtoGraph;
+	rv = setattr(ProtoGraph, kind, name, value);
+	protosnapshot(kind);
+	return rv;
     }
     if (value)
 	rv = setattr(g, kind, name, value);
@@ -478,6 +540,7 @@ int agxset(void *obj, Agsym_t * sym, char *value)
     assert((sym->id >= 0) && (sym->id < topdictsize(obj)));
     agstrfree(g, data->str[sym->id]);
     data->str[sym->id] = agstrdup(g, value);
+    tvinvalidate(g);
     if (hdr->tag.objtype == AGRAPH) {
 	/* also update dict default */
 	Dict_t *dict;
@@ -505,6 +568,229 @@ int agsafeset(void *obj, char *name, char *value, char *def)
 }
 
 
+/* Converted values
+ * Numeric attributes tend to repeat the same few values, such as a default
+ * width or an edge weight, yet layouts convert them object by object.
+ * Each symbol can carry a small direct-mapped cache of conversions, keyed
+ * by the value string. As values are interned, the key is the string's
+ * address, so a hit costs no hashing or comparison of the text. A string
+ * freed by agxset may come back at the same address with other contents,
+ * so agxset, and setting a default, advance the root graph's attrgen, and
+ * entries made before that no longer match.
+ * Layouts may look values up from several threads. A thread finding the
+ * cache in use by another converts the value itself.
+ */
+#define TCACHESIZE	64	/* power of 2 */
+
+#define TV_DOUBLE	1
+#define TV_INT		2
+#define TV_BOOL		3
+#define TV_POINT	4
+
+typedef struct {
+    char *str;			/* value converted, NULL if none */
+    uint64_t gen;		/* attrgen when converted */
+    unsigned char kind;
+    unsigned char ok;		/* conversion succeeded */
+    union {
+	double d;
+	long i;
+	struct {
+	    double v[3];
+	    char next[3];
+	} p;
+    } u;
+} tval_t;
+
+struct Agtval_s {
+    int busy;			/* a thread is using the cache */
+    tval_t v[TCACHESIZE];
+};
+
+#ifdef __GNUC__
+#define TVGEN(g)	__atomic_load_n(&(g)->clos->attrgen, __ATOMIC_RELAXED)
+#define TVBUMP(g)	__atomic_add_fetch(&(g)->clos->attrgen, 1, __ATOMIC_RELAXED)
+#define TVCACHE(sym)	__atomic_load_n(&(sym)->tcache, __ATOMIC_ACQUIRE)
+#define TVINSTALL(sym,tc) \
+    __atomic_compare_exchange_n(&(sym)->tcache, &(struct Agtval_s*){NULL}, \
+			(tc), 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#define TVLOCK(tc)	(__atomic_exchange_n(&(tc)->busy, 1, __ATOMIC_ACQUIRE) == 0)
+#define TVUNLOCK(tc)	__atomic_store_n(&(tc)->busy, 0, __ATOMIC_RELEASE)
+#else
+#define TVGEN(g)	((g)->clos->attrgen)
+#define TVBUMP(g)	(++(g)->clos->attrgen)
+#define TVCACHE(sym)	((sym)->tcache)
+#define TVINSTALL(sym,tc) ((sym)->tcache = (tc), 1)
+#define TVLOCK(tc)	(((tc)->busy) ? 0 : ((tc)->busy = 1))
+#define TVUNLOCK(tc)	((tc)->busy = 0)
+#endif
+
+static int streqcase(char *s, char *t)
+{
+    while (*s && (tolower(*(unsigned char *) s) == *t)) {
+	s++;
+	t++;
+    }
+    return (*s == '\0') && (*t == '\0');
+}
+
+static void tvconvert(tval_t * tv, char *s, int kind)
+{
+    char *endp;
+    int i;
+
+    switch (kind) {
+    case TV_DOUBLE:
+	tv->u.d = strtod(s, &endp);
+	tv->ok = (endp != s);
+	break;
+    case TV_INT:
+	tv->u.i = strtol(s, &endp, 10);
+	tv->ok = (endp != s);
+	break;
+    case TV_BOOL:		/* same rules as mapBool in lib/common */
+	tv->ok = TRUE;
+	if (streqcase(s, "false") || streqcase(s, "no"))
+	    tv->u.i = FALSE;
+	else if (streqcase(s, "true") || streqcase(s, "yes"))
+	    tv->u.i = TRUE;
+	else if (isdigit(*(unsigned char *) s))
+	    tv->u.i = atoi(s);
+	else
+	    tv->ok = FALSE;
+	break;
+    case TV_POINT:		/* as sscanf(s,"%lf,%lf,%lf%c",...) */
+	tv->ok = 0;
+	for (i = 0; i < 3; i++) {
+	    tv->u.p.v[i] = strtod(s, &endp);
+	    if (endp == s)
+		break;
+	    tv->ok++;
+	    tv->u.p.next[i] = *endp;
+	    if (*endp != ',')
+		break;
+	    s = endp + 1;
+	}
+	break;
+    }
+}
+
+/* tvinvalidate:
+ * Make the cached conversions of g's attributes stale.
+ */
+static void tvinvalidate(Agraph_t * g)
+{
+    TVBUMP(g);
+}
+
+/* tvcache:
+ * Return sym's cache, allocating it on first use.
+ */
+static struct Agtval_s *tvcache(Agraph_t * g, Agsym_t * sym)
+{
+    struct Agtval_s *tc;
+
+    if ((tc = TVCACHE(sym)))
+	return tc;
+    tc = agmemalloc(g, sizeof(struct Agtval_s), AGMEM_ATTR);
+    if (tc && !TVINSTALL(sym, tc)) {	/* another thread was first */
+	agmemfree(g, tc, AGMEM_ATTR);
+	tc = TVCACHE(sym);
+    }
+    return tc;
+}
+
+/* tvlookup:
+ * Set tv to the conversion of obj's value for sym, taking it from
+ * the cache if possible.
+ */
+static void tvlookup(void *obj, Agsym_t * sym, int kind, tval_t * tv)
+{
+    Agraph_t *g = agraphof(obj);
+    struct Agtval_s *tc;
+    tval_t *e;
+    uint64_t gen;
+    uintptr_t h;
+    char *s;
+
+    s = agxget(obj, sym);
+    gen = TVGEN(g);
+    tc = tvcache(g, sym);
+    if (!tc || !TVLOCK(tc)) {
+	tvconvert(tv, s, kind);
+	return;
+    }
+    h = (uintptr_t) s;
+    e = &tc->v[((h >> 4) ^ (h >> 10) ^ kind) & (TCACHESIZE - 1)];
+    if ((e->str != s) || (e->kind != kind) || (e->gen != gen)) {
+	tvconvert(e, s, kind);
+	e->str = s;
+	e->gen = gen;
+	e->kind = (unsigned char) kind;
+    }
+    *tv = *e;
+    TVUNLOCK(tc);
+}
+
+/* agxgetdouble:
+ * Convert obj's value for sym with strtod, returning FALSE if it
+ * is not a number.
+ */
+int agxgetdouble(void *obj, Agsym_t * sym, double *v)
+{
+    tval_t tv;
+
+    tvlookup(obj, sym, TV_DOUBLE, &tv);
+    if (tv.ok)
+	*v = tv.u.d;
+    return tv.ok;
+}
+
+/* agxgetint:
+ * Convert obj's value for sym with strtol, returning FALSE if it
+ * is not a number.
+ */
+int agxgetint(void *obj, Agsym_t * sym, int *v)
+{
+    tval_t tv;
+
+    tvlookup(obj, sym, TV_INT, &tv);
+    if (tv.ok)
+	*v = (int) tv.u.i;
+    return tv.ok;
+}
+
+/* agxgetbool:
+ * Return obj's value for sym as a boolean: false, no, true, yes in any
+ * case, or an integer. Anything else gives dflt.
+ */
+int agxgetbool(void *obj, Agsym_t * sym, int dflt)
+{
+    tval_t tv;
+
+    tvlookup(obj, sym, TV_BOOL, &tv);
+    return tv.ok ? (int) tv.u.i : dflt;
+}
+
+/* agxgetpoint:
+ * Convert up to 3 comma-separated numbers in obj's value for sym into pt,
+ * returning how many there were. If next is not NULL, next[i] is set to
+ * the character following coordinate i.
+ */
+int agxgetpoint(void *obj, Agsym_t * sym, double *pt, char *next)
+{
+    tval_t tv;
+    int i;
+
+    tvlookup(obj, sym, TV_POINT, &tv);
+    for (i = 0; i < tv.ok; i++) {
+	pt[i] = tv.u.p.v[i];
+	if (next)
+	    next[i] = tv.u.p.next[i];
+    }
+    return tv.ok;
+}
+
 /*
  * attach attributes to the already created graph objs.
  * presumably they were already initialized, so we don't invoke
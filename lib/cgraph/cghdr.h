@@ -52,6 +52,7 @@
 #define	SUCCESS				0
 #define FAILURE				-1
 #define LOCALNAMEPREFIX		'%'
+#define AGBINMAGIC			'\177'	/* first byte of binary graphs */
 
 #define AGDISC(g,d)			((g)->clos->disc.d)
 #define AGCLOS(g,d)			((g)->clos->state.d)
@@ -59,13 +60,24 @@
 
 #define ISALNUM(c) ((isalnum(c)) || ((c) == '_') || (!isascii(c)))
 
+	/* storage class for state that each thread keeps for itself */
+#ifndef AGTLS
+#if defined(_MSC_VER)
+#define AGTLS __declspec(thread)
+#elif defined(__GNUC__) || defined(__SUNPRO_C) || defined(__INTEL_COMPILER)
+#define AGTLS __thread
+#else
+#define AGTLS _Thread_local
+#endif
+#endif
+
 	/* functional definitions */
 typedef Agobj_t *(*agobjsearchfn_t) (Agraph_t * g, Agobj_t * obj);
 int agapply(Agraph_t * g, Agobj_t * obj, agobjfn_t fn, void *arg,
 	    int preorder);
 
 	/* global variables */
-EXTERN Agraph_t *Ag_G_global;
+EXTERN AGTLS Agraph_t *Ag_G_global;
 extern char *AgDataRecName;
 
 	/* set ordering disciplines */
@@ -103,8 +115,11 @@ void *agdictobjmem(Dict_t * dict, void * p, size_t size,
 void agdictobjfree(Dict_t * dict, void * p, Dtdisc_t * disc);
 
 	/* name-value pair operations */
+#define AGDATASLOT	0	/* record slot of AgDataRecName */
+#define AGDICTSLOT	1	/* record slot of the data dictionary */
 Agdatadict_t *agdatadict(Agraph_t * g, int cflag);
 Agattr_t *agattrrec(void *obj);
+void agattrslots(Agraph_t * g);
 
 void agraphattr_init(Agraph_t * g);
 int agraphattr_delete(Agraph_t * g);
@@ -114,11 +129,44 @@ void agedgeattr_init(Agraph_t *g, Agedge_t * e);
 void agedgeattr_delete(Agedge_t * e);
 
 	/* parsing and lexing graph files */
-int aagparse(void);
-void aglexinit(Agdisc_t * disc, void *ifile);
-int aaglex(void);
-void aglexeof(void);
-void aglexbad(void);
+/* The state of one parse, shared by the parser and the lexer, which
+ * keeps it as the flex scanner's extra data. Streams are read through a
+ * context that belongs to the calling thread; in-memory input has a
+ * context of its own.
+ */
+typedef struct aagextra_s {
+	/* parser */
+    Agraph_t *G;		/* top level graph */
+    Agdisc_t *Disc;		/* discipline passed to agread or agconcat */
+    struct gstack_s *S;		/* stack of open graphs */
+	/* lexer */
+    void *scanner;		/* flex scanner, or NULL until needed */
+    void *Ifile;		/* input channel */
+    char *InputFile;		/* name used in messages */
+    int line_num;
+    int html_nest;		/* nesting level for html strings */
+    int graphType;
+    char *Sbuf, *Sptr, *Send;	/* buffer for arbitrary length strings */
+    char *fnbuf;		/* file name set by a #line directive */
+    size_t fnsize;
+} aagextra_t;
+
+int aagparse(void *scanner, aagextra_t * ctx);
+void aagerror(void *scanner, aagextra_t * ctx, const char *str);
+Agraph_t *agparse(aagextra_t * ctx, Agraph_t * g, void *chan,
+		  Agdisc_t * disc);
+aagextra_t *aglexopen(char *base, size_t size);
+void aglexclose(aagextra_t * ctx);
+int aglexinit(aagextra_t * ctx, Agdisc_t * disc, void *ifile);
+void aglexeof(aagextra_t * ctx);
+void aglexbad(aagextra_t * ctx);
+int aglexempty(aagextra_t * ctx);
+
+	/* memory charged to a category */
+void *agmemalloc(Agraph_t * g, size_t size, int cat);
+void *agmemresize(Agraph_t * g, void *ptr, size_t oldsize, size_t size,
+		  int cat);
+void agmemfree(Agraph_t * g, void *ptr, int cat);
 
 	/* ID management */
 int agmapnametoid(Agraph_t * g, int objtype, char *str,
@@ -136,12 +184,26 @@ void aginternalmapclose(Agraph_t * g);
 void agregister(Agraph_t * g, int objtype, void *obj);
 
 	/* internal set operations */
+int agedgeindex_check(Agraph_t * g, int deg);
+void agedgeindex_insert(Agraph_t * g, Agedge_t * e);
+void agedgeindex_delete(Agraph_t * g, Agedge_t * e);
+Agedge_t *agedgeindex_find(Agraph_t * g, Agnode_t * t, Agnode_t * h,
+			   Agtag_t key);
+void agedgeindex_free(Agraph_t * g);
+Agnodeset_t *agsetopen(Agraph_t * g, int kind);
+void agsetadd(Agnodeset_t * s, void *obj);
+void agsetdel(Agnodeset_t * s, void *obj);
+int agsethas(Agnodeset_t * s, void *obj);
+void agsetor(Agnodeset_t * s, Agnodeset_t * b);
+void agsetunion(Agnodeset_t * s, Agraph_t * g);
+void agsetclose(Agnodeset_t * s);
 void agedgesetop(Agraph_t * g, Agedge_t * e, int insertion);
 void agdelnodeimage(Agraph_t * g, Agnode_t * node, void *ignored);
 void agdeledgeimage(Agraph_t * g, Agedge_t * edge, void *ignored);
 void *agrebind0(Agraph_t * g, void *obj);	/* unsafe */
 int agrename(Agobj_t * obj, char *newname);
 void agrecclose(Agobj_t * obj);
+void agrecslotclose(Agraph_t * g);
 
 void agmethod_init(Agraph_t * g, void *obj);
 void agmethod_upd(Agraph_t * g, void *obj, Agsym_t * sym);
@@ -151,6 +213,7 @@ void agmethod_delete(Agraph_t * g, void *obj);
 #define CB_UPDATE		101
 #define CB_DELETION		102
 void agsyspushdisc(Agraph_t * g, Agcbdisc_t * cb, void *state, int stack);
+void *aggetuserptr(Agraph_t * g, Agcbdisc_t * cbd);
 int agsyspopdisc(Agraph_t * g, Agcbdisc_t * cb, int stack);
 void agrecord_callback(Agraph_t * g, Agobj_t * obj, int kind,
 		       Agsym_t * optsym);
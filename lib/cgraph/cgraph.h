@@ -58,9 +58,17 @@ typedef struct Agcbdisc_s Agcbdisc_t;	/* client event callbacks */
 typedef struct Agcbstack_s Agcbstack_t;	/* enclosing state for cbdisc */
 typedef struct Agclos_s Agclos_t;	/* common fields for graph/subgs */
 typedef struct Agrec_s Agrec_t;	/* generic runtime record */
+typedef struct Agrecslots_s Agrecslots_t;	/* records by slot number */
 typedef struct Agdatadict_s Agdatadict_t;	/* set of dictionaries per graph */
 typedef struct Agedgepair_s Agedgepair_t;	/* the edge object */
 typedef struct Agsubnode_s Agsubnode_t;
+typedef struct Agstrtab_s Agstrtab_t;	/* interned strings */
+typedef struct Agmmap_s Agmmap_t;	/* memory-mapped input */
+typedef struct Agcsr_s Agcsr_t;		/* adjacency snapshot */
+typedef struct Agedgeindex_s Agedgeindex_t;	/* hashed edge lookup */
+typedef struct Agsidetab_s Agsidetab_t;	/* array keyed by object index */
+typedef struct Agnodeset_s Agnodeset_t;	/* node membership bitset */
+typedef struct Agchangelog_s Agchangelog_t;	/* changes since a checkpoint */
 
 /* Header of a user record.  These records are attached by client programs
 dynamically at runtime.  A unique string ID must be given to each record
@@ -68,7 +76,10 @@ attached to the same object.  Cgraph has functions to create, search for,
 and delete these records.   The records are maintained in a circular list,
 with obj->data pointing somewhere in the list.  The search function has
 an option to lock this pointer on a given record.  The application must
-be written so only one such lock is outstanding at a time. */
+be written so only one such lock is outstanding at a time.
+Each record name is also given a slot number per root graph, and each
+object keeps its records in an array by slot, so they are found without
+searching the list. */
 
 struct Agrec_s {
     char *name;
@@ -97,6 +108,7 @@ struct Agtag_s {
 struct Agobj_s {
     Agtag_t tag;
     Agrec_t *data;
+    Agrecslots_t *slots;	/* records by slot, see agrecslot */
 };
 
 #define AGTAG(obj)		(((Agobj_t*)(obj))->tag)
@@ -118,6 +130,7 @@ struct Agsubnode_s {		/* the node-per-graph-or-subgraph record */
     Agnode_t *node;		/* the object */
     Dtlink_t *in_id, *out_id;	/* by node/ID for random access */
     Dtlink_t *in_seq, *out_seq;	/* by node/sequence for serial access */
+    int in_deg, out_deg;	/* sizes of the edge sets */
 };
 
 struct Agnode_s {
@@ -156,6 +169,7 @@ struct Agmemdisc_s {		/* memory allocator */
     void *(*resize) (void *state, void *ptr, size_t old, size_t req);
     void (*free) (void *state, void *ptr);
     void (*close) (void *state);
+    size_t (*size) (void *state, void *ptr);	/* usable size, or NULL */
 };
 
 struct Agiddisc_s {		/* object ID allocator */
@@ -191,7 +205,9 @@ struct Agdisc_s {		/* user's discipline */
 /*end visual studio*/
 
 extern Agmemdisc_t AgMemDisc;
+extern Agmemdisc_t AgArenaMemDisc;	/* per-graph slabs, freed on agclose */
 extern Agiddisc_t AgIdDisc;
+extern Agiddisc_t AgDenseIdDisc;	/* indices 0..n-1, see agnodeindex */
 extern Agiodisc_t AgIoDisc;
 
 extern Agdisc_t AgDefaultDisc;
@@ -222,15 +238,37 @@ struct Agcbstack_s {		/* object event callbacks */
     Agcbstack_t *prev;		/* kept in a stack, unlike other disciplines */
 };
 
+/* memory accounting, by category */
+#define AGMEM_GRAPH	0	/* graphs, nodes, edges and indices */
+#define AGMEM_REC	1	/* records, such as layout data */
+#define AGMEM_ATTR	2	/* attribute declarations and values */
+#define AGMEM_STR	3	/* the string table */
+#define AGMEM_DICT	4	/* dictionaries */
+#define AGMEM_NCAT	5
+
+typedef struct Agmemstat_s {
+    size_t bytes[AGMEM_NCAT];	/* in use, by category */
+    size_t total, peak;		/* in use, and the most ever */
+    size_t nalloc, nfree;	/* calls */
+    int exact;			/* frees are counted */
+} Agmemstat_t;
+
 struct Agclos_s {
     Agdisc_t disc;		/* resource discipline functions */
     Agdstate_t state;		/* resource closures */
-    Dict_t *strdict;		/* shared string dict */
+    Agstrtab_t *strdict;	/* shared string table */
     uint64_t seq[3];	/* local object sequence number counter */
+    uint64_t gen;		/* count of structural changes, see agcsr */
+    uint64_t attrgen;		/* count of attribute changes, see agxgetdouble */
     Agcbstack_t *cb;		/* user and system callback function stacks */
     unsigned char callbacks_enabled;	/* issue user callbacks or hold them? */
     Dict_t *lookup_by_name[3];
     Dict_t *lookup_by_id[3];
+    char **recname;		/* record names by slot */
+    const char **recalias;	/* last caller's copy of each, not owned */
+    int nrecslot;
+    unsigned char subg_bits;	/* subgraphs keep n_bits, see agsubgbits */
+    Agmemstat_t memstat;	/* see agmemstat */
 };
 
 struct Agraph_s {
@@ -240,6 +278,8 @@ struct Agraph_s {
     Dict_t *n_seq;		/* the node set in sequence */
     Dict_t *n_id;		/* the node set indexed by ID */
     Dict_t *e_seq, *e_id;	/* holders for edge sets */
+    Agedgeindex_t *e_index;	/* hashed edge lookup, or NULL */
+    Agnodeset_t *n_bits;	/* the node set as a bitset, or NULL */
     Dict_t *g_dict;		/* subgraphs - descendants */
     Agraph_t *parent, *root;	/* subgraphs - ancestors */
     Agclos_t *clos;		/* shared resources */
@@ -254,10 +294,16 @@ extern Agraph_t *agopen(char *name, Agdesc_t desc, Agdisc_t * disc);
 extern int agclose(Agraph_t * g);
 extern Agraph_t *agread(void *chan, Agdisc_t * disc);
 extern Agraph_t *agmemread(const char *cp);
+extern Agraph_t *agmemread_len(const char *cp, size_t len);
+extern Agmmap_t *agmmapopen(void *chan);
+extern Agraph_t *agmmapread(Agmmap_t * m, Agdisc_t * disc);
+extern void agmmapclose(Agmmap_t * m);
 extern void agreadline(int);
 extern void agsetfile(char *);
 extern Agraph_t *agconcat(Agraph_t * g, void *chan, Agdisc_t * disc);
 extern int agwrite(Agraph_t * g, void *chan);
+extern int agwrite_binary(Agraph_t * g, void *chan);
+extern Agraph_t *agread_binary(void *chan, Agdisc_t * disc);
 extern int agisdirected(Agraph_t * g);
 extern int agisundirected(Agraph_t * g);
 extern int agisstrict(Agraph_t * g);
@@ -267,6 +313,8 @@ extern int agissimple(Agraph_t * g);
 extern Agnode_t *agnode(Agraph_t * g, char *name, int createflag);
 extern Agnode_t *agidnode(Agraph_t * g, IDTYPE id, int createflag);
 extern Agnode_t *agsubnode(Agraph_t * g, Agnode_t * n, int createflag);
+extern int agnodes_bulk(Agraph_t * g, int cnt, char **names,
+			Agnode_t ** nodes);
 extern Agnode_t *agfstnode(Agraph_t * g);
 extern Agnode_t *agnxtnode(Agraph_t * g, Agnode_t * n);
 extern Agnode_t *aglstnode(Agraph_t * g);
@@ -281,6 +329,8 @@ extern Agedge_t *agedge(Agraph_t * g, Agnode_t * t, Agnode_t * h,
 extern Agedge_t *agidedge(Agraph_t * g, Agnode_t * t, Agnode_t * h,
               IDTYPE id, int createflag);
 extern Agedge_t *agsubedge(Agraph_t * g, Agedge_t * e, int createflag);
+extern int agedges_bulk(Agraph_t * g, int cnt, Agnode_t ** tails,
+			Agnode_t ** heads, char **keys, Agedge_t ** edges);
 extern Agedge_t *agfstin(Agraph_t * g, Agnode_t * n);
 extern Agedge_t *agnxtin(Agraph_t * g, Agedge_t * e);
 extern Agedge_t *agfstout(Agraph_t * g, Agnode_t * n);
@@ -288,6 +338,59 @@ extern Agedge_t *agnxtout(Agraph_t * g, Agedge_t * e);
 extern Agedge_t *agfstedge(Agraph_t * g, Agnode_t * n);
 extern Agedge_t *agnxtedge(Agraph_t * g, Agedge_t * e, Agnode_t * n);
 
+/* adjacency snapshots */
+struct Agcsr_s {
+    Agraph_t *g;
+    int nnodes, nedges;
+    Agnode_t **node;		/* nodes in sequence order */
+    int *out, *in;		/* nnodes+1 offsets into the edge arrays */
+    int *out_adj;		/* node index of the head of each out-edge */
+    int *in_adj;		/* node index of the tail of each in-edge */
+    Agedge_t **out_edge, **in_edge;
+    double *out_wt, *in_wt;	/* edge weights, if requested */
+    int *seqidx;		/* node index by sequence number */
+    uint64_t nseq;
+    uint64_t gen;		/* graph generation when built */
+};
+extern Agcsr_t *agcsr(Agraph_t * g, char *weight, double dflt);
+extern int agcsrvalid(Agcsr_t * csr);
+extern int agcsrindex(Agcsr_t * csr, Agnode_t * n);
+extern void agcsrfree(Agcsr_t * csr);
+
+/* dense object indices and side tables, see AgDenseIdDisc */
+extern int agnodeindex(Agnode_t * n);
+extern int agedgeindex(Agedge_t * e);
+extern int agindexbound(Agraph_t * g, int objtype);
+extern Agsidetab_t *agsidetab(Agraph_t * g, int objtype, size_t size);
+extern void *agsidedata(Agsidetab_t * tab, void *obj);
+extern void *agsidearray(Agsidetab_t * tab);
+extern void agsidetabfree(Agsidetab_t * tab);
+#define AGSIDE(tab,type,obj)	(*(type*)agsidedata(tab,obj))
+
+/* subgraph membership bitsets */
+extern int agsubgbits(Agraph_t * g, int flag);
+extern int agissubnode(Agraph_t * g, Agnode_t * n);
+extern Agnodeset_t *agnodeset(Agraph_t * g);
+extern void agnodesetunion(Agnodeset_t * s, Agraph_t * g);
+extern void agnodesetinter(Agnodeset_t * s, Agraph_t * g);
+extern int agnodesetmember(Agnodeset_t * s, Agnode_t * n);
+extern void agnodesetfree(Agnodeset_t * s);
+
+/* change logs and deltas */
+#define AGCHG_NEW	1
+#define AGCHG_MOD	2
+#define AGCHG_DEL	4
+extern Agchangelog_t *agopenchanges(Agraph_t * g);
+extern Agchangelog_t *agchanges(Agraph_t * g);
+extern void agclosechanges(Agchangelog_t * log);
+extern void agcheckpoint(Agchangelog_t * log);
+extern int agobjchanged(Agchangelog_t * log, void *obj);
+extern int agsymchanged(Agchangelog_t * log, Agsym_t * sym);
+extern int agchangecount(Agchangelog_t * log, int kind, int what);
+extern Agnodeset_t *agchangednodes(Agchangelog_t * log);
+extern int agwritedelta(Agchangelog_t * log, void *ofile, int binary);
+extern int agapplydelta(Agraph_t * g, char *delta, size_t len);
+
 /* generic */
 extern Agraph_t *agraphof(void* obj);
 extern Agraph_t *agroot(void* obj);
@@ -326,6 +429,7 @@ struct Agsym_s {		/* symbol in one of the above dictionaries */
     unsigned char kind;		/* referent object type */
     unsigned char fixed;	/* immutable value */
     unsigned char print;	/* always print */
+    struct Agtval_s *tcache;	/* converted values, see agxgetdouble */
 };
 
 struct Agdatadict_s {		/* set of dictionaries per graph */
@@ -344,6 +448,8 @@ extern void *agbindrec(void *obj, char *name, unsigned int size,
 		       int move_to_front);
 extern Agrec_t *aggetrec(void *obj, char *name, int move_to_front);
 extern int agdelrec(void *obj, char *name);
+extern int agrecslot(Agraph_t * g, char *name);
+extern Agrec_t *aggetrecslot(void *obj, int slot);
 extern void aginit(Agraph_t * g, int kind, char *rec_name, int rec_size,
 		   int move_to_front);
 extern void agclean(Agraph_t * g, int kind, char *rec_name);
@@ -353,6 +459,10 @@ extern char *agxget(void *obj, Agsym_t * sym);
 extern int agset(void *obj, char *name, char *value);
 extern int agxset(void *obj, Agsym_t * sym, char *value);
 extern int agsafeset(void* obj, char* name, char* value, char* def);
+extern int agxgetdouble(void *obj, Agsym_t * sym, double *v);
+extern int agxgetint(void *obj, Agsym_t * sym, int *v);
+extern int agxgetbool(void *obj, Agsym_t * sym, int dflt);
+extern int agxgetpoint(void *obj, Agsym_t * sym, double *pt, char *next);
 
 /* defintions for subgraphs */
 extern Agraph_t *agsubg(Agraph_t * g, char *name, int cflag);	/* constructor */
@@ -371,6 +481,8 @@ extern void *agrealloc(Agraph_t * g, void *ptr, size_t oldsize,
 		       size_t size);
 extern void agfree(Agraph_t * g, void *ptr);
 extern struct _vmalloc_s *agheap(Agraph_t * g);
+extern void agmemstat(Agraph_t * g, Agmemstat_t * st);
+extern char *agmemcatname(int cat);
 
 /* an engineering compromise is a joy forever */
 extern void aginternalmapclearlocalnames(Agraph_t * g);
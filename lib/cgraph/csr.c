@@ -0,0 +1,152 @@
+/* $Id$ $Revision$ */
+/* vim:set shiftwidth=4 ts=8: */
+
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: See CVS logs. Details at http://www.graphviz.org/
+ *************************************************************************/
+
+#include <cghdr.h>
+
+/* Compressed sparse row snapshots of a graph's adjacency.
+ * Nodes are numbered 0..nnodes-1 in sequence order. The out-edges of
+ * node i are out_edge[out[i]] .. out_edge[out[i+1]-1], with the index of
+ * their heads in out_adj; the in-edges are arranged likewise, with the
+ * index of their tails in in_adj.
+ */
+
+/* agcsrweight:
+ * Return the value of sym on e as a number, or dflt if it is not one.
+ */
+static double agcsrweight(Agedge_t * e, Agsym_t * sym, double dflt)
+{
+    char *s, *p;
+    double v;
+
+    s = agxget(e, sym);
+    v = strtod(s, &p);
+    return (p == s) ? dflt : v;
+}
+
+/* agcsr:
+ * Build a snapshot of the nodes and edges of g. If weight names a declared
+ * edge attribute, out_wt and in_wt hold its values, with dflt used where
+ * the value is not a number; otherwise they are NULL.
+ * The snapshot records the structure of g when it was built, and becomes
+ * stale as soon as nodes or edges are added, deleted or reordered anywhere
+ * in the root graph; see agcsrvalid. Attribute changes do not affect it.
+ */
+Agcsr_t *agcsr(Agraph_t * g, char *weight, double dflt)
+{
+    Agcsr_t *csr;
+    Agsym_t *sym;
+    Agnode_t *n;
+    Agedge_t *e;
+    int i, j, k, *pos;
+
+    csr = agalloc(g, sizeof(Agcsr_t));
+    csr->g = g;
+    csr->gen = g->clos->gen;
+    csr->nnodes = agnnodes(g);
+    csr->nedges = agnedges(g);
+    csr->node = agalloc(g, (csr->nnodes + 1) * sizeof(Agnode_t *));
+    csr->nseq = g->clos->seq[AGNODE] + 1;
+    csr->seqidx = agalloc(g, csr->nseq * sizeof(int));
+    csr->out = agalloc(g, (csr->nnodes + 1) * sizeof(int));
+    csr->in = agalloc(g, (csr->nnodes + 1) * sizeof(int));
+    csr->out_adj = agalloc(g, (csr->nedges + 1) * sizeof(int));
+    csr->in_adj = agalloc(g, (csr->nedges + 1) * sizeof(int));
+    csr->out_edge = agalloc(g, (csr->nedges + 1) * sizeof(Agedge_t *));
+    csr->in_edge = agalloc(g, (csr->nedges + 1) * sizeof(Agedge_t *));
+    sym = weight ? agattr(g, AGEDGE, weight, NIL(char *)) : NILsym;
+    if (sym) {
+	csr->out_wt = agalloc(g, (csr->nedges + 1) * sizeof(double));
+	csr->in_wt = agalloc(g, (csr->nedges + 1) * sizeof(double));
+    }
+
+    i = 0;
+    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	csr->seqidx[AGSEQ(n)] = i;
+	csr->node[i++] = n;
+    }
+
+    /* out-edges in one pass, counting in-degrees on the way */
+    k = 0;
+    for (i = 0; i < csr->nnodes; i++) {
+	csr->out[i] = k;
+	for (e = agfstout(g, csr->node[i]); e; e = agnxtout(g, e)) {
+	    j = csr->seqidx[AGSEQ(aghead(e))];
+	    csr->out_adj[k] = j;
+	    csr->out_edge[k] = e;
+	    if (sym)
+		csr->out_wt[k] = agcsrweight(e, sym, dflt);
+	    csr->in[j + 1]++;
+	    k++;
+	}
+    }
+    csr->out[csr->nnodes] = k;
+
+    /* in-edges by counting sort on the heads */
+    csr->in[0] = 0;
+    for (i = 0; i < csr->nnodes; i++)
+	csr->in[i + 1] += csr->in[i];
+    pos = agalloc(g, (csr->nnodes + 1) * sizeof(int));
+    memcpy(pos, csr->in, csr->nnodes * sizeof(int));
+    for (i = 0; i < csr->nnodes; i++) {
+	for (k = csr->out[i]; k < csr->out[i + 1]; k++) {
+	    j = pos[csr->out_adj[k]]++;
+	    csr->in_adj[j] = i;
+	    csr->in_edge[j] = AGOPP(csr->out_edge[k]);
+	    if (sym)
+		csr->in_wt[j] = csr->out_wt[k];
+	}
+    }
+    agfree(g, pos);
+    return csr;
+}
+
+/* agcsrvalid:
+ * Return true if the graph has not changed since csr was built.
+ */
+int agcsrvalid(Agcsr_t * csr)
+{
+    return csr->gen == csr->g->clos->gen;
+}
+
+/* agcsrindex:
+ * Return the index of n in csr, or -1 if it is not one of its nodes.
+ */
+int agcsrindex(Agcsr_t * csr, Agnode_t * n)
+{
+    int i;
+
+    if (AGSEQ(n) >= csr->nseq)
+	return -1;
+    i = csr->seqidx[AGSEQ(n)];
+    return ((i < csr->nnodes) && (csr->node[i] == n)) ? i : -1;
+}
+
+void agcsrfree(Agcsr_t * csr)
+{
+    Agraph_t *g;
+
+    if (!csr)
+	return;
+    g = csr->g;
+    agfree(g, csr->node);
+    agfree(g, csr->seqidx);
+    agfree(g, csr->out);
+    agfree(g, csr->in);
+    agfree(g, csr->out_adj);
+    agfree(g, csr->in_adj);
+    agfree(g, csr->out_edge);
+    agfree(g, csr->in_edge);
+    agfree(g, csr->out_wt);
+    agfree(g, csr->in_wt);
+    agfree(g, csr);
+}
@@ -0,0 +1,1179 @@
+/* $Id$ $Revision$ */
+/* vim:set shiftwidth=4 ts=8: */
+
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: See CVS logs. Details at http://www.graphviz.org/
+ *************************************************************************/
+
+#include <stdio.h>
+#include <cghdr.h>
+#include <agxbuf.h>
+
+#define EMPTY(s)		((s == 0) || (s)[0] == '\0')
+#define MAX(a,b)		((a)>(b)?(a):(b))
+
+/* Change logs
+ * A change log is a callback discipline on a root graph. Since the last
+ * checkpoint, it notes which objects were created or modified, which
+ * attributes were set, and which nodes were touched, meaning created,
+ * modified or given a new, changed or deleted edge. Objects are kept in
+ * bitsets by sequence number. Deleted nodes and edges are kept by name,
+ * or if they have none by position (see anonpos), so that the changes can
+ * be written out as a delta and applied to another copy of the graph with
+ * agapplydelta.
+ */
+
+typedef struct {
+    int kind;			/* AGNODE or AGEDGE */
+    char *name;			/* node name, or edge key */
+    char *tail, *head;
+    size_t pos;			/* of an anonymous object, see anonpos */
+} chgdel_t;
+
+struct Agchangelog_s {
+    Agraph_t *root;
+    Agnodeset_t *created[3], *modified[3];	/* by kind */
+    Agnodeset_t *touched;	/* nodes */
+    int cnt[3][3];		/* by kind, and new, modified, deleted */
+    unsigned char *syms[3];	/* symbols set, by kind and id */
+    int nsyms[3];
+    chgdel_t *dels;
+    int ndels, szdels;
+};
+
+#define CHGKIND(obj)	(AGTYPE(obj) == AGINEDGE ? AGEDGE : AGTYPE(obj))
+
+/* anonname:
+ * Return true if a node or edge with this name has no name or key of
+ * its own.
+ */
+static int anonname(char *name)
+{
+    return (EMPTY(name) || (name[0] == LOCALNAMEPREFIX));
+}
+
+/* anonpos:
+ * Return the position of the anonymous edge e among the anonymous edges
+ * from its tail to its head in the root graph, in order of creation.
+ * Keyed edges are found by key, but parallel anonymous edges only by
+ * position; it is the same in a copy kept up to date by deltas, as
+ * edges are created there in the same order.
+ */
+static size_t anonpos(Agedge_t * e)
+{
+    Agraph_t *root = agroot(e);
+    Agnode_t *h = AGHEAD(e);
+    Agedge_t *f;
+    size_t pos = 0;
+
+    e = AGMKOUT(e);
+    for (f = agfstout(root, AGTAIL(e)); f && f != e;
+	 f = agnxtout(root, f)) {
+	if (AGHEAD(f) == h && anonname(agnameof(f)))
+	    pos++;
+    }
+    return pos;
+}
+
+/* anonnodepos:
+ * Return the position of the anonymous node n among the anonymous nodes
+ * of the root graph, in order of creation. An anonymous node's name is
+ * made from its ID, which another copy of the graph need not share.
+ */
+static size_t anonnodepos(Agnode_t * n)
+{
+    Agraph_t *root = agroot(n);
+    Agnode_t *m;
+    size_t pos = 0;
+
+    for (m = agfstnode(root); m && m != n; m = agnxtnode(root, m)) {
+	if (anonname(agnameof(m)))
+	    pos++;
+    }
+    return pos;
+}
+
+/* anonnodefind:
+ * Return the anonymous node of g at position pos, if any.
+ */
+static Agnode_t *anonnodefind(Agraph_t * g, size_t pos)
+{
+    Agnode_t *n;
+
+    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	if (anonname(agnameof(n)) && pos-- == 0)
+	    return n;
+    }
+    return NILnode;
+}
+
+/* anonfind:
+ * Return the anonymous edge from t to h in g at position pos, if any.
+ */
+static Agedge_t *anonfind(Agraph_t * g, Agnode_t * t, Agnode_t * h,
+			  size_t pos)
+{
+    Agedge_t *e;
+
+    for (e = agfstout(g, t); e; e = agnxtout(g, e)) {
+	if (AGHEAD(e) == h && anonname(agnameof(e)) && pos-- == 0)
+	    return e;
+    }
+    return NILedge;
+}
+
+static void chgins(Agraph_t * g, Agobj_t * obj, void *arg);
+static void chgmod(Agraph_t * g, Agobj_t * obj, void *arg, Agsym_t * sym);
+static void chgdel(Agraph_t * g, Agobj_t * obj, void *arg);
+
+static Agcbdisc_t ChangeDisc = {
+    {chgins, chgmod, chgdel},	/* graph */
+    {chgins, chgmod, chgdel},	/* node */
+    {chgins, chgmod, chgdel}	/* edge */
+};
+
+static void chgopensets(Agchangelog_t * log)
+{
+    int kind;
+
+    for (kind = 0; kind < 3; kind++) {
+	log->created[kind] = agsetopen(log->root, kind);
+	log->modified[kind] = agsetopen(log->root, kind);
+    }
+    log->touched = agsetopen(log->root, AGNODE);
+}
+
+static void chgclosesets(Agchangelog_t * log)
+{
+    int kind;
+
+    for (kind = 0; kind < 3; kind++) {
+	agsetclose(log->created[kind]);
+	agsetclose(log->modified[kind]);
+    }
+    agsetclose(log->touched);
+}
+
+static void chgfreedels(Agchangelog_t * log)
+{
+    chgdel_t *d;
+    int i;
+
+    for (i = 0; i < log->ndels; i++) {
+	d = &log->dels[i];
+	agstrfree(log->root, d->name);
+	agstrfree(log->root, d->tail);
+	agstrfree(log->root, d->head);
+    }
+    log->ndels = 0;
+}
+
+static void chgfree(Agchangelog_t * log)
+{
+    int kind;
+
+    chgclosesets(log);
+    chgfreedels(log);
+    agfree(log->root, log->dels);
+    for (kind = 0; kind < 3; kind++)
+	agfree(log->root, log->syms[kind]);
+    agfree(log->root, log);
+}
+
+/* touch:
+ * Note the nodes whose layout may be affected by a change to obj.
+ */
+static void touch(Agchangelog_t * log, void *obj)
+{
+    switch (AGTYPE(obj)) {
+    case AGNODE:
+	agsetadd(log->touched, obj);
+	break;
+    case AGOUTEDGE:
+    case AGINEDGE:
+	agsetadd(log->touched, AGTAIL((Agedge_t *) obj));
+	agsetadd(log->touched, AGHEAD((Agedge_t *) obj));
+	break;
+    }
+}
+
+static void chgins(Agraph_t * g, Agobj_t * obj, void *arg)
+{
+    Agchangelog_t *log = (Agchangelog_t *) arg;
+    int kind = CHGKIND(obj);
+
+    NOTUSED(g);
+    agsetadd(log->created[kind], obj);
+    log->cnt[kind][0]++;
+    touch(log, obj);
+}
+
+static void chgmod(Agraph_t * g, Agobj_t * obj, void *arg, Agsym_t * sym)
+{
+    Agchangelog_t *log = (Agchangelog_t *) arg;
+    int kind = CHGKIND(obj);
+    int n;
+
+    NOTUSED(g);
+    agsetadd(log->modified[kind], obj);
+    log->cnt[kind][1]++;
+    touch(log, obj);
+    if (sym == NILsym)
+	return;
+    if (sym->id >= log->nsyms[kind]) {
+	n = MAX(2 * log->nsyms[kind], sym->id + 1);
+	log->syms[kind] = agrealloc(log->root, log->syms[kind],
+				    log->nsyms[kind], n);
+	log->nsyms[kind] = n;
+    }
+    log->syms[kind][sym->id] = TRUE;
+}
+
+static void chgdel(Agraph_t * g, Agobj_t * obj, void *arg)
+{
+    Agchangelog_t *log = (Agchangelog_t *) arg;
+    int kind = CHGKIND(obj);
+    chgdel_t *d;
+    Agedge_t *e;
+    char *key;
+
+    NOTUSED(g);
+    if (obj == (Agobj_t *) log->root) {
+	chgfree(log);		/* agclose pops the discipline */
+	return;
+    }
+    log->cnt[kind][2]++;
+    touch(log, obj);
+    if (kind == AGRAPH || agsethas(log->created[kind], obj))
+	return;			/* no copy has seen it */
+    if (log->ndels == log->szdels) {
+	log->szdels = log->szdels ? 2 * log->szdels : 64;
+	log->dels = agrealloc(log->root, log->dels,
+			      log->ndels * sizeof(chgdel_t),
+			      log->szdels * sizeof(chgdel_t));
+    }
+    d = &log->dels[log->ndels++];
+    d->kind = kind;
+    d->pos = 0;
+    if (kind == AGNODE) {
+	key = agnameof(obj);
+	if (anonname(key)) {
+	    key = NIL(char *);
+	    d->pos = anonnodepos((Agnode_t *) obj);
+	}
+	d->name = agstrdup(log->root, key);
+	d->tail = d->head = NIL(char *);
+    } else {
+	e = (Agedge_t *) obj;
+	key = agnameof(e);
+	if (anonname(key)) {
+	    key = NIL(char *);
+	    d->pos = anonpos(e);
+	}
+	d->name = agstrdup(log->root, key);
+	d->tail = agstrdup(log->root, agnameof(AGTAIL(e)));
+	d->head = agstrdup(log->root, agnameof(AGHEAD(e)));
+    }
+}
+
+/* agopenchanges:
+ * Start a change log on the root of g, or return the one it has.
+ */
+Agchangelog_t *agopenchanges(Agraph_t * g)
+{
+    Agchangelog_t *log;
+
+    g = agroot(g);
+    if ((log = agchanges(g)))
+	return log;
+    log = AGNEW(g, Agchangelog_t);
+    log->root = g;
+    chgopensets(log);
+    agpushdisc(g, &ChangeDisc, log);
+    return log;
+}
+
+/* agchanges:
+ * Return the change log of the root of g, if any, so that layouts
+ * can find out what changed since they last ran.
+ */
+Agchangelog_t *agchanges(Agraph_t * g)
+{
+    return (Agchangelog_t *) aggetuserptr(agroot(g), &ChangeDisc);
+}
+
+void agclosechanges(Agchangelog_t * log)
+{
+    agpopdisc(log->root, &ChangeDisc);
+    chgfree(log);
+}
+
+/* agcheckpoint:
+ * Forget the changes recorded so far.
+ */
+void agcheckpoint(Agchangelog_t * log)
+{
+    int kind;
+
+    chgclosesets(log);
+    chgopensets(log);
+    chgfreedels(log);
+    memset(log->cnt, 0, sizeof(log->cnt));
+    for (kind = 0; kind < 3; kind++)
+	if (log->nsyms[kind])
+	    memset(log->syms[kind], 0, log->nsyms[kind]);
+}
+
+/* agobjchanged:
+ * Return AGCHG_NEW if obj was created since the checkpoint, and
+ * AGCHG_MOD if it was modified.
+ */
+int agobjchanged(Agchangelog_t * log, void *obj)
+{
+    int kind = CHGKIND(obj);
+    int rv = 0;
+
+    if (agroot(obj) != log->root)
+	return 0;
+    if (agsethas(log->created[kind], obj))
+	rv |= AGCHG_NEW;
+    if (agsethas(log->modified[kind], obj))
+	rv |= AGCHG_MOD;
+    return rv;
+}
+
+/* agsymchanged:
+ * Return true if the attribute was set on some object since the
+ * checkpoint.
+ */
+int agsymchanged(Agchangelog_t * log, Agsym_t * sym)
+{
+    int kind = (sym->kind == AGINEDGE ? AGEDGE : sym->kind);
+
+    return (sym->id < log->nsyms[kind] && log->syms[kind][sym->id]);
+}
+
+/* agchangecount:
+ * Return the number of creations, modifications or deletions of
+ * objects of the given kind since the checkpoint.
+ */
+int agchangecount(Agchangelog_t * log, int kind, int what)
+{
+    int rv = 0;
+
+    if (kind == AGINEDGE)
+	kind = AGEDGE;
+    if (kind < AGRAPH || kind > AGEDGE)
+	return 0;
+    if (what & AGCHG_NEW)
+	rv += log->cnt[kind][0];
+    if (what & AGCHG_MOD)
+	rv += log->cnt[kind][1];
+    if (what & AGCHG_DEL)
+	rv += log->cnt[kind][2];
+    return rv;
+}
+
+/* agchangednodes:
+ * Return a new set of the nodes touched since the checkpoint.
+ */
+Agnodeset_t *agchangednodes(Agchangelog_t * log)
+{
+    Agnodeset_t *s;
+
+    s = agsetopen(log->root, AGNODE);
+    agsetor(s, log->touched);
+    return s;
+}
+
+/* Deltas
+ * A delta is a sequence of statements, applied in order:
+ *     graph [attr=value, ...]
+ *     node name [attr=value, ...]
+ *     new edge tail head [key=name, attr=value, ...]
+ *     edge tail head [pos] [key=name, attr=value, ...]
+ *     delete node name
+ *     delete anonymous node [pos]
+ *     delete edge tail head [pos] [key=name]
+ * Names and values are written as in DOT, and statements may end with a
+ * semicolon. Nodes are created if needed, and attributes not yet
+ * declared are declared with an empty default. Only new edge creates an
+ * edge; the others find an edge by key or, if it has none, by its
+ * position among the anonymous edges between its ends (see anonpos),
+ * which is 0 if not given. A node with no name of its own is deleted by
+ * its position among such nodes (see anonnodepos). Modifying a missing
+ * edge is an error;
+ * deleting a missing object is not. A line starting with # is a comment.
+ *
+ * The binary form starts with AGBINMAGIC, "GVD" and a version, and holds
+ * the same statements, each an opcode followed by its strings, then for
+ * an anonymous node or an edge that is not new its position, and for
+ * those that set
+ * attributes a count of attributes and their name and value strings.
+ * It ends with a zero opcode. Integers are encoded as by agwrite_binary;
+ * a string is its length + 1, times 2, plus 1 if it is an HTML string,
+ * followed by its bytes, and 0 stands for no string.
+ */
+
+#define GVD_VERSION		1
+#define GVD_MAGICLEN		4
+static char gvd_magic[] = { AGBINMAGIC, 'G', 'V', 'D', '\0' };
+
+#define DOP_END			0
+#define DOP_GRAPH		1
+#define DOP_NODE		2
+#define DOP_EDGE		3
+#define DOP_DELNODE		4
+#define DOP_DELEDGE		5
+#define DOP_NEWEDGE		6
+#define DOP_DELANON		7
+
+#define DOP_ISEDGE(op)	((op) == DOP_EDGE || (op) == DOP_DELEDGE \
+			 || (op) == DOP_NEWEDGE)
+#define DOP_HASATTRS(op)	((op) != DOP_DELNODE && (op) != DOP_DELEDGE \
+			 && (op) != DOP_DELANON)
+
+typedef struct {
+    char *s;
+    int html;
+} dstr_t;
+
+typedef struct {
+    int op;
+    dstr_t id[3];		/* node name; or tail, head and key */
+    size_t pos;			/* of an anonymous node or edge */
+    dstr_t *attr;		/* names and values */
+    int nattr, szattr;
+} dstmt_t;
+
+static void dput(agxbuf * xb, size_t v)
+{
+    unsigned char digits[2 * sizeof(size_t)];
+    int i = 0;
+
+    digits[i++] = (unsigned char) (v % 127 + 1);
+    for (v /= 127; v; v /= 127)
+	digits[i++] = (unsigned char) (0x80 | (v % 127));
+    while (i > 0)
+	agxbputc(xb, digits[--i]);
+}
+
+static void dputstr(agxbuf * xb, char *s)
+{
+    size_t len;
+
+    if (s == NIL(char *)) {
+	dput(xb, 0);
+	return;
+    }
+    len = strlen(s);
+    dput(xb, ((len + 1) << 1) | (aghtmlstr(s) ? 1 : 0));
+    agxbput_n(xb, s, len);
+}
+
+/* dputname:
+ * Write s in canonical form, quoted if need be.
+ */
+static void dputname(agxbuf * xb, char *s)
+{
+    agxbput(xb, agcanonStr(s));
+}
+
+/* dputpos:
+ * Write the position of an anonymous node or edge, if not the first.
+ */
+static void dputpos(agxbuf * xb, size_t pos)
+{
+    char buf[3 * sizeof(size_t) + 2];
+
+    if (pos) {
+	sprintf(buf, " %lu", (unsigned long) pos);
+	agxbput(xb, buf);
+    }
+}
+
+/* dputattr:
+ * Return true if sym needs to be written for obj. The graph's values
+ * are its defaults, so those that were set are written. A new object
+ * starts with the defaults, so its other values are written; an old
+ * one may also have been set back to a default.
+ */
+static int dputattr(Agchangelog_t * log, void *obj, Agsym_t * sym)
+{
+    if (AGTYPE(obj) == AGRAPH)
+	return agsymchanged(log, sym);
+    if (strcmp(agxget(obj, sym), sym->defval))
+	return TRUE;
+    return (!(agobjchanged(log, obj) & AGCHG_NEW)
+	    && agsymchanged(log, sym));
+}
+
+/* dputattrs:
+ * Write the attributes of obj as needed. In text, key, if any, comes
+ * first.
+ */
+static void dputattrs(Agchangelog_t * log, agxbuf * xb, void *obj,
+		      char *key, int binary)
+{
+    Agraph_t *root = log->root;
+    int kind = CHGKIND(obj);
+    Agsym_t *sym;
+    char *v;
+    int cnt = 0;
+
+    for (sym = agnxtattr(root, kind, NILsym); sym;
+	 sym = agnxtattr(root, kind, sym)) {
+	if (dputattr(log, obj, sym))
+	    cnt++;
+    }
+    if (binary)
+	dput(xb, cnt);
+    else if (cnt == 0 && key == NIL(char *)) {
+	agxbput(xb, ";\n");
+	return;
+    } else {
+	agxbput(xb, " [");
+	if (key) {
+	    agxbput(xb, "key=");
+	    dputname(xb, key);
+	    if (cnt)
+		agxbput(xb, ", ");
+	}
+    }
+    for (sym = agnxtattr(root, kind, NILsym); sym;
+	 sym = agnxtattr(root, kind, sym)) {
+	if (!dputattr(log, obj, sym))
+	    continue;
+	v = agxget(obj, sym);
+	if (binary) {
+	    dputstr(xb, sym->name);
+	    dputstr(xb, v);
+	} else {
+	    dputname(xb, sym->name);
+	    agxbputc(xb, '=');
+	    dputname(xb, v);
+	    if (--cnt)
+		agxbput(xb, ", ");
+	}
+    }
+    if (!binary)
+	agxbput(xb, "];\n");
+}
+
+/* agwritedelta:
+ * Write the changes since the checkpoint as a delta, in text or in
+ * binary. Nodes and edges are written with their current attributes;
+ * the root graph with those that were set. Changes to subgraphs are
+ * not written.
+ */
+int agwritedelta(Agchangelog_t * log, void *ofile, int binary)
+{
+    Agraph_t *root = log->root;
+    agxbuf xb;
+    chgdel_t *d;
+    Agnode_t *n;
+    Agedge_t *e;
+    char *key;
+    size_t pos;
+    int i, chg, rv;
+
+    agxbinit(&xb, BUFSIZ, NIL(unsigned char *));
+    if (binary) {
+	agxbput(&xb, gvd_magic);
+	dput(&xb, GVD_VERSION);
+    }
+
+    for (i = 0; i < log->ndels; i++) {
+	d = &log->dels[i];
+	if (binary) {
+	    if (d->kind == AGNODE && !d->name) {
+		dput(&xb, DOP_DELANON);
+		dput(&xb, d->pos);
+	    } else if (d->kind == AGNODE) {
+		dput(&xb, DOP_DELNODE);
+		dputstr(&xb, d->name);
+	    } else {
+		dput(&xb, DOP_DELEDGE);
+		dputstr(&xb, d->tail);
+		dputstr(&xb, d->head);
+		dputstr(&xb, d->name);
+		dput(&xb, d->pos);
+	    }
+	} else if (d->kind == AGNODE && !d->name) {
+	    agxbput(&xb, "delete anonymous node");
+	    dputpos(&xb, d->pos);
+	    agxbput(&xb, ";\n");
+	} else if (d->kind == AGNODE) {
+	    agxbput(&xb, "delete node ");
+	    dputname(&xb, d->name);
+	    agxbput(&xb, ";\n");
+	} else {
+	    agxbput(&xb, "delete edge ");
+	    dputname(&xb, d->tail);
+	    agxbputc(&xb, ' ');
+	    dputname(&xb, d->head);
+	    dputpos(&xb, d->pos);
+	    if (d->name) {
+		agxbput(&xb, " [key=");
+		dputname(&xb, d->name);
+		agxbputc(&xb, ']');
+	    }
+	    agxbput(&xb, ";\n");
+	}
+    }
+
+    if (agobjchanged(log, root) & AGCHG_MOD) {
+	if (binary)
+	    dput(&xb, DOP_GRAPH);
+	else
+	    agxbput(&xb, "graph");
+	dputattrs(log, &xb, root, NIL(char *), binary);
+    }
+    for (n = agfstnode(root); n; n = agnxtnode(root, n)) {
+	if (!agobjchanged(log, n))
+	    continue;
+	if (binary) {
+	    dput(&xb, DOP_NODE);
+	    dputstr(&xb, agnameof(n));
+	} else {
+	    agxbput(&xb, "node ");
+	    dputname(&xb, agnameof(n));
+	}
+	dputattrs(log, &xb, n, NIL(char *), binary);
+    }
+    for (n = agfstnode(root); n; n = agnxtnode(root, n)) {
+	for (e = agfstout(root, n); e; e = agnxtout(root, e)) {
+	    if (!(chg = agobjchanged(log, e)))
+		continue;
+	    key = agnameof(e);
+	    pos = 0;
+	    if (anonname(key)) {
+		key = NIL(char *);
+		if (!(chg & AGCHG_NEW))
+		    pos = anonpos(e);
+	    }
+	    if (binary) {
+		dput(&xb, (chg & AGCHG_NEW) ? DOP_NEWEDGE : DOP_EDGE);
+		dputstr(&xb, agnameof(AGTAIL(e)));
+		dputstr(&xb, agnameof(AGHEAD(e)));
+		dputstr(&xb, key);
+		if (!(chg & AGCHG_NEW))
+		    dput(&xb, pos);
+	    } else {
+		agxbput(&xb, (chg & AGCHG_NEW) ? "new edge " : "edge ");
+		dputname(&xb, agnameof(AGTAIL(e)));
+		agxbputc(&xb, ' ');
+		dputname(&xb, agnameof(AGHEAD(e)));
+		dputpos(&xb, pos);
+	    }
+	    dputattrs(log, &xb, e, key, binary);
+	}
+    }
+    if (binary)
+	dput(&xb, DOP_END);
+
+    rv = AGDISC(root, io)->putstr(ofile, agxbuse(&xb));
+    if (rv != EOF)
+	rv = AGDISC(root, io)->flush(ofile);
+    agxbfree(&xb);
+    return (rv == EOF ? EOF : 0);
+}
+
+
+/* Reading deltas
+ * Both forms are read into a dstmt_t, one statement at a time.
+ */
+typedef struct {
+    unsigned char *p;
+    unsigned char *end;
+    int line;
+    int bol;			/* at the beginning of a line */
+    int err;
+    int unget;			/* return the last token again */
+    int last;
+    agxbuf tok;
+    dstr_t t;			/* last name read; t.s points into tok */
+} drdr_t;
+
+static void dclear(dstmt_t * st)
+{
+    int i;
+
+    for (i = 0; i < 3; i++)
+	free(st->id[i].s);
+    for (i = 0; i < st->nattr; i++)
+	free(st->attr[i].s);
+    memset(st->id, 0, sizeof(st->id));
+    st->nattr = 0;
+}
+
+static void dsave(dstr_t * d, dstr_t * t)
+{
+    free(d->s);
+    d->s = t->s ? strdup(t->s) : NIL(char *);
+    d->html = t->html;
+}
+
+static void daddattr(dstmt_t * st, dstr_t * name, dstr_t * value)
+{
+    if (st->nattr + 2 > st->szattr) {
+	st->szattr = st->szattr ? 2 * st->szattr : 16;
+	st->attr = realloc(st->attr, st->szattr * sizeof(dstr_t));
+    }
+    memset(st->attr + st->nattr, 0, 2 * sizeof(dstr_t));
+    dsave(&st->attr[st->nattr++], name);
+    dsave(&st->attr[st->nattr++], value);
+}
+
+#define DT_EOF		0
+#define DT_NAME		'a'
+
+/* dlex:
+ * Return the next token of a text delta: DT_EOF, DT_NAME with the name
+ * in rd->t, or one of the characters []=,;
+ */
+static int dlex(drdr_t * rd)
+{
+    unsigned char *p = rd->p;
+    int c, nest;
+
+    if (rd->unget) {
+	rd->unget = FALSE;
+	return rd->last;
+    }
+    agxbclear(&rd->tok);
+    rd->t.html = FALSE;
+    for (;;) {
+	while (p < rd->end && isspace(*p)) {
+	    if (*p++ == '\n') {
+		rd->line++;
+		rd->bol = TRUE;
+	    }
+	}
+	if (p < rd->end && *p == '#' && rd->bol) {
+	    while (p < rd->end && *p != '\n')
+		p++;
+	    continue;
+	}
+	break;
+    }
+    rd->bol = FALSE;
+    if (p >= rd->end) {
+	rd->p = p;
+	return (rd->last = DT_EOF);
+    }
+    c = *p++;
+    switch (c) {
+    case '[':
+    case ']':
+    case '=':
+    case ',':
+    case ';':
+	rd->p = p;
+	return (rd->last = c);
+    case '"':
+	while (p < rd->end && *p != '"') {
+	    if (*p == '\\' && p + 1 < rd->end) {
+		if (p[1] == '"') {
+		    agxbputc(&rd->tok, '"');
+		    p += 2;
+		    continue;
+		} else if (p[1] == '\n') {
+		    rd->line++;
+		    p += 2;
+		    continue;
+		}
+	    }
+	    if (*p == '\n')
+		rd->line++;
+	    agxbputc(&rd->tok, *p++);
+	}
+	if (p >= rd->end)
+	    rd->err = TRUE;
+	else
+	    p++;
+	break;
+    case '<':
+	for (nest = 1; p < rd->end; p++) {
+	    if (*p == '<')
+		nest++;
+	    else if (*p == '>' && --nest == 0)
+		break;
+	    else if (*p == '\n')
+		rd->line++;
+	    agxbputc(&rd->tok, *p);
+	}
+	if (p >= rd->end)
+	    rd->err = TRUE;
+	else
+	    p++;
+	rd->t.html = TRUE;
+	break;
+    default:
+	agxbputc(&rd->tok, c);
+	while (p < rd->end && !isspace(*p) && !strchr("[]=,;\"<", *p))
+	    agxbputc(&rd->tok, *p++);
+	break;
+    }
+    rd->p = p;
+    rd->t.s = agxbuse(&rd->tok);
+    return (rd->last = DT_NAME);
+}
+
+/* dattrs:
+ * Read an optional attribute list. An edge key is kept as the third name.
+ */
+static void dattrs(drdr_t * rd, dstmt_t * st)
+{
+    dstr_t name;
+    int tok;
+
+    if (dlex(rd) != '[') {
+	rd->unget = TRUE;
+	return;
+    }
+    name.s = NIL(char *);
+    while ((tok = dlex(rd)) == DT_NAME) {
+	dsave(&name, &rd->t);
+	if (dlex(rd) != '=' || dlex(rd) != DT_NAME) {
+	    rd->err = TRUE;
+	    break;
+	}
+	if (streq(name.s, "key") && DOP_ISEDGE(st->op))
+	    dsave(&st->id[2], &rd->t);
+	else
+	    daddattr(st, &name, &rd->t);
+	if ((tok = dlex(rd)) != ',' && tok != ';')
+	    break;
+    }
+    free(name.s);
+    if (tok != ']')
+	rd->err = TRUE;
+}
+
+/* dread_text:
+ * Read a statement; return FALSE at the end or on error.
+ */
+static int dread_text(drdr_t * rd, dstmt_t * st)
+{
+    int tok, i, nids, del = FALSE, new = FALSE, anon = FALSE;
+    char *endp;
+
+    do
+	tok = dlex(rd);
+    while (tok == ';');
+    if (tok == DT_EOF)
+	return FALSE;
+    if (tok == DT_NAME && streq(rd->t.s, "delete")) {
+	del = TRUE;
+	tok = dlex(rd);
+	if (tok == DT_NAME && streq(rd->t.s, "anonymous")) {
+	    anon = TRUE;
+	    tok = dlex(rd);
+	}
+    } else if (tok == DT_NAME && streq(rd->t.s, "new")) {
+	new = TRUE;
+	tok = dlex(rd);
+    }
+    st->op = -1;
+    if (tok == DT_NAME) {
+	if (streq(rd->t.s, "graph") && !del && !new)
+	    st->op = DOP_GRAPH;
+	else if (streq(rd->t.s, "node") && anon)
+	    st->op = DOP_DELANON;
+	else if (streq(rd->t.s, "node") && !new)
+	    st->op = del ? DOP_DELNODE : DOP_NODE;
+	else if (streq(rd->t.s, "edge") && !anon)
+	    st->op = del ? DOP_DELEDGE : new ? DOP_NEWEDGE : DOP_EDGE;
+    }
+    switch (st->op) {
+    case DOP_GRAPH:
+    case DOP_DELANON:
+	nids = 0;
+	break;
+    case DOP_NODE:
+    case DOP_DELNODE:
+	nids = 1;
+	break;
+    case DOP_EDGE:
+    case DOP_DELEDGE:
+    case DOP_NEWEDGE:
+	nids = 2;
+	break;
+    default:
+	rd->err = TRUE;
+	return FALSE;
+    }
+    for (i = 0; i < nids; i++) {
+	if (dlex(rd) != DT_NAME) {
+	    rd->err = TRUE;
+	    return FALSE;
+	}
+	dsave(&st->id[i], &rd->t);
+    }
+    st->pos = 0;
+    if (st->op == DOP_EDGE || st->op == DOP_DELEDGE
+	|| st->op == DOP_DELANON) {
+	if (dlex(rd) == DT_NAME && !rd->t.html && isdigit((unsigned char) rd->t.s[0])) {
+	    st->pos = strtoul(rd->t.s, &endp, 10);
+	    if (*endp)
+		rd->err = TRUE;
+	} else
+	    rd->unget = TRUE;
+    }
+    if (st->op != DOP_DELNODE && st->op != DOP_DELANON)
+	dattrs(rd, st);
+    return !rd->err;
+}
+
+static size_t dget(drdr_t * rd)
+{
+    size_t v = 0;
+    unsigned char c;
+
+    while (rd->p < rd->end) {
+	c = *rd->p++;
+	if (v > (SIZE_MAX - 127) / 127)
+	    break;
+	if (!(c & 0x80))
+	    return v * 127 + (size_t) (c - 1);
+	v = v * 127 + (c & 0x7F);
+    }
+    rd->err = TRUE;
+    return 0;
+}
+
+static void dgetstr(drdr_t * rd, dstr_t * d)
+{
+    size_t v = dget(rd), len;
+
+    free(d->s);
+    d->s = NIL(char *);
+    d->html = FALSE;
+    if (v == 0 || rd->err)
+	return;
+    len = (v >> 1) - 1;
+    if (len > (size_t) (rd->end - rd->p)) {
+	rd->err = TRUE;
+	return;
+    }
+    d->s = malloc(len + 1);
+    memcpy(d->s, rd->p, len);
+    d->s[len] = '\0';
+    d->html = (int) (v & 1);
+    rd->p += len;
+}
+
+/* dread_binary:
+ * Read a statement; return FALSE at the end or on error.
+ */
+static int dread_binary(drdr_t * rd, dstmt_t * st)
+{
+    dstr_t name, value;
+    size_t i, cnt;
+
+    st->op = (int) dget(rd);
+    switch (st->op) {
+    case DOP_END:
+	return FALSE;
+    case DOP_GRAPH:
+	break;
+    case DOP_NODE:
+    case DOP_DELNODE:
+	dgetstr(rd, &st->id[0]);
+	break;
+    case DOP_DELANON:
+	st->pos = dget(rd);
+	break;
+    case DOP_EDGE:
+    case DOP_DELEDGE:
+    case DOP_NEWEDGE:
+	for (i = 0; i < 3; i++)
+	    dgetstr(rd, &st->id[i]);
+	st->pos = (st->op == DOP_NEWEDGE) ? 0 : dget(rd);
+	break;
+    default:
+	rd->err = TRUE;
+	return FALSE;
+    }
+    if (DOP_HASATTRS(st->op)) {
+	cnt = dget(rd);
+	if (cnt > (size_t) (rd->end - rd->p))
+	    rd->err = TRUE;
+	name.s = value.s = NIL(char *);
+	for (i = 0; i < cnt && !rd->err; i++) {
+	    dgetstr(rd, &name);
+	    dgetstr(rd, &value);
+	    if (name.s && value.s)
+		daddattr(st, &name, &value);
+	    else
+		rd->err = TRUE;
+	}
+	free(name.s);
+	free(value.s);
+    }
+    if (st->op != DOP_GRAPH && st->op != DOP_DELANON
+	&& st->id[0].s == NIL(char *))
+	rd->err = TRUE;
+    if (DOP_ISEDGE(st->op) && st->id[1].s == NIL(char *))
+	rd->err = TRUE;
+    return !rd->err;
+}
+
+/* dsetattrs:
+ * Set the attributes of a statement on obj, declaring them if needed.
+ */
+static void dsetattrs(dstmt_t * st, void *obj)
+{
+    Agraph_t *root = agroot(obj);
+    int kind = CHGKIND(obj);
+    Agsym_t *sym;
+    char *v;
+    int i;
+
+    for (i = 0; i + 1 < st->nattr; i += 2) {
+	sym = agattr(root, kind, st->attr[i].s, NIL(char *));
+	if (!sym)
+	    sym = agattr(root, kind, st->attr[i].s, "");
+	if (st->attr[i + 1].html) {
+	    v = agstrdup_html(root, st->attr[i + 1].s);
+	    agxset(obj, sym, v);
+	    agstrfree(root, v);
+	} else
+	    agxset(obj, sym, st->attr[i + 1].s);
+    }
+}
+
+static char *dname(Agraph_t * g, dstr_t * d)
+{
+    return d->html ? agstrdup_html(g, d->s) : d->s;
+}
+
+static void dfreename(Agraph_t * g, dstr_t * d, char *s)
+{
+    if (d->html)
+	agstrfree(g, s);
+}
+
+static Agnode_t *dnode(Agraph_t * g, dstr_t * d, int cflag)
+{
+    Agnode_t *n;
+    char *s = dname(g, d);
+
+    n = agnode(g, s, cflag);
+    dfreename(g, d, s);
+    return n;
+}
+
+/* dapply:
+ * Apply a statement to g; return FALSE if it cannot be applied.
+ */
+static int dapply(Agraph_t * g, dstmt_t * st)
+{
+    Agnode_t *t, *h;
+    Agedge_t *e;
+    int cflag = (st->op == DOP_NODE || st->op == DOP_NEWEDGE);
+
+    switch (st->op) {
+    case DOP_GRAPH:
+	dsetattrs(st, g);
+	break;
+    case DOP_NODE:
+    case DOP_DELNODE:
+	if ((t = dnode(g, &st->id[0], cflag))) {
+	    if (cflag)
+		dsetattrs(st, t);
+	    else
+		agdelnode(g, t);
+	}
+	break;
+    case DOP_DELANON:
+	if ((t = anonnodefind(g, st->pos)))
+	    agdelnode(g, t);
+	break;
+    case DOP_NEWEDGE:
+	t = dnode(g, &st->id[0], TRUE);
+	h = dnode(g, &st->id[1], TRUE);
+	if (!t || !h || !(e = agedge(g, t, h, st->id[2].s, TRUE)))
+	    return FALSE;
+	dsetattrs(st, e);
+	break;
+    case DOP_EDGE:
+    case DOP_DELEDGE:
+	t = dnode(g, &st->id[0], FALSE);
+	h = dnode(g, &st->id[1], FALSE);
+	if (!t || !h)
+	    e = NILedge;
+	else if (st->id[2].s)
+	    e = agedge(g, t, h, st->id[2].s, FALSE);
+	else
+	    e = anonfind(g, t, h, st->pos);
+	if (st->op == DOP_DELEDGE) {
+	    if (e)
+		agdeledge(g, e);
+	} else if (e)
+	    dsetattrs(st, e);
+	else
+	    return FALSE;
+	break;
+    }
+    return TRUE;
+}
+
+/* agapplydelta:
+ * Apply a delta, in text or in binary, to g. Nodes and edges are
+ * created in g, and deleted from g. Statements are applied as they are
+ * read, so a malformed delta may be applied in part. Return the number
+ * of statements applied, or -1 on error.
+ */
+int agapplydelta(Agraph_t * g, char *delta, size_t len)
+{
+    drdr_t rd;
+    dstmt_t st;
+    int binary, cnt = 0;
+
+    memset(&rd, 0, sizeof(rd));
+    memset(&st, 0, sizeof(st));
+    rd.p = (unsigned char *) delta;
+    rd.end = rd.p + len;
+    rd.line = 1;
+    rd.bol = TRUE;
+    binary = (len >= GVD_MAGICLEN && !memcmp(delta, gvd_magic, GVD_MAGICLEN));
+    if (binary) {
+	rd.p += GVD_MAGICLEN;
+	if (dget(&rd) != GVD_VERSION) {
+	    agerr(AGERR, "agapplydelta: unsupported version\n");
+	    return -1;
+	}
+    } else
+	agxbinit(&rd.tok, BUFSIZ, NIL(unsigned char *));
+
+    while (binary ? dread_binary(&rd, &st) : dread_text(&rd, &st)) {
+	if (!dapply(g, &st)) {
+	    rd.err = TRUE;
+	    break;
+	}
+	dclear(&st);
+	cnt++;
+    }
+    dclear(&st);
+    free(st.attr);
+    if (!binary)
+	agxbfree(&rd.tok);
+
+    if (rd.err) {
+	if (binary)
+	    agerr(AGERR, "agapplydelta: malformed input after %d statements\n",
+		  cnt);
+	else
+	    agerr(AGERR, "agapplydelta: syntax error in line %d\n", rd.line);
+	return -1;
+    }
+    return cnt;
+}
@@ -125,6 +125,8 @@ static Agedge_t *agfindedge_by_key(Agraph_t * g, Agnode_t * t, Agnode_t * h,
     template.node = t;		/* guess that fan-in < fan-out */
     sn = agsubrep(g, h);
     if (!sn) e = 0;
+    else if (agedgeindex_check(g, sn->in_deg))
+	e = agedgeindex_find(g, t, h, key);
     else {
 #if 0
 	if (t != h) {
@@ -154,6 +156,35 @@ static Agedge_t *agfindedge_by_id(Agraph_t * g, Agnode_t * t, Agnode_t * h,
     return agfindedge_by_key(g, t, h, tag);
 }
 
+/* keyed edge lookup under AgDenseIdDisc, which gives every edge its own
+ * ID and keeps the keys itself: scan the shorter of the edge sets of t
+ * and h for an edge between them with the given key.
+ */
+static Agedge_t *agfindedge_by_name(Agraph_t * g, Agnode_t * t,
+				    Agnode_t * h, char *name)
+{
+    Agedge_t *e;
+    Agsubnode_t *tsn, *hsn;
+    char *key;
+
+    if ((t == NILnode) || (h == NILnode) || !(key = agstrbind(g, name)))
+	return NILedge;
+    if (!(tsn = agsubrep(g, t)) || !(hsn = agsubrep(g, h)))
+	return NILedge;
+    if (tsn->out_deg <= hsn->in_deg) {
+	for (e = agfstout(g, t); e; e = agnxtout(g, e))
+	    if ((aghead(e) == h) && (AGDISC(g, id)->print(AGCLOS(g, id),
+				AGEDGE, AGID(e)) == key))
+		return e;
+    } else {
+	for (e = agfstin(g, h); e; e = agnxtin(g, e))
+	    if ((agtail(e) == t) && (AGDISC(g, id)->print(AGCLOS(g, id),
+				AGEDGE, AGID(e)) == key))
+		return AGMKOUT(e);
+    }
+    return NILedge;
+}
+
 Agsubnode_t *agsubrep(Agraph_t * g, Agnode_t * n)
 {
     Agsubnode_t *sn, template;
@@ -182,43 +213,59 @@ static void del(Dict_t * d, Dtlink_t ** set, Agedge_t * e)
     *set = dtextract(d);
 }
 
-static void installedge(Agraph_t * g, Agedge_t * e)
+/* insedge:
+ * Insert the edge e into the sets of its endpoints in g.
+ */
+static void insedge(Agraph_t * g, Agedge_t * e)
 {
-    Agnode_t *t, *h;
     Agedge_t *out, *in;
     Agsubnode_t *sn;
 
     out = AGMKOUT(e);
     in = AGMKIN(e);
+    sn = agsubrep(g, in->node);
+    ins(g->e_seq, &sn->out_seq, out);
+    ins(g->e_id, &sn->out_id, out);
+    sn->out_deg++;
+    sn = agsubrep(g, out->node);
+    ins(g->e_seq, &sn->in_seq, in);
+    ins(g->e_id, &sn->in_id, in);
+    sn->in_deg++;
+    agedgeindex_insert(g, out);
+    g->clos->gen++;
+}
+
+static void installedge(Agraph_t * g, Agedge_t * e)
+{
+    Agnode_t *t, *h;
+
     t = agtail(e);
     h = aghead(e);
     while (g) {
 	if (agfindedge_by_key(g, t, h, AGTAG(e))) break;
-	sn = agsubrep(g, t);
-	ins(g->e_seq, &sn->out_seq, out);
-	ins(g->e_id, &sn->out_id, out);
-	sn = agsubrep(g, h);
-	ins(g->e_seq, &sn->in_seq, in);
-	ins(g->e_id, &sn->in_id, in);
+	insedge(g, e);
 	g = agparent(g);
     }
 }
 
 static void subedge(Agraph_t * g, Agedge_t * e)
 {
+    (void)agsubnode(g, agtail(e), TRUE);
+    (void)agsubnode(g, aghead(e), TRUE);
     installedge(g, e);
     /* might an init method call be needed here? */
 }
 
-static Agedge_t *newedge(Agraph_t * g, Agnode_t * t, Agnode_t * h,
+/* allocedge:
+ * Make an edge from t to h, not yet installed in any graph.
+ */
+static Agedge_t *allocedge(Agraph_t * g, Agnode_t * t, Agnode_t * h,
              IDTYPE id)
 {
     Agedgepair_t *e2;
     Agedge_t *in, *out;
     int seq;
 
-    (void)agsubnode(g,t,TRUE);
-    (void)agsubnode(g,h,TRUE);
     e2 = (Agedgepair_t *) agalloc(g, sizeof(Agedgepair_t));
     in = &(e2->in);
     out = &(e2->out);
@@ -229,13 +276,32 @@ static Agedge_t *newedge(Agraph_t * g, Agnode_t * t, Agnode_t * h,
     AGSEQ(in) = AGSEQ(out) = seq;
     in->node = t;
     out->node = h;
+    return out;
+}
 
-    installedge(g, out);
+static void initedge(Agraph_t * g, Agedge_t * out)
+{
     if (g->desc.has_attrs) {
 	(void) agbindrec(out, AgDataRecName, sizeof(Agattr_t), FALSE);
 	agedgeattr_init(g, out);
     }
     agmethod_init(g, out);
+}
+
+static Agedge_t *newedge(Agraph_t * g, Agnode_t * t, Agnode_t * h,
+             IDTYPE id)
+{
+    Agraph_t *par;
+    Agedge_t *out;
+
+    if (g != agroot(g)) {	/* nodes are always in the root */
+	(void)agsubnode(g,t,TRUE);
+	(void)agsubnode(g,h,TRUE);
+    }
+    out = allocedge(g, t, h, id);
+    for (par = g; par; par = agparent(par))	/* in none of them yet */
+	insedge(par, out);
+    initedge(g, out);
     return out;
 }
 
@@ -285,7 +351,23 @@ Agedge_t *agedge(Agraph_t * g, Agnode_t * t, Agnode_t * h, char *name,
     IDTYPE my_id;
     int have_id;
 
-    have_id = agmapnametoid(g, AGEDGE, name, &my_id, FALSE);
+    if (name && (AGDISC(g, id) == &AgDenseIdDisc)) {
+	/* keys are not IDs here; see AgDenseIdDisc */
+	e = agfindedge_by_name(g, t, h, name);
+	if ((e == NILedge) && agisundirected(g))
+	    e = agfindedge_by_name(g, h, t, name);
+	if ((e == NILedge) && cflag && (g != agroot(g))) {
+	    e = agfindedge_by_name(agroot(g), t, h, name);
+	    if ((e == NILedge) && agisundirected(g))
+		e = agfindedge_by_name(agroot(g), h, t, name);
+	    if (e)
+		subedge(g, e);
+	}
+	if (e || !cflag)
+	    return e;
+	have_id = FALSE;
+    } else
+	have_id = agmapnametoid(g, AGEDGE, name, &my_id, FALSE);
     if (have_id || ((name == NILstr) && (NOT(cflag) || agisstrict(g)))) {
 	/* probe for pre-existing edge */
 	Agtag_t key;
@@ -324,6 +406,174 @@ Agedge_t *agedge(Agraph_t * g, Agnode_t * t, Agnode_t * h, char *name,
     return e;
 }
 
+/* Bulk construction
+ * agedges_bulk makes the anonymous edges of a batch without installing
+ * them, and then adds them to each graph up to the root a node at a time:
+ * the edges are grouped by the node whose edge sets hold them (the tail
+ * for out-edges, the head for in-edges), so that each set is restored
+ * and extracted once per batch rather than once per edge. New anonymous
+ * edges in a graph that is not strict cannot already exist, so the usual
+ * search is skipped. Other edges go through agedge, after the pending
+ * ones are installed.
+ */
+#define OWNER(e)	(AGOPP(e)->node)
+
+/* groupedges:
+ * Stable counting sort of the cnt edges in list into sorted, by the
+ * sequence number of their owner; edges keep their sequence order
+ * within a group. count has room for all node sequence numbers.
+ */
+static void groupedges(Agedge_t ** list, Agedge_t ** sorted, int cnt,
+		       int *count, uint64_t nseq)
+{
+    uint64_t s;
+    int i, c, sum;
+
+    memset(count, 0, (nseq + 1) * sizeof(int));
+    for (i = 0; i < cnt; i++)
+	count[AGSEQ(OWNER(list[i]))]++;
+    sum = 0;
+    for (s = 0; s <= nseq; s++) {
+	c = count[s];
+	count[s] = sum;
+	sum += c;
+    }
+    for (i = 0; i < cnt; i++)
+	sorted[count[AGSEQ(OWNER(list[i]))]++] = list[i];
+}
+
+/* insset:
+ * Insert the cnt edges of list, all out-edges or all in-edges grouped
+ * by owner, into the owners' sets in g.
+ */
+static void insset(Agraph_t * g, Agedge_t ** list, int cnt)
+{
+    Agsubnode_t *sn;
+    Dtlink_t **seqset, **idset;
+    Agnode_t *n;
+    int i, j, out, *deg;
+
+    out = (cnt > 0) && (AGTYPE(list[0]) == AGOUTEDGE);
+    for (i = 0; i < cnt; i = j) {
+	n = OWNER(list[i]);
+	sn = agsubrep(g, n);
+	if (out) {
+	    seqset = &sn->out_seq;
+	    idset = &sn->out_id;
+	    deg = &sn->out_deg;
+	} else {
+	    seqset = &sn->in_seq;
+	    idset = &sn->in_id;
+	    deg = &sn->in_deg;
+	}
+	dtrestore(g->e_seq, *seqset);
+	for (j = i; (j < cnt) && (OWNER(list[j]) == n); j++)
+	    dtinsert(g->e_seq, list[j]);
+	*seqset = dtextract(g->e_seq);
+	dtrestore(g->e_id, *idset);
+	for (j = i; (j < cnt) && (OWNER(list[j]) == n); j++)
+	    dtinsert(g->e_id, list[j]);
+	*idset = dtextract(g->e_id);
+	*deg += j - i;
+	if (out)
+	    for (j = i; (j < cnt) && (OWNER(list[j]) == n); j++)
+		agedgeindex_insert(g, list[j]);
+    }
+}
+
+/* installedges:
+ * Like installedge for each of the cnt new edges in list, which are
+ * then initialized in order.
+ */
+static void installedges(Agraph_t * g, Agedge_t ** list, int cnt)
+{
+    Agraph_t *sg;
+    Agedge_t **outs, **ins;
+    uint64_t nseq;
+    int i, *count;
+
+    nseq = g->clos->seq[AGNODE];
+    count = agalloc(g, (nseq + 1) * sizeof(int));
+    outs = agalloc(g, 2 * cnt * sizeof(Agedge_t *));
+    ins = outs + cnt;
+    groupedges(list, outs, cnt, count, nseq);
+    for (i = 0; i < cnt; i++)
+	list[i] = AGOUT2IN(list[i]);
+    groupedges(list, ins, cnt, count, nseq);
+    for (i = 0; i < cnt; i++)
+	list[i] = AGIN2OUT(list[i]);
+    for (sg = g; sg; sg = agparent(sg)) {
+	insset(sg, outs, cnt);
+	insset(sg, ins, cnt);
+	sg->clos->gen++;
+    }
+    agfree(g, count);
+    agfree(g, outs);
+    for (i = 0; i < cnt; i++)
+	initedge(g, list[i]);
+}
+
+/* agedges_bulk:
+ * Find or create the edges tails[i] -> heads[i] for i in 0..cnt-1, with
+ * names keys[i] if keys is not NULL, as agedge would, storing them in
+ * edges if it is not NULL. The endpoints must belong to the root of g,
+ * and are added to g if necessary. Edges are numbered in array order,
+ * but the init callbacks of consecutive new anonymous edges are only
+ * invoked after all of them have been installed.
+ * Returns SUCCESS, or FAILURE if some edge could not be created, in
+ * which case its entry in edges is NULL.
+ */
+int agedges_bulk(Agraph_t * g, int cnt, Agnode_t ** tails,
+		 Agnode_t ** heads, char **keys, Agedge_t ** edges)
+{
+    Agraph_t *root;
+    Agnode_t *t, *h;
+    Agedge_t *e, **list;
+    IDTYPE id;
+    char *key;
+    int i, nnew, rv;
+
+    if (cnt <= 0)
+	return SUCCESS;
+    root = agroot(g);
+    list = agalloc(g, cnt * sizeof(Agedge_t *));
+    nnew = 0;
+    rv = SUCCESS;
+
+    for (i = 0; i < cnt; i++) {
+	t = tails[i];
+	h = heads[i];
+	key = keys ? keys[i] : NILstr;
+	e = NILedge;
+	if (!t || !h || (t->root != root) || (h->root != root))
+	    ;
+	else if (key || agisstrict(g)) {
+	    if (nnew > 0) {
+		installedges(g, list, nnew);
+		nnew = 0;
+	    }
+	    e = agedge(g, t, h, key, TRUE);
+	} else if (!(g->desc.no_loop && (t == h))
+		   && agmapnametoid(g, AGEDGE, NILstr, &id, TRUE)) {
+	    if (g != root) {
+		(void) agsubnode(g, t, TRUE);
+		(void) agsubnode(g, h, TRUE);
+	    }
+	    e = allocedge(g, t, h, id);
+	    list[nnew++] = e;
+	}
+	if (!e)
+	    rv = FAILURE;
+	if (edges)
+	    edges[i] = e;
+    }
+
+    if (nnew > 0)
+	installedges(g, list, nnew);
+    agfree(g, list);
+    return rv;
+}
+
 void agdeledgeimage(Agraph_t * g, Agedge_t * e, void *ignored)
 {
     Agedge_t *in, *out;
@@ -343,9 +593,13 @@ void agdeledgeimage(Agraph_t * g, Agedge_t * e, void *ignored)
     sn = agsubrep(g, t);
     del(g->e_seq, &sn->out_seq, out);
     del(g->e_id, &sn->out_id, out);
+    sn->out_deg--;
     sn = agsubrep(g, h);
     del(g->e_seq, &sn->in_seq, in);
     del(g->e_id, &sn->in_id, in);
+    sn->in_deg--;
+    agedgeindex_delete(g, out);
+    g->clos->gen++;
 #ifdef DEBUG
     for (e = agfstin(g,h); e; e = agnxtin(g,e))
 	assert(e != in);
@@ -0,0 +1,181 @@
+/* $Id$ $Revision$ */
+/* vim:set shiftwidth=4 ts=8: */
+
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: See CVS logs. Details at http://www.graphviz.org/
+ *************************************************************************/
+
+#include <cghdr.h>
+
+/* Hashed edge lookup
+ * Edges are found by searching the ID set of the head, a splay tree
+ * whose searches take a logarithmic number of scattered comparisons,
+ * and reorganize it, so that checking for an edge at a node with a very
+ * large degree, as strict graphs and named edges require, is slow. The
+ * first time a set of more than EDGEINDEX_MINDEG edges is searched, the
+ * graph is given an index of all its edges, hashed on their endpoints,
+ * which is kept up to date as edges are added and removed. Graphs that
+ * only add anonymous edges never pay for one.
+ * The table uses linear probing with backward shift deletion, so all
+ * the edges between the same pair of nodes are found in one run. Each
+ * slot keeps the hash of its edge, so probes seldom touch other edges.
+ */
+
+#define EDGEINDEX_MINDEG	1024
+#define EDGEINDEX_MINSIZE	1024	/* a power of 2 */
+
+typedef struct {
+    Agedge_t *e;		/* out-edge, or NULL if empty */
+    size_t hash;		/* of its endpoints */
+} eslot_t;
+
+struct Agedgeindex_s {
+    eslot_t *slot;
+    size_t size;		/* a power of 2, at least twice cnt */
+    size_t cnt;
+};
+
+static size_t ehash(Agnode_t * t, Agnode_t * h)
+{
+    uint64_t k;
+
+    k = AGSEQ(t) * 0x9E3779B97F4A7C15ULL ^ AGSEQ(h) * 0xC2B2AE3D27D4EB4FULL;
+    return (size_t) (k ^ (k >> 29));
+}
+
+static void eput(Agedgeindex_t * ix, Agedge_t * e, size_t hash)
+{
+    size_t i, mask = ix->size - 1;
+
+    for (i = hash & mask; ix->slot[i].e; i = (i + 1) & mask);
+    ix->slot[i].e = e;
+    ix->slot[i].hash = hash;
+    ix->cnt++;
+}
+
+static void egrow(Agraph_t * g, Agedgeindex_t * ix, size_t size)
+{
+    eslot_t *old = ix->slot;
+    size_t i, osize = ix->size;
+
+    ix->slot = agalloc(g, size * sizeof(eslot_t));
+    ix->size = size;
+    ix->cnt = 0;
+    for (i = 0; i < osize; i++)
+	if (old[i].e)
+	    eput(ix, old[i].e, old[i].hash);
+    agfree(g, old);
+}
+
+/* agedgeindex_build:
+ * Index all the edges of g.
+ */
+static void agedgeindex_build(Agraph_t * g)
+{
+    Agedgeindex_t *ix;
+    Agnode_t *n;
+    Agedge_t *e;
+    size_t size, nedges;
+
+    nedges = 0;
+    for (n = agfstnode(g); n; n = agnxtnode(g, n))
+	nedges += agsubrep(g, n)->out_deg;
+    for (size = EDGEINDEX_MINSIZE; size < 2 * nedges; size *= 2);
+    ix = agalloc(g, sizeof(Agedgeindex_t));
+    ix->slot = agalloc(g, size * sizeof(eslot_t));
+    ix->size = size;
+    for (n = agfstnode(g); n; n = agnxtnode(g, n))
+	for (e = agfstout(g, n); e; e = agnxtout(g, e))
+	    eput(ix, e, ehash(n, aghead(e)));
+    g->e_index = ix;
+}
+
+/* agedgeindex_check:
+ * Return true if edges in g should be found through its index, which
+ * is built when a set of more than EDGEINDEX_MINDEG edges is searched.
+ */
+int agedgeindex_check(Agraph_t * g, int deg)
+{
+    if (!g->e_index && (deg > EDGEINDEX_MINDEG))
+	agedgeindex_build(g);
+    return g->e_index != NIL(Agedgeindex_t *);
+}
+
+/* agedgeindex_insert:
+ * Add the out-edge e, just installed in g, to its index if any.
+ */
+void agedgeindex_insert(Agraph_t * g, Agedge_t * e)
+{
+    Agedgeindex_t *ix = g->e_index;
+
+    if (!ix)
+	return;
+    if (2 * (ix->cnt + 1) > ix->size)
+	egrow(g, ix, 2 * ix->size);
+    eput(ix, e, ehash(AGOUT2IN(e)->node, e->node));
+}
+
+/* agedgeindex_delete:
+ * Remove the out-edge e from the index of g.
+ */
+void agedgeindex_delete(Agraph_t * g, Agedge_t * e)
+{
+    Agedgeindex_t *ix = g->e_index;
+    size_t i, j, k, mask;
+
+    if (!ix)
+	return;
+    mask = ix->size - 1;
+    i = ehash(AGOUT2IN(e)->node, e->node) & mask;
+    while (ix->slot[i].e && (ix->slot[i].e != e))
+	i = (i + 1) & mask;
+    if (!ix->slot[i].e)
+	return;
+    /* move later members of the run back into the hole */
+    for (j = (i + 1) & mask; ix->slot[j].e; j = (j + 1) & mask) {
+	k = ix->slot[j].hash & mask;
+	if (((j > i) && ((k <= i) || (k > j)))
+	    || ((j < i) && (k <= i) && (k > j))) {
+	    ix->slot[i] = ix->slot[j];
+	    i = j;
+	}
+    }
+    ix->slot[i].e = NILedge;
+    ix->cnt--;
+}
+
+/* agedgeindex_find:
+ * Return the in-edge from t to h with the given key, as the search of
+ * the ID sets would, or NULL. An objtype of 0 in key matches any ID.
+ */
+Agedge_t *agedgeindex_find(Agraph_t * g, Agnode_t * t, Agnode_t * h,
+			   Agtag_t key)
+{
+    Agedgeindex_t *ix = g->e_index;
+    Agedge_t *e;
+    size_t i, hash, mask = ix->size - 1;
+
+    hash = ehash(t, h);
+    for (i = hash & mask; (e = ix->slot[i].e); i = (i + 1) & mask) {
+	if ((ix->slot[i].hash == hash)
+	    && (e->node == h) && (AGOUT2IN(e)->node == t)
+	    && ((key.objtype == 0) || (AGID(e) == key.id)))
+	    return AGOUT2IN(e);
+    }
+    return NILedge;
+}
+
+void agedgeindex_free(Agraph_t * g)
+{
+    if (g->e_index) {
+	agfree(g, g->e_index->slot);
+	agfree(g, g->e_index);
+	g->e_index = NIL(Agedgeindex_t *);
+    }
+}
@@ -15,7 +15,9 @@
 
 #include <stdio.h>  /* SAFE */
 #include <cghdr.h>	/* SAFE */
-extern void yyerror(char *);	/* gets mapped to aagerror, see below */
+
+union YYSTYPE;
+extern int yylex(union YYSTYPE *, void *);	/* gets mapped to aaglex */
 
 #ifdef _WIN32
 #define gettxt(a,b)	(b)
@@ -52,32 +54,32 @@ typedef struct gstack_s {
 } gstack_t;
 
 /* functions */
-static void appendnode(char *name, char *port, char *sport);
-static void attrstmt(int tkind, char *macroname);
-static void startgraph(char *name, int directed, int strict);
-static void getedgeitems(int x);
-static void newedge(Agnode_t *t, char *tport, Agnode_t *h, char *hport, char *key);
-static void edgerhs(Agnode_t *n, char *tport, item *hlist, char *key);
-static void appendattr(char *name, char *value);
-static void bindattrs(int kind);
-static void applyattrs(void *obj);
-static void endgraph(void);
-static void endnode(void);
-static void endedge(void);
-static void freestack(void);
-static char* concat(char*, char*);
-static char* concatPort(char*, char*);
-
-static void opensubg(char *name);
-static void closesubg(void);
-
-/* global */
-static Agraph_t *G;				/* top level graph */
-static	Agdisc_t	*Disc;		/* discipline passed to agread or agconcat */
-static gstack_t *S;
+static void appendnode(aagextra_t *ctx, char *name, char *port, char *sport);
+static void attrstmt(aagextra_t *ctx, int tkind, char *macroname);
+static void startgraph(aagextra_t *ctx, char *name, int directed, int strict);
+static void getedgeitems(aagextra_t *ctx, int x);
+static void newedge(aagextra_t *ctx, Agnode_t *t, char *tport, Agnode_t *h, char *hport, char *key);
+static void edgerhs(aagextra_t *ctx, Agnode_t *n, char *tport, item *hlist, char *key);
+static void appendattr(aagextra_t *ctx, char *name, char *value);
+static void bindattrs(aagextra_t *ctx, int kind);
+static void applyattrs(aagextra_t *ctx, void *obj);
+static void endgraph(aagextra_t *ctx);
+static void endnode(aagextra_t *ctx);
+static void endedge(aagextra_t *ctx);
+static void freestack(aagextra_t *ctx);
+static char* concat(aagextra_t *ctx, char*, char*);
+static char* concatPort(aagextra_t *ctx, char*, char*);
+
+static void opensubg(aagextra_t *ctx, char *name);
+static void closesubg(aagextra_t *ctx);
+
 
 %}
 
+%define api.pure
+%lex-param {void *scanner}
+%parse-param {void *scanner} {aagextra_t *ctx}
+
 %union	{
 			int				i;
 			char			*str;
@@ -95,14 +97,14 @@ static gstack_t *S;
 
 %%
 
-graph		:  hdr body {freestack(); endgraph();}
-			|  error	{if (G) {freestack(); endgraph(); agclose(G); G = Ag_G_global = NIL(Agraph_t*);}}
+graph		:  hdr body {freestack(ctx); endgraph(ctx);}
+			|  error	{if (ctx->G) {freestack(ctx); endgraph(ctx); agclose(ctx->G); ctx->G = Ag_G_global = NIL(Agraph_t*);}}
 			|  /* empty */
 			;
 
 body		: '{' optstmtlist '}' ;
 
-hdr			:	optstrict graphtype optgraphname {startgraph($3,$2,$1);}
+hdr			:	optstrict graphtype optgraphname {startgraph(ctx,$3,$2,$1);}
 			;
 
 optgraphname:	atom {$$=$1;} | /* empty */ {$$=0;} ;
@@ -122,25 +124,25 @@ stmt		:  attrstmt  optsemi
 			;
 
 compound 	:	simple rcompound optattr
-					{if ($2) endedge(); else endnode();}
+					{if ($2) endedge(ctx); else endnode(ctx);}
 			;
 
 simple		:	nodelist | subgraph ;
 
-rcompound	:	T_edgeop {getedgeitems(1);} simple {getedgeitems(2);} rcompound {$$ = 1;}
+rcompound	:	T_edgeop {getedgeitems(ctx,1);} simple {getedgeitems(ctx,2);} rcompound {$$ = 1;}
 			|	/* empty */ {$$ = 0;}
 			;
 
 
 nodelist	: node | nodelist ',' node ;
 
-node		: atom {appendnode($1,NIL(char*),NIL(char*));}
-            | atom ':' atom {appendnode($1,$3,NIL(char*));}
-            | atom ':' atom ':' atom {appendnode($1,$3,$5);}
+node		: atom {appendnode(ctx,$1,NIL(char*),NIL(char*));}
+            | atom ':' atom {appendnode(ctx,$1,$3,NIL(char*));}
+            | atom ':' atom ':' atom {appendnode(ctx,$1,$3,$5);}
             ;
 
-attrstmt	:  attrtype optmacroname attrlist {attrstmt($1,$2);}
-			|  graphattrdefs {attrstmt(T_graph,NIL(char*));}
+attrstmt	:  attrtype optmacroname attrlist {attrstmt(ctx,$1,$2);}
+			|  graphattrdefs {attrstmt(ctx,T_graph,NIL(char*));}
 			;
 
 attrtype :	T_graph {$$ = T_graph;}
@@ -164,16 +166,16 @@ attrdefs	:  attritem optseparator
 
 attritem	: attrassignment | attrmacro ; 
 
-attrassignment	:  atom '=' atom {appendattr($1,$3);}
+attrassignment	:  atom '=' atom {appendattr(ctx,$1,$3);}
 			;
 
-attrmacro	:	'@' atom {appendattr($2,NIL(char*));}	/* not yet impl */
+attrmacro	:	'@' atom {appendattr(ctx,$2,NIL(char*));}	/* not yet impl */
 			;
 
 graphattrdefs : attrassignment
 			;
 
-subgraph	:  optsubghdr {opensubg($1);} body {closesubg();}
+subgraph	:  optsubghdr {opensubg(ctx,$1);} body {closesubg(ctx);}
 			;
 
 optsubghdr	: T_subgraph atom {$$=$2;}
@@ -188,64 +190,64 @@ atom	:  T_atom {$$ = $1;}
 			;
 
 qatom	:  T_qatom {$$ = $1;}
-			|  qatom '+' T_qatom {$$ = concat($1,$3);}
+			|  qatom '+' T_qatom {$$ = concat(ctx,$1,$3);}
 			;
 %%
 
 #define NILitem  NIL(item*)
 
 
-static item *newitem(int tag, void *p0, char *p1)
+static item *newitem(aagextra_t *ctx, int tag, void *p0, char *p1)
 {
-	item	*rv = agalloc(G,sizeof(item));
+	item	*rv = agalloc(ctx->G,sizeof(item));
 	rv->tag = tag; rv->u.name = (char*)p0; rv->str = p1;
 	return rv;
 }
 
-static item *cons_node(Agnode_t *n, char *port)
-	{ return newitem(T_node,n,port); }
+static item *cons_node(aagextra_t *ctx, Agnode_t *n, char *port)
+	{ return newitem(ctx,T_node,n,port); }
 
-static item *cons_attr(char *name, char *value)
-	{ return newitem(T_atom,name,value); }
+static item *cons_attr(aagextra_t *ctx, char *name, char *value)
+	{ return newitem(ctx,T_atom,name,value); }
 
-static item *cons_list(item *list)
-	{ return newitem(T_list,list,NIL(char*)); }
+static item *cons_list(aagextra_t *ctx, item *list)
+	{ return newitem(ctx,T_list,list,NIL(char*)); }
 
-static item *cons_subg(Agraph_t *subg)
-	{ return newitem(T_subgraph,subg,NIL(char*)); }
+static item *cons_subg(aagextra_t *ctx, Agraph_t *subg)
+	{ return newitem(ctx,T_subgraph,subg,NIL(char*)); }
 
-static gstack_t *push(gstack_t *s, Agraph_t *subg) {
+static gstack_t *push(aagextra_t *ctx, gstack_t *s, Agraph_t *subg) {
 	gstack_t *rv;
-	rv = agalloc(G,sizeof(gstack_t));
+	rv = agalloc(ctx->G,sizeof(gstack_t));
 	rv->down = s;
 	rv->g = subg;
 	return rv;
 }
 
-static gstack_t *pop(gstack_t *s)
+static gstack_t *pop(aagextra_t *ctx, gstack_t *s)
 {
 	gstack_t *rv;
-	rv = S->down;
-	agfree(G,s);
+	rv = ctx->S->down;
+	agfree(ctx->G,s);
 	return rv;
 }
 
 #ifdef NOTDEF
-static item *cons_edge(Agedge_t *e)
-	{ return newitem(T_edge,e,NIL(char*)); }
+static item *cons_edge(aagextra_t *ctx, Agedge_t *e)
+	{ return newitem(ctx,T_edge,e,NIL(char*)); }
 #endif
 
-static void delete_items(item *ilist)
+static void delete_items(aagextra_t *ctx, item *ilist)
 {
 	item	*p,*pn;
 
 	for (p = ilist; p; p = pn) {
 		pn = p->next;
 		switch(p->tag) {
-			case T_list: delete_items(p->u.list); break;
-			case T_atom: case T_attr: agstrfree(G,p->str); break;
+			case T_list: delete_items(ctx,p->u.list); break;
+			case T_atom: case T_attr: agstrfree(ctx->G,p->str); break;
 		}
-		agfree(G,p);
+		agfree(ctx->G,p);
 	}
 }
 
@@ -256,9 +258,9 @@ static void initlist(list_t *list)
 }
 #endif
 
-static void deletelist(list_t *list)
+static void deletelist(aagextra_t *ctx, list_t *list)
 {
-	delete_items(list->first);
+	delete_items(ctx,list->first);
 	list->first = list->last = NILitem;
 }
 
@@ -280,37 +282,37 @@ static void listapp(list_t *list, item *v)
 
 
 /* attrs */
-static void appendattr(char *name, char *value)
+static void appendattr(aagextra_t *ctx, char *name, char *value)
 {
 	item		*v;
 
 	assert(value != NIL(char*));
-	v = cons_attr(name,value);
-	listapp(&(S->attrlist),v);
+	v = cons_attr(ctx,name,value);
+	listapp(&(ctx->S->attrlist),v);
 }
 
-static void bindattrs(int kind)
+static void bindattrs(aagextra_t *ctx, int kind)
 {
 	item		*aptr;
 	char		*name;
 
-	for (aptr = S->attrlist.first; aptr; aptr = aptr->next) {
+	for (aptr = ctx->S->attrlist.first; aptr; aptr = aptr->next) {
 		assert(aptr->tag == T_atom);	/* signifies unbound attr */
 		name = aptr->u.name;
 		if ((kind == AGEDGE) && streq(name,Key)) continue;
-		if ((aptr->u.asym = agattr(S->g,kind,name,NIL(char*))) == NILsym)
-			aptr->u.asym = agattr(S->g,kind,name,"");
+		if ((aptr->u.asym = agattr(ctx->S->g,kind,name,NIL(char*))) == NILsym)
+			aptr->u.asym = agattr(ctx->S->g,kind,name,"");
 		aptr->tag = T_attr;				/* signifies bound attr */
-		agstrfree(G,name);
+		agstrfree(ctx->G,name);
 	}
 }
 
 /* attach node/edge specific attributes */
-static void applyattrs(void *obj)
+static void applyattrs(aagextra_t *ctx, void *obj)
 {
 	item		*aptr;
 
-	for (aptr = S->attrlist.first; aptr; aptr = aptr->next) {
+	for (aptr = ctx->S->attrlist.first; aptr; aptr = aptr->next) {
 		if (aptr->tag == T_attr) {
 			if (aptr->u.asym) {
 				agxset(obj,aptr->u.asym,aptr->str);
@@ -333,7 +335,7 @@ static void nomacros(void)
  * First argument is always attrtype, so switch covers all cases.
  * This function is used to handle default attribute value assignment.
  */
-static void attrstmt(int tkind, char *macroname)
+static void attrstmt(aagextra_t *ctx, int tkind, char *macroname)
 {
 	item			*aptr;
 	int				kind = 0;
@@ -342,7 +344,7 @@ static void attrstmt(int tkind, char *macroname)
 		/* creating a macro def */
 	if (macroname) nomacros();
 		/* invoking a macro def */
-	for (aptr = S->attrlist.first; aptr; aptr = aptr->next)
+	for (aptr = ctx->S->attrlist.first; aptr; aptr = aptr->next)
 		if (aptr->str == NIL(char*)) nomacros();
 
 	switch(tkind) {
@@ -350,32 +352,32 @@ static void attrstmt(int tkind, char *macroname)
 		case T_node: kind = AGNODE; break;
 		case T_edge: kind = AGEDGE; break;
 	}
-	bindattrs(kind);	/* set up defaults for new attributes */
-	for (aptr = S->attrlist.first; aptr; aptr = aptr->next) {
+	bindattrs(ctx,kind);	/* set up defaults for new attributes */
+	for (aptr = ctx->S->attrlist.first; aptr; aptr = aptr->next) {
 		/* If the tag is still T_atom, aptr->u.asym has not been set */
 		if (aptr->tag == T_atom) continue;
-		if (!(aptr->u.asym->fixed) || (S->g != G))
-			sym = agattr(S->g,kind,aptr->u.asym->name,aptr->str);
+		if (!(aptr->u.asym->fixed) || (ctx->S->g != ctx->G))
+			sym = agattr(ctx->S->g,kind,aptr->u.asym->name,aptr->str);
 		else
 			sym = aptr->u.asym;
-		if (S->g == G)
+		if (ctx->S->g == ctx->G)
 			sym->print = TRUE;
 	}
-	deletelist(&(S->attrlist));
+	deletelist(ctx,&(ctx->S->attrlist));
 }
 
 /* nodes */
 
-static void appendnode(char *name, char *port, char *sport)
+static void appendnode(aagextra_t *ctx, char *name, char *port, char *sport)
 {
 	item		*elt;
 
 	if (sport) {
-		port = concatPort (port, sport);
+		port = concatPort (ctx, port, sport);
 	}
-	elt = cons_node(agnode(S->g,name,TRUE),port);
-	listapp(&(S->nodelist),elt);
-	agstrfree(G,name);
+	elt = cons_node(ctx,agnode(ctx->S->g,name,TRUE),port);
+	listapp(&(ctx->S->nodelist),elt);
+	agstrfree(ctx->G,name);
 }
 
 /* apply current optional attrs to nodelist and clean up lists */
@@ -383,35 +385,35 @@ static void appendnode(char *name, char *port, char *sport)
 clean up S->subg in closesubg() because S->subg might be needed
 to construct edges.  these are the sort of notes you write to yourself
 in the future. */
-static void endnode()
+static void endnode(aagextra_t *ctx)
 {
 	item	*ptr;
 
-	bindattrs(AGNODE);
-	for (ptr = S->nodelist.first; ptr; ptr = ptr->next)
-		applyattrs(ptr->u.n);
-	deletelist(&(S->nodelist));
-	deletelist(&(S->attrlist));
-	deletelist(&(S->edgelist));
-	S->subg = 0;  /* notice a pattern here? :-( */
+	bindattrs(ctx,AGNODE);
+	for (ptr = ctx->S->nodelist.first; ptr; ptr = ptr->next)
+		applyattrs(ctx,ptr->u.n);
+	deletelist(ctx,&(ctx->S->nodelist));
+	deletelist(ctx,&(ctx->S->attrlist));
+	deletelist(ctx,&(ctx->S->edgelist));
+	ctx->S->subg = 0;  /* notice a pattern here? :-( */
 }
 
 /* edges - store up node/subg lists until optional edge key can be seen */
 
-static void getedgeitems(int x)
+static void getedgeitems(aagextra_t *ctx, int x)
 {
 	item	*v = 0;
 
-	if (S->nodelist.first) {
-		v = cons_list(S->nodelist.first);
-		S->nodelist.first = S->nodelist.last = NILitem;
+	if (ctx->S->nodelist.first) {
+		v = cons_list(ctx,ctx->S->nodelist.first);
+		ctx->S->nodelist.first = ctx->S->nodelist.last = NILitem;
 	}
-	else {if (S->subg) v = cons_subg(S->subg); S->subg = 0;}
+	else {if (ctx->S->subg) v = cons_subg(ctx,ctx->S->subg); ctx->S->subg = 0;}
 	/* else nil append */
-	if (v) listapp(&(S->edgelist),v);
+	if (v) listapp(&(ctx->S->edgelist),v);
 }
 
-static void endedge(void)
+static void endedge(aagextra_t *ctx)
 {
 	char			*key;
 	item			*aptr,*tptr,*p;
@@ -419,37 +421,37 @@ static void endedge(void)
 	Agnode_t		*t;
 	Agraph_t		*subg;
 
-	bindattrs(AGEDGE);
+	bindattrs(ctx,AGEDGE);
 
 	/* look for "key" pseudo-attribute */
 	key = NIL(char*);
-	for (aptr = S->attrlist.first; aptr; aptr = aptr->next) {
+	for (aptr = ctx->S->attrlist.first; aptr; aptr = aptr->next) {
 		if ((aptr->tag == T_atom) && streq(aptr->u.name,Key))
 			key = aptr->str;
 	}
 
 	/* can make edges with node lists or subgraphs */
-	for (p = S->edgelist.first; p->next; p = p->next) {
+	for (p = ctx->S->edgelist.first; p->next; p = p->next) {
 		if (p->tag == T_subgraph) {
 			subg = p->u.subg;
 			for (t = agfstnode(subg); t; t = agnxtnode(subg,t))
-				edgerhs(agsubnode(S->g,t,FALSE),NIL(char*),p->next,key);
+				edgerhs(ctx,agsubnode(ctx->S->g,t,FALSE),NIL(char*),p->next,key);
 		}
 		else {
 			for (tptr = p->u.list; tptr; tptr = tptr->next)
-				edgerhs(tptr->u.n,tptr->str,p->next,key);
+				edgerhs(ctx,tptr->u.n,tptr->str,p->next,key);
 		}
 	}
-	deletelist(&(S->nodelist));
-	deletelist(&(S->edgelist));
-	deletelist(&(S->attrlist));
-	S->subg = 0;
+	deletelist(ctx,&(ctx->S->nodelist));
+	deletelist(ctx,&(ctx->S->edgelist));
+	deletelist(ctx,&(ctx->S->attrlist));
+	ctx->S->subg = 0;
 }
 
 /* concat:
  */
 static char*
-concat (char* s1, char* s2)
+concat (aagextra_t *ctx, char* s1, char* s2)
 {
   char*  s;
   char   buf[BUFSIZ];
@@ -460,9 +462,9 @@ concat (char* s1, char* s2)
   else sym = (char*)malloc(len);
   strcpy(sym,s1);
   strcat(sym,s2);
-  s = agstrdup (G,sym);
-  agstrfree (G,s1);
-  agstrfree (G,s2);
+  s = agstrdup (ctx->G,sym);
+  agstrfree (ctx->G,s1);
+  agstrfree (ctx->G,s2);
   if (sym != buf) free (sym);
   return s;
 }
@@ -470,7 +472,7 @@ concat (char* s1, char* s2)
 /* concatPort:
  */
 static char*
-concatPort (char* s1, char* s2)
+concatPort (aagextra_t *ctx, char* s1, char* s2)
 {
   char*  s;
   char   buf[BUFSIZ];
@@ -480,15 +482,15 @@ concatPort (char* s1, char* s2)
   if (len <= BUFSIZ) sym = buf;
   else sym = (char*)malloc(len);
   sprintf (sym, "%s:%s", s1, s2);
-  s = agstrdup (G,sym);
-  agstrfree (G,s1);
-  agstrfree (G,s2);
+  s = agstrdup (ctx->G,sym);
+  agstrfree (ctx->G,s1);
+  agstrfree (ctx->G,s2);
   if (sym != buf) free (sym);
   return s;
 }
 
 
-static void edgerhs(Agnode_t *tail, char *tport, item *hlist, char *key)
+static void edgerhs(aagextra_t *ctx, Agnode_t *tail, char *tport, item *hlist, char *key)
 {
 	Agnode_t		*head;
 	Agraph_t		*subg;
@@ -497,29 +499,29 @@ static void edgerhs(Agnode_t *tail, char *tport, item *hlist, char *key)
 	if (hlist->tag == T_subgraph) {
 		subg = hlist->u.subg;
 		for (head = agfstnode(subg); head; head = agnxtnode(subg,head))
-			newedge(tail,tport,agsubnode(S->g,head,FALSE),NIL(char*),key);
+			newedge(ctx,tail,tport,agsubnode(ctx->S->g,head,FALSE),NIL(char*),key);
 	}
 	else {
 		for (hptr = hlist->u.list; hptr; hptr = hptr->next)
-			newedge(tail,tport,agsubnode(S->g,hptr->u.n,FALSE),hptr->str,key);
+			newedge(ctx,tail,tport,agsubnode(ctx->S->g,hptr->u.n,FALSE),hptr->str,key);
 	}
 }
 
-static void mkport(Agedge_t *e, char *name, char *val)
+static void mkport(aagextra_t *ctx, Agedge_t *e, char *name, char *val)
 {
 	Agsym_t *attr;
 	if (val) {
-		if ((attr = agattr(S->g,AGEDGE,name,NIL(char*))) == NILsym)
-			attr = agattr(S->g,AGEDGE,name,"");
+		if ((attr = agattr(ctx->S->g,AGEDGE,name,NIL(char*))) == NILsym)
+			attr = agattr(ctx->S->g,AGEDGE,name,"");
 		agxset(e,attr,val);
 	}
 }
 
-static void newedge(Agnode_t *t, char *tport, Agnode_t *h, char *hport, char *key)
+static void newedge(aagextra_t *ctx, Agnode_t *t, char *tport, Agnode_t *h, char *hport, char *key)
 {
 	Agedge_t 	*e;
 
-	e = agedge(S->g,t,h,key,TRUE);
+	e = agedge(ctx->S->g,t,h,key,TRUE);
 	if (e) {		/* can fail if graph is strict and t==h */
 		char    *tp = tport;
 		char    *hp = hport;
@@ -528,74 +530,107 @@ static void newedge(Agnode_t *t, char *tport, Agnode_t *h, char *hport, char *ke
 			char    *temp;
 			temp = tp; tp = hp; hp = temp;
 		}
-		mkport(e,TAILPORT_ID,tp);
-		mkport(e,HEADPORT_ID,hp);
-		applyattrs(e);
+		mkport(ctx,e,TAILPORT_ID,tp);
+		mkport(ctx,e,HEADPORT_ID,hp);
+		applyattrs(ctx,e);
 	}
 }
 
 /* graphs and subgraphs */
 
 
-static void startgraph(char *name, int directed, int strict)
+static void startgraph(aagextra_t *ctx, char *name, int directed, int strict)
 {
-	static Agdesc_t	req;	/* get rid of warnings */
+	Agdesc_t	req = Agdirected;	/* get rid of warnings */
 
-	if (G == NILgraph) {
+	if (ctx->G == NILgraph) {
 		req.directed = directed;
 		req.strict = strict;
 		req.maingraph = TRUE;
-		Ag_G_global = G = agopen(name,req,Disc);
+		Ag_G_global = ctx->G = agopen(name,req,ctx->Disc);
 	}
 	else {
-		Ag_G_global = G;
+		Ag_G_global = ctx->G;
 	}
-	S = push(S,G);
+	ctx->S = push(ctx,ctx->S,ctx->G);
 	agstrfree(NIL(Agraph_t*),name);
 }
 
-static void endgraph()
+static void endgraph(aagextra_t *ctx)
 {
-	aglexeof();
-	aginternalmapclearlocalnames(G);
+	aglexeof(ctx);
+	aginternalmapclearlocalnames(ctx->G);
 }
 
-static void opensubg(char *name)
+static void opensubg(aagextra_t *ctx, char *name)
 {
-	S = push(S,agsubg(S->g,name,TRUE));
-	agstrfree(G,name);
+	ctx->S = push(ctx,ctx->S,agsubg(ctx->S->g,name,TRUE));
+	agstrfree(ctx->G,name);
 }
 
-static void closesubg()
+static void closesubg(aagextra_t *ctx)
 {
-	Agraph_t *subg = S->g;
-	S = pop(S);
-	S->subg = subg;
+	Agraph_t *subg = ctx->S->g;
+	ctx->S = pop(ctx,ctx->S);
+	ctx->S->subg = subg;
 	assert(subg);
 }
 
-static void freestack()
+static void freestack(aagextra_t *ctx)
 {
-	while (S) {
-		deletelist(&(S->nodelist));
-		deletelist(&(S->attrlist));
-		deletelist(&(S->edgelist));
-		S = pop(S);
+	while (ctx->S) {
+		deletelist(ctx,&(ctx->S->nodelist));
+		deletelist(ctx,&(ctx->S->attrlist));
+		deletelist(ctx,&(ctx->S->edgelist));
+		ctx->S = pop(ctx,ctx->S);
 	}
 }
 
-extern FILE *yyin;
-Agraph_t *agconcat(Agraph_t *g, void *chan, Agdisc_t *disc)
+/* agparse:
+ * Parse the next graph from ctx into g, or into a new graph if g is NULL.
+ */
+Agraph_t *agparse(aagextra_t *ctx, Agraph_t *g, void *chan, Agdisc_t *disc)
 {
-	yyin = chan;
-	G = g;
+	ctx->G = g;
 	Ag_G_global = NILgraph;
-	Disc = (disc? disc :  &AgDefaultDisc);
-	aglexinit(Disc, chan);
-	yyparse();
-	if (Ag_G_global == NILgraph) aglexbad();
+	ctx->Disc = (disc? disc :  &AgDefaultDisc);
+	if (aglexinit(ctx, ctx->Disc, chan))
+		return NILgraph;
+	yyparse(ctx->scanner, ctx);
+	if (Ag_G_global == NILgraph) aglexbad(ctx);
+	ctx->G = NILgraph;
 	return Ag_G_global;
 }
 
-Agraph_t *agread(void *fp, Agdisc_t *disc) {return agconcat(NILgraph,fp,disc); }
+/* agconcat:
+ * Streams are read through the calling thread's lexer context, which
+ * keeps whatever input was read ahead for the next call.
+ */
+Agraph_t *agconcat(Agraph_t *g, void *chan, Agdisc_t *disc)
+{
+	aagextra_t *ctx = aglexopen(NIL(char*), 0);
+	Agraph_t *rv;
+
+	rv = agparse(ctx, g, chan, disc);
+	aglexclose(ctx);
+	return rv;
+}
+
+/* agread:
+ * With the default I/O discipline, input starting with AGBINMAGIC
+ * is taken to be in the binary format of agwrite_binary.
+ */
+Agraph_t *agread(void *fp, Agdisc_t *disc)
+{
+	int c;
+
+	if (fp && (!disc || (disc->io->afread == AgIoDisc.afread))
+	    && aglexempty(aglexopen(NIL(char*), 0))) {
+		c = getc((FILE*)fp);
+		ungetc(c, (FILE*)fp);
+		if (c == AGBINMAGIC)
+			return agread_binary(fp, disc);
+	}
+	return agconcat(NILgraph,fp,disc);
+}
 
@@ -58,6 +58,7 @@ Agraph_t *agopen(char *name, Agdesc_t desc, Agdisc_t * arg_disc)
     if (agmapnametoid(g, AGRAPH, name, &gid, TRUE))
 	AGID(g) = gid;
     /* else AGID(g) = 0 because we have no alternatives */
+    agattrslots(g);
     g = agopen1(g);
     agregister(g, AGRAPH, g);
     return g;
@@ -80,6 +81,8 @@ Agraph_t *agopen1(Agraph_t * g)
     if (par) {
 	AGSEQ(g) = agnextseq(par, AGRAPH);
 	dtinsert(par->g_dict, g);
+	if (g->clos->subg_bits)
+	    g->n_bits = agsetopen(g, AGNODE);
     }				/* else AGSEQ=0 */
     if (!par || par->desc.has_attrs)
 	agraphattr_init(g);
@@ -100,6 +103,7 @@ int agclose(Agraph_t * g)
 	/* free entire heap */
 	agmethod_delete(g, g);	/* invoke user callbacks */
 	agfreeid(g, AGRAPH, AGID(g));
+	AGDISC(g, id)->close(AGCLOS(g, id));
 	AGDISC(g, mem)->close(AGCLOS(g, mem));	/* whoosh */
 	return SUCCESS;
     }
@@ -114,7 +118,8 @@ int agclose(Agraph_t * g)
 	agdelnode(g, n);
     }
 
-    aginternalmapclose(g);
+    if (!par)			/* the maps belong to the root */
+	aginternalmapclose(g);
     agmethod_delete(g, g);
 
     assert(dtsize(g->n_id) == 0);
@@ -129,6 +134,8 @@ int agclose(Agraph_t * g)
 
     assert(dtsize(g->g_dict) == 0);
     if (agdtclose(g, g->g_dict)) return FAILURE;
+    agedgeindex_free(g);
+    agsetclose(g->n_bits);
 
     if (g->desc.has_attrs)
 	if (agraphattr_delete(g)) return FAILURE;
@@ -144,6 +151,7 @@ int agclose(Agraph_t * g)
 	while (g->clos->cb)
 	    agpopdisc(g, g->clos->cb->f);
 	AGDISC(g, id)->close(AGCLOS(g, id));
+	agrecslotclose(g);
 	if (agstrclose(g)) return FAILURE;
 	memdisc = AGDISC(g, mem);
 	memclos = AGCLOS(g, mem);
@@ -16,29 +16,43 @@
 
 /* a default ID allocator that works off the shared string lib */
 
+/* the counter for anonymous IDs is kept per root graph, so that
+ * graphs on different threads do not share it
+ */
+typedef struct {
+    Agraph_t *g;
+    IDTYPE ctr;
+} idstate_t;
+
 static void *idopen(Agraph_t * g, Agdisc_t* disc)
 {
-    return g;
+    idstate_t *state;
+
+    NOTUSED(disc);
+    state = agalloc(g, sizeof(idstate_t));
+    state->g = g;
+    state->ctr = 1;
+    return state;
 }
 
 static long idmap(void *state, int objtype, char *str, IDTYPE *id,
 		  int createflag)
 {
+    idstate_t *ids = state;
     char *s;
-    static IDTYPE ctr = 1;
 
     NOTUSED(objtype);
     if (str) {
         Agraph_t *g;
-        g = state;
+        g = ids->g;
         if (createflag)
             s = agstrdup(g, str);
         else
             s = agstrbind(g, str);
         *id = (IDTYPE) s;
     } else {
-        *id = ctr;
-        ctr += 2;
+        *id = ids->ctr;
+        ids->ctr += 2;
     }
     return TRUE;
 }
@@ -56,7 +70,7 @@ static void idfree(void *state, int objtype, IDTYPE id)
 {
     NOTUSED(objtype);
     if (id % 2 == 0)
-	agstrfree((Agraph_t *) state, (char *) id);
+	agstrfree(((idstate_t *) state)->g, (char *) id);
 }
 
 static char *idprint(void *state, int objtype, IDTYPE id)
@@ -71,7 +85,9 @@ static char *idprint(void *state, int objtype, IDTYPE id)
 
 static void idclose(void *state)
 {
-    NOTUSED(state);
+    idstate_t *ids = state;
+
+    agfree(ids->g, ids);
 }
 
 static void idregister(void *state, int objtype, void *obj)
@@ -91,6 +107,140 @@ Agiddisc_t AgIdDisc = {
     idregister
 };
 
+/* an ID allocator that numbers the objects of each kind densely from 0,
+ * reusing the numbers of deleted objects, so that they can index arrays;
+ * see agnodeindex. Node and graph names are kept in the internal map.
+ * Edge keys are not unique, as edges with different ends may share one,
+ * so each edge gets an index of its own, and its key, if any, is kept
+ * here by index; agedge finds keyed edges by name.
+ */
+typedef struct {
+    Agraph_t *g;
+    IDTYPE next[3];		/* first never used, by kind */
+    IDTYPE *free[3];		/* released, by kind */
+    int nfree[3], szfree[3];
+    IDTYPE cap[3];		/* room in used, and in key for edges */
+    unsigned char *used[3];	/* by index: held by an object */
+    char **key;			/* by edge index: the edge's key, or NULL */
+} denseidstate_t;
+
+#define DENSEKIND(objtype)	((objtype) == AGINEDGE ? AGEDGE : (objtype))
+
+static void *denseidopen(Agraph_t * g, Agdisc_t * disc)
+{
+    denseidstate_t *state;
+
+    NOTUSED(disc);
+    state = agalloc(g, sizeof(denseidstate_t));
+    state->g = g;
+    return state;
+}
+
+static long denseidmap(void *state, int objtype, char *str, IDTYPE * id,
+		       int createflag)
+{
+    denseidstate_t *ids = state;
+    int k = DENSEKIND(objtype);
+    IDTYPE i, cap;
+
+    if (!createflag || (str && (k != AGEDGE)))
+	return FALSE;		/* names go to the internal map */
+    if (ids->nfree[k] > 0)
+	i = ids->free[k][--ids->nfree[k]];
+    else {
+	i = ids->next[k]++;
+	if (i == ids->cap[k]) {
+	    cap = ids->cap[k] ? 2 * ids->cap[k] : 64;
+	    ids->used[k] = agrealloc(ids->g, ids->used[k], ids->cap[k], cap);
+	    if (k == AGEDGE)
+		ids->key = agrealloc(ids->g, ids->key,
+				     ids->cap[k] * sizeof(char *),
+				     cap * sizeof(char *));
+	    ids->cap[k] = cap;
+	}
+    }
+    ids->used[k][i] = TRUE;
+    if (k == AGEDGE)
+	ids->key[i] = (str ? agstrdup(ids->g, str) : NILstr);
+    *id = i;
+    return TRUE;
+}
+
+static void denseidfree(void *state, int objtype, IDTYPE id)
+{
+    denseidstate_t *ids = state;
+    int k = DENSEKIND(objtype);
+
+    if ((id >= ids->next[k]) || !ids->used[k][id])
+	return;			/* not one of ours */
+    ids->used[k][id] = FALSE;
+    if ((k == AGEDGE) && ids->key[id]) {
+	agstrfree(ids->g, ids->key[id]);
+	ids->key[id] = NILstr;
+    }
+    if (ids->nfree[k] == ids->szfree[k]) {
+	ids->szfree[k] = ids->szfree[k] ? 2 * ids->szfree[k] : 64;
+	ids->free[k] = agrealloc(ids->g, ids->free[k],
+				 ids->nfree[k] * sizeof(IDTYPE),
+				 ids->szfree[k] * sizeof(IDTYPE));
+    }
+    ids->free[k][ids->nfree[k]++] = id;
+}
+
+static char *denseidprint(void *state, int objtype, IDTYPE id)
+{
+    denseidstate_t *ids = state;
+
+    if ((DENSEKIND(objtype) != AGEDGE) || (id >= ids->next[AGEDGE]))
+	return NILstr;
+    return ids->key[id];
+}
+
+static void denseidclose(void *state)
+{
+    denseidstate_t *ids = state;
+    int k;
+
+    for (k = 0; k < 3; k++) {
+	agfree(ids->g, ids->free[k]);
+	agfree(ids->g, ids->used[k]);
+    }
+    agfree(ids->g, ids->key);
+    agfree(ids->g, ids);
+}
+
+Agiddisc_t AgDenseIdDisc = {
+    denseidopen,
+    denseidmap,
+    idalloc,
+    denseidfree,
+    denseidprint,
+    denseidclose,
+    idregister
+};
+
+/* agindexbound:
+ * Return one more than the largest index of an object of the given kind
+ * ever used in the root of g, or 0 if g does not use AgDenseIdDisc.
+ */
+int agindexbound(Agraph_t * g, int objtype)
+{
+    if (AGDISC(g, id) != &AgDenseIdDisc)
+	return 0;
+    return (int) ((denseidstate_t *) AGCLOS(g, id))->
+	next[DENSEKIND(objtype)];
+}
+
+int agnodeindex(Agnode_t * n)
+{
+    return (AGDISC(agraphof(n), id) == &AgDenseIdDisc) ? (int) AGID(n) : -1;
+}
+
+int agedgeindex(Agedge_t * e)
+{
+    return (AGDISC(agraphof(e), id) == &AgDenseIdDisc) ? (int) AGID(e) : -1;
+}
+
 /* aux functions incl. support for disciplines with anonymous IDs */
 
 int agmapnametoid(Agraph_t * g, int objtype, char *str,
@@ -138,13 +288,13 @@ void agfreeid(Agraph_t * g, int objtype, IDTYPE id)
  * Return string representation of object.
  * In general, returns the name of node or graph,
  * and the key of an edge. If edge is anonymous, returns NULL.
- * Uses static buffer for anonymous graphs.
+ * Uses a static, per-thread buffer for anonymous graphs.
  */
 char *agnameof(void *obj)
 {
     Agraph_t *g;
     char *rv;
-    static char buf[32];
+    static AGTLS char buf[32];
 
     /* perform internal lookup first */
     g = agraphof(obj);
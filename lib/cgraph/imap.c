@@ -211,9 +211,25 @@ static void closeit(Dict_t ** d)
     }
 }
 
+/* aginternalmapclose:
+ * Free the maps of the root graph g, with any entries left in them.
+ */
 void aginternalmapclose(Agraph_t * g)
 {
+    IMapEntry_t *sym;
+    Dict_t *d;
+    int i;
+
     Ag_G_global = g;
     closeit(g->clos->lookup_by_name);
+    for (i = 0; i < 3; i++) {
+	if ((d = g->clos->lookup_by_id[i])) {
+	    while ((sym = dtfirst(d))) {
+		dtdelete(d, sym);
+		agstrfree(g, sym->str);
+		agfree(g, sym);
+	    }
+	}
+    }
     closeit(g->clos->lookup_by_id);
 }
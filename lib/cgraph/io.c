@@ -12,10 +12,20 @@
  *************************************************************************/
 
 #include <stdio.h>
+#include <limits.h>
 #include <cghdr.h>
 #if defined(_WIN32)
 #include <io.h>
 #endif
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#endif
 
 /* experimental ICONV code - probably should be removed - JCE */
 #undef HAVE_ICONV
@@ -90,65 +100,157 @@ static int ioflush(void *chan)
 /* Agiodisc_t AgIoDisc = { iofreadiconv, ioputstr, ioflush }; */
 Agiodisc_t AgIoDisc = { iofread, ioputstr, ioflush };
 
-typedef struct {
-    const char *data;
-    int len;
-    int cur;
-} rdr_t;
+/* In-memory input
+ * The lexer scans these buffers in place, so apart from the interned
+ * names and values, no bytes are copied while parsing. Flex needs two
+ * NUL bytes after the data, and writes into the buffer while scanning.
+ * Each buffer has a lexer context of its own, so it can be read on any
+ * thread, independently of any stream being read.
+ */
+struct Agmmap_s {
+    char *base;			/* start of the mapping or copy */
+    size_t maplen;		/* length of mapping; 0 if base was malloc'ed */
+    aagextra_t *lexctx;		/* lexer context scanning the data */
+};
 
-static int
-memiofread(void *chan, char *buf, int bufsize)
+/* memparse:
+ * Parse the next graph in m's buffer.
+ */
+static Agraph_t *memparse(Agmmap_t * m, Agdisc_t * disc)
 {
-    const char *ptr;
-    char *optr;
-    char c;
-    int l;
-    rdr_t *s;
-
-    if (bufsize == 0) return 0;
-    s = (rdr_t *) chan;
-    if (s->cur >= s->len)
-        return 0;
-    l = 0;
-    ptr = s->data + s->cur;
-    optr = buf;
-    /* We know we have at least one character */
-    c = *ptr++;
-    do {
-        *optr++ = c;
-        l++;
-	/* continue if c is not newline, we have space in buffer,
-	 * and next character is non-null (we are working with
-	 * null-terminated strings.
-	 */
-    } while ((c != '\n') && (l < bufsize) && (c = *ptr++));
-    s->cur += l;
-    return l;
+    return agparse(m->lexctx, NILgraph, NIL(void *), disc);
 }
 
-static Agiodisc_t memIoDisc = {memiofread, 0, 0};
-
-Agraph_t *agmemread(const char *cp)
+/* agmemread_len:
+ * Read a graph from the len bytes at cp, which need not be NUL-terminated.
+ */
+Agraph_t *agmemread_len(const char *cp, size_t len)
 {
-    Agraph_t* g;
-    rdr_t rdr;
-    Agdisc_t disc;
-
-    memIoDisc.putstr = AgIoDisc.putstr;
-    memIoDisc.flush = AgIoDisc.flush;
-    rdr.data = cp;
-    rdr.len = strlen(cp);
-    rdr.cur = 0;
-
-    disc.mem = &AgMemDisc;
-    disc.id = &AgIdDisc;
-    disc.io = &memIoDisc;  
-    g = agread (&rdr, &disc);
+    Agraph_t *g;
+    Agmmap_t m;
+
+    if (len > INT_MAX - 2)	/* flex buffers are indexed by int */
+	return NIL(Agraph_t *);
+    m.base = malloc(len + 2);
+    if (!m.base)
+	return NIL(Agraph_t *);
+    memcpy(m.base, cp, len);
+    m.base[len] = m.base[len + 1] = '\0';
+    m.maplen = 0;
+    m.lexctx = aglexopen(m.base, len + 2);
+    g = m.lexctx ? memparse(&m, NIL(Agdisc_t *)) : NILgraph;
+    aglexclose(m.lexctx);
+    free(m.base);
     /* Null out filename and reset line number 
-     * The name may have been set with a ppDirective, and
+     * The name may have been set with agsetfile, and
      * we want to reset line_num.
      */
     agsetfile(NULL);
     return g;
 }
 
+Agraph_t *agmemread(const char *cp)
+{
+    return agmemread_len(cp, strlen(cp));
+}
+
+/* agmmapopen:
+ * Map the rest of the regular file chan into memory, for reading with
+ * agmmapread. Returns NULL if fp cannot be mapped or holds a binary
+ * graph, in which case the caller should fall back on agread.
+ * Where mmap is not available, the data is read into memory instead.
+ */
+Agmmap_t *agmmapopen(void *chan)
+{
+#ifdef HAVE_SYS_STAT_H
+    FILE *fp = (FILE *) chan;
+    struct stat sb;
+    Agmmap_t *m;
+    long off;
+    size_t len;
+    int c;
+#ifdef HAVE_SYS_MMAN_H
+    size_t pgsz, maplen;
+    char *base;
+#endif
+
+    if (fstat(fileno(fp), &sb) || !S_ISREG(sb.st_mode)
+	|| (off = ftell(fp)) < 0 || (off_t) off > sb.st_size)
+	return NIL(Agmmap_t *);
+    len = (size_t) (sb.st_size - off);
+    if (len > INT_MAX - 2)
+	return NIL(Agmmap_t *);
+    c = getc(fp);
+    ungetc(c, fp);
+    if (c == AGBINMAGIC)
+	return NIL(Agmmap_t *);
+    m = calloc(1, sizeof(Agmmap_t));
+    if (!m)
+	return NIL(Agmmap_t *);
+
+#ifdef HAVE_SYS_MMAN_H
+    /* Reserve zeroed pages for the whole file plus the two NULs, then map
+     * the file over them. Pages are private, so the lexer's writes are
+     * never seen in the file.
+     */
+    pgsz = (size_t) sysconf(_SC_PAGESIZE);
+    maplen = ((size_t) sb.st_size + 2 + pgsz - 1) / pgsz * pgsz;
+    base = mmap(NIL(void *), maplen, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+	free(m);
+	return NIL(Agmmap_t *);
+    }
+    if (sb.st_size > 0
+	&& mmap(base, (size_t) sb.st_size, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_FIXED, fileno(fp), 0) == MAP_FAILED) {
+	munmap(base, maplen);
+	free(m);
+	return NIL(Agmmap_t *);
+    }
+    m->base = base;
+    m->maplen = maplen;
+    m->lexctx = aglexopen(base + off, len + 2);
+#else
+    m->base = malloc(len + 2);
+    if (!m->base) {
+	free(m);
+	return NIL(Agmmap_t *);
+    }
+    len = fread(m->base, 1, len, fp);	/* may be short in text mode */
+    m->base[len] = m->base[len + 1] = '\0';
+    m->lexctx = aglexopen(m->base, len + 2);
+#endif
+    if (!m->lexctx) {
+	agmmapclose(m);
+	return NIL(Agmmap_t *);
+    }
+    fseek(fp, 0, SEEK_END);	/* the stream has been consumed */
+    return m;
+#else
+    NOTUSED(chan);
+    return NIL(Agmmap_t *);
+#endif
+}
+
+/* agmmapread:
+ * Read the next graph from m; returns NULL at the end of the data.
+ */
+Agraph_t *agmmapread(Agmmap_t * m, Agdisc_t * disc)
+{
+    return memparse(m, disc);
+}
+
+void agmmapclose(Agmmap_t * m)
+{
+    if (!m)
+	return;
+    aglexclose(m->lexctx);
+#ifdef HAVE_SYS_MMAN_H
+    if (m->maplen)
+	munmap(m->base, m->maplen);
+    else
+#endif
+	free(m->base);
+    free(m);
+}
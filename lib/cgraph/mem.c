@@ -12,6 +12,12 @@
  *************************************************************************/
 
 #include <cghdr.h>
+/* <malloc.h> would find the one in this directory; on Windows, _msize
+ * comes with <stdlib.h>.
+ */
+#if defined(HAVE_MALLOC_USABLE_SIZE) && !defined(_WIN32)
+extern size_t malloc_usable_size(void *);
+#endif
 
 /* memory management discipline and entry points */
 static void *memopen(Agdisc_t* disc)
@@ -47,6 +53,20 @@ static void memfree(void *heap, void *ptr)
     free(ptr);
 }
 
+#if defined(HAVE_MALLOC_USABLE_SIZE) || defined(_WIN32)
+static size_t memsize(void *heap, void *ptr)
+{
+    NOTUSED(heap);
+#ifdef _WIN32
+    return _msize(ptr);
+#else
+    return malloc_usable_size(ptr);
+#endif
+}
+#else
+#define memsize 0
+#endif
+
 #ifndef WRONG
 #define memclose 0
 #else
@@ -57,28 +77,247 @@ static void memclose(void *heap)
 #endif
 
 Agmemdisc_t AgMemDisc =
-    { memopen, memalloc, memresize, memfree, memclose };
+    { memopen, memalloc, memresize, memfree, memclose, memsize };
 
-void *agalloc(Agraph_t * g, size_t size)
+/* arena memory discipline
+ * Objects are carved out of large slabs owned by the root graph.
+ * Requests of up to ARENA_MAXSMALL bytes are rounded up to a multiple
+ * of ARENA_ALIGN and recycled through per-size-class free lists.
+ * Larger requests are passed on to malloc, but are kept on a list
+ * so that closing the arena releases everything at once, without
+ * agclose having to visit each node, edge and record.
+ */
+#define ARENA_ALIGN	16
+#define ARENA_MAXSMALL	1024
+#define ARENA_NCLASS	(ARENA_MAXSMALL / ARENA_ALIGN + 1)
+#define ARENA_SLABSIZE	(256 * 1024)
+#define ARENA_ROUND(n)	(((n) + ARENA_ALIGN - 1) & ~((size_t)ARENA_ALIGN - 1))
+
+/* every block is preceded by a header recording its rounded size */
+typedef union {
+    size_t size;
+    char pad[ARENA_ALIGN];
+} arenahdr_t;
+
+/* large blocks carry list links in front of the header */
+typedef struct arenabig_s {
+    struct arenabig_s *prev, *next;
+    arenahdr_t hdr;
+} arenabig_t;
+
+typedef union arenaslab_u {
+    union arenaslab_u *next;
+    char pad[ARENA_ALIGN];
+} arenaslab_t;
+
+typedef struct {
+    char *cur, *end;		/* unused tail of the current slab */
+    arenaslab_t *slabs;		/* all slabs, most recent first */
+    arenabig_t *big;		/* live large blocks */
+    void *freelist[ARENA_NCLASS];	/* recycled small blocks, by size class */
+} arena_t;
+
+#define ARENA_HDR(p)	((arenahdr_t *)(p) - 1)
+#define ARENA_BIG(p)	((arenabig_t *)((char *)ARENA_HDR(p) - offsetof(arenabig_t, hdr)))
+
+static void *arenaopen(Agdisc_t * disc)
+{
+    NOTUSED(disc);
+    return calloc(1, sizeof(arena_t));
+}
+
+static void *arenaalloc(void *heap, size_t request)
+{
+    arena_t *arena = heap;
+    arenahdr_t *hdr;
+    arenabig_t *big;
+    size_t sz, cls, need;
+    void *rv;
+
+    sz = ARENA_ROUND(request ? request : 1);
+    if (sz > ARENA_MAXSMALL) {
+	big = malloc(sizeof(arenabig_t) + sz);
+	if (!big)
+	    return NIL(void *);
+	big->prev = NIL(arenabig_t *);
+	big->next = arena->big;
+	if (arena->big)
+	    arena->big->prev = big;
+	arena->big = big;
+	big->hdr.size = sz;
+	rv = &big->hdr + 1;
+	memset(rv, 0, sz);
+	return rv;
+    }
+
+    cls = sz / ARENA_ALIGN;
+    if ((rv = arena->freelist[cls])) {
+	arena->freelist[cls] = *(void **) rv;
+	memset(rv, 0, sz);
+	return rv;
+    }
+
+    need = sizeof(arenahdr_t) + sz;
+    if ((size_t) (arena->end - arena->cur) < need) {
+	arenaslab_t *slab = malloc(ARENA_SLABSIZE);
+	if (!slab)
+	    return NIL(void *);
+	slab->next = arena->slabs;
+	arena->slabs = slab;
+	arena->cur = (char *) (slab + 1);
+	arena->end = (char *) slab + ARENA_SLABSIZE;
+    }
+    hdr = (arenahdr_t *) arena->cur;
+    arena->cur += need;
+    hdr->size = sz;
+    rv = hdr + 1;
+    memset(rv, 0, sz);		/* slab memory is not pre-zeroed */
+    return rv;
+}
+
+static void arenafree(void *heap, void *ptr)
+{
+    arena_t *arena = heap;
+    arenabig_t *big;
+    size_t sz;
+
+    sz = ARENA_HDR(ptr)->size;
+    if (sz > ARENA_MAXSMALL) {
+	big = ARENA_BIG(ptr);
+	if (big->prev)
+	    big->prev->next = big->next;
+	else
+	    arena->big = big->next;
+	if (big->next)
+	    big->next->prev = big->prev;
+	free(big);
+    } else {
+	*(void **) ptr = arena->freelist[sz / ARENA_ALIGN];
+	arena->freelist[sz / ARENA_ALIGN] = ptr;
+    }
+}
+
+static void *arenaresize(void *heap, void *ptr, size_t oldsize,
+			 size_t request)
+{
+    size_t sz;
+    void *rv;
+
+    sz = ARENA_HDR(ptr)->size;
+    if (request <= sz) {	/* still fits in the old block */
+	if (request > oldsize)
+	    memset((char *) ptr + oldsize, 0, request - oldsize);
+	return ptr;
+    }
+    rv = arenaalloc(heap, request);
+    if (rv) {
+	memcpy(rv, ptr, (oldsize < sz) ? oldsize : sz);
+	arenafree(heap, ptr);
+    }
+    return rv;
+}
+
+static size_t arenasize(void *heap, void *ptr)
+{
+    NOTUSED(heap);
+    return ARENA_HDR(ptr)->size;
+}
+
+static void arenaclose(void *heap)
+{
+    arena_t *arena = heap;
+    arenaslab_t *slab, *nslab;
+    arenabig_t *big, *nbig;
+
+    for (slab = arena->slabs; slab; slab = nslab) {
+	nslab = slab->next;
+	free(slab);
+    }
+    for (big = arena->big; big; big = nbig) {
+	nbig = big->next;
+	free(big);
+    }
+    free(arena);
+}
+
+Agmemdisc_t AgArenaMemDisc =
+    { arenaopen, arenaalloc, arenaresize, arenafree, arenaclose,
+      arenasize };
+
+/* memory accounting
+ * Every block allocated through agalloc and friends is charged to a
+ * category in counters kept by the root graph: records, attributes,
+ * strings and dictionaries use the category functions below, and
+ * everything else counts as graph structure. A block must be resized and
+ * freed with the category it was allocated with. Blocks are measured by the
+ * discipline's size function; without one, requests are counted but
+ * frees cannot be, and the counters only grow. Layouts may allocate
+ * from several threads, so the counters are updated atomically.
+ */
+#ifdef __GNUC__
+#define MEMGET(c)	__atomic_load_n(&(c), __ATOMIC_RELAXED)
+#define MEMADD(c,n)	__atomic_add_fetch(&(c), (n), __ATOMIC_RELAXED)
+#define MEMCAS(c,o,n)	__atomic_compare_exchange_n(&(c), &(o), (n), 1, \
+			__ATOMIC_RELAXED, __ATOMIC_RELAXED)
+#else
+#define MEMGET(c)	(c)
+#define MEMADD(c,n)	((c) += (n))
+#define MEMCAS(c,o,n)	((c) = (n), 1)
+#endif
+#define MEMMAX(c,n)	do { size_t o_ = MEMGET(c); \
+    while (((n) > o_) && !MEMCAS(c, o_, n)); } while (0)
+
+static size_t memblock(Agraph_t * g, void *ptr, size_t req)
+{
+    Agmemdisc_t *disc = AGDISC(g, mem);
+
+    return disc->size ? disc->size(AGCLOS(g, mem), ptr) : req;
+}
+
+static void memcharge(Agraph_t * g, int cat, size_t add, size_t sub)
+{
+    Agmemstat_t *st = &g->clos->memstat;
+    size_t total;
+
+    /* a block is resized and freed under the category it was allocated
+     * in, so a category always holds at least what is taken from it
+     */
+    assert(MEMGET(st->bytes[cat]) >= sub);
+    MEMADD(st->bytes[cat], add - sub);
+    total = MEMADD(st->total, add - sub);
+    MEMMAX(st->peak, total);
+}
+
+void *agmemalloc(Agraph_t * g, size_t size, int cat)
 {
     void *mem;
 
     mem = AGDISC(g, mem)->alloc(AGCLOS(g, mem), size);
     if (mem == NIL(void *))
 	 agerr(AGERR,"memory allocation failure");
+    else {
+	MEMADD(g->clos->memstat.nalloc, 1);
+	memcharge(g, cat, memblock(g, mem, size), 0);
+    }
     return mem;
 }
 
-void *agrealloc(Agraph_t * g, void *ptr, size_t oldsize, size_t size)
+void *agmemresize(Agraph_t * g, void *ptr, size_t oldsize, size_t size,
+		  int cat)
 {
     void *mem;
+    size_t old;
 
     if (size > 0) {
 	if (ptr == 0)
-	    mem = agalloc(g, size);
-	else
+	    mem = agmemalloc(g, size, cat);
+	else {
+	    old = memblock(g, ptr, oldsize);
 	    mem =
 		AGDISC(g, mem)->resize(AGCLOS(g, mem), ptr, oldsize, size);
+	    if (mem)
+		memcharge(g, cat, memblock(g, mem, size), old);
+	}
 	if (mem == NIL(void *))
 	     agerr(AGERR,"memory re-allocation failure");
     } else
@@ -86,10 +325,52 @@ void *agrealloc(Agraph_t * g, void *ptr, size_t oldsize, size_t size)
     return mem;
 }
 
+void agmemfree(Agraph_t * g, void *ptr, int cat)
+{
+    Agmemdisc_t *disc;
+
+    if (ptr) {
+	disc = AGDISC(g, mem);
+	MEMADD(g->clos->memstat.nfree, 1);
+	if (disc->size)
+	    memcharge(g, cat, 0, disc->size(AGCLOS(g, mem), ptr));
+	(disc->free) (AGCLOS(g, mem), ptr);
+    }
+}
+
+void *agalloc(Agraph_t * g, size_t size)
+{
+    return agmemalloc(g, size, AGMEM_GRAPH);
+}
+
+void *agrealloc(Agraph_t * g, void *ptr, size_t oldsize, size_t size)
+{
+    return agmemresize(g, ptr, oldsize, size, AGMEM_GRAPH);
+}
+
 void agfree(Agraph_t * g, void *ptr)
 {
-    if (ptr)
-	(AGDISC(g, mem)->free) (AGCLOS(g, mem), ptr);
+    agmemfree(g, ptr, AGMEM_GRAPH);
+}
+
+/* agmemstat:
+ * Copy the memory counters of the root of g.
+ */
+void agmemstat(Agraph_t * g, Agmemstat_t * st)
+{
+    *st = g->clos->memstat;
+    st->exact = (AGDISC(g, mem)->size != 0);
+}
+
+char *agmemcatname(int cat)
+{
+    static char *names[AGMEM_NCAT] = {
+	"graph", "records", "attributes", "strings", "dictionaries"
+    };
+
+    if ((cat < 0) || (cat >= AGMEM_NCAT))
+	return NIL(char *);
+    return names[cat];
 }
 
 #ifndef _VMALLOC_H
@@ -16,8 +16,8 @@
 Agnode_t *agfindnode_by_id(Agraph_t * g, IDTYPE id)
 {
     Agsubnode_t *sn;
-    static Agsubnode_t template;
-    static Agnode_t dummy;
+    Agsubnode_t template;
+    Agnode_t dummy;
 
     dummy.base.tag.id = id;
     template.node = &dummy;
@@ -96,8 +96,11 @@ static void installnode(Agraph_t * g, Agnode_t * n)
     sn->node = n;
     dtinsert(g->n_id, sn);
     dtinsert(g->n_seq, sn);
+    if (g->n_bits)
+	agsetadd(g->n_bits, n);
     assert(dtsize(g->n_id) == dtsize(g->n_seq));
     assert(dtsize(g->n_id) == osize + 1);
+    g->clos->gen++;
 }
 
 static void installnodetoroot(Agraph_t * g, Agnode_t * n)
@@ -169,12 +172,139 @@ Agnode_t *agnode(Agraph_t * g, char *name, int cflag)
     return NILnode;
 }
 
+/* Bulk construction
+ * agnodes_bulk creates or finds the nodes of a batch, and then installs
+ * the new ones in each graph up to the root in ID order, so that the
+ * insertions into the ID dictionaries are next to each other.
+ * New nodes are found by ID in an open addressing table, in case a
+ * name occurs more than once in the batch.
+ */
+typedef struct {
+    Agnode_t **slot;
+    size_t mask;
+} nodeset_t;
+
+static Agnode_t **nodeset_find(nodeset_t * set, IDTYPE id)
+{
+    size_t i;
+    Agnode_t *n;
+
+    i = (size_t) ((id * 0x9E3779B97F4A7C15ULL) >> 32) & set->mask;
+    while ((n = set->slot[i]) && (AGID(n) != id))
+	i = (i + 1) & set->mask;
+    return &set->slot[i];
+}
+
+static int subnodeidcmp(const void *p0, const void *p1)
+{
+    Agnode_t *n0 = (*(Agsubnode_t **) p0)->node;
+    Agnode_t *n1 = (*(Agsubnode_t **) p1)->node;
+
+    if (AGID(n0) < AGID(n1)) return -1;
+    if (AGID(n0) > AGID(n1)) return 1;
+    return 0;
+}
+
+/* installnodes:
+ * Like installnodetoroot for each of the cnt nodes in list.
+ */
+static void installnodes(Agraph_t * g, Agnode_t ** list, int cnt)
+{
+    Agraph_t *sg;
+    Agsubnode_t **sns, **byid;
+    int i;
+
+    sns = agalloc(g, cnt * sizeof(Agsubnode_t *));
+    byid = agalloc(g, cnt * sizeof(Agsubnode_t *));
+    for (sg = g; sg; sg = agparent(sg)) {
+	for (i = 0; i < cnt; i++) {
+	    if (sg == agroot(sg)) sns[i] = &(list[i]->mainsub);
+	    else sns[i] = agalloc(sg, sizeof(Agsubnode_t));
+	    sns[i]->node = list[i];
+	}
+	memcpy(byid, sns, cnt * sizeof(Agsubnode_t *));
+	qsort(byid, cnt, sizeof(Agsubnode_t *), subnodeidcmp);
+	for (i = 0; i < cnt; i++)
+	    dtinsert(sg->n_id, byid[i]);
+	for (i = 0; i < cnt; i++)
+	    dtinsert(sg->n_seq, sns[i]);
+	if (sg->n_bits)
+	    for (i = 0; i < cnt; i++)
+		agsetadd(sg->n_bits, list[i]);
+	assert(dtsize(sg->n_id) == dtsize(sg->n_seq));
+	sg->clos->gen++;
+    }
+    agfree(g, sns);
+    agfree(g, byid);
+}
+
+/* agnodes_bulk:
+ * Find or create the nodes named in names[0..cnt-1] in g, as agnode
+ * would, storing them in nodes if it is not NULL. If names is NULL,
+ * cnt anonymous nodes are created. Nodes are numbered in array order,
+ * but the init callbacks of the new nodes are only invoked after all
+ * of them have been installed.
+ * Returns SUCCESS, or FAILURE if some node could not be created, in
+ * which case its entry in nodes is NULL.
+ */
+int agnodes_bulk(Agraph_t * g, int cnt, char **names, Agnode_t ** nodes)
+{
+    Agraph_t *root;
+    Agnode_t *n, **list;
+    nodeset_t set;
+    IDTYPE id;
+    char *name;
+    size_t sz;
+    int i, nnew, rv;
+
+    if (cnt <= 0)
+	return SUCCESS;
+    root = agroot(g);
+    for (sz = 2; sz < 2 * (size_t) cnt; sz *= 2);
+    set.slot = agalloc(g, sz * sizeof(Agnode_t *));
+    set.mask = sz - 1;
+    list = agalloc(g, cnt * sizeof(Agnode_t *));
+    nnew = 0;
+    rv = SUCCESS;
+
+    for (i = 0; i < cnt; i++) {
+	name = names ? names[i] : NILstr;
+	n = NILnode;
+	if (agmapnametoid(g, AGNODE, name, &id, FALSE)) {
+	    if (!(n = agfindnode_by_id(g, id)))
+		n = *nodeset_find(&set, id);
+	    if (!n && (g != root) && (n = agfindnode_by_id(root, id)))
+		n = agsubnode(g, n, TRUE);
+	}
+	if (!n && agmapnametoid(g, AGNODE, name, &id, TRUE)) {
+	    n = newnode(g, id, agnextseq(g, AGNODE));
+	    *nodeset_find(&set, id) = n;
+	    list[nnew++] = n;
+	}
+	if (!n)
+	    rv = FAILURE;
+	if (nodes)
+	    nodes[i] = n;
+    }
+
+    if (nnew > 0) {
+	installnodes(g, list, nnew);
+	for (i = 0; i < nnew; i++) {
+	    initnode(g, list[i]);
+	    agregister(g, AGNODE, list[i]);
+	}
+    }
+    agfree(g, set.slot);
+    agfree(g, list);
+    return rv;
+}
+
 /* removes image of node and its edges from graph.
    caller must ensure n belongs to g. */
 void agdelnodeimage(Agraph_t * g, Agnode_t * n, void *ignored)
 {
     Agedge_t *e, *f;
-    static Agsubnode_t template;
+    Agsubnode_t template;
     template.node = n;
 
     NOTUSED(ignored);
@@ -187,6 +317,9 @@ void agdelnodeimage(Agraph_t * g, Agnode_t * n, void *ignored)
      */ 
     dtdelete(g->n_id, &template);
     dtdelete(g->n_seq, &template);
+    if (g->n_bits)
+	agsetdel(g->n_bits, n);
+    g->clos->gen++;
 }
 
 int agdelnode(Agraph_t * g, Agnode_t * n)
@@ -258,6 +391,8 @@ Agnode_t *agsubnode(Agraph_t * g, Agnode_t * n0, int cflag)
 
     if (agroot(g) != n0->root)
 	return NILnode;
+    if (g->n_bits && !cflag)
+	return agsethas(g->n_bits, n0) ? n0 : NILnode;
     n = agfindnode_by_id(g, AGID(n0));
     if ((n == NILnode) && cflag) {
 	if ((par = agparent(g))) {
@@ -337,16 +472,19 @@ Dtdisc_t Ag_subnode_seq_disc = {
 
 void agnodesetfinger(Agraph_t * g, Agnode_t * n, void *ignored)
 {
-    static Agsubnode_t template;
+    Agsubnode_t template;
 	template.node = n;
 	dtsearch(g->n_seq,&template);
+    if (g->n_bits)
+	agsetdel(g->n_bits, n);
     NOTUSED(ignored);
 }
 
 void agnoderenew(Agraph_t * g, Agnode_t * n, void *ignored)
 {
     dtrenew(g->n_seq, dtfinger(g->n_seq));
-    NOTUSED(n);
+    if (g->n_bits)
+	agsetadd(g->n_bits, n);
     NOTUSED(ignored);
 }
 
@@ -358,6 +496,7 @@ int agnodebefore(Agnode_t *fst, Agnode_t *snd)
 
 	g = agroot(fst);
 	if (AGSEQ(fst) > AGSEQ(snd)) return SUCCESS;
+	g->clos->gen++;
 
 	/* move snd out of the way somewhere */
 	n = snd;
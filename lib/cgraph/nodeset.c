@@ -0,0 +1,223 @@
+/* $Id$ $Revision$ */
+/* vim:set shiftwidth=4 ts=8: */
+
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: See CVS logs. Details at http://www.graphviz.org/
+ *************************************************************************/
+
+#include <cghdr.h>
+
+/* Membership bitsets
+ * A set of nodes (or, internally, edges) of a root graph is a bit
+ * vector indexed by sequence number, which the root hands out densely.
+ * When enabled with agsubgbits, every subgraph keeps such a set of its
+ * nodes in step with its dictionaries, so membership tests do not
+ * search the node dictionary. The dictionaries are still kept, as they
+ * give the iteration order, so the sets cost memory rather than save it.
+ */
+
+#define SETBITS 64
+#define SETWORD(seq)	((seq) / SETBITS)
+#define SETMASK(seq)	((uint64_t)1 << ((seq) % SETBITS))
+
+struct Agnodeset_s {
+    Agraph_t *root;
+    int kind;			/* AGNODE or AGEDGE */
+    size_t nwords;
+    uint64_t *w;
+};
+
+/* setgrow:
+ * Make room for sequence number seq, and all numbers in use.
+ */
+static void setgrow(Agnodeset_t * s, uint64_t seq)
+{
+    size_t n;
+
+    n = SETWORD(s->root->clos->seq[s->kind]) + 1;
+    if (n <= SETWORD(seq))
+	n = SETWORD(seq) + 1;
+    if (n < 2 * s->nwords)
+	n = 2 * s->nwords;
+    s->w = agrealloc(s->root, s->w, s->nwords * sizeof(uint64_t),
+		     n * sizeof(uint64_t));
+    s->nwords = n;
+}
+
+Agnodeset_t *agsetopen(Agraph_t * g, int kind)
+{
+    Agnodeset_t *s;
+
+    s = agalloc(g, sizeof(Agnodeset_t));
+    s->root = agroot(g);
+    s->kind = kind;
+    return s;
+}
+
+void agsetadd(Agnodeset_t * s, void *obj)
+{
+    uint64_t seq = AGSEQ(obj);
+
+    if (SETWORD(seq) >= s->nwords)
+	setgrow(s, seq);
+    s->w[SETWORD(seq)] |= SETMASK(seq);
+}
+
+void agsetdel(Agnodeset_t * s, void *obj)
+{
+    uint64_t seq = AGSEQ(obj);
+
+    if (SETWORD(seq) < s->nwords)
+	s->w[SETWORD(seq)] &= ~SETMASK(seq);
+}
+
+int agsethas(Agnodeset_t * s, void *obj)
+{
+    uint64_t seq = AGSEQ(obj);
+
+    if (SETWORD(seq) >= s->nwords)
+	return FALSE;
+    return ((s->w[SETWORD(seq)] & SETMASK(seq)) != 0);
+}
+
+/* agsetor:
+ * Add the members of b to s.
+ */
+void agsetor(Agnodeset_t * s, Agnodeset_t * b)
+{
+    size_t i;
+
+    if (b->nwords > s->nwords)
+	setgrow(s, b->nwords * SETBITS - 1);
+    for (i = 0; i < b->nwords; i++)
+	s->w[i] |= b->w[i];
+}
+
+/* agsetunion:
+ * Add the nodes or edges of g to s, by words if g keeps a node set.
+ */
+void agsetunion(Agnodeset_t * s, Agraph_t * g)
+{
+    Agnode_t *n;
+    Agedge_t *e;
+
+    if (s->kind == AGNODE && g->n_bits) {
+	agsetor(s, g->n_bits);
+	return;
+    }
+    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	if (s->kind == AGNODE)
+	    agsetadd(s, n);
+	else
+	    for (e = agfstout(g, n); e; e = agnxtout(g, e))
+		agsetadd(s, e);
+    }
+}
+
+void agsetclose(Agnodeset_t * s)
+{
+    if (!s)
+	return;
+    agfree(s->root, s->w);
+    agfree(s->root, s);
+}
+
+static void subgbits(Agraph_t * g, int flag)
+{
+    Agraph_t *subg;
+    Agnodeset_t *s;
+
+    for (subg = agfstsubg(g); subg; subg = agnxtsubg(subg)) {
+	if (flag && !subg->n_bits) {
+	    s = agsetopen(subg, AGNODE);
+	    agsetunion(s, subg);
+	    subg->n_bits = s;
+	} else if (!flag) {
+	    agsetclose(subg->n_bits);
+	    subg->n_bits = NIL(Agnodeset_t *);
+	}
+	subgbits(subg, flag);
+    }
+}
+
+/* agsubgbits:
+ * Turn maintained node sets on or off for the subgraphs of g,
+ * including those created later. Return the previous setting.
+ */
+int agsubgbits(Agraph_t * g, int flag)
+{
+    int prev;
+
+    g = agroot(g);
+    prev = g->clos->subg_bits;
+    g->clos->subg_bits = (flag != 0);
+    if (prev != g->clos->subg_bits)
+	subgbits(g, flag);
+    return prev;
+}
+
+/* agissubnode:
+ * Return true if n is a node of g.
+ */
+int agissubnode(Agraph_t * g, Agnode_t * n)
+{
+    if (agroot(g) != n->root)
+	return FALSE;
+    if (g == agroot(g))
+	return TRUE;
+    if (g->n_bits)
+	return agsethas(g->n_bits, n);
+    return (agsubrep(g, n) != NIL(Agsubnode_t *));
+}
+
+/* agnodeset:
+ * Return a new set holding the nodes of g.
+ */
+Agnodeset_t *agnodeset(Agraph_t * g)
+{
+    Agnodeset_t *s;
+
+    s = agsetopen(g, AGNODE);
+    agsetunion(s, g);
+    return s;
+}
+
+void agnodesetunion(Agnodeset_t * s, Agraph_t * g)
+{
+    agsetunion(s, g);
+}
+
+/* agnodesetinter:
+ * Remove from s the nodes that are not in g.
+ */
+void agnodesetinter(Agnodeset_t * s, Agraph_t * g)
+{
+    Agnodeset_t *b;
+    size_t i;
+
+    if (g == s->root)
+	return;
+    b = g->n_bits ? g->n_bits : agnodeset(g);
+    for (i = 0; i < s->nwords; i++)
+	s->w[i] &= (i < b->nwords) ? b->w[i] : 0;
+    if (b != g->n_bits)
+	agsetclose(b);
+}
+
+int agnodesetmember(Agnodeset_t * s, Agnode_t * n)
+{
+    if (s->root != n->root)
+	return FALSE;
+    return agsethas(s, n);
+}
+
+void agnodesetfree(Agnodeset_t * s)
+{
+    agsetclose(s);
+}
@@ -96,7 +96,8 @@ void aginitcb(Agraph_t * g, void *obj, Agcbstack_t * cbstack)
     case AGNODE:
 	fn = cbstack->f->node.ins;
 	break;
-    case AGEDGE:
+    case AGINEDGE:
+    case AGOUTEDGE:
 	fn = cbstack->f->edge.ins;
 	break;
     }
@@ -127,7 +128,8 @@ void agupdcb(Agraph_t * g, void *obj, Agsym_t * sym, Agcbstack_t * cbstack)
     case AGNODE:
 	fn = cbstack->f->node.mod;
 	break;
-    case AGEDGE:
+    case AGINEDGE:
+    case AGOUTEDGE:
 	fn = cbstack->f->edge.mod;
 	break;
     }
@@ -158,7 +160,8 @@ void agdelcb(Agraph_t * g, void *obj, Agcbstack_t * cbstack)
     case AGNODE:
 	fn = cbstack->f->node.del;
 	break;
-    case AGEDGE:
+    case AGINEDGE:
+    case AGOUTEDGE:
 	fn = cbstack->f->edge.del;
 	break;
     }
@@ -255,7 +258,7 @@ int agcontains(Agraph_t* g, void* obj)
 	} while ((subg = agparent (subg)));
 	return 0;
     case AGNODE: 
-        return (agidnode(g, AGID(obj), 0) != 0);
+        return agissubnode(g, (Agnode_t *) obj);
     default:
         return (agsubedge(g, (Agedge_t *) obj, 0) != 0);
     }
@@ -64,7 +64,9 @@ static Dtdisc_t Disc = {
     NIL(Dtmake_f),
     freef,
     NIL(Dtcompar_f),
-    NIL(Dthash_f)
+    NIL(Dthash_f),
+    agdictobjmem,
+    NIL(Dtevent_f)
 };
 
 static Dict_t *dictof(pendingset_t * ds, Agobj_t * obj, int kind)
@@ -17,6 +17,111 @@
  * run time records
  */
 
+struct Agrecslots_s {
+    int size;
+    Agrec_t *rec[1];		/* actually size */
+};
+
+#define SLOTSIZE(n)	(sizeof(Agrecslots_t) + ((n) - 1) * sizeof(Agrec_t *))
+
+/* recslotof:
+ * Return the slot of the record name in g, or -1 if it has none.
+ * Callers nearly always pass the same string constant for a record, so
+ * the last pointer seen for each name is tried first.
+ */
+static int recslotof(Agraph_t * g, char *name)
+{
+    Agclos_t *clos = g->clos;
+    int i;
+
+    for (i = 0; i < clos->nrecslot; i++)
+	if (clos->recalias[i] == name) {
+	    if (streq(clos->recname[i], name))
+		return i;
+	    break;
+	}
+    for (i = 0; i < clos->nrecslot; i++)
+	if (streq(clos->recname[i], name)) {
+	    clos->recalias[i] = name;
+	    return i;
+	}
+    return -1;
+}
+
+/* agrecslot:
+ * Return the slot of the record name in the root of g, giving it the
+ * next one if it has none. Slots are never reused while the graph is open.
+ */
+int agrecslot(Agraph_t * g, char *name)
+{
+    Agclos_t *clos = g->clos;
+    int slot;
+
+    if ((slot = recslotof(g, name)) < 0) {
+	slot = clos->nrecslot++;
+	clos->recname = agmemresize(g, clos->recname,
+				    slot * sizeof(char *),
+				    clos->nrecslot * sizeof(char *), AGMEM_REC);
+	clos->recalias = agmemresize(g, clos->recalias,
+				     slot * sizeof(char *),
+				     clos->nrecslot * sizeof(char *),
+				     AGMEM_REC);
+	clos->recname[slot] = agstrdup(g, name);
+	clos->recalias[slot] = name;
+    }
+    return slot;
+}
+
+void agrecslotclose(Agraph_t * g)
+{
+    Agclos_t *clos = g->clos;
+    int i;
+
+    for (i = 0; i < clos->nrecslot; i++)
+	agstrfree(g, clos->recname[i]);
+    agmemfree(g, clos->recname, AGMEM_REC);
+    agmemfree(g, (void *) clos->recalias, AGMEM_REC);
+    clos->recname = NIL(char **);
+    clos->recalias = NIL(const char **);
+    clos->nrecslot = 0;
+}
+
+/* aggetrecslot:
+ * Return the record of obj in the given slot, or NULL.
+ */
+Agrec_t *aggetrecslot(void *obj, int slot)
+{
+    Agrecslots_t *slots = ((Agobj_t *) obj)->slots;
+
+    if (slots && (slot >= 0) && (slot < slots->size))
+	return slots->rec[slot];
+    return NIL(Agrec_t *);
+}
+
+/* set_slot:
+ * Put rec, which may be NULL, in the given slot of obj, enlarging its
+ * array if needed. Both halves of an edge share the array.
+ */
+static void set_slot(Agraph_t * g, Agobj_t * obj, int slot, Agrec_t * rec)
+{
+    Agrecslots_t *slots = obj->slots;
+    int osize, size;
+
+    if (!slots || (slot >= slots->size)) {
+	osize = slots ? slots->size : 0;
+	size = g->clos->nrecslot;	/* room for every slot so far */
+	if (size <= slot)
+	    size = slot + 1;
+	slots = agmemresize(g, slots, osize ? SLOTSIZE(osize) : 0,
+			    SLOTSIZE(size), AGMEM_REC);
+	slots->size = size;
+	obj->slots = slots;
+	if ((AGTYPE(obj) == AGINEDGE) || (AGTYPE(obj) == AGOUTEDGE))
+	    agopp((Agedge_t *) obj)->base.slots = slots;
+    }
+    slots->rec[slot] = rec;
+}
+
 static void set_data(Agobj_t * obj, Agrec_t * data, int mtflock)
 {
     Agedge_t *e;
@@ -30,31 +135,22 @@ static void set_data(Agobj_t * obj, Agrec_t * data, int mtflock)
     }
 }
 
-/* find record in circular list and do optional move-to-front */
+/* find record by its slot and do optional move-to-front */
 Agrec_t *aggetrec(void *obj, char *name, int mtf)
 {
     Agobj_t *hdr;
-    Agrec_t *d, *first;
+    Agrec_t *d;
 
     hdr = (Agobj_t *) obj;
-    first = d = hdr->data;
-    while (d) {
-	if ((d->name == name) || streq(name, d->name))
-	    break;
-	d = d->next;
-	if (d == first) {
-	    d = NIL(Agrec_t *);
-	    break;
-	}
-    }
-    if (d) {
+    if (!hdr->slots)
+	return NIL(Agrec_t *);
+    d = aggetrecslot(hdr, recslotof(agraphof(hdr), name));
+    if (d && mtf) {
 	if (hdr->tag.mtflock) {
-	    if (mtf && (hdr->data != d))
+	    if (hdr->data != d)
 		agerr(AGERR, "move to front lock inconsistency");
-	} else {
-	    if ((d != first) || (mtf != hdr->tag.mtflock))
-		set_data(hdr, d, mtf);	/* Always optimize */
-	}
+	} else
+	    set_data(hdr, d, TRUE);
     }
     return d;
 }
@@ -94,8 +190,9 @@ void *agbindrec(void *arg_obj, char *recname, unsigned int recsize,
     g = agraphof(obj);
     rec = aggetrec(obj, recname, FALSE);
     if ((rec == NIL(Agrec_t *)) && (recsize > 0)) {
-	rec = (Agrec_t *) agalloc(g, recsize);
+	rec = (Agrec_t *) agmemalloc(g, recsize, AGMEM_REC);
 	rec->name = agstrdup(g, recname);
+	set_slot(g, obj, agrecslot(g, recname), rec);
 	switch (obj->tag.objtype) {
 	case AGRAPH:
 	    objputrec(g, obj, rec);
@@ -152,6 +249,7 @@ int agdelrec(void *arg_obj, char *name)
     g = agraphof(obj);
     rec = aggetrec(obj, name, FALSE);
     if (rec) {
+	set_slot(g, obj, recslotof(g, name), NIL(Agrec_t *));
 	listdelrec(obj, rec);	/* zap it from the circular list */
 	switch (obj->tag.objtype) {	/* refresh any stale pointers */
 	case AGRAPH:
@@ -164,7 +262,7 @@ int agdelrec(void *arg_obj, char *name)
 	    break;
 	}
 	agstrfree(g, rec->name);
-	agfree(g, rec);
+	agmemfree(g, rec, AGMEM_REC);
 	return SUCCESS;
     } else
 	return FAILURE;
@@ -270,9 +368,11 @@ void agrecclose(Agobj_t * obj)
 	do {
 	    nrec = rec->next;
 	    agstrfree(g, rec->name);
-	    agfree(g, rec);
+	    agmemfree(g, rec, AGMEM_REC);
 	    rec = nrec;
 	} while (rec != obj->data);
     }
     obj->data = NIL(Agrec_t *);
+    agmemfree(g, obj->slots, AGMEM_REC);
+    obj->slots = NIL(Agrecslots_t *);
 }
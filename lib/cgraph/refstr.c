@@ -19,72 +19,194 @@
 
 /*
  * reference counted strings.
+ *
+ * Strings are interned in an open addressing hash table with linear
+ * probing. Each slot caches the hash and length of its string, so most
+ * probes are resolved without touching the string itself. The string
+ * bytes are stored inline at the end of their refstr_t, which is
+ * allocated from the graph's memory discipline.
  */
 
-static uint64_t HTML_BIT;	/* msbit of uint64_t */
-static uint64_t CNT_BITS;	/* complement of HTML_BIT */
+#define HTML_BIT	((uint64_t) (((unsigned int) 1) << (sizeof(unsigned int) * 8 - 1)))
+#define CNT_BITS	(~HTML_BIT)
 
 typedef struct refstr_t {
-    Dtlink_t link;
     uint64_t refcnt;
-    char *s;
+    unsigned int hash;
+    unsigned int len;
     char store[1];		/* this is actually a dynamic array */
 } refstr_t;
 
-static Dtdisc_t Refstrdisc = {
-    offsetof(refstr_t, s),	/* key */
-    -1,				/* size */
-    0,				/* link offset */
-    NIL(Dtmake_f),
-    agdictobjfree,
-    NIL(Dtcompar_f),
-    NIL(Dthash_f),
-    agdictobjmem,
-    NIL(Dtevent_f)
+typedef struct {
+    unsigned int hash;
+    unsigned int len;
+    refstr_t *r;		/* NULL if the slot is empty */
+} strslot_t;
+
+struct Agstrtab_s {
+    strslot_t *slot;
+    size_t size;		/* number of slots, a power of 2 */
+    size_t cnt;			/* number of strings */
 };
 
-static Dict_t *Refdict_default;
+#define MINTABSIZE	256
+#define MAXLOAD(sz)	(((sz) >> 1) + ((sz) >> 2))	/* 75% full */
+
+/* strings interned without a graph; each thread has its own */
+static AGTLS Agstrtab_t *Refdict_default;
+
+/* refhash:
+ * FNV-1a hash of s, also returning its length.
+ */
+static unsigned int refhash(const char *s, size_t * lenp)
+{
+    const unsigned char *p = (const unsigned char *) s;
+    unsigned int h = 2166136261U;
+
+    while (*p) {
+	h ^= *p++;
+	h *= 16777619U;
+    }
+    *lenp = (size_t) (p - (const unsigned char *) s);
+    return h;
+}
+
+static void *refalloc(Agraph_t * g, size_t sz)
+{
+    if (g)
+	return agmemalloc(g, sz, AGMEM_STR);
+    else
+	return calloc(1, sz);
+}
+
+static void reffree(Agraph_t * g, void *p)
+{
+    if (g)
+	agmemfree(g, p, AGMEM_STR);
+    else
+	free(p);
+}
 
 /* refdict:
- * Return the string dictionary associated with g.
+ * Return the string table associated with g.
  * If necessary, create it.
  * As a side-effect, set html masks. This assumes 8-bit bytes.
  */
-static Dict_t *refdict(Agraph_t * g)
+static Agstrtab_t *refdict(Agraph_t * g)
 {
-    Dict_t **dictref;
+    Agstrtab_t **dictref;
 
     if (g)
 	dictref = &(g->clos->strdict);
     else
 	dictref = &Refdict_default;
-    if (*dictref == NIL(Dict_t *)) {
-	*dictref = agdtopen(g, &Refstrdisc, Dttree);
-	HTML_BIT = ((unsigned int) 1) << (sizeof(unsigned int) * 8 - 1);
-	CNT_BITS = ~HTML_BIT;
+    if (*dictref == NIL(Agstrtab_t *)) {
+	*dictref = refalloc(g, sizeof(Agstrtab_t));
+	(*dictref)->size = MINTABSIZE;
+	(*dictref)->slot = refalloc(g, MINTABSIZE * sizeof(strslot_t));
     }
     return *dictref;
 }
 
 int agstrclose(Agraph_t * g)
 {
-    return agdtclose(g, refdict(g));
+    Agstrtab_t *strdict = refdict(g);
+    size_t i;
+
+    for (i = 0; i < strdict->size; i++)
+	if (strdict->slot[i].r)
+	    reffree(g, strdict->slot[i].r);
+    reffree(g, strdict->slot);
+    reffree(g, strdict);
+    if (g)
+	g->clos->strdict = NIL(Agstrtab_t *);
+    else
+	Refdict_default = NIL(Agstrtab_t *);
+    return 0;
 }
 
-static refstr_t *refsymbind(Dict_t * strdict, char *s)
+/* refslot:
+ * Return the slot holding s, or the empty slot where it belongs.
+ */
+static strslot_t *refslot(Agstrtab_t * strdict, const char *s,
+			  unsigned int hash, size_t len)
 {
-    refstr_t key, *r;
-    key.s = s;
-    r = (refstr_t *) dtsearch(strdict, &key);
-    return r;
+    size_t mask = strdict->size - 1;
+    size_t i = hash & mask;
+    strslot_t *sp;
+
+    for (;;) {
+	sp = &strdict->slot[i];
+	if (sp->r == NIL(refstr_t *))
+	    return sp;
+	if ((sp->hash == hash) && (sp->len == len)
+	    && !memcmp(sp->r->store, s, len))
+	    return sp;
+	i = (i + 1) & mask;
+    }
 }
 
-static char *refstrbind(Dict_t * strdict, char *s)
+static void refgrow(Agraph_t * g, Agstrtab_t * strdict)
+{
+    strslot_t *oslot = strdict->slot, *sp;
+    size_t osize = strdict->size, i;
+
+    strdict->size = 2 * osize;
+    strdict->slot = refalloc(g, strdict->size * sizeof(strslot_t));
+    for (i = 0; i < osize; i++) {
+	if (oslot[i].r == NIL(refstr_t *))
+	    continue;
+	sp = &strdict->slot[oslot[i].hash & (strdict->size - 1)];
+	while (sp->r) {
+	    if (++sp == strdict->slot + strdict->size)
+		sp = strdict->slot;
+	}
+	*sp = oslot[i];
+    }
+    reffree(g, oslot);
+}
+
+/* refdelete:
+ * Empty the slot sp, moving later entries of its probe sequence
+ * back so that no tombstones are needed.
+ */
+static void refdelete(Agstrtab_t * strdict, strslot_t * sp)
+{
+    size_t mask = strdict->size - 1;
+    size_t i = (size_t) (sp - strdict->slot), j = i, k;
+
+    for (;;) {
+	strdict->slot[i].r = NIL(refstr_t *);
+	for (;;) {
+	    j = (j + 1) & mask;
+	    if (strdict->slot[j].r == NIL(refstr_t *)) {
+		strdict->cnt--;
+		return;
+	    }
+	    k = strdict->slot[j].hash & mask;
+	    /* entry j can move to i if its home k is not in (i, j] */
+	    if ((i <= j) ? ((i < k) && (k <= j)) : ((i < k) || (k <= j)))
+		continue;
+	    break;
+	}
+	strdict->slot[i] = strdict->slot[j];
+	i = j;
+    }
+}
+
+static refstr_t *refsymbind(Agstrtab_t * strdict, char *s)
+{
+    size_t len;
+    unsigned int hash = refhash(s, &len);
+    return refslot(strdict, s, hash, len)->r;
+}
+
+static char *refstrbind(Agstrtab_t * strdict, char *s)
 {
     refstr_t *r;
     r = refsymbind(strdict, s);
     if (r)
-	return r->s;
+	return r->store;
     else
 	return NIL(char *);
 }
@@ -94,76 +216,68 @@ char *agstrbind(Agraph_t * g, char *s)
     return refstrbind(refdict(g), s);
 }
 
-char *agstrdup(Agraph_t * g, char *s)
+static char *refstrdup(Agraph_t * g, char *s, uint64_t html)
 {
     refstr_t *r;
-    Dict_t *strdict;
-    size_t sz;
+    Agstrtab_t *strdict;
+    strslot_t *sp;
+    unsigned int hash;
+    size_t len;
 
     if (s == NIL(char *))
 	 return NIL(char *);
     strdict = refdict(g);
-    r = refsymbind(strdict, s);
-    if (r)
+    hash = refhash(s, &len);
+    sp = refslot(strdict, s, hash, len);
+    if ((r = sp->r))
 	r->refcnt++;
     else {
-	sz = sizeof(refstr_t) + strlen(s);
-	if (g)
-	    r = (refstr_t *) agalloc(g, sz);
-	else
-	    r = (refstr_t *) malloc(sz);
-	r->refcnt = 1;
-	strcpy(r->store, s);
-	r->s = r->store;
-	dtinsert(strdict, r);
+	r = (refstr_t *) refalloc(g, sizeof(refstr_t) + len);
+	r->refcnt = 1 | html;
+	r->hash = hash;
+	r->len = len;
+	memcpy(r->store, s, len + 1);
+	sp->hash = hash;
+	sp->len = len;
+	sp->r = r;
+	if (++strdict->cnt > MAXLOAD(strdict->size))
+	    refgrow(g, strdict);
     }
-    return r->s;
+    return r->store;
 }
 
-char *agstrdup_html(Agraph_t * g, char *s)
+char *agstrdup(Agraph_t * g, char *s)
 {
-    refstr_t *r;
-    Dict_t *strdict;
-    size_t sz;
+    return refstrdup(g, s, 0);
+}
 
+char *agstrdup_html(Agraph_t * g, char *s)
+{
     if (s == NIL(char *))
 	 return NIL(char *);
-    strdict = refdict(g);
-    r = refsymbind(strdict, s);
-    if (r)
-	r->refcnt++;
-    else {
-	sz = sizeof(refstr_t) + strlen(s);
-	if (g)
-	    r = (refstr_t *) agalloc(g, sz);
-	else
-	    r = (refstr_t *) malloc(sz);
-	r->refcnt = 1 | HTML_BIT;
-	strcpy(r->store, s);
-	r->s = r->store;
-	dtinsert(strdict, r);
-    }
-    return r->s;
+    return refstrdup(g, s, HTML_BIT);
 }
 
 int agstrfree(Agraph_t * g, char *s)
 {
     refstr_t *r;
-    Dict_t *strdict;
+    Agstrtab_t *strdict;
+    strslot_t *sp;
+    unsigned int hash;
+    size_t len;
 
     if (s == NIL(char *))
 	 return FAILURE;
 
     strdict = refdict(g);
-    r = refsymbind(strdict, s);
-    if (r && (r->s == s)) {
+    hash = refhash(s, &len);
+    sp = refslot(strdict, s, hash, len);
+    r = sp->r;
+    if (r && (r->store == s)) {
 	r->refcnt--;
 	if ((r->refcnt && CNT_BITS) == 0) {
-	    agdtdelete(g, strdict, r);
-	    /*
-	       if (g) agfree(g,r);
-	       else free(r);
-	     */
+	    refdelete(strdict, sp);
+	    reffree(g, r);
 	}
     }
     if (r == NIL(refstr_t *))
@@ -196,20 +310,18 @@ void agmarkhtmlstr(char *s)
 }
 
 #ifdef DEBUG
-static int refstrprint(Dict_t * dict, void *ptr, void *user)
+void agrefstrdump(Agraph_t * g)
 {
+    size_t i;
     refstr_t *r;
 
-    NOTUSED(dict);
-    r = ptr;
-    NOTUSED(user);
-    write(2, r->s, strlen(r->s));
-    write(2, "\n", 1);
-    return 0;
-}
-
-void agrefstrdump(Agraph_t * g)
-{
-    dtwalk(Refdict_default, refstrprint, 0);
+    if (!Refdict_default)
+	return;
+    for (i = 0; i < Refdict_default->size; i++) {
+	if ((r = Refdict_default->slot[i].r)) {
+	    write(2, r->store, r->len);
+	    write(2, "\n", 1);
+	}
+    }
 }
 #endif
@@ -0,0 +1,97 @@
+/* $Id$ $Revision$ */
+/* vim:set shiftwidth=4 ts=8: */
+
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: See CVS logs. Details at http://www.graphviz.org/
+ *************************************************************************/
+
+#include <cghdr.h>
+
+/* Side tables
+ * A side table is a flat array of fixed size elements, one per node or
+ * per edge of a graph that uses AgDenseIdDisc, found by the object's
+ * index. It grows as objects are created, with new elements zeroed.
+ * Elements are not cleared when an object is deleted and its index is
+ * given to a new one.
+ */
+
+struct Agsidetab_s {
+    Agraph_t *g;
+    int kind;			/* AGNODE or AGEDGE */
+    size_t size;		/* of an element */
+    int cnt;			/* number of elements allocated */
+    char *data;
+};
+
+/* sidegrow:
+ * Make room for at least n elements, and all indices in use.
+ */
+static void sidegrow(Agsidetab_t * tab, int n)
+{
+    int cnt;
+
+    cnt = agindexbound(tab->g, tab->kind);
+    if (cnt < n)
+	cnt = n;
+    if (cnt < 2 * tab->cnt)
+	cnt = 2 * tab->cnt;
+    tab->data = agrealloc(tab->g, tab->data, tab->cnt * tab->size,
+			  cnt * tab->size);
+    tab->cnt = cnt;
+}
+
+/* agsidetab:
+ * Make a side table of elements of the given size for the nodes or
+ * edges of g, or return NULL if g does not number them densely.
+ */
+Agsidetab_t *agsidetab(Agraph_t * g, int objtype, size_t size)
+{
+    Agsidetab_t *tab;
+
+    if ((AGDISC(g, id) != &AgDenseIdDisc) || (objtype == AGRAPH))
+	return NIL(Agsidetab_t *);
+    tab = agalloc(g, sizeof(Agsidetab_t));
+    tab->g = agroot(g);
+    tab->kind = (objtype == AGNODE) ? AGNODE : AGEDGE;
+    tab->size = size;
+    sidegrow(tab, 1);
+    return tab;
+}
+
+/* agsidedata:
+ * Return the element of obj, a node or edge of the table's kind.
+ */
+void *agsidedata(Agsidetab_t * tab, void *obj)
+{
+    int i = (int) AGID(obj);
+
+    if (i >= tab->cnt)
+	sidegrow(tab, i + 1);
+    return tab->data + i * tab->size;
+}
+
+/* agsidearray:
+ * Return the elements as an array indexed by agnodeindex or agedgeindex,
+ * with room for all the objects in the graph. It moves when the table
+ * grows, so must be fetched again after objects are created.
+ */
+void *agsidearray(Agsidetab_t * tab)
+{
+    if (agindexbound(tab->g, tab->kind) > tab->cnt)
+	sidegrow(tab, 0);
+    return tab->data;
+}
+
+void agsidetabfree(Agsidetab_t * tab)
+{
+    if (!tab)
+	return;
+    agfree(tab->g, tab->data);
+    agfree(tab->g, tab);
+}
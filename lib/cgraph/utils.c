@@ -13,7 +13,7 @@
 
 #include <cghdr.h>
 
-static Agraph_t *Ag_dictop_G;
+static AGTLS Agraph_t *Ag_dictop_G;
 
 /* only indirect call through dtopen() is expected */
 void *agdictobjmem(Dict_t * dict, void * p, size_t size, Dtdisc_t * disc)
@@ -25,9 +25,9 @@ void *agdictobjmem(Dict_t * dict, void * p, size_t size, Dtdisc_t * disc)
     g = Ag_dictop_G;
     if (g) {
 	if (p)
-	    agfree(g, p);
+	    agmemfree(g, p, AGMEM_DICT);
 	else
-	    return agalloc(g, size);
+	    return agmemalloc(g, size, AGMEM_DICT);
     } else {
 	if (p)
 	    free(p);
@@ -45,7 +45,7 @@ void agdictobjfree(Dict_t * dict, void * p, Dtdisc_t * disc)
     NOTUSED(disc);
     g = Ag_dictop_G;
     if (g)
-	agfree(g, p);
+	agmemfree(g, p, AGMEM_DICT);
     else
 	free(p);
 }
@@ -55,11 +55,16 @@ Dict_t *agdtopen(Agraph_t * g, Dtdisc_t * disc, Dtmethod_t * method)
     Dtmemory_f memf;
     Dict_t *d;
 
+    /* cgraph's own disciplines already use agdictobjmem, and are
+     * left untouched, as other threads may be using them.
+     */
     memf = disc->memoryf;
-    disc->memoryf = agdictobjmem;
+    if (memf != agdictobjmem)
+	disc->memoryf = agdictobjmem;
     Ag_dictop_G = g;
     d = dtopen(disc, method);
-    disc->memoryf = memf;
+    if (memf != agdictobjmem)
+	disc->memoryf = memf;
     Ag_dictop_G = NIL(Agraph_t*);
     return d;
 }
@@ -83,11 +88,13 @@ int agdtclose(Agraph_t * g, Dict_t * dict)
 
     disc = dtdisc(dict, NIL(Dtdisc_t *), 0);
     memf = disc->memoryf;
-    disc->memoryf = agdictobjmem;
+    if (memf != agdictobjmem)
+	disc->memoryf = agdictobjmem;
     Ag_dictop_G = g;
     if (dtclose(dict))
 	return 1;
-    disc->memoryf = memf;
+    if (memf != agdictobjmem)
+	disc->memoryf = memf;
     Ag_dictop_G = NIL(Agraph_t*);
     return 0;
 }
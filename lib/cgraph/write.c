@@ -13,7 +13,9 @@
 
 #include <stdio.h>		/* need sprintf() */
 #include <ctype.h>
+#include <limits.h>
 #include "cghdr.h"
+#include "agxbuf.h"
 
 #define EMPTY(s)		((s == 0) || (s)[0] == '\0')
 #define MAX(a,b)     ((a)>(b)?(a):(b))
@@ -21,19 +23,62 @@
 
 typedef void iochan_t;
 
-static int ioput(Agraph_t * g, iochan_t * ofile, char *str)
+/* Output is collected in Outbuf and handed to the putstr discipline in
+ * large pieces by ioflush, rather than one token at a time.
+ * The writer's state is kept per thread, so that different graphs can
+ * be written concurrently.
+ */
+#define OUTBUFSIZE	(64 * 1024)
+static AGTLS char *Outbuf;
+static AGTLS size_t Outlen;
+
+static void iobufopen(void)
+{
+    Outbuf = malloc(OUTBUFSIZE);	/* if NULL, output is unbuffered */
+    Outlen = 0;
+}
+
+static void iobufclose(void)
 {
-    return AGDISC(g, io)->putstr(ofile, str);
+    free(Outbuf);
+    Outbuf = NIL(char *);
+    Outlen = 0;
+}
 
+static int ioflush(Agraph_t * g, iochan_t * ofile)
+{
+    if (Outlen == 0)
+	return 0;
+    Outbuf[Outlen] = '\0';
+    Outlen = 0;
+    return AGDISC(g, io)->putstr(ofile, Outbuf);
+}
+
+static int ioput(Agraph_t * g, iochan_t * ofile, char *str)
+{
+    size_t len;
+
+    if (!Outbuf)
+	return AGDISC(g, io)->putstr(ofile, str);
+    len = strlen(str);
+    if (Outlen + len >= OUTBUFSIZE) {
+	if (ioflush(g, ofile) == EOF)
+	    return EOF;
+	if (len >= OUTBUFSIZE)
+	    return AGDISC(g, io)->putstr(ofile, str);
+    }
+    memcpy(Outbuf + Outlen, str, len);
+    Outlen += len;
+    return 0;
 }
 
 #define MAX_OUTPUTLINE		128
 #define MIN_OUTPUTLINE		 60
 static int write_body(Agraph_t * g, iochan_t * ofile);
-static int Level;
-static int Max_outputline = MAX_OUTPUTLINE;
-static unsigned char Attrs_not_written_flag;
-static Agsym_t *Tailport, *Headport;
+static AGTLS int Level;
+static AGTLS int Max_outputline = MAX_OUTPUTLINE;
+static AGTLS unsigned char Attrs_not_written_flag;
+static AGTLS Agsym_t *Tailport, *Headport;
 
 static int indent(Agraph_t * g, iochan_t * ofile)
 {
@@ -63,9 +108,71 @@ static int strcasecmp(const char *s1, const char *s2)
     /* alphanumeric, '.', '-', or non-ascii; basically, chars used in unquoted ids */
 #define is_id_char(c) (isalnum(c) || ((c) == '.') || ((c) == '-') || !isascii(c))
 
+/* Word-at-a-time test for the chars of unquoted ids, as in ISALNUM.
+ * For a word x whose bytes are all < 0x80, BYTES_GE sets the high bit
+ * of each byte >= c, and BYTES_IN of each byte in lo..hi.
+ */
+#define ONES		((uint64_t) 0x0101010101010101ULL)
+#define HIGHS		(ONES * 0x80)
+#define BYTES_GE(x,c)	(((x) + ONES * (0x80 - (c))) & HIGHS)
+#define BYTES_IN(x,lo,hi)	(BYTES_GE(x,lo) & ~BYTES_GE(x,(hi)+1))
+
+static int idword(uint64_t w)
+{
+    uint64_t a = w & ~HIGHS;
+    uint64_t ok = (w & HIGHS)	/* non-ascii */
+	| BYTES_IN(a, '0', '9')
+	| BYTES_IN(a | (ONES * 0x20), 'a', 'z')
+	| BYTES_IN(a, '_', '_');
+
+    return (ok == HIGHS);
+}
+
+/* idstr:
+ * Return true if the len chars of arg are all letters, digits, '_' or
+ * non-ascii, and the first is not a digit.
+ */
+static int idstr(char *arg, size_t len)
+{
+    unsigned char *s = (unsigned char *) arg;
+    uint64_t w;
+    size_t i;
+
+    if (isdigit(s[0]))
+	return FALSE;
+    for (i = 0; i + sizeof(w) <= len; i += sizeof(w)) {
+	memcpy(&w, s + i, sizeof(w));
+	if (!idword(w))
+	    return FALSE;
+    }
+    for (; i < len; i++)
+	if (!ISALNUM(s[i]))
+	    return FALSE;
+    return TRUE;
+}
+
+/* iskeyword:
+ * Return true if arg would be read as a keyword rather than an id.
+ */
+static int iskeyword(char *arg)
+{
+    static const char *tokenlist[]	/* must agree with scan.l */
+	= { "node", "edge", "strict", "graph", "digraph", "subgraph",
+	NIL(char *)
+    };
+    const char **tok;
+
+    for (tok = tokenlist; *tok; tok++)
+	if (!strcasecmp(*tok, arg))
+	    return TRUE;
+    return FALSE;
+}
+
 /* _agstrcanon:
  * Canonicalize ordinary strings. 
  * Assumes buf is large enough to hold output.
+ * Ids too short to be broken across lines are recognized a word at a
+ * time and returned as is, without building the quoted form.
  */
 static char *_agstrcanon(char *arg, char *buf)
 {
@@ -75,14 +182,14 @@ static char *_agstrcanon(char *arg, char *buf)
     int needs_quotes = FALSE;
     int maybe_num;
     int backslash_pending = FALSE;
-    static const char *tokenlist[]	/* must agree with scan.l */
-	= { "node", "edge", "strict", "graph", "digraph", "subgraph",
-	NIL(char *)
-    };
-    const char **tok;
+    size_t len;
 
     if (EMPTY(arg))
 	return "\"\"";
+    len = strlen(arg);
+    if (((Max_outputline == 0) || (len <= (size_t) Max_outputline))
+	&& idstr(arg, len) && !iskeyword(arg))
+	return arg;
     s = arg;
     p = buf;
     *p++ = '\"';
@@ -146,9 +253,8 @@ static char *_agstrcanon(char *arg, char *buf)
 
     /* Use quotes to protect tokens (example, a node named "node") */
     /* It would be great if it were easier to use flex here. */
-    for (tok = tokenlist; *tok; tok++)
-	if (!strcasecmp(*tok, arg))
-	    return buf;
+    if (iskeyword(arg))
+	return buf;
     return arg;
 }
 
@@ -184,8 +290,8 @@ char *agstrcanon(char *arg, char *buf)
 
 static char *getoutputbuffer(char *str)
 {
-    static char *rv;
-    static size_t len = 0;
+    static AGTLS char *rv;
+    static AGTLS size_t len = 0;
     size_t req;
 
     req = MAX(2 * strlen(str) + 2, BUFSIZ);
@@ -202,7 +308,7 @@ static char *getoutputbuffer(char *str)
 /*
  * canonicalize a string for printing.
  * must agree with strings in scan.l
- * Shared static buffer - unsafe.
+ * Shared static buffer, one per thread - unsafe.
  */
 char *agcanonStr(char *str)
 {
@@ -212,7 +318,7 @@ char *agcanonStr(char *str)
 /*
  * canonicalize a string for printing.
  * If html is true, use HTML canonicalization.
- * Shared static buffer - unsafe.
+ * Shared static buffer, one per thread - unsafe.
  */
 char *agcanon(char *str, int html)
 {
@@ -238,6 +344,64 @@ static int write_canonstr(Agraph_t * g, iochan_t * ofile, char *str)
     return _write_canonstr(g, ofile, str, TRUE);
 }
 
+/* Attribute names and values are interned strings, and the same few
+ * values tend to recur on many objects. Their canonical forms are kept
+ * in a direct-mapped table keyed by address, so each is computed once
+ * per agwrite. The table is freed by canonmemo_close when agwrite
+ * finishes, as the strings may be freed or reused afterward.
+ */
+#define CANONMEMOSIZE	1024	/* a power of 2 */
+#define CANONMEMOLEN	256	/* longer canonical forms are not kept */
+
+typedef struct {
+    char *str;
+    char *canon;		/* str itself, or buf */
+    char *buf;
+} canonmemo_t;
+
+static AGTLS canonmemo_t *Canonmemo;
+
+static void canonmemo_close(void)
+{
+    int i;
+
+    if (Canonmemo) {
+	for (i = 0; i < CANONMEMOSIZE; i++)
+	    free(Canonmemo[i].buf);
+	free(Canonmemo);
+	Canonmemo = NIL(canonmemo_t *);
+    }
+}
+
+static int write_canonval(Agraph_t * g, iochan_t * ofile, char *str)
+{
+    canonmemo_t *m;
+    uintptr_t key;
+    char *canon;
+    size_t len;
+
+    if (!Canonmemo
+	&& !(Canonmemo = calloc(CANONMEMOSIZE, sizeof(canonmemo_t))))
+	return write_canonstr(g, ofile, str);
+    key = (uintptr_t) str;
+    m = Canonmemo + (((key >> 4) ^ (key >> 14)) & (CANONMEMOSIZE - 1));
+    if (m->str != str) {
+	canon = agcanonStr(str);
+	if (canon != str) {
+	    len = strlen(canon) + 1;
+	    if (len > CANONMEMOLEN)
+		return ioput(g, ofile, canon);
+	    if (!m->buf && !(m->buf = malloc(CANONMEMOLEN)))
+		return ioput(g, ofile, canon);
+	    memcpy(m->buf, canon, len);
+	    canon = m->buf;
+	}
+	m->str = str;
+	m->canon = canon;
+    }
+    return ioput(g, ofile, m->canon);
+}
+
 static int write_dict(Agraph_t * g, iochan_t * ofile, char *name,
 		      Dict_t * dict, int top)
 {
@@ -498,9 +662,9 @@ static int write_nondefault_attrs(void *obj, iochan_t * ofile,
 		    CHKRV(ioput(g, ofile, ",\n"));
 		    CHKRV(indent(g, ofile));
 		}
-		CHKRV(write_canonstr(g, ofile, sym->name));
+		CHKRV(write_canonval(g, ofile, sym->name));
 		CHKRV(ioput(g, ofile, "="));
-		CHKRV(write_canonstr(g, ofile, data->str[sym->id]));
+		CHKRV(write_canonval(g, ofile, data->str[sym->id]));
 	    }
 	}
     if (cnt > 0) {
@@ -546,12 +710,13 @@ static int write_node(Agnode_t * n, iochan_t * ofile, Dict_t * d)
 
 /* node must be written if it wasn't already emitted because of
  * a subgraph or one of its predecessors, and if it is a singleton
- * or has non-default attributes.
+ * or has non-default attributes. insubg holds the nodes of the
+ * relevant subgraphs of g, as node_in_subg would find them.
  */
-static int write_node_test(Agraph_t * g, Agnode_t * n,
-			   uint64_t pred_id)
+static int write_node_test(Agraph_t * g, Agnodeset_t * insubg,
+			   Agnode_t * n, uint64_t pred_id)
 {
-    if (NOT(node_in_subg(g, n)) && has_no_predecessor_below(g, n, pred_id)) {
+    if (NOT(agsethas(insubg, n)) && has_no_predecessor_below(g, n, pred_id)) {
 	if (has_no_edges(g, n) || not_default_attrs(g, n))
 	    return TRUE;
     }
@@ -588,18 +753,20 @@ static int write_port(Agedge_t * e, iochan_t * ofile, Agsym_t * port)
     return 0;
 }
 
-static int write_edge_test(Agraph_t * g, Agedge_t * e)
+/* subg_sets:
+ * Collect the nodes and edges of the relevant subgraphs of g, which
+ * were written with them, so the body of g can test each object once.
+ */
+static void subg_sets(Agraph_t * g, Agnodeset_t * ns, Agnodeset_t * es)
 {
     Agraph_t *subg;
 
-    /* can use agedge() because we subverted the dict compar_f */
     for (subg = agfstsubg(g); subg; subg = agnxtsubg(subg)) {
 	if (irrelevant_subgraph(subg))
 	    continue;
-	if (agsubedge(subg, e, FALSE))
-	    return FALSE;
+	agsetunion(ns, subg);
+	agsetunion(es, subg);
     }
-    return TRUE;
 }
 
 static int write_edge(Agedge_t * e, iochan_t * ofile, Dict_t * d)
@@ -629,28 +796,34 @@ static int write_body(Agraph_t * g, iochan_t * ofile)
     Agnode_t *n, *prev;
     Agedge_t *e;
     Agdatadict_t *dd;
+    Agnodeset_t *ns, *es;
+    int rv = 0;
     /* int                  has_attr; */
 
     /* has_attr = (agattrrec(g) != NIL(Agattr_t*)); */
 
     CHKRV(write_subgs(g, ofile));
     dd = agdatadict(agroot(g), FALSE);
-    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
-	if (write_node_test(g, n, AGSEQ(n)))
-	    CHKRV(write_node(n, ofile, dd ? dd->dict.n : 0));
+    ns = agsetopen(g, AGNODE);
+    es = agsetopen(g, AGEDGE);
+    subg_sets(g, ns, es);
+    for (n = agfstnode(g); n && (rv != EOF); n = agnxtnode(g, n)) {
+	if (write_node_test(g, ns, n, AGSEQ(n)))
+	    rv = write_node(n, ofile, dd ? dd->dict.n : 0);
 	prev = n;
-	for (e = agfstout(g, n); e; e = agnxtout(g, e)) {
+	for (e = agfstout(g, n); e && (rv != EOF); e = agnxtout(g, e)) {
 	    if ((prev != aghead(e))
-		&& write_node_test(g, aghead(e), AGSEQ(n))) {
-		CHKRV(write_node(aghead(e), ofile, dd ? dd->dict.n : 0));
+		&& write_node_test(g, ns, aghead(e), AGSEQ(n))) {
+		rv = write_node(aghead(e), ofile, dd ? dd->dict.n : 0);
 		prev = aghead(e);
 	    }
-	    if (write_edge_test(g, e))
-		CHKRV(write_edge(e, ofile, dd ? dd->dict.e : 0));
+	    if ((rv != EOF) && NOT(agsethas(es, e)))
+		rv = write_edge(e, ofile, dd ? dd->dict.e : 0);
 	}
-
-	}
-    return 0;
+    }
+    agsetclose(ns);
+    agsetclose(es);
+    return (rv == EOF) ? EOF : 0;
 }
 
 static void set_attrwf(Agraph_t * g, int toplevel, int value)
@@ -678,17 +851,628 @@ static void set_attrwf(Agraph_t * g, int toplevel, int value)
 int agwrite(Agraph_t * g, void *ofile)
 {
     char* s;
-    int len;
+    int len, rv;
     Level = 0;			/* re-initialize tab level */
+    iobufopen();
     if ((s = agget(g, "linelength")) && isdigit(*s)) {
 	len = (int)strtol(s, (char **)NULL, 10);
 	if ((len == 0) || (len >= MIN_OUTPUTLINE))
 	    Max_outputline = len;
     }
     set_attrwf(g, TRUE, FALSE);
-    CHKRV(write_hdr(g, ofile, TRUE));
-    CHKRV(write_body(g, ofile));
-    CHKRV(write_trl(g, ofile));
+    rv = write_hdr(g, ofile, TRUE);
+    if (rv != EOF)
+	rv = write_body(g, ofile);
+    if (rv != EOF)
+	rv = write_trl(g, ofile);
+    if (rv != EOF)
+	rv = ioflush(g, ofile);
+    iobufclose();
+    canonmemo_close();
     Max_outputline = MAX_OUTPUTLINE;
+    CHKRV(rv);
+    return AGDISC(g, io)->flush(ofile);
+}
+
+/* Binary format
+ * A graph is written as the magic bytes, a format version and the length
+ * of the remainder, followed by a string table, the attribute declarations,
+ * the node names, the edges as pairs of node indices, a column of values
+ * per attribute, and finally the subgraphs with the indices of their
+ * members. Strings are referenced by index + 1, with 0 standing for no
+ * name or, in an attribute column, for the default value.
+ *
+ * Integers are written in base 127, most significant digit first. All but
+ * the last digit have the high bit set, and the last one is stored plus one,
+ * so the output contains no NUL bytes and can be passed through putstr.
+ */
+#define GVB_VERSION		1
+#define GVB_DIRECTED		1
+#define GVB_STRICT		2
+#define GVB_NOLOOP		4
+#define GVB_MAGICLEN		4
+static char gvb_magic[] = { AGBINMAGIC, 'G', 'V', 'B', '\0' };
+
+typedef struct {
+    size_t off;			/* offset of the bytes in the table */
+    size_t len;
+    size_t ref;			/* index + 1, or 0 if the slot is free */
+    unsigned int hash;
+} bstr_t;
+
+typedef struct {
+    agxbuf tab;			/* serialized strings */
+    size_t cnt;
+    bstr_t *slot;		/* open addressing, size a power of 2 */
+    size_t size;
+} bstrtab_t;
+
+/* bint:
+ * Encode v into buf, returning the number of bytes used.
+ */
+static int bint(unsigned char *buf, size_t v)
+{
+    unsigned char digits[2 * sizeof(size_t)];
+    int i = 0, n = 0;
+
+    digits[i++] = (unsigned char) (v % 127 + 1);
+    for (v /= 127; v; v /= 127)
+	digits[i++] = (unsigned char) (0x80 | (v % 127));
+    while (i > 0)
+	buf[n++] = digits[--i];
+    return n;
+}
+
+static void bput(agxbuf * xb, size_t v)
+{
+    unsigned char buf[2 * sizeof(size_t)];
+
+    agxbput_n(xb, (char *) buf, bint(buf, v));
+}
+
+static void bstrgrow(bstrtab_t * st)
+{
+    bstr_t *old = st->slot;
+    size_t i, j, oldsize = st->size;
+
+    st->size = oldsize ? 2 * oldsize : 256;
+    st->slot = calloc(st->size, sizeof(bstr_t));
+    for (i = 0; i < oldsize; i++) {
+	if (old[i].ref == 0)
+	    continue;
+	for (j = old[i].hash & (st->size - 1); st->slot[j].ref;
+	     j = (j + 1) & (st->size - 1));
+	st->slot[j] = old[i];
+    }
+    free(old);
+}
+
+/* bstr:
+ * Return the reference for s, adding it to the string table if needed.
+ */
+static size_t bstr(bstrtab_t * st, char *s)
+{
+    unsigned int hash = 2166136261U;
+    unsigned char *p;
+    size_t i, len;
+    bstr_t *sp;
+
+    if (s == NIL(char *))
+	return 0;
+    for (p = (unsigned char *) s; *p; p++)
+	hash = (hash ^ *p) * 16777619U;
+    len = (size_t) (p - (unsigned char *) s);
+    if (4 * (st->cnt + 1) > 3 * st->size)
+	bstrgrow(st);
+    for (i = hash & (st->size - 1); (sp = &st->slot[i])->ref;
+	 i = (i + 1) & (st->size - 1)) {
+	if ((sp->hash == hash) && (sp->len == len)
+	    && !memcmp(agxbstart(&st->tab) + sp->off, s, len))
+	    return sp->ref;
+    }
+    bput(&st->tab, (len << 1) | (aghtmlstr(s) ? 1 : 0));
+    sp->off = (size_t) agxblen(&st->tab);
+    agxbput_n(&st->tab, s, len);
+    sp->len = len;
+    sp->hash = hash;
+    sp->ref = ++st->cnt;
+    return sp->ref;
+}
+
+/* bname:
+ * Return the reference for the name of obj, or 0 if it is anonymous.
+ */
+static size_t bname(bstrtab_t * st, void *obj)
+{
+    char *s = agnameof(obj);
+
+    if (EMPTY(s) || (s[0] == LOCALNAMEPREFIX))
+	return 0;
+    return bstr(st, s);
+}
+
+static Dict_t *bdict(Agdatadict_t * dd, int kind)
+{
+    switch (kind) {
+    case AGRAPH:
+	return dd->dict.g;
+    case AGNODE:
+	return dd->dict.n;
+    default:
+	return dd->dict.e;
+    }
+}
+
+/* bsyms:
+ * Return the attributes of the given kind declared in root g,
+ * in order of id.
+ */
+static Agsym_t **bsyms(Agraph_t * g, int kind, int *cnt)
+{
+    Agsym_t *sym, **syms;
+    Agdatadict_t *dd;
+    Dict_t *dict;
+
+    *cnt = 0;
+    if (!(dd = agdatadict(g, FALSE)))
+	return NIL(Agsym_t **);
+    dict = bdict(dd, kind);
+    *cnt = dtsize(dict);
+    syms = calloc((size_t) (*cnt ? *cnt : 1), sizeof(Agsym_t *));
+    for (sym = (Agsym_t *) dtfirst(dict); sym;
+	 sym = (Agsym_t *) dtnext(dict, sym))
+	syms[sym->id] = sym;
+    return syms;
+}
+
+static void bput_subg(Agraph_t * g, bstrtab_t * st, agxbuf * xb,
+		      size_t * nidx, size_t * eidx)
+{
+    static int kinds[] = { AGRAPH, AGNODE, AGEDGE };
+    Agdatadict_t *dd;
+    Dict_t *dict, *view;
+    Agsym_t *sym;
+    Agraph_t *subg;
+    Agnode_t *n;
+    Agedge_t *e;
+    int i;
+
+    bput(xb, bname(st, g));
+    dd = agdatadict(g, FALSE);
+    for (i = 0; i < 3; i++) {
+	if (!dd) {
+	    bput(xb, 0);
+	    continue;
+	}
+	dict = bdict(dd, kinds[i]);
+	view = dtview(dict, NIL(Dict_t *));	/* local declarations only */
+	bput(xb, (size_t) dtsize(dict));
+	for (sym = (Agsym_t *) dtfirst(dict); sym;
+	     sym = (Agsym_t *) dtnext(dict, sym)) {
+	    bput(xb, bstr(st, sym->name));
+	    bput(xb, bstr(st, sym->defval));
+	}
+	dtview(dict, view);
+    }
+    bput(xb, (size_t) agnnodes(g));
+    for (n = agfstnode(g); n; n = agnxtnode(g, n))
+	bput(xb, nidx[AGSEQ(n)]);
+    bput(xb, (size_t) agnedges(g));
+    for (n = agfstnode(g); n; n = agnxtnode(g, n))
+	for (e = agfstout(g, n); e; e = agnxtout(g, e))
+	    bput(xb, eidx[AGSEQ(e)]);
+    bput(xb, (size_t) agnsubg(g));
+    for (subg = agfstsubg(g); subg; subg = agnxtsubg(subg))
+	bput_subg(subg, st, xb, nidx, eidx);
+}
+
+/* agwrite_binary:
+ * Write g in the binary format. Only a root graph can be written.
+ * Return 0 on success, EOF on failure
+ */
+int agwrite_binary(Agraph_t * g, void *ofile)
+{
+    static int kinds[] = { AGRAPH, AGNODE, AGEDGE };
+    bstrtab_t st;
+    agxbuf xb, hb;
+    unsigned char buf[2 * sizeof(size_t)];
+    Agsym_t **syms[3];
+    int nsyms[3];
+    size_t *nidx, *eidx, cnt, len;
+    Agattr_t *data;
+    Agnode_t *n;
+    Agedge_t *e;
+    Agraph_t *subg;
+    char *s;
+    int i, j, rv;
+
+    if (g != agroot(g)) {
+	agerr(AGERR, "agwrite_binary: %s is not a root graph\n",
+	      agnameof(g));
+	return EOF;
+    }
+    memset(&st, 0, sizeof(st));
+    agxbinit(&st.tab, BUFSIZ, NIL(unsigned char *));
+    agxbinit(&xb, BUFSIZ, NIL(unsigned char *));
+    agxbinit(&hb, BUFSIZ, NIL(unsigned char *));
+
+    bput(&xb, (g->desc.directed ? GVB_DIRECTED : 0)
+	 | (g->desc.strict ? GVB_STRICT : 0)
+	 | (g->desc.no_loop ? GVB_NOLOOP : 0));
+    bput(&xb, bname(&st, g));
+    for (i = 0; i < 3; i++) {
+	syms[i] = bsyms(g, kinds[i], &nsyms[i]);
+	bput(&xb, (size_t) nsyms[i]);
+	for (j = 0; j < nsyms[i]; j++) {
+	    bput(&xb, bstr(&st, syms[i][j]->name));
+	    bput(&xb, bstr(&st, syms[i][j]->defval));
+	}
+    }
+
+    /* dense indices, looked up by sequence number */
+    nidx = calloc(g->clos->seq[AGNODE] + 1, sizeof(size_t));
+    eidx = calloc(g->clos->seq[AGEDGE] + 1, sizeof(size_t));
+    bput(&xb, (size_t) agnnodes(g));
+    cnt = 0;
+    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	nidx[AGSEQ(n)] = cnt++;
+	bput(&xb, bname(&st, n));
+    }
+    bput(&xb, (size_t) agnedges(g));
+    cnt = 0;
+    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	for (e = agfstout(g, n); e; e = agnxtout(g, e)) {
+	    eidx[AGSEQ(e)] = cnt++;
+	    bput(&xb, nidx[AGSEQ(agtail(e))]);
+	    bput(&xb, nidx[AGSEQ(aghead(e))]);
+	    bput(&xb, bname(&st, e));
+	}
+    }
+
+    /* attribute columns; 0 if the value is the default */
+    for (j = 0; j < nsyms[1]; j++) {
+	for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	    data = agattrrec(n);
+	    s = data->str[syms[1][j]->id];
+	    bput(&xb, (s == syms[1][j]->defval) ? 0 : bstr(&st, s));
+	}
+    }
+    for (j = 0; j < nsyms[2]; j++) {
+	for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	    for (e = agfstout(g, n); e; e = agnxtout(g, e)) {
+		data = agattrrec(e);
+		s = data->str[syms[2][j]->id];
+		bput(&xb, (s == syms[2][j]->defval) ? 0 : bstr(&st, s));
+	    }
+	}
+    }
+    for (j = 0; j < nsyms[0]; j++) {
+	s = agxget(g, syms[0][j]);
+	bput(&xb, (s == syms[0][j]->defval) ? 0 : bstr(&st, s));
+    }
+
+    bput(&xb, (size_t) agnsubg(g));
+    for (subg = agfstsubg(g); subg; subg = agnxtsubg(subg))
+	bput_subg(subg, &st, &xb, nidx, eidx);
+
+    agxbput_n(&hb, gvb_magic, GVB_MAGICLEN);
+    bput(&hb, GVB_VERSION);
+    len = (size_t) bint(buf, st.cnt) + (size_t) agxblen(&st.tab)
+	+ (size_t) agxblen(&xb);
+    bput(&hb, len);
+    bput(&hb, st.cnt);
+    iobufopen();
+    rv = ioput(g, ofile, agxbuse(&hb));
+    if (rv != EOF)
+	rv = ioput(g, ofile, agxbuse(&st.tab));
+    if (rv != EOF)
+	rv = ioput(g, ofile, agxbuse(&xb));
+    if (rv != EOF)
+	rv = ioflush(g, ofile);
+    iobufclose();
+
+    for (i = 0; i < 3; i++)
+	free(syms[i]);
+    free(nidx);
+    free(eidx);
+    free(st.slot);
+    agxbfree(&st.tab);
+    agxbfree(&xb);
+    agxbfree(&hb);
+    CHKRV(rv);
     return AGDISC(g, io)->flush(ofile);
 }
+
+typedef struct {
+    unsigned char *p;		/* next byte */
+    unsigned char *end;
+    int err;
+    char **str;			/* interned strings */
+    size_t nstr;
+    Agraph_t *g;
+    Agnode_t **nodes;
+    size_t nnodes;
+    Agedge_t **edges;
+    size_t nedges;
+} brdr_t;
+
+static size_t bget(brdr_t * rd)
+{
+    size_t v = 0;
+    unsigned char c;
+
+    while (rd->p < rd->end) {
+	c = *rd->p++;
+	if (v > (SIZE_MAX - 127) / 127)
+	    break;
+	if (!(c & 0x80))
+	    return v * 127 + (size_t) (c - 1);
+	v = v * 127 + (c & 0x7F);
+    }
+    rd->err = TRUE;
+    return 0;
+}
+
+/* bgetcnt:
+ * Read a count of items, each taking at least one byte.
+ */
+static size_t bgetcnt(brdr_t * rd)
+{
+    size_t v = bget(rd);
+
+    if (v > (size_t) (rd->end - rd->p)) {
+	rd->err = TRUE;
+	return 0;
+    }
+    return v;
+}
+
+/* bgetstr:
+ * Read a string reference, returning NULL for 0.
+ */
+static char *bgetstr(brdr_t * rd)
+{
+    size_t ref = bget(rd);
+
+    if (ref == 0)
+	return NIL(char *);
+    if (ref > rd->nstr) {
+	rd->err = TRUE;
+	return NIL(char *);
+    }
+    return rd->str[ref - 1];
+}
+
+static size_t bgetidx(brdr_t * rd, size_t limit)
+{
+    size_t v = bget(rd);
+
+    if (v >= limit) {
+	rd->err = TRUE;
+	return 0;
+    }
+    return v;
+}
+
+static void bget_subg(brdr_t * rd, Agraph_t * parent)
+{
+    static int kinds[] = { AGRAPH, AGNODE, AGEDGE };
+    Agraph_t *subg;
+    char *name, *def;
+    size_t i, cnt, idx;
+    int k;
+
+    subg = agsubg(parent, bgetstr(rd), TRUE);
+    if (rd->err || !subg) {
+	rd->err = TRUE;
+	return;
+    }
+    for (k = 0; k < 3; k++) {
+	cnt = bgetcnt(rd);
+	for (i = 0; (i < cnt) && !rd->err; i++) {
+	    name = bgetstr(rd);
+	    def = bgetstr(rd);
+	    if (!name || !def) {
+		rd->err = TRUE;
+		return;
+	    }
+	    agattr(subg, kinds[k], name, def);
+	}
+    }
+    cnt = bgetcnt(rd);
+    for (i = 0; (i < cnt) && !rd->err; i++) {
+	idx = bgetidx(rd, rd->nnodes);
+	if (!rd->err)
+	    agsubnode(subg, rd->nodes[idx], TRUE);
+    }
+    cnt = bgetcnt(rd);
+    for (i = 0; (i < cnt) && !rd->err; i++) {
+	idx = bgetidx(rd, rd->nedges);
+	if (!rd->err)
+	    agsubedge(subg, rd->edges[idx], TRUE);
+    }
+    cnt = bgetcnt(rd);
+    for (i = 0; (i < cnt) && !rd->err; i++)
+	bget_subg(rd, subg);
+}
+
+/* bread:
+ * Read n bytes from chan. As fgets() stops short of the buffer size,
+ * the default discipline reads the FILE directly.
+ */
+static int bread(Agdisc_t * disc, void *chan, char *buf, size_t n)
+{
+    int r;
+
+    if (disc->io->afread == AgIoDisc.afread)
+	return fread(buf, 1, n, (FILE *) chan) == n;
+    while (n > 0) {
+	r = disc->io->afread(chan, buf, n > INT_MAX ? INT_MAX : (int) n);
+	if (r <= 0)
+	    return FALSE;
+	buf += r;
+	n -= (size_t) r;
+    }
+    return TRUE;
+}
+
+static int bread_int(Agdisc_t * disc, void *chan, size_t * v)
+{
+    unsigned char buf[2 * sizeof(size_t)];
+    brdr_t rd;
+    size_t n = 0;
+
+    do {
+	if ((n == sizeof(buf)) || !bread(disc, chan, (char *) buf + n, 1))
+	    return FALSE;
+    } while (buf[n++] & 0x80);
+    memset(&rd, 0, sizeof(rd));
+    rd.p = buf;
+    rd.end = buf + n;
+    *v = bget(&rd);
+    return !rd.err;
+}
+
+/* agread_binary:
+ * Read a graph written by agwrite_binary. The graph is built through the
+ * usual API calls, so the disciplines and callbacks apply, but there is
+ * no tokenizing or parsing.
+ */
+Agraph_t *agread_binary(void *chan, Agdisc_t * disc)
+{
+    static int kinds[] = { AGRAPH, AGNODE, AGEDGE };
+    char magic[GVB_MAGICLEN];
+    unsigned char *buf;
+    size_t version, len, i, j, *slen, cnt;
+    brdr_t rd;
+    Agdesc_t desc;
+    Agsym_t **syms[3];
+    size_t nsyms[3];
+    unsigned int flags;
+    char *name, *def, *s;
+    Agraph_t *g;
+    int k, html;
+
+    if (!disc)
+	disc = &AgDefaultDisc;
+    if (!bread(disc, chan, magic, GVB_MAGICLEN)
+	|| memcmp(magic, gvb_magic, GVB_MAGICLEN)
+	|| !bread_int(disc, chan, &version) || !bread_int(disc, chan, &len)) {
+	agerr(AGERR, "agread_binary: not a binary graph\n");
+	return NIL(Agraph_t *);
+    }
+    if (version != GVB_VERSION) {
+	agerr(AGERR, "agread_binary: unsupported version %d\n",
+	      (int) version);
+	return NIL(Agraph_t *);
+    }
+    if (!(buf = malloc(len + 1)) || !bread(disc, chan, (char *) buf, len)) {
+	agerr(AGERR, "agread_binary: truncated input\n");
+	free(buf);
+	return NIL(Agraph_t *);
+    }
+
+    memset(&rd, 0, sizeof(rd));
+    memset(syms, 0, sizeof(syms));
+    memset(nsyms, 0, sizeof(nsyms));
+    rd.p = buf;
+    rd.end = buf + len;
+    rd.nstr = bgetcnt(&rd);
+    rd.str = calloc(rd.nstr + 1, sizeof(char *));
+    slen = calloc(rd.nstr + 1, sizeof(size_t));
+    for (i = 0; (i < rd.nstr) && !rd.err; i++) {
+	slen[i] = bget(&rd);
+	if ((slen[i] >> 1) > (size_t) (rd.end - rd.p))
+	    rd.err = TRUE;
+	else {
+	    rd.str[i] = (char *) rd.p;
+	    rd.p += slen[i] >> 1;
+	}
+    }
+    flags = (unsigned int) bget(&rd);
+    g = NIL(Agraph_t *);
+    if (!rd.err) {
+	/* Terminate the strings in place. This overwrites the length of
+	 * the following string, or the flags, which have been read.
+	 */
+	for (i = 0; i < rd.nstr; i++)
+	    rd.str[i][slen[i] >> 1] = '\0';
+	desc = Agundirected;
+	desc.directed = (flags & GVB_DIRECTED) != 0;
+	desc.strict = (flags & GVB_STRICT) != 0;
+	desc.no_loop = (flags & GVB_NOLOOP) != 0;
+	desc.maingraph = TRUE;
+	name = bgetstr(&rd);
+	if (!rd.err)
+	    g = agopen(name, desc, disc);
+    }
+    if (g) {
+	rd.g = g;
+	for (i = 0; i < rd.nstr; i++) {
+	    html = (int) (slen[i] & 1);
+	    s = rd.str[i];
+	    rd.str[i] = html ? agstrdup_html(g, s) : agstrdup(g, s);
+	}
+
+	for (k = 0; (k < 3) && !rd.err; k++) {
+	    nsyms[k] = bgetcnt(&rd);
+	    syms[k] = calloc(nsyms[k] + 1, sizeof(Agsym_t *));
+	    for (j = 0; (j < nsyms[k]) && !rd.err; j++) {
+		name = bgetstr(&rd);
+		def = bgetstr(&rd);
+		if (!name || !def)
+		    rd.err = TRUE;
+		else
+		    syms[k][j] = agattr(g, kinds[k], name, def);
+	    }
+	}
+
+	rd.nnodes = bgetcnt(&rd);
+	rd.nodes = calloc(rd.nnodes + 1, sizeof(Agnode_t *));
+	for (i = 0; (i < rd.nnodes) && !rd.err; i++)
+	    if (!(rd.nodes[i] = agnode(g, bgetstr(&rd), TRUE)))
+		rd.err = TRUE;
+	rd.nedges = bgetcnt(&rd);
+	rd.edges = calloc(rd.nedges + 1, sizeof(Agedge_t *));
+	for (i = 0; (i < rd.nedges) && !rd.err; i++) {
+	    Agnode_t *t = rd.nodes[bgetidx(&rd, rd.nnodes)];
+	    Agnode_t *h = rd.nodes[bgetidx(&rd, rd.nnodes)];
+	    s = bgetstr(&rd);
+	    if (rd.err || !(rd.edges[i] = agedge(g, t, h, s, TRUE)))
+		rd.err = TRUE;
+	}
+
+	for (j = 0; (j < nsyms[1]) && !rd.err; j++)
+	    for (i = 0; i < rd.nnodes; i++)
+		if ((s = bgetstr(&rd)))
+		    agxset(rd.nodes[i], syms[1][j], s);
+	for (j = 0; (j < nsyms[2]) && !rd.err; j++)
+	    for (i = 0; i < rd.nedges; i++)
+		if ((s = bgetstr(&rd)))
+		    agxset(rd.edges[i], syms[2][j], s);
+	for (j = 0; (j < nsyms[0]) && !rd.err; j++)
+	    if ((s = bgetstr(&rd)))
+		agxset(g, syms[0][j], s);
+
+	cnt = bgetcnt(&rd);
+	for (i = 0; (i < cnt) && !rd.err; i++)
+	    bget_subg(&rd, g);
+
+	for (i = 0; i < rd.nstr; i++)
+	    agstrfree(g, rd.str[i]);
+    }
+    if (rd.err) {
+	agerr(AGERR, "agread_binary: malformed input\n");
+	if (g)
+	    agclose(g);
+	g = NIL(Agraph_t *);
+    }
+    for (k = 0; k < 3; k++)
+	free(syms[k]);
+    free(rd.nodes);
+    free(rd.edges);
+    free(rd.str);
+    free(slen);
+    free(buf);
+    return g;
+}
@@ -264,6 +264,7 @@
  * Bit(s):  0     HAS_CLUST_EDGE
  *          1-3   ET_ 
  *          4     NEW_RANK
+ *          5     INCREMENTAL
  */
 
 /* edge types */
@@ -277,8 +278,15 @@
 
 /* New ranking is used */
 #define NEW_RANK    	(1 << 4)
+/* Layout starts from the previous one (incremental=true) */
+#define INCREMENTAL    	(1 << 5)
 /******/
 
+/* what is known of a node's previous layout: ND_prior */
+#define PRIOR_RANK	1	/* ND_prior_rank is set */
+#define PRIOR_X		2	/* ND_prior_x is set */
+#define PRIOR_DIRTY	4	/* the node or its edges changed since */
+
 /* user-specified node position: ND_pinned */
 #define P_SET    1		/* position supplied by user */
 #define P_FIX    2		/* position fixed during topological layout */
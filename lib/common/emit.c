@@ -3621,7 +3621,7 @@ static Dtdisc_t stringdict = {
 int emit_once(char *str)
 {
     if (strings == 0)
-	strings = dtopen(&stringdict, Dtoset);
+	strings = dtopen(&stringdict, Dtoahash);
     if (!dtsearch(strings, str)) {
 	dtinsert(strings, strdup(str));
 	return TRUE;
@@ -4089,15 +4089,21 @@ void gv_fixLocale (int set)
 }
 
 
-#define FINISH() if (Verbose) fprintf(stderr,"gvRenderJobs %s: %.2f secs.\n", agnameof(g), elapsed_sec())
+#define FINISH() if (Verbose) { \
+	fprintf(stderr,"gvRenderJobs %s: %.2f secs.\n", agnameof(g), elapsed_sec()); \
+	gv_memreport(g, "gvRenderJobs"); \
+    }
 
 int gvRenderJobs (GVC_t * gvc, graph_t * g)
 {
     static GVJ_t *prevjob;
     GVJ_t *job, *firstjob;
 
-    if (Verbose)
+    gvmemphase(GVMEM_RENDER);
+    if (Verbose) {
 	start_timer();
+	gvmemcount(NULL, TRUE);
+    }
     
     if (!LAYOUT_DONE(g)) {
         agerr (AGERR, "Layout was not done.  Missing layout plugins? \n");
@@ -74,6 +74,7 @@ extern "C" {
     EXTERN unsigned char Reduce;
     EXTERN int MemTest;
     EXTERN char *HTTPServerEnVar;
+    EXTERN unsigned char UseArena;	/* read graphs into per-graph arenas */
     EXTERN char *Output_file_name;
     EXTERN int graphviz_errors;
     EXTERN int Nop;
@@ -236,6 +236,9 @@ int dotneato_args_initialize(GVC_t * gvc, int argc, char **argv)
     /* establish Gvfilepath, if any */
     Gvfilepath = getenv("GV_FILE_PATH");
 
+    /* allocate input graphs from an arena, freed in one step by agclose */
+    UseArena = mapbool(getenv("GV_ARENA"));
+
     gvc->common.cmdname = dotneato_basename(argv[0]);
     if (gvc->common.verbose) {
         fprintf(stderr, "%s - %s version %s (%s)\n",
@@ -534,13 +537,24 @@ static char *myfgets(char * ubuf, int n, FILE * fp)
 }
 #endif
 
+static Agdisc_t ArenaDisc;
+
 graph_t *gvNextInputGraph(GVC_t *gvc)
 {
     graph_t *g = NULL;
     static char *fn;
     static FILE *fp;
     static FILE *oldfp;
+    static Agmmap_t *map;
     static int fidx, gidx;
+    Agdisc_t *disc = NIL(Agdisc_t*);
+
+    if (UseArena) {
+	ArenaDisc.mem = &AgArenaMemDisc;
+	ArenaDisc.id = &AgIdDisc;
+	ArenaDisc.io = &AgIoDisc;
+	disc = &ArenaDisc;
+    }
 
     while (!g) {
 	if (!fp) {
@@ -560,16 +574,28 @@ graph_t *gvNextInputGraph(GVC_t *gvc)
 	if (oldfp != fp) {
 	    agsetfile(fn ? fn : "<stdin>");
 	    oldfp = fp;
+#ifndef EXPERIMENTAL_MYFGETS
+	    /* scan named files in place if possible */
+	    if (fp != stdin)
+		map = agmmapopen(fp);
+#endif
 	}
 #ifdef EXPERIMENTAL_MYFGETS
 	g = agread_usergets(fp, myfgets);
 #else
-	g = agread(fp,NIL(Agdisc_t*));
+	if (map)
+	    g = agmmapread(map, disc);
+	else
+	    g = agread(fp,disc);
 #endif
 	if (g) {
 	    gvg_init(gvc, g, fn, gidx++);
 	    break;
 	}
+	if (map) {
+	    agmmapclose(map);
+	    map = NULL;
+	}
 	if (fp != stdin)
 	    fclose (fp);
 	oldfp = fp = NULL;
@@ -17,6 +17,99 @@
 #include <string.h>
 #include "memory.h"
 
+#if defined(HAVE_MALLOC_USABLE_SIZE) && !defined(_WIN32)
+extern size_t malloc_usable_size(void *);
+#endif
+
+#ifndef GVTLS
+#if defined(_MSC_VER)
+#define GVTLS __declspec(thread)
+#elif defined(__GNUC__) || defined(__SUNPRO_C) || defined(__INTEL_COMPILER)
+#define GVTLS __thread
+#else
+#define GVTLS _Thread_local
+#endif
+#endif
+
+/* Bytes requested through gmalloc and friends, and the number of calls,
+ * charged to the part of the layout the thread is in, set by gvmemphase.
+ * Memory is released with plain free, so only requests are counted.
+ * Each thread keeps its own counts, so graphs laid out at the same time
+ * on different threads are counted apart; worker threads add theirs to
+ * the thread that started them when they finish (see gvrunwork).
+ */
+static GVTLS gvmemstat_t Req;
+static GVTLS int Cat;
+
+static char *CatNames[] = {
+    "layout", "vnodes", "ranks", "splines", "render"
+};
+
+static void count(size_t nbytes)
+{
+    Req.bytes[Cat] += nbytes;
+    Req.calls[Cat]++;
+}
+
+/* blocksize:
+ * Return the size of the block at ptr, or 0 if it cannot be known, in
+ * which case a reallocation is counted at its full new size.
+ */
+static size_t blocksize(void *ptr)
+{
+    if (!ptr)
+	return 0;
+#ifdef _WIN32
+    return _msize(ptr);
+#elif defined(HAVE_MALLOC_USABLE_SIZE)
+    return malloc_usable_size(ptr);
+#else
+    return 0;
+#endif
+}
+
+/* gvmemphase:
+ * Charge the thread's later requests to cat, returning the previous
+ * category. If cat is negative, the category is left as it is.
+ */
+int gvmemphase(int cat)
+{
+    int prev = Cat;
+
+    if (cat >= 0 && cat < GVMEM_NCAT)
+	Cat = cat;
+    return prev;
+}
+
+/* gvmemcount:
+ * Copy the thread's counts since the last reset into st, if not NULL.
+ */
+void gvmemcount(gvmemstat_t * st, int reset)
+{
+    if (st)
+	*st = Req;
+    if (reset)
+	memset(&Req, 0, sizeof(Req));
+}
+
+/* gvmemadd:
+ * Add the counts in st to the thread's.
+ */
+void gvmemadd(gvmemstat_t * st)
+{
+    int i;
+
+    for (i = 0; i < GVMEM_NCAT; i++) {
+	Req.bytes[i] += st->bytes[i];
+	Req.calls[i] += st->calls[i];
+    }
+}
+
+char *gvmemcatname(int cat)
+{
+    return CatNames[cat];
+}
+
 void *zmalloc(size_t nbytes)
 {
     char *rv;
@@ -30,6 +123,7 @@ void *zmalloc(size_t nbytes)
 void *zrealloc(void *ptr, size_t size, size_t elt, size_t osize)
 {
     void *p = realloc(ptr, size * elt);
+    count(size > osize ? (size - osize) * elt : 0);
     if (p == NULL && size) {
 	fprintf(stderr, "out of memory\n");
 	return p;
@@ -45,6 +139,7 @@ void *gmalloc(size_t nbytes)
     if (nbytes == 0)
 	return NULL;
     rv = malloc(nbytes);
+    count(nbytes);
     if (rv == NULL) {
 	fprintf(stderr, "out of memory\n");
     }
@@ -53,7 +148,9 @@ void *gmalloc(size_t nbytes)
 
 void *grealloc(void *ptr, size_t size)
 {
+    size_t osize = blocksize(ptr);
     void *p = realloc(ptr, size);
+    count(size > osize ? size - osize : 0);
     if (p == NULL && size) {
 	fprintf(stderr, "out of memory\n");
     }
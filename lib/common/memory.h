@@ -57,6 +57,20 @@ extern "C" {
     extern void *zrealloc(void *, size_t, size_t, size_t);
     extern void *gmalloc(size_t);
 	extern void *grealloc(void *, size_t);
+
+    /* parts of a layout that engine allocations are charged to */
+    typedef enum { GVMEM_LAYOUT, GVMEM_VNODES, GVMEM_RANKS,
+	GVMEM_SPLINES, GVMEM_RENDER, GVMEM_NCAT } gvmemcat_t;
+
+    typedef struct {
+	size_t bytes[GVMEM_NCAT];	/* bytes requested */
+	size_t calls[GVMEM_NCAT];	/* calls made */
+    } gvmemstat_t;
+
+    extern int gvmemphase(int cat);
+    extern void gvmemcount(gvmemstat_t *st, int reset);
+    extern void gvmemadd(gvmemstat_t *st);
+    extern char *gvmemcatname(int cat);
 #undef extern
 
 #ifdef __cplusplus
@@ -2,7 +2,7 @@
 /* vim:set shiftwidth=4 ts=8: */
 
 /*************************************************************************
- * Copyright (c) 2011 AT&T Intellectual Property 
+ * Copyright (c) 2011 AT&T Intellectual Property
  * All rights reserved. This program and the accompanying materials
  * are made available under the terms of the Eclipse Public License v1.0
  * which accompanies this distribution, and is available at
@@ -12,292 +12,382 @@
  *************************************************************************/
 
 
-/* 
+/*
  * Network Simplex Algorithm for Ranking Nodes of a DAG
+ *
+ * The solver works on an nsgraph_t, which holds the problem as arrays
+ * indexed by node and edge number and all of the solver's state, so
+ * several problems may be solved at once. rank and rank2 copy a graph
+ * laid out with GD_nlist, ND_out and ND_in into one and back.
  */
 
 #include "render.h"
-#include <setjmp.h>
+#include "ns.h"
 
-static int init_graph(graph_t *);
-static void dfs_cutval(node_t * v, edge_t * par);
-static int dfs_range(node_t * v, edge_t * par, int low);
-static int x_val(edge_t * e, node_t * v, int dir);
+static void dfs_cutval(nsgraph_t * ns, int v, int par);
+static int dfs_range(nsgraph_t * ns, int v, int par, int low);
+static int x_val(nsgraph_t * ns, int e, int v, int dir);
 #ifdef DEBUG
 static void check_cycles(graph_t * g);
 #endif
 
-#define LENGTH(e)		(ND_rank(aghead(e)) - ND_rank(agtail(e)))
-#define SLACK(e)		(LENGTH(e) - ED_minlen(e))
+#define LENGTH(ns,e)		((ns)->rank[(ns)->head[e]] - (ns)->rank[(ns)->tail[e]])
+#define SLACK(ns,e)		(LENGTH(ns,e) - (ns)->minlen[e])
 #define SEQ(a,b,c)		(((a) <= (b)) && ((b) <= (c)))
-#define TREE_EDGE(e)	(ED_tree_index(e) >= 0)
-
-static jmp_buf jbuf;
-static graph_t *G;
-static int N_nodes, N_edges;
-static int Minrank, Maxrank;
-static int S_i;			/* search index for enter_edge */
-static int Search_size;
+#define TREE_EDGE(ns,e)	((ns)->treeidx[e] >= 0)
+#define TOUT(ns,v)		((ns)->tout + (ns)->outbeg[v])
+#define TIN(ns,v)		((ns)->tin + (ns)->inbeg[v])
+#define OUTDEG(ns,v)		((ns)->outbeg[(v)+1] - (ns)->outbeg[v])
+#define INDEG(ns,v)		((ns)->inbeg[(v)+1] - (ns)->inbeg[v])
+
 #define SEARCHSIZE 30
-static nlist_t Tree_node;
-static elist Tree_edge;
 
-static void add_tree_edge(edge_t * e)
+/* ns_open:
+ * Make a problem with the given numbers of nodes and edges.
+ */
+nsgraph_t *ns_open(int nnodes, int nedges)
 {
-    node_t *n;
-    //fprintf(stderr,"add tree edge %p %s ", (void*)e, agnameof(agtail(e))) ; fprintf(stderr,"%s\n", agnameof(aghead(e))) ;
-    if (TREE_EDGE(e)) {
+    nsgraph_t *ns = NEW(nsgraph_t);
+
+    ns->nnodes = nnodes;
+    ns->nedges = nedges;
+    ns->tail = N_NEW(nedges, int);
+    ns->head = N_NEW(nedges, int);
+    ns->minlen = N_NEW(nedges, int);
+    ns->weight = N_NEW(nedges, int);
+    ns->rank = N_NEW(nnodes, int);
+    ns->normal = N_NEW(nnodes, unsigned char);
+    ns->outbeg = N_NEW(nnodes + 1, int);
+    ns->out = N_NEW(nedges, int);
+    ns->inbeg = N_NEW(nnodes + 1, int);
+    ns->in = N_NEW(nedges, int);
+    ns->cutvalue = N_NEW(nedges, int);
+    ns->treeidx = N_NEW(nedges, int);
+    ns->tree_edge = N_NEW(nnodes, int);
+    ns->tout = N_NEW(nedges, int);
+    ns->ntout = N_NEW(nnodes, int);
+    ns->tin = N_NEW(nedges, int);
+    ns->ntin = N_NEW(nnodes, int);
+    ns->par = N_NEW(nnodes, int);
+    ns->low = N_NEW(nnodes, int);
+    ns->lim = N_NEW(nnodes, int);
+    ns->priority = N_NEW(nnodes, int);
+    ns->subtree = N_NEW(nnodes, struct subtree_s *);
+    return ns;
+}
+
+/* ns_adjacency:
+ * Fill in the adjacency lists from the edges, in edge order.
+ */
+void ns_adjacency(nsgraph_t * ns)
+{
+    int v, e;
+
+    for (v = 0; v <= ns->nnodes; v++)
+	ns->outbeg[v] = ns->inbeg[v] = 0;
+    for (e = 0; e < ns->nedges; e++) {
+	ns->outbeg[ns->tail[e] + 1]++;
+	ns->inbeg[ns->head[e] + 1]++;
+    }
+    for (v = 0; v < ns->nnodes; v++) {
+	ns->outbeg[v + 1] += ns->outbeg[v];
+	ns->inbeg[v + 1] += ns->inbeg[v];
+	ns->ntout[v] = ns->ntin[v] = 0;
+    }
+    for (e = 0; e < ns->nedges; e++) {
+	v = ns->tail[e];
+	ns->out[ns->outbeg[v] + ns->ntout[v]++] = e;
+	v = ns->head[e];
+	ns->in[ns->inbeg[v] + ns->ntin[v]++] = e;
+    }
+}
+
+void ns_close(nsgraph_t * ns)
+{
+    if (!ns)
+	return;
+    free(ns->tail);
+    free(ns->head);
+    free(ns->minlen);
+    free(ns->weight);
+    free(ns->rank);
+    free(ns->normal);
+    free(ns->node);
+    free(ns->outbeg);
+    free(ns->out);
+    free(ns->inbeg);
+    free(ns->in);
+    free(ns->cutvalue);
+    free(ns->treeidx);
+    free(ns->tree_edge);
+    free(ns->tout);
+    free(ns->ntout);
+    free(ns->tin);
+    free(ns->ntin);
+    free(ns->par);
+    free(ns->low);
+    free(ns->lim);
+    free(ns->priority);
+    free(ns->subtree);
+    free(ns);
+}
+
+static void add_tree_edge(nsgraph_t * ns, int e)
+{
+    int n;
+
+    if (TREE_EDGE(ns, e)) {
 	agerr(AGERR, "add_tree_edge: missing tree edge\n");
-	longjmp (jbuf, 1);
+	longjmp (ns->jbuf, 1);
     }
-    ED_tree_index(e) = Tree_edge.size;
-    Tree_edge.list[Tree_edge.size++] = e;
-    if (ND_mark(agtail(e)) == FALSE)
-	Tree_node.list[Tree_node.size++] = agtail(e);
-    if (ND_mark(aghead(e)) == FALSE)
-	Tree_node.list[Tree_node.size++] = aghead(e);
-    n = agtail(e);
-    ND_mark(n) = TRUE;
-    ND_tree_out(n).list[ND_tree_out(n).size++] = e;
-    ND_tree_out(n).list[ND_tree_out(n).size] = NULL;
-    if (ND_out(n).list[ND_tree_out(n).size - 1] == 0) {
+    ns->treeidx[e] = ns->ntree;
+    ns->tree_edge[ns->ntree++] = e;
+    n = ns->tail[e];
+    if (ns->ntout[n] >= OUTDEG(ns, n)) {
 	agerr(AGERR, "add_tree_edge: empty outedge list\n");
-	longjmp (jbuf, 1);
+	longjmp (ns->jbuf, 1);
     }
-    n = aghead(e);
-    ND_mark(n) = TRUE;
-    ND_tree_in(n).list[ND_tree_in(n).size++] = e;
-    ND_tree_in(n).list[ND_tree_in(n).size] = NULL;
-    if (ND_in(n).list[ND_tree_in(n).size - 1] == 0) {
+    TOUT(ns, n)[ns->ntout[n]++] = e;
+    n = ns->head[e];
+    if (ns->ntin[n] >= INDEG(ns, n)) {
 	agerr(AGERR, "add_tree_edge: empty inedge list\n");
-	longjmp (jbuf, 1);
+	longjmp (ns->jbuf, 1);
     }
+    TIN(ns, n)[ns->ntin[n]++] = e;
 }
 
-static void exchange_tree_edges(edge_t * e, edge_t * f)
+/* remove e from a list of tree edges, moving the last one into its place */
+static void tree_remove(int *list, int *size, int e)
 {
     int i, j;
-    node_t *n;
 
-    ED_tree_index(f) = ED_tree_index(e);
-    Tree_edge.list[ED_tree_index(e)] = f;
-    ED_tree_index(e) = -1;
-
-    n = agtail(e);
-    i = --(ND_tree_out(n).size);
-    for (j = 0; j <= i; j++)
-	if (ND_tree_out(n).list[j] == e)
-	    break;
-    ND_tree_out(n).list[j] = ND_tree_out(n).list[i];
-    ND_tree_out(n).list[i] = NULL;
-    n = aghead(e);
-    i = --(ND_tree_in(n).size);
-    for (j = 0; j <= i; j++)
-	if (ND_tree_in(n).list[j] == e)
+    i = --(*size);
+    for (j = 0; j < i; j++)
+	if (list[j] == e)
 	    break;
-    ND_tree_in(n).list[j] = ND_tree_in(n).list[i];
-    ND_tree_in(n).list[i] = NULL;
-
-    n = agtail(f);
-    ND_tree_out(n).list[ND_tree_out(n).size++] = f;
-    ND_tree_out(n).list[ND_tree_out(n).size] = NULL;
-    n = aghead(f);
-    ND_tree_in(n).list[ND_tree_in(n).size++] = f;
-    ND_tree_in(n).list[ND_tree_in(n).size] = NULL;
+    list[j] = list[i];
+}
+
+static void exchange_tree_edges(nsgraph_t * ns, int e, int f)
+{
+    int n;
+
+    ns->treeidx[f] = ns->treeidx[e];
+    ns->tree_edge[ns->treeidx[e]] = f;
+    ns->treeidx[e] = -1;
+
+    n = ns->tail[e];
+    tree_remove(TOUT(ns, n), &ns->ntout[n], e);
+    n = ns->head[e];
+    tree_remove(TIN(ns, n), &ns->ntin[n], e);
+
+    n = ns->tail[f];
+    TOUT(ns, n)[ns->ntout[n]++] = f;
+    n = ns->head[f];
+    TIN(ns, n)[ns->ntin[n]++] = f;
+}
+
+static char *nodename(nsgraph_t * ns, int v, char *buf)
+{
+    if (ns->node)
+	return agnameof(ns->node[v]);
+    sprintf(buf, "%d", v);
+    return buf;
 }
 
 static
-void init_rank(void)
+void init_rank(nsgraph_t * ns)
 {
-    int i, ctr;
-    nodequeue *Q;
-    node_t *v;
-    edge_t *e;
+    int i, v, e, ctr, qhead, qtail;
+    int *queue;
+    char buf[20];
 
-    Q = new_queue(N_nodes);
-    ctr = 0;
+    queue = N_NEW(ns->nnodes, int);
+    qhead = qtail = ctr = 0;
 
-    for (v = GD_nlist(G); v; v = ND_next(v)) {
-	if (ND_priority(v) == 0)
-	    enqueue(Q, v);
+    for (v = 0; v < ns->nnodes; v++) {
+	if (ns->priority[v] == 0)
+	    queue[qtail++] = v;
     }
 
-    while ((v = dequeue(Q))) {
-	ND_rank(v) = 0;
+    while (qhead < qtail) {
+	v = queue[qhead++];
+	ns->rank[v] = 0;
 	ctr++;
-	for (i = 0; (e = ND_in(v).list[i]); i++)
-	    ND_rank(v) = MAX(ND_rank(v), ND_rank(agtail(e)) + ED_minlen(e));
-	for (i = 0; (e = ND_out(v).list[i]); i++) {
-	    if (--(ND_priority(aghead(e))) <= 0)
-		enqueue(Q, aghead(e));
+	for (i = ns->inbeg[v]; i < ns->inbeg[v + 1]; i++) {
+	    e = ns->in[i];
+	    ns->rank[v] = MAX(ns->rank[v], ns->rank[ns->tail[e]] + ns->minlen[e]);
+	}
+	for (i = ns->outbeg[v]; i < ns->outbeg[v + 1]; i++) {
+	    e = ns->out[i];
+	    if ((--(ns->priority[ns->head[e]]) <= 0) && (qtail < ns->nnodes))
+		queue[qtail++] = ns->head[e];
 	}
     }
-    if (ctr != N_nodes) {
+    if (ctr != ns->nnodes) {
 	agerr(AGERR, "trouble in init_rank\n");
-	for (v = GD_nlist(G); v; v = ND_next(v))
-	    if (ND_priority(v))
-		agerr(AGPREV, "\t%s %d\n", agnameof(v), ND_priority(v));
+	for (v = 0; v < ns->nnodes; v++)
+	    if (ns->priority[v])
+		agerr(AGPREV, "\t%s %d\n", nodename(ns, v, buf), ns->priority[v]);
     }
-    free_queue(Q);
+    free(queue);
 }
 
-static edge_t *leave_edge(void)
+static int leave_edge(nsgraph_t * ns)
 {
-    edge_t *f, *rv = NULL;
+    int f, rv = -1;
     int j, cnt = 0;
 
-    j = S_i;
-    while (S_i < Tree_edge.size) {
-	if (ED_cutvalue(f = Tree_edge.list[S_i]) < 0) {
-	    if (rv) {
-		if (ED_cutvalue(rv) > ED_cutvalue(f))
+    j = ns->S_i;
+    while (ns->S_i < ns->ntree) {
+	if (ns->cutvalue[f = ns->tree_edge[ns->S_i]] < 0) {
+	    if (rv >= 0) {
+		if (ns->cutvalue[rv] > ns->cutvalue[f])
 		    rv = f;
 	    } else
-		rv = Tree_edge.list[S_i];
-	    if (++cnt >= Search_size)
+		rv = ns->tree_edge[ns->S_i];
+	    if (++cnt >= ns->search_size)
 		return rv;
 	}
-	S_i++;
+	ns->S_i++;
     }
     if (j > 0) {
-	S_i = 0;
-	while (S_i < j) {
-	    if (ED_cutvalue(f = Tree_edge.list[S_i]) < 0) {
-		if (rv) {
-		    if (ED_cutvalue(rv) > ED_cutvalue(f))
+	ns->S_i = 0;
+	while (ns->S_i < j) {
+	    if (ns->cutvalue[f = ns->tree_edge[ns->S_i]] < 0) {
+		if (rv >= 0) {
+		    if (ns->cutvalue[rv] > ns->cutvalue[f])
 			rv = f;
 		} else
-		    rv = Tree_edge.list[S_i];
-		if (++cnt >= Search_size)
+		    rv = ns->tree_edge[ns->S_i];
+		if (++cnt >= ns->search_size)
 		    return rv;
 	    }
-	    S_i++;
+	    ns->S_i++;
 	}
     }
     return rv;
 }
 
-static edge_t *Enter;
-static int Low, Lim, Slack;
-
-static void dfs_enter_outedge(node_t * v)
+static void dfs_enter_outedge(nsgraph_t * ns, int v)
 {
-    int i, slack;
-    edge_t *e;
-
-    for (i = 0; (e = ND_out(v).list[i]); i++) {
-	if (TREE_EDGE(e) == FALSE) {
-	    if (!SEQ(Low, ND_lim(aghead(e)), Lim)) {
-		slack = SLACK(e);
-		if ((slack < Slack) || (Enter == NULL)) {
-		    Enter = e;
-		    Slack = slack;
+    int i, e, slack;
+
+    for (i = ns->outbeg[v]; i < ns->outbeg[v + 1]; i++) {
+	e = ns->out[i];
+	if (TREE_EDGE(ns, e) == FALSE) {
+	    if (!SEQ(ns->elow, ns->lim[ns->head[e]], ns->elim)) {
+		slack = SLACK(ns, e);
+		if ((slack < ns->eslack) || (ns->enter < 0)) {
+		    ns->enter = e;
+		    ns->eslack = slack;
 		}
 	    }
-	} else if (ND_lim(aghead(e)) < ND_lim(v))
-	    dfs_enter_outedge(aghead(e));
+	} else if (ns->lim[ns->head[e]] < ns->lim[v])
+	    dfs_enter_outedge(ns, ns->head[e]);
+    }
+    for (i = 0; (i < ns->ntin[v]) && (ns->eslack > 0); i++) {
+	e = TIN(ns, v)[i];
+	if (ns->lim[ns->tail[e]] < ns->lim[v])
+	    dfs_enter_outedge(ns, ns->tail[e]);
     }
-    for (i = 0; (e = ND_tree_in(v).list[i]) && (Slack > 0); i++)
-	if (ND_lim(agtail(e)) < ND_lim(v))
-	    dfs_enter_outedge(agtail(e));
 }
 
-static void dfs_enter_inedge(node_t * v)
+static void dfs_enter_inedge(nsgraph_t * ns, int v)
 {
-    int i, slack;
-    edge_t *e;
-
-    for (i = 0; (e = ND_in(v).list[i]); i++) {
-	if (TREE_EDGE(e) == FALSE) {
-	    if (!SEQ(Low, ND_lim(agtail(e)), Lim)) {
-		slack = SLACK(e);
-		if ((slack < Slack) || (Enter == NULL)) {
-		    Enter = e;
-		    Slack = slack;
+    int i, e, slack;
+
+    for (i = ns->inbeg[v]; i < ns->inbeg[v + 1]; i++) {
+	e = ns->in[i];
+	if (TREE_EDGE(ns, e) == FALSE) {
+	    if (!SEQ(ns->elow, ns->lim[ns->tail[e]], ns->elim)) {
+		slack = SLACK(ns, e);
+		if ((slack < ns->eslack) || (ns->enter < 0)) {
+		    ns->enter = e;
+		    ns->eslack = slack;
 		}
 	    }
-	} else if (ND_lim(agtail(e)) < ND_lim(v))
-	    dfs_enter_inedge(agtail(e));
+	} else if (ns->lim[ns->tail[e]] < ns->lim[v])
+	    dfs_enter_inedge(ns, ns->tail[e]);
+    }
+    for (i = 0; (i < ns->ntout[v]) && (ns->eslack > 0); i++) {
+	e = TOUT(ns, v)[i];
+	if (ns->lim[ns->head[e]] < ns->lim[v])
+	    dfs_enter_inedge(ns, ns->head[e]);
     }
-    for (i = 0; (e = ND_tree_out(v).list[i]) && (Slack > 0); i++)
-	if (ND_lim(aghead(e)) < ND_lim(v))
-	    dfs_enter_inedge(aghead(e));
 }
 
-static edge_t *enter_edge(edge_t * e)
+static int enter_edge(nsgraph_t * ns, int e)
 {
-    node_t *v;
-    int outsearch;
+    int v, outsearch;
 
     /* v is the down node */
-    if (ND_lim(agtail(e)) < ND_lim(aghead(e))) {
-	v = agtail(e);
+    if (ns->lim[ns->tail[e]] < ns->lim[ns->head[e]]) {
+	v = ns->tail[e];
 	outsearch = FALSE;
     } else {
-	v = aghead(e);
+	v = ns->head[e];
 	outsearch = TRUE;
     }
-    Enter = NULL;
-    Slack = INT_MAX;
-    Low = ND_low(v);
-    Lim = ND_lim(v);
+    ns->enter = -1;
+    ns->eslack = INT_MAX;
+    ns->elow = ns->low[v];
+    ns->elim = ns->lim[v];
     if (outsearch)
-	dfs_enter_outedge(v);
+	dfs_enter_outedge(ns, v);
     else
-	dfs_enter_inedge(v);
-    return Enter;
+	dfs_enter_inedge(ns, v);
+    return ns->enter;
 }
 
-static void init_cutvalues(void)
+static void init_cutvalues(nsgraph_t * ns)
 {
-    dfs_range(GD_nlist(G), NULL, 1);
-    dfs_cutval(GD_nlist(G), NULL);
+    dfs_range(ns, 0, -1, 1);
+    dfs_cutval(ns, 0, -1);
 }
 
 /* functions for initial tight tree construction */
-// borrow field from network simplex - overwritten in init_cutvalues() forgive me
-#define ND_subtree(n) (subtree_t*)ND_par(n)
-#define ND_subtree_set(n,value) (ND_par(n) = (edge_t*)value)
 
 typedef struct subtree_s {
-        node_t *rep;            /* some node in the tree */
+        int    rep;             /* some node in the tree */
         int    size;            /* total tight tree size */
         int    heap_index;      /* required to find non-min elts when merged */
         struct subtree_s *par;  /* union find */
 } subtree_t;
 
 /* find initial tight subtrees */
-static int tight_subtree_search(Agnode_t *v, subtree_t *st)
+static int tight_subtree_search(nsgraph_t * ns, int v, subtree_t *st)
 {
-    Agedge_t *e;
-    int     i;
+    int     i, e;
     int     rv;
 
     rv = 1;
-    ND_subtree_set(v,st);
-    for (i = 0; (e = ND_in(v).list[i]); i++) {
-        if (TREE_EDGE(e)) continue;
-        if ((ND_subtree(agtail(e)) == 0) && (SLACK(e) == 0)) {
-               add_tree_edge(e);
-               rv += tight_subtree_search(agtail(e),st);
+    ns->subtree[v] = st;
+    for (i = ns->inbeg[v]; i < ns->inbeg[v + 1]; i++) {
+        e = ns->in[i];
+        if (TREE_EDGE(ns, e)) continue;
+        if ((ns->subtree[ns->tail[e]] == 0) && (SLACK(ns, e) == 0)) {
+               add_tree_edge(ns, e);
+               rv += tight_subtree_search(ns, ns->tail[e], st);
         }
     }
-    for (i = 0; (e = ND_out(v).list[i]); i++) {
-        if (TREE_EDGE(e)) continue;
-        if ((ND_subtree(aghead(e)) == 0) && (SLACK(e) == 0)) {
-               add_tree_edge(e);
-               rv += tight_subtree_search(aghead(e),st);
+    for (i = ns->outbeg[v]; i < ns->outbeg[v + 1]; i++) {
+        e = ns->out[i];
+        if (TREE_EDGE(ns, e)) continue;
+        if ((ns->subtree[ns->head[e]] == 0) && (SLACK(ns, e) == 0)) {
+               add_tree_edge(ns, e);
+               rv += tight_subtree_search(ns, ns->head[e], st);
         }
     }
     return rv;
 }
 
-static subtree_t *find_tight_subtree(Agnode_t *v)
+static subtree_t *find_tight_subtree(nsgraph_t * ns, int v)
 {
     subtree_t       *rv;
     rv = NEW(subtree_t);
     rv->rep = v;
-    rv->size = tight_subtree_search(v,rv);
+    rv->size = tight_subtree_search(ns, v, rv);
     rv->par = rv;
     return rv;
 }
@@ -307,16 +397,16 @@ typedef struct STheap_s {
         int             size;
 } STheap_t;
 
-static subtree_t *STsetFind(Agnode_t *n0)
+static subtree_t *STsetFind(nsgraph_t * ns, int n0)
 {
-  subtree_t *s0 = ND_subtree(n0);
+  subtree_t *s0 = ns->subtree[n0];
   while  (s0->par && (s0->par != s0)) {
     if (s0->par->par) {s0->par = s0->par->par;}  /* path compression for the code weary */
     s0 = s0->par;
   }
   return s0;
 }
- 
+
 static subtree_t *STsetUnion(subtree_t *s0, subtree_t *s1)
 {
   subtree_t *r0, *r1, *r;
@@ -336,53 +426,50 @@ static subtree_t *STsetUnion(subtree_t *s0, subtree_t *s1)
   return r;
 }
 
-#define INCIDENT(e,treeset)  ((STsetFind(agtail(e),treeset)) != STsetFind(aghead(e),treeset))
-
 /* find tightest edge to another tree incident on the given tree */
-static Agedge_t *inter_tree_edge_search(Agnode_t *v, Agnode_t *from, Agedge_t *best)
+static int inter_tree_edge_search(nsgraph_t * ns, int v, int from, int best)
 {
-    int i;
-    Agedge_t *e;
-    subtree_t *ts = STsetFind(v);
-    if (best && SLACK(best) == 0) return best;
-    for (i = 0; (e = ND_out(v).list[i]); i++) {
-      if (TREE_EDGE(e)) {
-          if (aghead(e) == from) continue;  // do not search back in tree
-          best = inter_tree_edge_search(aghead(e),v,best); // search forward in tree
+    int i, e;
+    subtree_t *ts = STsetFind(ns, v);
+    if ((best >= 0) && SLACK(ns, best) == 0) return best;
+    for (i = ns->outbeg[v]; i < ns->outbeg[v + 1]; i++) {
+      e = ns->out[i];
+      if (TREE_EDGE(ns, e)) {
+          if (ns->head[e] == from) continue;  // do not search back in tree
+          best = inter_tree_edge_search(ns, ns->head[e], v, best); // search forward in tree
       }
       else {
-        if (STsetFind(aghead(e)) != ts) {   // encountered candidate edge
-          if ((best == 0) || (SLACK(e) < SLACK(best))) best = e;
+        if (STsetFind(ns, ns->head[e]) != ts) {   // encountered candidate edge
+          if ((best < 0) || (SLACK(ns, e) < SLACK(ns, best))) best = e;
         }
         /* else ignore non-tree edge between nodes in the same tree */
       }
     }
     /* the following code must mirror the above, but for in-edges */
-    for (i = 0; (e = ND_in(v).list[i]); i++) {
-      if (TREE_EDGE(e)) {
-          if (agtail(e) == from) continue;
-          best = inter_tree_edge_search(agtail(e),v,best);
+    for (i = ns->inbeg[v]; i < ns->inbeg[v + 1]; i++) {
+      e = ns->in[i];
+      if (TREE_EDGE(ns, e)) {
+          if (ns->tail[e] == from) continue;
+          best = inter_tree_edge_search(ns, ns->tail[e], v, best);
       }
       else {
-        if (STsetFind(agtail(e)) != ts) {
-          if ((best == 0) || (SLACK(e) < SLACK(best))) best = e;
+        if (STsetFind(ns, ns->tail[e]) != ts) {
+          if ((best < 0) || (SLACK(ns, e) < SLACK(ns, best))) best = e;
         }
       }
     }
     return best;
 }
 
-static Agedge_t *inter_tree_edge(subtree_t *tree)
+static int inter_tree_edge(nsgraph_t * ns, subtree_t *tree)
 {
-    Agedge_t *rv;
-    rv = inter_tree_edge_search(tree->rep, (Agnode_t *)0, (Agedge_t *)0);
-    return rv;
+    return inter_tree_edge_search(ns, tree->rep, -1, -1);
 }
 
 static
 int STheapsize(STheap_t *heap) { return heap->size; }
 
-static 
+static
 void STheapify(STheap_t *heap, int i)
 {
     int left, right, smallest;
@@ -436,74 +523,71 @@ subtree_t *STextractmin(STheap_t *heap)
 }
 
 static
-void tree_adjust(Agnode_t *v, Agnode_t *from, int delta)
+void tree_adjust(nsgraph_t * ns, int v, int from, int delta)
 {
-    int i;
-    Agedge_t *e;
-    Agnode_t *w;
-    ND_rank(v) = ND_rank(v) + delta;
-    for (i = 0; (e = ND_tree_in(v).list[i]); i++) {
-      w = agtail(e);
+    int i, e, w;
+    ns->rank[v] = ns->rank[v] + delta;
+    for (i = 0; i < ns->ntin[v]; i++) {
+      e = TIN(ns, v)[i];
+      w = ns->tail[e];
       if (w != from)
-        tree_adjust(w, v, delta);
+        tree_adjust(ns, w, v, delta);
     }
-    for (i = 0; (e = ND_tree_out(v).list[i]); i++) {
-      w = aghead(e);
+    for (i = 0; i < ns->ntout[v]; i++) {
+      e = TOUT(ns, v)[i];
+      w = ns->head[e];
       if (w != from)
-        tree_adjust(w, v, delta);
+        tree_adjust(ns, w, v, delta);
     }
 }
 
 static
-subtree_t *merge_trees(Agedge_t *e)   /* entering tree edge */
+subtree_t *merge_trees(nsgraph_t * ns, int e)   /* entering tree edge */
 {
   int       delta;
   subtree_t *t0, *t1, *rv;
 
-  assert(!TREE_EDGE(e));
+  assert(!TREE_EDGE(ns, e));
 
-  t0 = STsetFind(agtail(e));
-  t1 = STsetFind(aghead(e));
-
-  //fprintf(stderr,"merge trees of %d %d of %d, delta %d\n",t0->size,t1->size,N_nodes,delta);
+  t0 = STsetFind(ns, ns->tail[e]);
+  t1 = STsetFind(ns, ns->head[e]);
 
   if (t0->heap_index == -1) {   // move t0
-    delta = SLACK(e);
-    tree_adjust(t0->rep,(Agnode_t*)0,delta);
+    delta = SLACK(ns, e);
+    tree_adjust(ns, t0->rep, -1, delta);
   }
   else {  // move t1
-    delta = -SLACK(e);
-    tree_adjust(t1->rep,0,delta);
+    delta = -SLACK(ns, e);
+    tree_adjust(ns, t1->rep, -1, delta);
   }
-  add_tree_edge(e);
+  add_tree_edge(ns, e);
   rv = STsetUnion(t0,t1);
-  
+
   return rv;
 }
 
 /* Construct initial tight tree. Graph must be connected, feasible.
- * Adjust ND_rank(v) as needed.  add_tree_edge() on tight tree edges.
- * trees are basically lists of nodes stored in nodequeues.
+ * Adjust ranks as needed.  add_tree_edge() on tight tree edges.
+ * Return 1 if the graph is not connected.
  */
 static
-int feasible_tree(void)
+int feasible_tree(nsgraph_t * ns)
 {
-  Agnode_t *n;
-  Agedge_t *ee;
+  int v, ee, rv = 0;
   subtree_t **tree, *tree0, *tree1;
   int i, subtree_count = 0;
   STheap_t *heap;
 
   /* initialization */
-  for (n = GD_nlist(G); n; n = ND_next(n)) {
-      ND_subtree_set(n,0);
+  for (v = 0; v < ns->nnodes; v++) {
+      ns->subtree[v] = 0;
   }
 
-  tree = N_NEW(N_nodes,subtree_t*);
+  tree = N_NEW(ns->nnodes,subtree_t*);
   /* given init_rank, find all tight subtrees */
-  for (n = GD_nlist(G); n; n = ND_next(n)) {
-        if (ND_subtree(n) == 0) {
-                tree[subtree_count] = find_tight_subtree(n);
+  for (v = 0; v < ns->nnodes; v++) {
+        if (ns->subtree[v] == 0) {
+                tree[subtree_count] = find_tight_subtree(ns, v);
                 subtree_count++;
         }
   }
@@ -512,187 +596,171 @@ int feasible_tree(void)
   heap = STbuildheap(tree,subtree_count);
   while (STheapsize(heap) > 1) {
     tree0 = STextractmin(heap);
-    ee = inter_tree_edge(tree0);
-    tree1 = merge_trees(ee);
+    if ((ee = inter_tree_edge(ns, tree0)) < 0) {
+      rv = 1;
+      break;
+    }
+    tree1 = merge_trees(ns, ee);
     STheapify(heap,tree1->heap_index);
   }
 
   free(heap);
   for (i = 0; i < subtree_count; i++) free(tree[i]);
   free(tree);
-  assert(Tree_edge.size == N_nodes - 1);
-  init_cutvalues();
+  if (rv)
+    return rv;
+  assert(ns->ntree == ns->nnodes - 1);
+  init_cutvalues(ns);
   return 0;
 }
 
-/* utility functions for debugging */
-static subtree_t *nd_subtree(Agnode_t *n) {return ND_subtree(n);}
-static int nd_priority(Agnode_t *n) {return ND_priority(n);}
-static int nd_rank(Agnode_t *n) {return ND_rank(n);}
-static int ed_minlen(Agedge_t *e) {return ED_minlen(e);}
-
 /* walk up from v to LCA(v,w), setting new cutvalues. */
-static Agnode_t *treeupdate(Agnode_t * v, Agnode_t * w, int cutvalue, int dir)
+static int treeupdate(nsgraph_t * ns, int v, int w, int cutvalue, int dir)
 {
-    edge_t *e;
-    int d;
+    int e, d;
 
-    while (!SEQ(ND_low(v), ND_lim(w), ND_lim(v))) {
-	e = ND_par(v);
-	if (v == agtail(e))
+    while (!SEQ(ns->low[v], ns->lim[w], ns->lim[v])) {
+	e = ns->par[v];
+	if (v == ns->tail[e])
 	    d = dir;
 	else
 	    d = NOT(dir);
 	if (d)
-	    ED_cutvalue(e) += cutvalue;
+	    ns->cutvalue[e] += cutvalue;
 	else
-	    ED_cutvalue(e) -= cutvalue;
-	if (ND_lim(agtail(e)) > ND_lim(aghead(e)))
-	    v = agtail(e);
+	    ns->cutvalue[e] -= cutvalue;
+	if (ns->lim[ns->tail[e]] > ns->lim[ns->head[e]])
+	    v = ns->tail[e];
 	else
-	    v = aghead(e);
+	    v = ns->head[e];
     }
     return v;
 }
 
-static void rerank(Agnode_t * v, int delta)
+static void rerank(nsgraph_t * ns, int v, int delta)
 {
-    int i;
-    edge_t *e;
-
-    ND_rank(v) -= delta;
-    for (i = 0; (e = ND_tree_out(v).list[i]); i++)
-	if (e != ND_par(v))
-	    rerank(aghead(e), delta);
-    for (i = 0; (e = ND_tree_in(v).list[i]); i++)
-	if (e != ND_par(v))
-	    rerank(agtail(e), delta);
+    int i, e;
+
+    ns->rank[v] -= delta;
+    for (i = 0; i < ns->ntout[v]; i++)
+	if ((e = TOUT(ns, v)[i]) != ns->par[v])
+	    rerank(ns, ns->head[e], delta);
+    for (i = 0; i < ns->ntin[v]; i++)
+	if ((e = TIN(ns, v)[i]) != ns->par[v])
+	    rerank(ns, ns->tail[e], delta);
 }
 
 /* e is the tree edge that is leaving and f is the nontree edge that
  * is entering.  compute new cut values, ranks, and exchange e and f.
  */
-static void 
-update(edge_t * e, edge_t * f)
+static void
+update(nsgraph_t * ns, int e, int f)
 {
-    int cutvalue, delta;
-    Agnode_t *lca;
+    int cutvalue, delta, lca;
+    int t = ns->tail[e], h = ns->head[e];
 
-    delta = SLACK(f);
-    /* "for (v = in nodes in tail side of e) do ND_rank(v) -= delta;" */
+    delta = SLACK(ns, f);
+    /* "for (v = in nodes in tail side of e) do rank[v] -= delta;" */
     if (delta > 0) {
 	int s;
-	s = ND_tree_in(agtail(e)).size + ND_tree_out(agtail(e)).size;
+	s = ns->ntin[t] + ns->ntout[t];
 	if (s == 1)
-	    rerank(agtail(e), delta);
+	    rerank(ns, t, delta);
 	else {
-	    s = ND_tree_in(aghead(e)).size + ND_tree_out(aghead(e)).size;
+	    s = ns->ntin[h] + ns->ntout[h];
 	    if (s == 1)
-		rerank(aghead(e), -delta);
+		rerank(ns, h, -delta);
 	    else {
-		if (ND_lim(agtail(e)) < ND_lim(aghead(e)))
-		    rerank(agtail(e), delta);
+		if (ns->lim[t] < ns->lim[h])
+		    rerank(ns, t, delta);
 		else
-		    rerank(aghead(e), -delta);
+		    rerank(ns, h, -delta);
 	    }
 	}
     }
 
-    cutvalue = ED_cutvalue(e);
-    lca = treeupdate(agtail(f), aghead(f), cutvalue, 1);
-    if (treeupdate(aghead(f), agtail(f), cutvalue, 0) != lca) {
+    cutvalue = ns->cutvalue[e];
+    lca = treeupdate(ns, ns->tail[f], ns->head[f], cutvalue, 1);
+    if (treeupdate(ns, ns->head[f], ns->tail[f], cutvalue, 0) != lca) {
 	agerr(AGERR, "update: mismatched lca in treeupdates\n");
-	longjmp (jbuf, 1);
+	longjmp (ns->jbuf, 1);
     }
-    ED_cutvalue(f) = -cutvalue;
-    ED_cutvalue(e) = 0;
-    exchange_tree_edges(e, f);
-    dfs_range(lca, ND_par(lca), ND_low(lca));
+    ns->cutvalue[f] = -cutvalue;
+    ns->cutvalue[e] = 0;
+    exchange_tree_edges(ns, e, f);
+    dfs_range(ns, lca, ns->par[lca], ns->low[lca]);
 }
 
-static void scan_and_normalize(void)
+static void scan_and_normalize(nsgraph_t * ns)
 {
-    node_t *n;
-
-    Minrank = INT_MAX;
-    Maxrank = -INT_MAX;
-    for (n = GD_nlist(G); n; n = ND_next(n)) {
-	if (ND_node_type(n) == NORMAL) {
-	    Minrank = MIN(Minrank, ND_rank(n));
-	    Maxrank = MAX(Maxrank, ND_rank(n));
+    int v;
+
+    ns->minrank = INT_MAX;
+    ns->maxrank = -INT_MAX;
+    for (v = 0; v < ns->nnodes; v++) {
+	if (ns->normal[v]) {
+	    ns->minrank = MIN(ns->minrank, ns->rank[v]);
+	    ns->maxrank = MAX(ns->maxrank, ns->rank[v]);
 	}
     }
-    if (Minrank != 0) {
-	for (n = GD_nlist(G); n; n = ND_next(n))
-	    ND_rank(n) -= Minrank;
-	Maxrank -= Minrank;
-	Minrank = 0;
+    if (ns->minrank != 0) {
+	for (v = 0; v < ns->nnodes; v++)
+	    ns->rank[v] -= ns->minrank;
+	ns->maxrank -= ns->minrank;
+	ns->minrank = 0;
     }
 }
 
-static void
-freeTreeList (graph_t* g)
+static void LR_balance(nsgraph_t * ns)
 {
-    node_t *n;
-    for (n = GD_nlist(G); n; n = ND_next(n)) {
-	free_list(ND_tree_in(n));
-	free_list(ND_tree_out(n));
-	ND_mark(n) = FALSE;
-    }
-}
+    int i, delta, e, f;
 
-static void LR_balance(void)
-{
-    int i, delta;
-    edge_t *e, *f;
-
-    for (i = 0; i < Tree_edge.size; i++) {
-	e = Tree_edge.list[i];
-	if (ED_cutvalue(e) == 0) {
-	    f = enter_edge(e);
-	    if (f == NULL)
+    for (i = 0; i < ns->ntree; i++) {
+	e = ns->tree_edge[i];
+	if (ns->cutvalue[e] == 0) {
+	    f = enter_edge(ns, e);
+	    if (f < 0)
 		continue;
-	    delta = SLACK(f);
+	    delta = SLACK(ns, f);
 	    if (delta <= 1)
 		continue;
-	    if (ND_lim(agtail(e)) < ND_lim(aghead(e)))
-		rerank(agtail(e), delta / 2);
+	    if (ns->lim[ns->tail[e]] < ns->lim[ns->head[e]])
+		rerank(ns, ns->tail[e], delta / 2);
 	    else
-		rerank(aghead(e), -delta / 2);
+		rerank(ns, ns->head[e], -delta / 2);
 	}
     }
-    freeTreeList (G);
 }
 
-static void TB_balance(void)
+static void TB_balance(nsgraph_t * ns)
 {
-    node_t *n;
-    edge_t *e;
-    int i, low, high, choice, *nrank;
+    int v, e, i, low, high, choice, *nrank;
     int inweight, outweight;
 
-    scan_and_normalize();
+    scan_and_normalize(ns);
 
     /* find nodes that are not tight and move to less populated ranks */
-    nrank = N_NEW(Maxrank + 1, int);
-    for (i = 0; i <= Maxrank; i++)
+    nrank = N_NEW(ns->maxrank + 1, int);
+    for (i = 0; i <= ns->maxrank; i++)
 	nrank[i] = 0;
-    for (n = GD_nlist(G); n; n = ND_next(n))
-	if (ND_node_type(n) == NORMAL)
-	    nrank[ND_rank(n)]++;
-    for (n = GD_nlist(G); n; n = ND_next(n)) {
-	if (ND_node_type(n) != NORMAL)
+    for (v = 0; v < ns->nnodes; v++)
+	if (ns->normal[v])
+	    nrank[ns->rank[v]]++;
+    for (v = 0; v < ns->nnodes; v++) {
+	if (!ns->normal[v])
 	    continue;
 	inweight = outweight = 0;
 	low = 0;
-	high = Maxrank;
-	for (i = 0; (e = ND_in(n).list[i]); i++) {
-	    inweight += ED_weight(e);
-	    low = MAX(low, ND_rank(agtail(e)) + ED_minlen(e));
+	high = ns->maxrank;
+	for (i = ns->inbeg[v]; i < ns->inbeg[v + 1]; i++) {
+	    e = ns->in[i];
+	    inweight += ns->weight[e];
+	    low = MAX(low, ns->rank[ns->tail[e]] + ns->minlen[e]);
 	}
-	for (i = 0; (e = ND_out(n).list[i]); i++) {
-	    outweight += ED_weight(e);
-	    high = MIN(high, ND_rank(aghead(e)) - ED_minlen(e));
+	for (i = ns->outbeg[v]; i < ns->outbeg[v + 1]; i++) {
+	    e = ns->out[i];
+	    outweight += ns->weight[e];
+	    high = MIN(high, ns->rank[ns->head[e]] - ns->minlen[e]);
 	}
 	if (low < 0)
 	    low = 0;		/* vnodes can have ranks < 0 */
@@ -701,57 +769,113 @@ static void TB_balance(void)
 	    for (i = low + 1; i <= high; i++)
 		if (nrank[i] < nrank[choice])
 		    choice = i;
-	    nrank[ND_rank(n)]--;
+	    nrank[ns->rank[v]]--;
 	    nrank[choice]++;
-	    ND_rank(n) = choice;
+	    ns->rank[v] = choice;
 	}
-	free_list(ND_tree_in(n));
-	free_list(ND_tree_out(n));
-	ND_mark(n) = FALSE;
     }
     free(nrank);
 }
 
-static int init_graph(graph_t * g)
+static int init_graph(nsgraph_t * ns)
 {
-    int i, feasible;
-    node_t *n;
-    edge_t *e;
-
-    G = g;
-    N_nodes = N_edges = S_i = 0;
-    for (n = GD_nlist(g); n; n = ND_next(n)) {
-	ND_mark(n) = FALSE;
-	N_nodes++;
-	for (i = 0; (e = ND_out(n).list[i]); i++)
-	    N_edges++;
-    }
-
-    Tree_node.list = ALLOC(N_nodes, Tree_node.list, node_t *);
-    Tree_node.size = 0;
-    Tree_edge.list = ALLOC(N_nodes, Tree_edge.list, edge_t *);
-    Tree_edge.size = 0;
+    int i, v, e, feasible;
 
+    ns->S_i = ns->ntree = 0;
     feasible = TRUE;
-    for (n = GD_nlist(g); n; n = ND_next(n)) {
-	ND_priority(n) = 0;
-	for (i = 0; (e = ND_in(n).list[i]); i++) {
-	    ND_priority(n)++;
-	    ED_cutvalue(e) = 0;
-	    ED_tree_index(e) = -1;
-	    if (feasible
-		&& (ND_rank(aghead(e)) - ND_rank(agtail(e)) < ED_minlen(e)))
+    for (v = 0; v < ns->nnodes; v++) {
+	ns->priority[v] = 0;
+	for (i = ns->inbeg[v]; i < ns->inbeg[v + 1]; i++) {
+	    e = ns->in[i];
+	    ns->priority[v]++;
+	    ns->cutvalue[e] = 0;
+	    ns->treeidx[e] = -1;
+	    if (feasible && (LENGTH(ns, e) < ns->minlen[e]))
 		feasible = FALSE;
 	}
-	ND_tree_in(n).list = N_NEW(i + 1, edge_t *);
-	ND_tree_in(n).size = 0;
-	for (i = 0; (e = ND_out(n).list[i]); i++);
-	ND_tree_out(n).list = N_NEW(i + 1, edge_t *);
-	ND_tree_out(n).size = 0;
+	ns->ntin[v] = ns->ntout[v] = 0;
     }
     return feasible;
 }
 
+/* ns_solve:
+ * Apply network simplex to rank the nodes of ns.
+ * The constraint of an edge e is rank[head] - rank[tail] >= minlen[e].
+ * If ns->g is set and its layout runs out of time (see gvtimedout),
+ * the pivots stop early, leaving feasible but longer ranks.
+ * Returns 0 if successful; returns 1 if the graph was not connected;
+ * returns 2 if something seriously wrong;
+ */
+int ns_solve(nsgraph_t * ns, int balance, int maxiter, int search_size)
+{
+    int iter = 0, feasible;
+    char *s = "network simplex: ";
+    int e, f;
+
+    if (Verbose) {
+	fprintf(stderr, "%s %d nodes %d edges maxiter=%d balance=%d\n", s,
+	    ns->nnodes, ns->nedges, maxiter, balance);
+	start_timer();
+    }
+    if (ns->nnodes == 0)
+	return 0;
+    feasible = init_graph(ns);
+    if (!feasible)
+	init_rank(ns);
+    if (maxiter <= 0)
+	return 0;
+
+    if (search_size >= 0)
+	ns->search_size = search_size;
+    else
+	ns->search_size = SEARCHSIZE;
+
+    if (setjmp (ns->jbuf)) {
+	return 2;
+    }
+
+    if (feasible_tree(ns))
+	return 1;
+    while ((e = leave_edge(ns)) >= 0) {
+	if ((f = enter_edge(ns, e)) < 0) {
+	    agerr(AGERR, "network simplex: no entering edge\n");
+	    return 2;
+	}
+	update(ns, e, f);
+	iter++;
+	if (Verbose && (iter % 100 == 0)) {
+	    if (iter % 1000 == 100)
+		fputs(s, stderr);
+	    fprintf(stderr, "%d ", iter);
+	    if (iter % 1000 == 0)
+		fputc('\n', stderr);
+	}
+	if (iter >= maxiter)
+	    break;
+	/* every tree is feasible, so stopping early only costs length */
+	if (ns->g && (iter % 64 == 0) && gvtimedout(ns->g))
+	    break;
+    }
+    switch (balance) {
+    case 1:
+	TB_balance(ns);
+	break;
+    case 2:
+	LR_balance(ns);
+	break;
+    default:
+	scan_and_normalize(ns);
+	break;
+    }
+    if (Verbose) {
+	if (iter >= 100)
+	    fputc('\n', stderr);
+	fprintf(stderr, "%s%d nodes %d edges %d iter %.2f sec\n",
+		s, ns->nnodes, ns->nedges, iter, elapsed_sec());
+    }
+    return 0;
+}
+
 /* graphSize:
  * Compute no. of nodes and edges in the graph
  */
@@ -761,7 +885,7 @@ graphSize (graph_t * g, int* nn, int* ne)
     int i, nnodes, nedges;
     node_t *n;
     edge_t *e;
-   
+
     nnodes = nedges = 0;
     for (n = GD_nlist(g); n; n = ND_next(n)) {
 	nnodes++;
@@ -782,79 +906,62 @@ graphSize (graph_t * g, int* nn, int* ne)
  *   Out and in edges lists stored in ND_out and ND_in, even if the node
  *  doesn't have any out or in edges.
  * The node rank values are stored in ND_rank.
+ * Nodes and edges are numbered in list order, using ND_low and
+ * ED_tree_index, which the solver used to own, as scratch space, so
+ * that the adjacency lists keep the order of ND_out and ND_in.
  * Returns 0 if successful; returns 1 if `he graph was not connected;
  * returns 2 if something seriously wrong;
  */
 int rank2(graph_t * g, int balance, int maxiter, int search_size)
 {
-    int iter = 0, feasible;
-    char *ns = "network simplex: ";
-    edge_t *e, *f;
+    nsgraph_t *ns;
+    node_t *n;
+    edge_t *e;
+    int i, k, v, nn, ne, rv;
 
 #ifdef DEBUG
     check_cycles(g);
 #endif
-    if (Verbose) {
-	int nn, ne;
-	graphSize (g, &nn, &ne);
-	fprintf(stderr, "%s %d nodes %d edges maxiter=%d balance=%d\n", ns,
-	    nn, ne, maxiter, balance);
-	start_timer();
-    }
-    feasible = init_graph(g);
-    if (!feasible)
-	init_rank();
-    if (maxiter <= 0) {
-	freeTreeList (g);
-	return 0;
-    }
-
-    if (search_size >= 0)
-	Search_size = search_size;
-    else
-	Search_size = SEARCHSIZE;
-
-    if (setjmp (jbuf)) {
-	return 2;
-    }
-
-    if (feasible_tree()) {
-	freeTreeList (g);
-	return 1;
+    graphSize (g, &nn, &ne);
+    ns = ns_open(nn, ne);
+    ns->node = N_NEW(nn, node_t *);
+    ns->g = g;
+    for (v = 0, n = GD_nlist(g); n; v++, n = ND_next(n)) {
+	ND_low(n) = v;
+	ns->node[v] = n;
+	ns->rank[v] = ND_rank(n);
+	ns->normal[v] = (ND_node_type(n) == NORMAL);
     }
-    while ((e = leave_edge())) {
-	f = enter_edge(e);
-	update(e, f);
-	iter++;
-	if (Verbose && (iter % 100 == 0)) {
-	    if (iter % 1000 == 100)
-		fputs(ns, stderr);
-	    fprintf(stderr, "%d ", iter);
-	    if (iter % 1000 == 0)
-		fputc('\n', stderr);
+    for (k = 0, n = GD_nlist(g); n; n = ND_next(n)) {
+	v = ND_low(n);
+	ns->outbeg[v] = k;
+	for (i = 0; (e = ND_out(n).list[i]); i++) {
+	    ED_tree_index(e) = k;
+	    ns->tail[k] = v;
+	    ns->head[k] = ND_low(aghead(e));
+	    ns->minlen[k] = ED_minlen(e);
+	    ns->weight[k] = ED_weight(e);
+	    ns->out[k] = k;
+	    k++;
 	}
-	if (iter >= maxiter)
-	    break;
     }
-    switch (balance) {
-    case 1:
-	TB_balance();
-	break;
-    case 2:
-	LR_balance();
-	break;
-    default:
-	scan_and_normalize();
-	freeTreeList (G);
-	break;
+    ns->outbeg[nn] = k;
+    for (k = 0, n = GD_nlist(g); n; n = ND_next(n)) {
+	ns->inbeg[ND_low(n)] = k;
+	for (i = 0; (e = ND_in(n).list[i]); i++)
+	    ns->in[k++] = ED_tree_index(e);
     }
-    if (Verbose) {
-	if (iter >= 100)
-	    fputc('\n', stderr);
-	fprintf(stderr, "%s%d nodes %d edges %d iter %.2f sec\n",
-		ns, N_nodes, N_edges, iter, elapsed_sec());
+    ns->inbeg[nn] = k;
+    assert(k == ne);
+
+    rv = ns_solve(ns, balance, maxiter, search_size);
+
+    for (n = GD_nlist(g); n; n = ND_next(n)) {
+	ND_rank(n) = ns->rank[ND_low(n)];
+	ND_mark(n) = FALSE;
     }
-    return 0;
+    ns_close(ns);
+    return rv;
 }
 
 int rank(graph_t * g, int balance, int maxiter)
@@ -862,7 +969,10 @@ int rank(graph_t * g, int balance, int maxiter)
     char *s;
     int search_size;
 
-    if ((s = agget(g, "searchsize")))
+    gvlock();
+    s = agget(g, "searchsize");
+    gvunlock();
+    if (s)
 	search_size = atoi(s);
     else
 	search_size = SEARCHSIZE;
@@ -871,56 +981,54 @@ int rank(graph_t * g, int balance, int maxiter)
 }
 
 /* set cut value of f, assuming values of edges on one side were already set */
-static void x_cutval(edge_t * f)
+static void x_cutval(nsgraph_t * ns, int f)
 {
-    node_t *v;
-    edge_t *e;
-    int i, sum, dir;
+    int v, i, sum, dir;
 
     /* set v to the node on the side of the edge already searched */
-    if (ND_par(agtail(f)) == f) {
-	v = agtail(f);
+    if (ns->par[ns->tail[f]] == f) {
+	v = ns->tail[f];
 	dir = 1;
     } else {
-	v = aghead(f);
+	v = ns->head[f];
 	dir = -1;
     }
 
     sum = 0;
-    for (i = 0; (e = ND_out(v).list[i]); i++)
-	sum += x_val(e, v, dir);
-    for (i = 0; (e = ND_in(v).list[i]); i++)
-	sum += x_val(e, v, dir);
-    ED_cutvalue(f) = sum;
+    for (i = ns->outbeg[v]; i < ns->outbeg[v + 1]; i++)
+	sum += x_val(ns, ns->out[i], v, dir);
+    for (i = ns->inbeg[v]; i < ns->inbeg[v + 1]; i++)
+	sum += x_val(ns, ns->in[i], v, dir);
+    ns->cutvalue[f] = sum;
 }
 
-static int x_val(edge_t * e, node_t * v, int dir)
+static int x_val(nsgraph_t * ns, int e, int v, int dir)
 {
-    node_t *other;
+    int other;
     int d, rv, f;
 
-    if (agtail(e) == v)
-	other = aghead(e);
+    if (ns->tail[e] == v)
+	other = ns->head[e];
     else
-	other = agtail(e);
-    if (!(SEQ(ND_low(v), ND_lim(other), ND_lim(v)))) {
+	other = ns->tail[e];
+    if (!(SEQ(ns->low[v], ns->lim[other], ns->lim[v]))) {
 	f = 1;
-	rv = ED_weight(e);
+	rv = ns->weight[e];
     } else {
 	f = 0;
-	if (TREE_EDGE(e))
-	    rv = ED_cutvalue(e);
+	if (TREE_EDGE(ns, e))
+	    rv = ns->cutvalue[e];
 	else
 	    rv = 0;
-	rv -= ED_weight(e);
+	rv -= ns->weight[e];
     }
     if (dir > 0) {
-	if (aghead(e) == v)
+	if (ns->head[e] == v)
 	    d = 1;
 	else
 	    d = -1;
     } else {
-	if (agtail(e) == v)
+	if (ns->tail[e] == v)
 	    d = 1;
 	else
 	    d = -1;
@@ -932,110 +1040,77 @@ static int x_val(edge_t * e, node_t * v, int dir)
     return rv;
 }
 
-static void dfs_cutval(node_t * v, edge_t * par)
+static void dfs_cutval(nsgraph_t * ns, int v, int par)
 {
-    int i;
-    edge_t *e;
-
-    for (i = 0; (e = ND_tree_out(v).list[i]); i++)
-	if (e != par)
-	    dfs_cutval(aghead(e), e);
-    for (i = 0; (e = ND_tree_in(v).list[i]); i++)
-	if (e != par)
-	    dfs_cutval(agtail(e), e);
-    if (par)
-	x_cutval(par);
+    int i, e;
+
+    for (i = 0; i < ns->ntout[v]; i++)
+	if ((e = TOUT(ns, v)[i]) != par)
+	    dfs_cutval(ns, ns->head[e], e);
+    for (i = 0; i < ns->ntin[v]; i++)
+	if ((e = TIN(ns, v)[i]) != par)
+	    dfs_cutval(ns, ns->tail[e], e);
+    if (par >= 0)
+	x_cutval(ns, par);
 }
 
-static int dfs_range(node_t * v, edge_t * par, int low)
+static int dfs_range(nsgraph_t * ns, int v, int par, int low)
 {
-    edge_t *e;
-    int i, lim;
+    int i, e, lim;
 
     lim = low;
-    ND_par(v) = par;
-    ND_low(v) = low;
-    for (i = 0; (e = ND_tree_out(v).list[i]); i++)
-	if (e != par)
-	    lim = dfs_range(aghead(e), e, lim);
-    for (i = 0; (e = ND_tree_in(v).list[i]); i++)
-	if (e != par)
-	    lim = dfs_range(agtail(e), e, lim);
-    ND_lim(v) = lim;
+    ns->par[v] = par;
+    ns->low[v] = low;
+    for (i = 0; i < ns->ntout[v]; i++)
+	if ((e = TOUT(ns, v)[i]) != par)
+	    lim = dfs_range(ns, ns->head[e], e, lim);
+    for (i = 0; i < ns->ntin[v]; i++)
+	if ((e = TIN(ns, v)[i]) != par)
+	    lim = dfs_range(ns, ns->tail[e], e, lim);
+    ns->lim[v] = lim;
     return lim + 1;
 }
 
 #ifdef DEBUG
-void tchk(void)
-{
-    int i, n_cnt, e_cnt;
-    node_t *n;
-    edge_t *e;
-
-    n_cnt = 0;
-    e_cnt = 0;
-    for (n = agfstnode(G); n; n = agnxtnode(G, n)) {
-	n_cnt++;
-	for (i = 0; (e = ND_tree_out(n).list[i]); i++) {
-	    e_cnt++;
-	    if (SLACK(e) > 0)
-		fprintf(stderr, "not a tight tree %p", e);
-	}
-    }
-    if ((n_cnt != Tree_node.size) || (e_cnt != Tree_edge.size))
-	fprintf(stderr, "something missing\n");
-}
-
-void check_cutvalues(void)
+void check_cutvalues(nsgraph_t * ns)
 {
-    node_t *v;
-    edge_t *e;
-    int i, save;
-
-    for (v = agfstnode(G); v; v = agnxtnode(G, v)) {
-	for (i = 0; (e = ND_tree_out(v).list[i]); i++) {
-	    save = ED_cutvalue(e);
-	    x_cutval(e);
-	    if (save != ED_cutvalue(e))
+    int v, i, e, save;
+
+    for (v = 0; v < ns->nnodes; v++) {
+	for (i = 0; i < ns->ntout[v]; i++) {
+	    e = TOUT(ns, v)[i];
+	    save = ns->cutvalue[e];
+	    x_cutval(ns, e);
+	    if (save != ns->cutvalue[e])
 		abort();
 	}
     }
 }
 
-int check_ranks(void)
+int check_ranks(nsgraph_t * ns)
 {
-    int cost = 0;
-    node_t *n;
-    edge_t *e;
+    int e, cost = 0;
 
-    for (n = agfstnode(G); n; n = agnxtnode(G, n)) {
-	for (e = agfstout(G, n); e; e = agnxtout(G, e)) {
-	    cost += (ED_weight(e)) * abs(LENGTH(e));
-	    if (ND_rank(aghead(e)) - ND_rank(agtail(e)) - ED_minlen(e) < 0)
-		abort();
-	}
+    for (e = 0; e < ns->nedges; e++) {
+	cost += ns->weight[e] * abs(LENGTH(ns, e));
+	if (SLACK(ns, e) < 0)
+	    abort();
     }
     fprintf(stderr, "rank cost %d\n", cost);
     return cost;
 }
 
-void checktree(void)
+void checktree(nsgraph_t * ns)
 {
-    int i, n = 0, m = 0;
-    node_t *v;
-    edge_t *e;
+    int v, n = 0, m = 0;
 
-    for (v = agfstnode(G); v; v = agnxtnode(G, v)) {
-	for (i = 0; (e = ND_tree_out(v).list[i]); i++)
-	    n++;
-	if (i != ND_tree_out(v).size)
-	    abort();
-	for (i = 0; (e = ND_tree_in(v).list[i]); i++)
-	    m++;
-	if (i != ND_tree_in(v).size)
-	    abort();
+    for (v = 0; v < ns->nnodes; v++) {
+	n += ns->ntout[v];
+	m += ns->ntin[v];
     }
-    fprintf(stderr, "%d %d %d\n", Tree_edge.size, n, m);
+    if ((n != ns->ntree) || (m != ns->ntree))
+	abort();
+    fprintf(stderr, "%d %d %d\n", ns->ntree, n, m);
 }
 
 void check_fast_node(node_t * n)
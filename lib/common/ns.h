@@ -0,0 +1,65 @@
+/* $Id$ $Revision$ */
+/* vim:set shiftwidth=4 ts=8: */
+
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: See CVS logs. Details at http://www.graphviz.org/
+ *************************************************************************/
+
+#ifndef NS_H
+#define NS_H
+
+#include <setjmp.h>
+#include "types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Network simplex problem
+ * Nodes and edges are numbered from 0. The caller fills in the edges,
+ * the initial ranks, which nodes are normal, and the adjacency lists,
+ * either directly or from the edges with ns_adjacency. All solver
+ * state is kept here, so separate problems can be solved concurrently.
+ */
+typedef struct nsgraph_s {
+    int nnodes, nedges;
+	/* set by the caller */
+    int *tail, *head;		/* edge endpoints */
+    int *minlen, *weight;
+    int *rank;			/* initial, then final, node ranks */
+    unsigned char *normal;	/* counted when normalizing and balancing */
+    node_t **node;		/* for messages, or NULL */
+    graph_t *g;			/* whose layout may stop pivoting early, or NULL */
+    int *outbeg, *out;		/* out edges of v: out[outbeg[v]..outbeg[v+1]) */
+    int *inbeg, *in;		/* in edges, likewise */
+	/* solver state */
+    int *cutvalue;
+    int *treeidx;		/* index in tree_edge, or -1 */
+    int *tree_edge, ntree;
+    int *tout, *ntout;		/* tree out edges of v, from tout + outbeg[v] */
+    int *tin, *ntin;
+    int *par, *low, *lim;	/* parent edge, or -1, and postorder range */
+    int *priority;
+    struct subtree_s **subtree;
+    int search_size, S_i;
+    int enter, elow, elim, eslack;	/* enter_edge search */
+    int minrank, maxrank;
+    jmp_buf jbuf;
+} nsgraph_t;
+
+extern nsgraph_t *ns_open(int nnodes, int nedges);
+extern void ns_adjacency(nsgraph_t * ns);
+extern int ns_solve(nsgraph_t * ns, int balance, int maxiter,
+		    int search_size);
+extern void ns_close(nsgraph_t * ns);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
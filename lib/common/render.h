@@ -42,6 +42,7 @@ extern "C" {
 #include "const.h"
 #include "globals.h"
 #include "memory.h"
+#include "workers.h"
 #include "colorprocs.h"		/* must collow color.h (in types.h) */
 #include "geomprocs.h"		/* must follow geom.h (in types.h) */
 #include "agxbuf.h"
@@ -142,8 +143,10 @@ extern "C" {
     extern int routesplinesinit(void);
     extern pointf *routesplines(path *, int *);
     extern void routesplinesterm(void);
+    extern void routesplinesfree(void);
     extern pointf* simpleSplineRoute (pointf, pointf, Ppoly_t, int*, int);
     extern pointf *routepolylines(path* pp, int* npoints);
+    extern pointf *tryroutesplines(path* pp, int* npoints, int polyline);
     extern int selfRightSpace (edge_t* e);
     extern void setup_graph(GVC_t * gvc, graph_t * g);
     extern shape_kind shapeOf(node_t *);
@@ -30,16 +30,17 @@ static int maxbn = 0;
 static edge_t *origedge;
 #endif
 
-static int nedges, nboxes; /* total no. of edges and boxes used in routing */
+static GVTLS int nedges, nboxes; /* total no. of edges and boxes used in routing */
 
 static int routeinit;
-/* static data used across multiple edges */
-static pointf *ps;             /* final spline points */
-static int maxpn;             /* size of ps[] */
-static Ppoint_t *polypoints;  /* vertices of polygon defined by boxes */
-static int polypointn;        /* size of polypoints[] */
-static Pedge_t *edges;        /* polygon edges passed to Proutespline */
-static int edgen;             /* size of edges[] */
+/* static data used across multiple edges, kept by each thread */
+static GVTLS pointf *ps;             /* final spline points */
+static GVTLS int maxpn;             /* size of ps[] */
+static GVTLS Ppoint_t *polypoints;  /* vertices of polygon defined by boxes */
+static GVTLS int polypointn;        /* size of polypoints[] */
+static GVTLS Pedge_t *edges;        /* polygon edges passed to Proutespline */
+static GVTLS int edgen;             /* size of edges[] */
+static GVTLS boolean trial;         /* give up rather than report problems */
 
 static int checkpath(int, boxf*, path*);
 static int mkspacep(int size);
@@ -323,6 +324,23 @@ void routesplinesterm()
 		nedges, nboxes, elapsed_sec());
 }
 
+/* routesplinesfree:
+ * Free the space the calling thread has used to route edges, as a
+ * worker thread routing edges for the thread that called
+ * routesplinesinit should before it finishes. Routing allocates the
+ * space again as needed.
+ */
+void routesplinesfree()
+{
+    free(ps);
+    ps = NULL, maxpn = 0;
+    free(polypoints);
+    polypoints = NULL, polypointn = 0;
+    free(edges);
+    edges = NULL, edgen = 0;
+    Pfreespace();
+}
+
 static void
 limitBoxes (boxf* boxes, int boxn, pointf *pps, int pn, int delta)
 {
@@ -413,7 +431,8 @@ static pointf *_routesplines(path * pp, int *npoints, int polyline)
 	 realedge && ED_edge_type(realedge) != NORMAL;
 	 realedge = ED_to_orig(realedge));
     if (!realedge) {
-	agerr(AGERR, "in routesplines, cannot find NORMAL edge\n");
+	if (!trial)
+	    agerr(AGERR, "in routesplines, cannot find NORMAL edge\n");
 	return NULL;
     }
 
@@ -477,7 +496,8 @@ static pointf *_routesplines(path * pp, int *npoints, int polyline)
 	    } 
 	    else {
 		if (!(prev == -1 && next == -1)) {
-		    agerr(AGERR, "in routesplines, illegal values of prev %d and next %d, line %d\n", prev, next, __LINE__);
+		    if (!trial)
+			agerr(AGERR, "in routesplines, illegal values of prev %d and next %d, line %d\n", prev, next, __LINE__);
 		    return NULL;
 		}
 	    }
@@ -510,7 +530,8 @@ static pointf *_routesplines(path * pp, int *npoints, int polyline)
 	    else {
 		if (!(prev == -1 && next == -1)) {
 		    /* it went badly, e.g. degenerate box in boxlist */
-		    agerr(AGERR, "in routesplines, illegal values of prev %d and next %d, line %d\n", prev, next, __LINE__);
+		    if (!trial)
+			agerr(AGERR, "in routesplines, illegal values of prev %d and next %d, line %d\n", prev, next, __LINE__);
 		    return NULL; /* for correctness sake, it's best to just stop */
 		}
 		polypoints[pi].x = boxes[bi].UR.x;
@@ -525,7 +546,8 @@ static pointf *_routesplines(path * pp, int *npoints, int polyline)
 	}
     }
     else {
-	agerr(AGERR, "in routesplines, edge is a loop at %s\n", agnameof(aghead(realedge)));
+	if (!trial)
+	    agerr(AGERR, "in routesplines, edge is a loop at %s\n", agnameof(aghead(realedge)));
 	return NULL;
     }
 
@@ -546,7 +568,8 @@ static pointf *_routesplines(path * pp, int *npoints, int polyline)
     eps[0].x = pp->start.p.x, eps[0].y = pp->start.p.y;
     eps[1].x = pp->end.p.x, eps[1].y = pp->end.p.y;
     if (Pshortestpath(&poly, eps, &pl) < 0) {
-	agerr(AGERR, "in routesplines, Pshortestpath failed\n");
+	if (!trial)
+	    agerr(AGERR, "in routesplines, Pshortestpath failed\n");
 	return NULL;
     }
 #ifdef DEBUG
@@ -580,7 +603,8 @@ static pointf *_routesplines(path * pp, int *npoints, int polyline)
 	    evs[1].x = evs[1].y = 0;
 
 	if (Proutespline(edges, poly.pn, pl, evs, &spl) < 0) {
-	    agerr(AGERR, "in routesplines, Proutespline failed\n");
+	    if (!trial)
+		agerr(AGERR, "in routesplines, Proutespline failed\n");
 	    return NULL;
 	}
 #ifdef DEBUG
@@ -630,10 +654,11 @@ static pointf *_routesplines(path * pp, int *npoints, int polyline)
 	 * loop and we can see the bad edge, and even use the showboxes scaffolding.
 	 */
 	Ppolyline_t polyspl;
+	if (trial)
+	    return NULL;
 	agerr(AGWARN, "Unable to reclaim box space in spline routing for edge \"%s\" -> \"%s\". Something is probably seriously wrong.\n", agnameof(agtail(realedge)), agnameof(aghead(realedge)));
 	make_polyline (pl, &polyspl);
 	limitBoxes (boxes, boxn, polyspl.ps, polyspl.pn, INIT_DELTA);
-	free (polyspl.ps);
     }
 
     *npoints = spl.pn;
@@ -660,6 +685,22 @@ pointf *routepolylines(path * pp, int *npoints)
     return _routesplines (pp, npoints, 1);
 }
 
+/* tryroutesplines:
+ * Route pp as routesplines or, if polyline is true, routepolylines
+ * would, for a worker thread routing edges ahead of time. Where they
+ * would report a problem, it quietly returns NULL instead, leaving the
+ * edge to be routed again in turn.
+ */
+pointf *tryroutesplines(path * pp, int *npoints, int polyline)
+{
+    pointf *rv;
+
+    trial = TRUE;
+    rv = _routesplines (pp, npoints, polyline);
+    trial = FALSE;
+    return rv;
+}
+
 static int overlap(int i0, int i1, int j0, int j1)
 {
     /* i'll bet there's an elegant way to do this */
@@ -707,6 +748,8 @@ static int checkpath(int boxn, boxf* boxes, path* thepath)
 
     ba = &boxes[0];
     if (ba->LL.x > ba->UR.x || ba->LL.y > ba->UR.y) {
+	if (trial)
+	    return 1;
 	agerr(AGERR, "in checkpath, box 0 has LL coord > UR coord\n");
 	printpath(thepath);
 	return 1;
@@ -714,6 +757,8 @@ static int checkpath(int boxn, boxf* boxes, path* thepath)
     for (bi = 0; bi < boxn - 1; bi++) {
 	ba = &boxes[bi], bb = &boxes[bi + 1];
 	if (bb->LL.x > bb->UR.x || bb->LL.y > bb->UR.y) {
+	    if (trial)
+		return 1;
 	    agerr(AGERR, "in checkpath, box %d has LL coord > UR coord\n",
 		  bi + 1);
 	    printpath(thepath);
@@ -848,7 +893,8 @@ static int mkspacep(int size)
 	int newmax = maxpn + (size / PINC + 1) * PINC;
 	ps = RALLOC(newmax, ps, pointf);
 	if (!ps) {
-	    agerr(AGERR, "cannot re-allocate ps\n");
+	    if (!trial)
+		agerr(AGERR, "cannot re-allocate ps\n");
 	    return 1;
 	}
 	maxpn = newmax;
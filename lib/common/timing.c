@@ -17,6 +17,7 @@
 #include	<sys/types.h>
 #include	<sys/times.h>
 #include	<sys/param.h>
+#include	<sys/time.h>
 
 
 
@@ -38,9 +39,10 @@ typedef clock_t mytime_t;
 #define DIFF_IN_SECS(S,T) ((S - T) / (double)CLOCKS_PER_SEC)
 
 #endif
+#include "workers.h"
 
 
-static mytime_t T;
+static GVTLS mytime_t T;
 
 void start_timer(void)
 {
@@ -56,3 +58,20 @@ double elapsed_sec(void)
     rv = DIFF_IN_SECS(S, T);
     return rv;
 }
+
+/* wall_sec:
+ * Return the time in seconds by the clock on the wall, from some fixed
+ * point. Unlike elapsed_sec, it counts time spent by other threads and
+ * waiting, so it suits deadlines.
+ */
+double wall_sec(void)
+{
+#ifndef _WIN32
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+#else
+    return clock() / (double) CLOCKS_PER_SEC;
+#endif
+}
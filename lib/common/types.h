@@ -281,6 +281,8 @@ typedef enum {NATIVEFONTS,PSFONTS,SVGFONTS} fontname_kind;
 	void *alg;
 	GVC_t *gvc;	/* context for "globals" over multiple graphs */
 	void (*cleanup) (graph_t * g);   /* function to deallocate layout-specific data */
+	double deadline;	/* wall clock time set by maxtime, or 0 */
+	boolean timedout;	/* the layout should finish with what it has */
 
 #ifndef DOT_ONLY
 	/* to place nodes */
@@ -335,6 +337,8 @@ typedef enum {NATIVEFONTS,PSFONTS,SVGFONTS} fontname_kind;
 #define GD_drawing(g) (((Agraphinfo_t*)AGDATA(g))->drawing)
 #define GD_bb(g) (((Agraphinfo_t*)AGDATA(g))->bb)
 #define GD_gvc(g) (((Agraphinfo_t*)AGDATA(g))->gvc)
+#define GD_deadline(g) (((Agraphinfo_t*)AGDATA(g))->deadline)
+#define GD_timedout(g) (((Agraphinfo_t*)AGDATA(g))->timedout)
 #define GD_cleanup(g) (((Agraphinfo_t*)AGDATA(g))->cleanup)
 #define GD_dist(g) (((Agraphinfo_t*)AGDATA(g))->dist)
 #define GD_alg(g) (((Agraphinfo_t*)AGDATA(g))->alg)
@@ -441,6 +445,11 @@ typedef enum {NATIVEFONTS,PSFONTS,SVGFONTS} fontname_kind;
 	int low, lim;
 	int priority;
 
+	/* for incremental layout */
+	char prior;		/* PRIOR_* flags */
+	int prior_rank;
+	double prior_x;
+
 	double pad[1];
 #endif
 
@@ -485,6 +494,9 @@ typedef enum {NATIVEFONTS,PSFONTS,SVGFONTS} fontname_kind;
 #define ND_pinned(n) (((Agnodeinfo_t*)AGDATA(n))->pinned)
 #define ND_pos(n) (((Agnodeinfo_t*)AGDATA(n))->pos)
 #define ND_prev(n) (((Agnodeinfo_t*)AGDATA(n))->prev)
+#define ND_prior(n) (((Agnodeinfo_t*)AGDATA(n))->prior)
+#define ND_prior_rank(n) (((Agnodeinfo_t*)AGDATA(n))->prior_rank)
+#define ND_prior_x(n) (((Agnodeinfo_t*)AGDATA(n))->prior_x)
 #define ND_priority(n) (((Agnodeinfo_t*)AGDATA(n))->priority)
 #define ND_rank(n) (((Agnodeinfo_t*)AGDATA(n))->rank)
 #define ND_ranktype(n) (((Agnodeinfo_t*)AGDATA(n))->ranktype)
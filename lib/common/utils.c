@@ -65,35 +65,28 @@ node_t *dequeue(nodequeue * q)
     return n;
 }
 
+/* The late_* functions convert through the symbol's cache of converted
+ * values, so repeated values are only parsed once.
+ */
 int late_int(void *obj, attrsym_t * attr, int def, int low)
 {
-    char *p;
-    char *endp;
     int rv;
     if (attr == NULL)
 	return def;
-    p = ag_xget(obj, attr);
-    if (!p || p[0] == '\0')
-	return def;
-    rv = strtol (p, &endp, 10);
-    if (p == endp) return def;  /* invalid int format */
+    if (!agxgetint(obj, attr, &rv))
+	return def;  /* empty or invalid int format */
     if (rv < low) return low;
     else return rv;
 }
 
 double late_double(void *obj, attrsym_t * attr, double def, double low)
 {
-    char *p;
-    char *endp;
     double rv;
 
     if (!attr || !obj)
 	return def;
-    p = ag_xget(obj, attr);
-    if (!p || p[0] == '\0')
-	return def;
-    rv = strtod (p, &endp);
-    if (p == endp) return def;  /* invalid double format */
+    if (!agxgetdouble(obj, attr, &rv))
+	return def;  /* empty or invalid double format */
     if (rv < low) return low;
     else return rv;
 }
@@ -136,7 +129,7 @@ boolean late_bool(void *obj, attrsym_t * attr, int def)
     if (attr == NULL)
 	return def;
 
-    return mapbool(agxget(obj, attr));
+    return agxgetbool(obj, attr, FALSE);
 }
 
 /* union-find */
@@ -2031,7 +2024,7 @@ static void fillMap (Agraph_t* g, Dt_t* map)
  */
 Dt_t* mkClustMap (Agraph_t* g)
 {
-    Dt_t* map = dtopen (&strDisc, Dtoset);
+    Dt_t* map = dtopen (&strDisc, Dtoahash);
 
     fillMap (g, map);
     
@@ -2048,6 +2041,41 @@ findCluster (Dt_t* map, char* name)
 	return NULL;
 }
 
+/* gv_memreport:
+ * For -v, print the memory held by the root of g, by category,
+ * and the bytes requested from the engine allocators by this thread
+ * and its workers since the last report, by the part of the layout or
+ * rendering that asked for them.
+ */
+void gv_memreport(graph_t * g, char *phase)
+{
+    Agmemstat_t st;
+    gvmemstat_t req;
+    size_t bytes = 0, calls = 0;
+    int i;
+
+    agmemstat(agroot(g), &st);
+    gvmemcount(&req, TRUE);
+    fprintf(stderr, "%s %s: graph memory %lu bytes%s, peak %lu:", phase,
+	    agnameof(g), (unsigned long) st.total,
+	    st.exact ? "" : " allocated", (unsigned long) st.peak);
+    for (i = 0; i < AGMEM_NCAT; i++)
+	fprintf(stderr, " %s %lu", agmemcatname(i),
+		(unsigned long) st.bytes[i]);
+    for (i = 0; i < GVMEM_NCAT; i++) {
+	bytes += req.bytes[i];
+	calls += req.calls[i];
+    }
+    fprintf(stderr, "\n%s %s: %lu bytes in %lu engine allocations:",
+	    phase, agnameof(g), (unsigned long) bytes,
+	    (unsigned long) calls);
+    for (i = 0; i < GVMEM_NCAT; i++)
+	if (req.calls[i])
+	    fprintf(stderr, " %s %lu", gvmemcatname(i),
+		    (unsigned long) req.bytes[i]);
+    fputs("\n", stderr);
+}
+
 Agnodeinfo_t* ninf(Agnode_t* n) {return (Agnodeinfo_t*)AGDATA(n);}
 Agraphinfo_t* ginf(Agraph_t* g) {return (Agraphinfo_t*)AGDATA(g);}
 Agedgeinfo_t* einf(Agedge_t* e) {return (Agedgeinfo_t*)AGDATA(e);}
@@ -112,6 +112,9 @@ extern "C" {
     /* from timing.c */
     extern void start_timer(void);
     extern double elapsed_sec(void);
+    extern double wall_sec(void);
+
+    extern void gv_memreport(graph_t * g, char *phase);
 
     /* from psusershape.c */
     extern void cat_libfile(GVJ_t * job, const char **arglib, const char **stdlib);
@@ -0,0 +1,192 @@
+/* $Id$ $Revision$ */
+/* vim:set shiftwidth=4 ts=8: */
+
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: See CVS logs. Details at http://www.graphviz.org/
+ *************************************************************************/
+
+/* Worker threads for layouts
+ * A layout that splits into independent pieces, such as the connected
+ * components of a graph, can hand them to gvrunwork, which calls the
+ * given function on each piece from a small pool of threads. The
+ * pieces are taken in order, but may finish in any order, so each must
+ * only touch its own part of the graph. The few calls that change state
+ * shared by the whole graph, such as looking up attributes by name,
+ * are made between gvlock and gvunlock.
+ */
+
+#include "config.h"
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#include "render.h"
+
+#ifdef HAVE_PTHREAD
+static pthread_mutex_t Lock = PTHREAD_MUTEX_INITIALIZER;
+
+typedef struct {
+    pthread_mutex_t lock;
+    int next, n;		/* next piece to hand out, and how many */
+    gvwork_t fn;
+    void *state;
+    int memcat;			/* category to charge engine memory to */
+    gvmemstat_t mem;		/* engine memory requested by the workers */
+} workq_t;
+
+static void *worker(void *arg)
+{
+    workq_t *q = (workq_t *) arg;
+    int i;
+
+    for (;;) {
+	pthread_mutex_lock(&q->lock);
+	i = q->next++;
+	pthread_mutex_unlock(&q->lock);
+	if (i >= q->n)
+	    break;
+	q->fn(q->state, i);
+    }
+    return NULL;
+}
+
+/* start:
+ * Run a worker thread, adding the engine memory it requested to the
+ * queue's, for the caller of gvrunwork.
+ */
+static void *start(void *arg)
+{
+    workq_t *q = (workq_t *) arg;
+    gvmemstat_t mem;
+    int i;
+
+    gvmemphase(q->memcat);
+    worker(q);
+    gvmemcount(&mem, TRUE);
+    pthread_mutex_lock(&q->lock);
+    for (i = 0; i < GVMEM_NCAT; i++) {
+	q->mem.bytes[i] += mem.bytes[i];
+	q->mem.calls[i] += mem.calls[i];
+    }
+    pthread_mutex_unlock(&q->lock);
+    return NULL;
+}
+#endif
+
+/* gvworkers:
+ * Return the number of threads a layout of g may use: the value of
+ * the threads attribute, 1 if it is unset, or, if it is 0, the number
+ * of processors. Workers allocate from the graph, so only graphs using
+ * malloc, and not an arena, can have more than one.
+ */
+int gvworkers(graph_t * g)
+{
+    int n = late_int(g, agattr(g, AGRAPH, "threads", NULL), 1, 0);
+
+#ifdef HAVE_PTHREAD
+    if (agroot(g)->clos->disc.mem != &AgMemDisc)
+	return 1;
+    if (n == 0) {
+#ifdef _SC_NPROCESSORS_ONLN
+	n = (int) sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    }
+    return MAX(n, 1);
+#else
+    return 1;
+#endif
+}
+
+/* gvrunwork:
+ * Call fn(state, i) for i = 0..n-1, using up to nthreads threads,
+ * counting the caller's. Return when all calls have finished, with the
+ * engine memory the threads requested added to the caller's. Without
+ * threads, or if threads cannot be started, the calls are made in order
+ * by the caller.
+ */
+void gvrunwork(int n, int nthreads, gvwork_t fn, void *state)
+{
+    int i;
+#ifdef HAVE_PTHREAD
+    pthread_t *tid;
+    workq_t q;
+    int nt;
+
+    nthreads = MIN(nthreads, n);
+    if (nthreads > 1) {
+	q.next = 0;
+	q.n = n;
+	q.fn = fn;
+	q.state = state;
+	q.memcat = gvmemphase(-1);
+	memset(&q.mem, 0, sizeof(q.mem));
+	pthread_mutex_init(&q.lock, NULL);
+	tid = N_GNEW(nthreads - 1, pthread_t);
+	for (nt = 0; nt < nthreads - 1; nt++)
+	    if (pthread_create(&tid[nt], NULL, start, &q))
+		break;
+	worker(&q);
+	for (i = 0; i < nt; i++)
+	    pthread_join(tid[i], NULL);
+	gvmemadd(&q.mem);
+	free(tid);
+	pthread_mutex_destroy(&q.lock);
+	return;
+    }
+#endif
+    for (i = 0; i < n; i++)
+	fn(state, i);
+}
+
+/* gvlock:
+ * Keep other workers out until gvunlock.
+ */
+void gvlock(void)
+{
+#ifdef HAVE_PTHREAD
+    pthread_mutex_lock(&Lock);
+#endif
+}
+
+void gvunlock(void)
+{
+#ifdef HAVE_PTHREAD
+    pthread_mutex_unlock(&Lock);
+#endif
+}
+
+/* gvtimedout:
+ * Return TRUE if the layout of g should finish quickly with what it
+ * has, because the graph's maxtime has passed or the function set by
+ * gvSetLayoutCancel asks it to. Once TRUE, it stays so for the rest of
+ * the layout. The layout phases that refine a result call this between
+ * steps, from any of the layout's threads.
+ */
+boolean gvtimedout(graph_t * g)
+{
+    graph_t *root = agroot(g);
+    GVC_t *gvc;
+    boolean rv;
+
+    gvlock();
+    if (!GD_timedout(root)) {
+	gvc = GD_gvc(root);
+	if (GD_deadline(root) > 0 && wall_sec() > GD_deadline(root)) {
+	    agerr(AGWARN, "maxtime reached, finishing the layout early\n");
+	    GD_timedout(root) = TRUE;
+	} else if (gvc && gvc->cancel_fn && gvc->cancel_fn(gvc->cancel_data))
+	    GD_timedout(root) = TRUE;
+    }
+    rv = GD_timedout(root);
+    gvunlock();
+    return rv;
+}
@@ -0,0 +1,57 @@
+/* $Id$ $Revision$ */
+/* vim:set shiftwidth=4 ts=8: */
+
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: See CVS logs. Details at http://www.graphviz.org/
+ *************************************************************************/
+
+#ifndef GV_WORKERS_H
+#define GV_WORKERS_H
+
+#include "types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+	/* storage class for layout state that each thread keeps for itself */
+#ifndef GVTLS
+#if defined(_MSC_VER)
+#define GVTLS __declspec(thread)
+#elif defined(__GNUC__) || defined(__SUNPRO_C) || defined(__INTEL_COMPILER)
+#define GVTLS __thread
+#else
+#define GVTLS _Thread_local
+#endif
+#endif
+
+#ifdef GVDLL
+#define extern __declspec(dllexport)
+#else
+#ifdef _WIN32
+#ifndef GVC_EXPORTS
+#define extern __declspec(dllimport)
+#endif
+#endif
+#endif
+
+    typedef void (*gvwork_t) (void *state, int i);
+
+    extern int gvworkers(graph_t * g);
+    extern void gvrunwork(int n, int nthreads, gvwork_t fn, void *state);
+    extern void gvlock(void);
+    extern void gvunlock(void);
+    extern boolean gvtimedout(graph_t * g);
+#undef extern
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
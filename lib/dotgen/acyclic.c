@@ -61,6 +61,8 @@ void acyclic(graph_t * g)
 
     for (c = 0; c < GD_comp(g).size; c++) {
 	GD_nlist(g) = GD_comp(g).list[c];
+	if (GD_flags(dot_root(g)) & INCREMENTAL)
+	    prior_reverse(g);
 	for (n = GD_nlist(g); n; n = ND_next(n))
 	    ND_mark(n) = FALSE;
 	for (n = GD_nlist(g); n; n = ND_next(n))
@@ -0,0 +1,534 @@
+/* $Id$ $Revision$ */
+/* vim:set shiftwidth=4 ts=8: */
+
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: See CVS logs. Details at http://www.graphviz.org/
+ *************************************************************************/
+
+
+/*
+ * Brandes-Koepf x coordinates, used by dot_position when xmethod=bk.
+ * After U. Brandes and B. Koepf, "Fast and Simple Horizontal Coordinate
+ * Assignment", Graph Drawing 2001. Each node is aligned with a median
+ * neighbor in the rank above (or below), giving way to chains of virtual
+ * nodes, and the vertical blocks so formed are packed to the left (or
+ * right). The four layouts are then balanced node by node.
+ *
+ * Blocks are packed against the auxiliary graph of position.c, built
+ * without the edge pairs that only network simplex needs, so node
+ * separation, flat edge labels and cluster boxes are kept as before.
+ * If an alignment makes those constraints cyclic, nothing is changed
+ * and the caller falls back to network simplex.
+ */
+
+#include "dot.h"
+
+#define LEFTBOX  1		/* kind of GD_ln of a cluster */
+#define RIGHTBOX 2		/* kind of GD_rn of a cluster */
+
+typedef struct {
+    int id;			/* neighbor */
+    int pos;			/* its order in its rank */
+    int slot;			/* index of the edge's conflict mark */
+} nbr_t;
+
+typedef struct {
+    graph_t *g;
+    int nn;			/* nodes, ranked and slack; ids kept in ND_low */
+    int ne;			/* auxiliary edges */
+    node_t **node;
+    int *rnk;			/* rank of node, or -1 for slack nodes */
+    char *kind;
+    nbr_t *up, *down;		/* neighbors in the rank above and below */
+    int *upoff, *downoff;
+    char *conflict;		/* type 1 conflicts, by slot */
+    int *root;			/* block of node */
+	/* constraints between blocks, forward and back, and an order */
+    int *outoff, *outh, *outlen;
+    int *inoff, *inth, *inlen;
+    int *topo, ntopo;
+} bk_t;
+
+static int bypos(const void *a, const void *b)
+{
+    return ((nbr_t *) a)->pos - ((nbr_t *) b)->pos;
+}
+
+/* alignable:
+ * Flat edge labels are constrained to lie between the edge's
+ * endpoints, so they are left out of blocks.
+ */
+static int alignable(node_t * u, node_t * v)
+{
+    return ND_alg(u) == NULL && ND_alg(v) == NULL
+	&& ND_clust(u) == ND_clust(v);
+}
+
+static int inner(node_t * u, node_t * v)
+{
+    return ND_node_type(u) == VIRTUAL && ND_node_type(v) == VIRTUAL
+	&& ND_alg(u) == NULL && ND_alg(v) == NULL;
+}
+
+/* markboxes:
+ * Note the cluster boundary nodes below g.
+ */
+static void markboxes(bk_t * bk, graph_t * g)
+{
+    int c;
+
+    if (GD_ln(g)) {
+	bk->kind[ND_low(GD_ln(g))] = LEFTBOX;
+	bk->kind[ND_low(GD_rn(g))] = RIGHTBOX;
+    }
+    for (c = 1; c <= GD_n_cluster(g); c++)
+	markboxes(bk, GD_clust(g)[c]);
+}
+
+/* bk_init:
+ * Number the nodes, and list each ranked node's neighbors on the
+ * adjacent ranks in order.
+ */
+static void bk_init(bk_t * bk, graph_t * g)
+{
+    rank_t *rank = GD_rank(g);
+    node_t *n, *v;
+    edge_t *e;
+    int i, j, r, nup;
+
+    bk->g = g;
+    bk->nn = bk->ne = 0;
+    for (n = GD_nlist(g); n; n = ND_next(n)) {
+	ND_low(n) = bk->nn++;
+	bk->ne += ND_out(n).size;
+    }
+    bk->node = N_NEW(bk->nn, node_t *);
+    bk->rnk = N_NEW(bk->nn, int);
+    bk->kind = N_NEW(bk->nn, char);
+    for (n = GD_nlist(g); n; n = ND_next(n)) {
+	bk->node[ND_low(n)] = n;
+	bk->rnk[ND_low(n)] = -1;
+    }
+    for (r = GD_minrank(g); r <= GD_maxrank(g); r++)
+	for (j = 0; j < rank[r].n; j++)
+	    bk->rnk[ND_low(rank[r].v[j])] = r;
+    markboxes(bk, g);
+
+    bk->upoff = N_NEW(bk->nn + 1, int);
+    bk->downoff = N_NEW(bk->nn + 1, int);
+    nup = 0;
+    for (i = 0; i < bk->nn; i++) {
+	n = bk->node[i];
+	bk->upoff[i] = nup;
+	if (bk->rnk[i] < 0 || !ND_save_in(n).list)
+	    continue;
+	for (j = 0; (e = ND_save_in(n).list[j]); j++)
+	    if (bk->rnk[ND_low(agtail(e))] == bk->rnk[i] - 1) {
+		nup++;
+		bk->downoff[ND_low(agtail(e))]++;
+	    }
+    }
+    bk->upoff[bk->nn] = nup;
+    for (i = 0, r = 0; i <= bk->nn; i++) {
+	j = bk->downoff[i];
+	bk->downoff[i] = r;
+	r += j;
+    }
+    bk->up = N_NEW(nup + 1, nbr_t);
+    bk->down = N_NEW(nup + 1, nbr_t);
+    bk->conflict = N_NEW(nup + 1, char);
+    nup = 0;
+    for (i = 0; i < bk->nn; i++) {
+	n = bk->node[i];
+	if (bk->rnk[i] < 0 || !ND_save_in(n).list)
+	    continue;
+	for (j = 0; (e = ND_save_in(n).list[j]); j++) {
+	    v = agtail(e);
+	    if (bk->rnk[ND_low(v)] != bk->rnk[i] - 1)
+		continue;
+	    bk->up[nup].id = ND_low(v);
+	    bk->up[nup].pos = ND_order(v);
+	    bk->up[nup].slot = nup;
+	    r = bk->downoff[ND_low(v)]++;
+	    bk->down[r].id = i;
+	    bk->down[r].pos = ND_order(n);
+	    bk->down[r].slot = nup;
+	    nup++;
+	}
+    }
+    for (i = bk->nn; i > 0; i--)
+	bk->downoff[i] = bk->downoff[i - 1];
+    bk->downoff[0] = 0;
+    for (i = 0; i < bk->nn; i++) {
+	qsort(bk->up + bk->upoff[i], bk->upoff[i + 1] - bk->upoff[i],
+	      sizeof(nbr_t), bypos);
+	qsort(bk->down + bk->downoff[i],
+	      bk->downoff[i + 1] - bk->downoff[i], sizeof(nbr_t), bypos);
+    }
+
+    bk->root = N_NEW(bk->nn, int);
+    bk->outoff = N_NEW(bk->nn + 1, int);
+    bk->inoff = N_NEW(bk->nn + 1, int);
+    bk->outh = N_NEW(bk->ne + 1, int);
+    bk->outlen = N_NEW(bk->ne + 1, int);
+    bk->inth = N_NEW(bk->ne + 1, int);
+    bk->inlen = N_NEW(bk->ne + 1, int);
+    bk->topo = N_NEW(bk->nn, int);
+}
+
+static void bk_free(bk_t * bk)
+{
+    free(bk->node);
+    free(bk->rnk);
+    free(bk->kind);
+    free(bk->upoff);
+    free(bk->downoff);
+    free(bk->up);
+    free(bk->down);
+    free(bk->conflict);
+    free(bk->root);
+    free(bk->outoff);
+    free(bk->inoff);
+    free(bk->outh);
+    free(bk->outlen);
+    free(bk->inth);
+    free(bk->inlen);
+    free(bk->topo);
+}
+
+/* mark_conflicts:
+ * Mark the edges between adjacent ranks that cross an inner segment,
+ * an edge between two virtual nodes, so that alignment prefers the
+ * inner segments and long edges stay straight.
+ */
+static void mark_conflicts(bk_t * bk)
+{
+    graph_t *g = bk->g;
+    rank_t *rank = GD_rank(g);
+    int r, k0, k1, l, l1, w, i, n;
+    node_t *v;
+    nbr_t *nb;
+
+    for (r = GD_minrank(g); r < GD_maxrank(g); r++) {
+	k0 = 0;
+	l = 0;
+	n = rank[r + 1].n;
+	for (l1 = 0; l1 < n; l1++) {
+	    v = rank[r + 1].v[l1];
+	    w = -1;
+	    for (i = bk->upoff[ND_low(v)]; i < bk->upoff[ND_low(v) + 1]; i++)
+		if (inner(bk->node[bk->up[i].id], v)) {
+		    w = bk->up[i].pos;
+		    break;
+		}
+	    if (l1 < n - 1 && w < 0)
+		continue;
+	    k1 = (w < 0) ? rank[r].n - 1 : w;
+	    for (; l <= l1; l++) {
+		v = rank[r + 1].v[l];
+		for (i = bk->upoff[ND_low(v)]; i < bk->upoff[ND_low(v) + 1];
+		     i++) {
+		    nb = bk->up + i;
+		    if ((nb->pos < k0 || nb->pos > k1)
+			&& !inner(bk->node[nb->id], v))
+			bk->conflict[nb->slot] = 1;
+		}
+	    }
+	    k0 = k1;
+	}
+    }
+}
+
+/* align:
+ * Form blocks by aligning each node with a median neighbor above
+ * (down == 0) or below, sweeping each rank left to right (right == 0)
+ * or right to left.
+ */
+static void align(bk_t * bk, int down, int right)
+{
+    graph_t *g = bk->g;
+    rank_t *rank = GD_rank(g);
+    int i, k, kk, m, rr, r, d, v, lim;
+    nbr_t *nb, *u;
+
+    for (i = 0; i < bk->nn; i++)
+	bk->root[i] = i;
+    for (rr = GD_minrank(g); rr <= GD_maxrank(g); rr++) {
+	r = down ? GD_maxrank(g) + GD_minrank(g) - rr : rr;
+	lim = right ? INT_MAX : -1;
+	for (kk = 0; kk < rank[r].n; kk++) {
+	    k = right ? rank[r].n - 1 - kk : kk;
+	    v = ND_low(rank[r].v[k]);
+	    if (down) {
+		nb = bk->down + bk->downoff[v];
+		d = bk->downoff[v + 1] - bk->downoff[v];
+	    } else {
+		nb = bk->up + bk->upoff[v];
+		d = bk->upoff[v + 1] - bk->upoff[v];
+	    }
+	    for (m = 0; m < 2 && d > 0; m++) {
+		/* the lower median first when sweeping left to right */
+		u = nb + ((m == right) ? (d - 1) / 2 : d / 2);
+		if (bk->root[v] != v)
+		    break;
+		if (bk->conflict[u->slot]
+		    || !alignable(bk->node[u->id], bk->node[v]))
+		    continue;
+		if (right ? (u->pos < lim) : (u->pos > lim)) {
+		    bk->root[v] = bk->root[u->id];
+		    lim = u->pos;
+		}
+	    }
+	}
+    }
+}
+
+/* block_graph:
+ * Collect the constraints between blocks, and order the blocks so
+ * that every constraint goes forward. Return 1 if there is no such
+ * order, or a constraint inside a block.
+ */
+static int block_graph(bk_t * bk)
+{
+    int *root = bk->root;
+    int i, j, t, h, n, qh;
+    node_t *u;
+    edge_t *e;
+
+    memset(bk->outoff, 0, (bk->nn + 1) * sizeof(int));
+    memset(bk->inoff, 0, (bk->nn + 1) * sizeof(int));
+    for (i = 0; i < bk->nn; i++) {
+	u = bk->node[i];
+	for (j = 0; (e = ND_out(u).list[j]); j++) {
+	    t = root[i];
+	    h = root[ND_low(aghead(e))];
+	    if (t == h) {
+		if (ED_minlen(e) > 0)
+		    return 1;
+		continue;
+	    }
+	    bk->outoff[t + 1]++;
+	    bk->inoff[h + 1]++;
+	}
+    }
+    for (i = 0; i < bk->nn; i++) {
+	bk->outoff[i + 1] += bk->outoff[i];
+	bk->inoff[i + 1] += bk->inoff[i];
+    }
+    for (i = 0; i < bk->nn; i++) {
+	u = bk->node[i];
+	for (j = 0; (e = ND_out(u).list[j]); j++) {
+	    t = root[i];
+	    h = root[ND_low(aghead(e))];
+	    if (t == h)
+		continue;
+	    n = bk->outoff[t]++;
+	    bk->outh[n] = h;
+	    bk->outlen[n] = ED_minlen(e);
+	    n = bk->inoff[h]++;
+	    bk->inth[n] = t;
+	    bk->inlen[n] = ED_minlen(e);
+	}
+    }
+    for (i = bk->nn; i > 0; i--) {
+	bk->outoff[i] = bk->outoff[i - 1];
+	bk->inoff[i] = bk->inoff[i - 1];
+    }
+    bk->outoff[0] = bk->inoff[0] = 0;
+
+    /* in-degrees are counted down in bk->topo until it holds the order */
+    n = 0;
+    for (i = 0; i < bk->nn; i++)
+	if (root[i] == i)
+	    n++;
+    {
+	int *deg = N_NEW(bk->nn, int);
+
+	bk->ntopo = qh = 0;
+	for (i = 0; i < bk->nn; i++) {
+	    deg[i] = bk->inoff[i + 1] - bk->inoff[i];
+	    if (root[i] == i && deg[i] == 0)
+		bk->topo[bk->ntopo++] = i;
+	}
+	while (qh < bk->ntopo) {
+	    t = bk->topo[qh++];
+	    for (j = bk->outoff[t]; j < bk->outoff[t + 1]; j++)
+		if (--deg[bk->outh[j]] == 0)
+		    bk->topo[bk->ntopo++] = bk->outh[j];
+	}
+	free(deg);
+    }
+    return bk->ntopo != n;
+}
+
+/* pack:
+ * Place each block as far left (or right) as the constraints allow.
+ */
+static void pack(bk_t * bk, int *x, int right)
+{
+    int i, j, b, v;
+
+    if (!right) {
+	for (i = 0; i < bk->ntopo; i++) {
+	    b = bk->topo[i];
+	    x[b] = 0;
+	    for (j = bk->inoff[b]; j < bk->inoff[b + 1]; j++)
+		x[b] = MAX(x[b], x[bk->inth[j]] + bk->inlen[j]);
+	}
+    } else {
+	for (i = bk->ntopo - 1; i >= 0; i--) {
+	    b = bk->topo[i];
+	    x[b] = 0;
+	    for (j = bk->outoff[b]; j < bk->outoff[b + 1]; j++) {
+		v = x[bk->outh[j]] - bk->outlen[j];
+		x[b] = MIN(x[b], v);
+	    }
+	}
+    }
+}
+
+/* tighten:
+ * Packing leaves the box of a cluster as wide as its neighbors allow
+ * on one side. Move each left side right, and then each right side
+ * left, as far as its constraints allow.
+ */
+static void tighten(bk_t * bk, int *x)
+{
+    int i, j, b, v;
+
+    for (i = bk->ntopo - 1; i >= 0; i--) {
+	b = bk->topo[i];
+	if (bk->kind[b] != LEFTBOX || bk->outoff[b] == bk->outoff[b + 1])
+	    continue;
+	x[b] = INT_MAX;
+	for (j = bk->outoff[b]; j < bk->outoff[b + 1]; j++) {
+	    v = x[bk->outh[j]] - bk->outlen[j];
+	    x[b] = MIN(x[b], v);
+	}
+    }
+    for (i = 0; i < bk->ntopo; i++) {
+	b = bk->topo[i];
+	if (bk->kind[b] != RIGHTBOX || bk->inoff[b] == bk->inoff[b + 1])
+	    continue;
+	x[b] = -INT_MAX;
+	for (j = bk->inoff[b]; j < bk->inoff[b + 1]; j++)
+	    x[b] = MAX(x[b], x[bk->inth[j]] + bk->inlen[j]);
+    }
+}
+
+/* extent:
+ * Find the left and right ends of the ranks in layout x.
+ */
+static void extent(bk_t * bk, int *x, int *lo, int *hi)
+{
+    int i;
+    node_t *n;
+
+    *lo = INT_MAX;
+    *hi = -INT_MAX;
+    for (i = 0; i < bk->nn; i++) {
+	if (bk->rnk[i] < 0)
+	    continue;
+	n = bk->node[i];
+	*lo = MIN(*lo, x[i] - ND_lw(n));
+	*hi = MAX(*hi, x[i] + ND_rw(n));
+    }
+}
+
+static int floorhalf(int v)
+{
+    return (v - (v & 1)) / 2;
+}
+
+/* bk_xcoords:
+ * Set ND_rank of the nodes of the auxiliary graph of g to their x
+ * coordinates. Return 0 on success, or 1, leaving the nodes as they
+ * were, if the constraints cannot be met by any set of blocks.
+ */
+int bk_xcoords(graph_t * g)
+{
+    bk_t bk;
+    int *xs[4], *x;
+    int d, i, k, best, w, t, fail, lo[4], hi[4], y[4];
+
+    if (Verbose)
+	start_timer();
+    bk_init(&bk, g);
+    mark_conflicts(&bk);
+    for (d = 0; d < 4; d++)
+	xs[d] = N_NEW(bk.nn, int);
+    x = N_NEW(bk.nn, int);
+
+    best = 0;
+    for (d = 0; d < 4; d++) {
+	align(&bk, d >> 1, d & 1);
+	if (block_graph(&bk))
+	    break;
+	pack(&bk, x, d & 1);
+	tighten(&bk, x);
+	for (i = 0; i < bk.nn; i++)
+	    xs[d][i] = x[bk.root[i]];
+	extent(&bk, xs[d], &lo[d], &hi[d]);
+	if (hi[d] - lo[d] < hi[best] - lo[best])
+	    best = d;
+    }
+
+    fail = (d < 4);
+    if (!fail) {
+	/* balance: align the layouts with the narrowest, take the
+	 * average of the two middle values at each node */
+	for (d = 0; d < 4; d++) {
+	    w = (d & 1) ? hi[best] - hi[d] : lo[best] - lo[d];
+	    for (i = 0; i < bk.nn; i++)
+		xs[d][i] += w;
+	}
+	for (i = 0; i < bk.nn; i++) {
+	    for (d = 0; d < 4; d++) {
+		y[d] = xs[d][i];
+		for (k = d; k > 0 && y[k - 1] > y[k]; k--) {
+		    t = y[k];
+		    y[k] = y[k - 1];
+		    y[k - 1] = t;
+		}
+	    }
+	    x[i] = floorhalf(y[1] + y[2]);
+	}
+
+	/* the balanced layout may break a constraint; push nodes right
+	 * until it does not, then tighten the cluster boxes again */
+	for (i = 0; i < bk.nn; i++)
+	    bk.root[i] = i;
+	fail = block_graph(&bk);
+	if (!fail) {
+	    for (i = 0; i < bk.ntopo; i++) {
+		t = bk.topo[i];
+		for (k = bk.outoff[t]; k < bk.outoff[t + 1]; k++)
+		    x[bk.outh[k]] =
+			MAX(x[bk.outh[k]], x[t] + bk.outlen[k]);
+	    }
+	    tighten(&bk, x);
+	    for (i = 0; i < bk.nn; i++)
+		ND_rank(bk.node[i]) = x[i];
+	}
+    }
+    if (Verbose) {
+	if (fail)
+	    fprintf(stderr, "Brandes-Koepf: %d nodes %d edges: constraints conflict with blocks\n",
+		    bk.nn, bk.ne);
+	else
+	    fprintf(stderr, "Brandes-Koepf: %d nodes %d edges %.2f sec\n",
+		    bk.nn, bk.ne, elapsed_sec());
+    }
+
+    for (i = 0; i < 4; i++)
+	free(xs[i]);
+    free(x);
+    bk_free(&bk);
+    return fail;
+}
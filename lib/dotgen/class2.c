@@ -174,6 +174,7 @@ void class2(graph_t * g)
     int c;
     node_t *n, *t, *h;
     edge_t *e, *prev, *opp;
+    int memcat = gvmemphase(GVMEM_VNODES);
 
     GD_nlist(g) = NULL;
 
@@ -303,5 +304,6 @@ void class2(graph_t * g)
 	GD_comp(g).list = ALLOC(1, GD_comp(g).list, node_t *);
 	GD_comp(g).list[0] = GD_nlist(g);
     }
+    gvmemphase(memcat);
 }
 
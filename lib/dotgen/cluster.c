@@ -314,10 +314,12 @@ void mark_clusters(graph_t * g)
 	for (n = agfstnode(clust); n; n = nn) {
 		nn = agnxtnode(clust,n);
 	    if (ND_ranktype(n) != NORMAL) {
+		gvlock();
 		agerr(AGWARN,
 		      "%s was already in a rankset, deleted from cluster %s\n",
 		      agnameof(n), agnameof(g));
 		agdelete(clust,n);
+		gvunlock();
 		continue;
 	    }
 	    UF_setname(n, GD_leader(clust));
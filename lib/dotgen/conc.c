@@ -22,7 +22,7 @@
 #define		UP		0
 #define		DOWN	1
 
-static jmp_buf jbuf;
+static GVTLS jmp_buf jbuf;
 
 static boolean samedir(edge_t * e, edge_t * f)
 {
@@ -22,8 +22,8 @@
 
 #include "dot.h"
 
-static node_t *Last_node;
-static char Cmark;
+static GVTLS node_t *Last_node;
+static GVTLS char Cmark;
 
 static void 
 begin_component(graph_t* g)
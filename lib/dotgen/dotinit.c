@@ -295,19 +295,47 @@ attach_phase_attrs (Agraph_t * g, int maxphase)
     }
 }
 
-static void dotLayout(Agraph_t * g)
+/* dotInit:
+ * Set up g for layout, returning the aspect data to use, if any.
+ */
+static aspect_t* dotInit(Agraph_t * g, aspect_t* aspect)
 {
-    aspect_t aspect;
     aspect_t* asp;
-    int maxphase = late_int(g, agfindgraphattr(g,"phase"), -1, 1);
 
     setEdgeType (g, ET_SPLINE);
-    asp = setAspect (g, &aspect);
+    asp = setAspect (g, aspect);
 
     dot_init_subg(g,g);
     dot_init_node_edge(g);
+    dot_prior(g);
+    return asp;
+}
+
+/* dotFinish:
+ * Route the edges of g, once its nodes are placed.
+ */
+static void dotFinish(Agraph_t * g)
+{
+    gvmemphase(GVMEM_SPLINES);
+    if (GD_flags(g) & NEW_RANK)
+	removeFill (g);
+    dot_sameports(g);
+    dot_splines(g);
+    if (mapbool(agget(g, "compound")))
+	dot_compoundEdges(g);
+    gvmemphase(GVMEM_LAYOUT);
+}
+
+static void dotLayout(Agraph_t * g)
+{
+    aspect_t aspect;
+    aspect_t* asp;
+    int maxphase = late_int(g, agfindgraphattr(g,"phase"), -1, 1);
+
+    asp = dotInit (g, &aspect);
 
     do {
+	gvmemphase(GVMEM_RANKS);
         dot_rank(g, asp);
 	if (maxphase == 1) {
 	    attach_phase_attrs (g, 1);
@@ -323,6 +351,7 @@ static void dotLayout(Agraph_t * g)
 	    attach_phase_attrs (g, 2);
 	    return;
 	}
+	gvmemphase(GVMEM_LAYOUT);
         dot_position(g, asp);
 	if (maxphase == 3) {
 	    attach_phase_attrs (g, 2);  /* positions will be attached on output */
@@ -330,12 +359,7 @@ static void dotLayout(Agraph_t * g)
 	}
 	aspect.nPasses--;
     } while (aspect.nextIter && aspect.nPasses);
-    if (GD_flags(g) & NEW_RANK)
-	removeFill (g);
-    dot_sameports(g);
-    dot_splines(g);
-    if (mapbool(agget(g, "compound")))
-	dot_compoundEdges(g);
+    dotFinish (g);
 }
 
 static void
@@ -353,6 +377,57 @@ initSubg (Agraph_t* sg, Agraph_t* g)
     GD_fontnames(sg) = GD_fontnames(g);
 }
 
+/* Dotroot is the component a worker thread is laying out, which
+ * dot_root returns in place of the one recorded in the root graph.
+ */
+static GVTLS Agraph_t* Dotroot;
+
+static void dotPlace(void* state, int i)
+{
+    Agraph_t* sg = ((Agraph_t**)state)[i];
+
+    Dotroot = sg;
+    gvmemphase(GVMEM_RANKS);
+    dot_mincross(sg, 0);
+    gvmemphase(GVMEM_LAYOUT);
+    dot_position(sg, NULL);
+    Dotroot = NULL;
+}
+
+/* dotLayoutComps:
+ * Lay out the components of g using up to nthreads threads.
+ * Each component is ranked in turn, then the components are ordered and
+ * positioned by the workers, and their edges are routed in turn again,
+ * as spline routing changes attributes shared by the whole graph. The
+ * components do not depend on one another, so the result does not depend
+ * on the number of threads.
+ */
+static void dotLayoutComps(Agraph_t * g, int ncc, Agraph_t** ccs, int nthreads)
+{
+    aspect_t aspect;
+    Agraph_t* sg;
+    int i;
+
+    for (i = 0; i < ncc; i++) {
+	sg = ccs[i];
+	initSubg (sg, g);
+	gvmemphase(GVMEM_LAYOUT);
+	dotInit (sg, &aspect);
+	gvmemphase(GVMEM_RANKS);
+	dot_rank (sg, NULL);
+	/* new ranking adds fill nodes to the graph while ordering */
+	if (GD_flags(sg) & NEW_RANK)
+	    nthreads = 1;
+    }
+    gvrunwork(ncc, nthreads, dotPlace, ccs);
+    gvmemphase(GVMEM_LAYOUT);
+    for (i = 0; i < ncc; i++) {
+	sg = ccs[i];
+	GD_dotroot(agroot(sg)) = sg;
+	dotFinish (sg);
+    }
+}
+
 /* attachPos:
  * the packing library assumes all units are in inches stored in ND_pos, so we
  * have to copy the position info there.
@@ -442,6 +517,17 @@ copyClusterInfo (int ncc, Agraph_t** ccs, Agraph_t* root)
     } 
 }
 
+/* hasAspect:
+ * Return true if g sets aspect, as read by setAspect.
+ */
+static int hasAspect(Agraph_t * g)
+{
+    char *p = agget(g, "aspect");
+    double rv;
+
+    return p && (sscanf(p, "%lf", &rv) > 0);
+}
+
 /* doDot:
  * Assume g has nodes.
  */
@@ -450,7 +536,7 @@ static void doDot (Agraph_t* g)
     Agraph_t **ccs;
     Agraph_t *sg;
     int ncc;
-    int i;
+    int i, nthreads;
     pack_info pinfo;
     int Pack = getPack(g, -1, CL_OFFSET);
     pack_mode mode = getPackModeInfo (g, l_undef, &pinfo);
@@ -477,10 +563,19 @@ static void doDot (Agraph_t* g)
 	} else if (GD_drawing(g)->ratio_kind == R_NONE) {
 	    pinfo.doSplines = 1;
 
-	    for (i = 0; i < ncc; i++) {
-		sg = ccs[i];
-		initSubg (sg, g);
-		dotLayout (sg);
+	    /* stopping after an early phase, and the repeated passes
+	     * of aspect, are left to dotLayout
+	     */
+	    nthreads = gvworkers(g);
+	    if ((nthreads > 1) && (late_int(g, agfindgraphattr(g,"phase"), -1, 1) < 0)
+		&& !hasAspect(g))
+		dotLayoutComps (g, ncc, ccs, nthreads);
+	    else {
+		for (i = 0; i < ncc; i++) {
+		    sg = ccs[i];
+		    initSubg (sg, g);
+		    dotLayout (sg);
+		}
 	    }
 	    attachPos (g);
 	    packSubgraphs(ncc, ccs, g, &pinfo);
@@ -504,14 +599,57 @@ static void doDot (Agraph_t* g)
     }
 }
 
+static int countSubgs(Agraph_t * g)
+{
+    Agraph_t *subg;
+    int cnt = 0;
+
+    for (subg = agfstsubg(g); subg; subg = agnxtsubg(subg))
+	cnt += 1 + countSubgs(subg);
+    return cnt;
+}
+
+/* useSubgBits:
+ * The cluster code asks agcontains about most nodes and edges of
+ * each cluster, so have subgraphs keep their nodes as bitsets, unless
+ * there are so many subgraphs that the bitsets would outweigh the graph.
+ */
+static int useSubgBits(Agraph_t * g)
+{
+    int nsubg = countSubgs(g);
+    double words = (double)nsubg * (agnnodes(g) / 64 + 1);
+
+    return (nsubg > 0) && (words <= 8.0 * (agnnodes(g) + agnedges(g)));
+}
+
 void dot_layout(Agraph_t * g)
 {
+    int bits = -1;
+
+    if (useSubgBits(g))
+	bits = agsubgbits(g, TRUE);
     if (agnnodes(g)) doDot (g);
     dotneato_postprocess(g);
+    if (bits == FALSE)
+	agsubgbits(g, FALSE);
 }
 
 Agraph_t * dot_root (void* p)
 {
+    if (Dotroot)
+	return Dotroot;
     return GD_dotroot(agroot(p));
 }
 
+/* dot_setroot:
+ * Make g the graph dot_root returns on this thread, or undo that if g
+ * is NULL, and return the graph it replaces.
+ */
+Agraph_t * dot_setroot (Agraph_t* g)
+{
+    Agraph_t* prev = Dotroot;
+
+    Dotroot = g;
+    return prev;
+}
+
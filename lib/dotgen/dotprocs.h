@@ -22,6 +22,7 @@ extern "C" {
 
     extern void acyclic(Agraph_t *);
     extern void allocate_ranks(Agraph_t *);
+    extern int bk_xcoords(Agraph_t *);
     extern void build_ranks(Agraph_t *, int);
     extern void build_skeleton(Agraph_t *, Agraph_t *);
     extern void checkLabelOrder (graph_t* g);
@@ -34,6 +35,8 @@ extern "C" {
     extern void dot_cleanup(graph_t * g);
     extern void dot_layout(Agraph_t * g);
     extern void dot_init_node_edge(graph_t * g);
+    extern int dot_prior(graph_t * g);
+    extern char *dirty_ranks(graph_t * g);
     extern void dot_scan_ranks(graph_t * g);
     extern void enqueue_neighbors(nodequeue * q, node_t * n0, int pass);
     extern void expand_cluster(Agraph_t *);
@@ -60,6 +63,9 @@ extern "C" {
     extern void other_edge(Agedge_t *);
     extern void rank1(graph_t * g);
     extern int portcmp(port p0, port p1);
+    extern void prior_order(graph_t * g);
+    extern void prior_rank(graph_t * g, int balance, int maxiter);
+    extern void prior_reverse(graph_t * g);
     extern int ports_eq(edge_t *, edge_t *);
     extern void rec_reset_vlists(Agraph_t *);
     extern void rec_save_vlists(Agraph_t *);
@@ -71,6 +77,7 @@ extern "C" {
     extern Agnode_t *virtual_node(Agraph_t *);
     extern void virtual_weight(Agedge_t *);
     extern void zapinlist(elist *, Agedge_t *);
+    extern Agraph_t* dot_setroot(Agraph_t *);
 
 #if defined(_BLD_dot) && defined(_DLL)
 #   define extern __EXPORT__
@@ -51,10 +51,35 @@
 	ED_to_orig(newp) = old; \
 }
 
-static boxf boxes[1000];
+static GVTLS boxf boxes[1000];
+
+/* A route worked out ahead of time: the path routesplines was given,
+ * what it left of the path, and the points of the route, or pn < 0 if
+ * it gave up.
+ */
+typedef struct {
+    port start, end;
+    int nbox, polyline;
+    boxf *boxes;		/* nbox boxes as given, then nbox as left */
+    pointf sp, ep;		/* start and end points as left */
+    pointf *ps;
+    int pn;
+} route_t;
+
+/* the routes worked out ahead for the group of edges edges[ind..ind+cnt-1],
+ * in the order they were made, and the next one to use
+ */
+typedef struct {
+    int ind, cnt;
+    int n, next;
+    route_t *routes;
+} ahead_t;
+
 typedef struct {
     int LeftBound, RightBound, Splinesep, Multisep;
     boxf* Rank_box;
+    ahead_t* Ahead;	/* routes for the group being routed, or NULL */
+    boolean Trial;	/* if true, make them, leaving the graph alone */
 } spline_info_t;
 
 static void adjustregularpath(path *, int, int);
@@ -243,6 +268,238 @@ setEdgeLabelPos (graph_t * g)
     }
 }
 
+/* edge_group:
+ * Return the number of edges, starting with edges[i], that are routed
+ * together as one group. The edges are sorted by edgecmp.
+ */
+static int edge_group(edge_t ** edges, int i, int n_edges)
+{
+    Agedgeinfo_t fwdedgeai, fwdedgebi;
+    Agedgepair_t fwdedgea, fwdedgeb;
+    edge_t *e0, *e1, *ea, *eb, *le0, *le1;
+    int cnt;
+
+    fwdedgea.out.base.data = (Agrec_t*)&fwdedgeai;
+    fwdedgeb.out.base.data = (Agrec_t*)&fwdedgebi;
+    le0 = getmainedge((e0 = edges[i++]));
+    if (ED_tail_port(e0).defined || ED_head_port(e0).defined) {
+	ea = e0;
+    } else {
+	ea =  le0;
+    }
+    if (ED_tree_index(ea) & BWDEDGE) {
+	MAKEFWDEDGE(&fwdedgea.out, ea);
+	ea = &fwdedgea.out;
+    }
+    for (cnt = 1; i < n_edges; cnt++, i++) {
+	if (le0 != (le1 = getmainedge((e1 = edges[i]))))
+	    break;
+	if (ED_adjacent(e0)) continue; /* all flat adjacent edges at once */
+	if (ED_tail_port(e1).defined || ED_head_port(e1).defined) {
+		eb = e1;
+	} else {
+		eb = le1;
+	}
+	if (ED_tree_index(eb) & BWDEDGE) {
+	    MAKEFWDEDGE(&fwdedgeb.out, eb);
+	    eb = &fwdedgeb.out;
+	}
+	if (portcmp(ED_tail_port(ea), ED_tail_port(eb)))
+	    break;
+	if (portcmp(ED_head_port(ea), ED_head_port(eb)))
+	    break;
+	if ((ED_tree_index(e0) & EDGETYPEMASK) == FLATEDGE
+	    && ED_label(e0) != ED_label(e1))
+	    break;
+	if (ED_tree_index(edges[i]) & MAINGRAPH)	/* Aha! -C is on */
+	    break;
+    }
+    return cnt;
+}
+
+/* Routing regular edges ahead of time.
+ * Once the nodes are placed, most of the work of routing an edge is in
+ * finding a spline through its corridor of boxes, which does not depend
+ * on the other edges. But routing an edge gives the slack in its boxes
+ * back to its virtual nodes, narrowing the corridors of the edges routed
+ * after it, so the edges are still routed in turn. Before that, worker
+ * threads route the groups of regular edges ahead of time, in corridors
+ * taken from the nodes as they are before any edge is routed, keeping
+ * each path and what routesplines made of it. When an edge's turn comes,
+ * a path that is exactly the one routed ahead, as it is unless an edge
+ * routed before it took the slack beside it, uses the route kept for it
+ * in place of calling routesplines again. So the splines are the same
+ * however many threads are used.
+ */
+
+typedef struct {
+    graph_t *g;
+    spline_info_t *sp;
+    edge_t **edges;
+    ahead_t *ahead;
+    int nahead, nchunk;
+    int nboxes;			/* size of a path's boxes */
+    int et;
+} route_work_t;
+
+/* fixed_ports:
+ * Return true if routing e leaves its ports alone. Dynamic ports are
+ * resolved, and ports on a node's side unclipped, as the edge is routed.
+ */
+static boolean fixed_ports(edge_t * e)
+{
+    edge_t *le = getmainedge(e);
+
+    return !(ED_tail_port(e).dyna || ED_head_port(e).dyna
+	     || ED_tail_port(e).side || ED_head_port(e).side
+	     || ED_tail_port(le).dyna || ED_head_port(le).dyna
+	     || ED_tail_port(le).side || ED_head_port(le).side);
+}
+
+/* route_chunk:
+ * Route a chunk of the groups in a route_work_t ahead of time.
+ */
+static void route_chunk(void *state, int c)
+{
+    route_work_t *w = (route_work_t *) state;
+    spline_info_t sd = *w->sp;
+    path P;
+    int i;
+
+    memset(&P, 0, sizeof(P));
+    P.boxes = N_NEW(w->nboxes, boxf);
+    sd.Trial = TRUE;
+    for (i = c * w->nahead / w->nchunk;
+	 i < (c + 1) * w->nahead / w->nchunk; i++) {
+	if (gvtimedout(w->g))
+	    break;
+	sd.Ahead = &w->ahead[i];
+	make_regular_edge(w->g, &sd, &P, w->edges, w->ahead[i].ind,
+			  w->ahead[i].cnt, w->et);
+    }
+    free(P.boxes);
+    routesplinesfree();
+}
+
+/* route_ahead:
+ * Route the groups of regular edges among edges[0..n_edges-1] ahead of
+ * time, using up to nthreads threads, and return their routes, in the
+ * order of the groups. The number of groups is stored in *nahead.
+ */
+static ahead_t *route_ahead(graph_t * g, spline_info_t * sp,
+			    edge_t ** edges, int n_edges, int nboxes,
+			    int et, int nthreads, int *nahead)
+{
+    route_work_t w;
+    edge_t *e0;
+    int i, r, cnt;
+
+    w.ahead = N_NEW(n_edges, ahead_t);
+    w.nahead = 0;
+    for (i = 0; i < n_edges; i += cnt) {
+	e0 = edges[i];
+	cnt = edge_group(edges, i, n_edges);
+	if ((agtail(e0) == aghead(e0))
+	    || (ND_rank(agtail(e0)) == ND_rank(aghead(e0)))
+	    || !fixed_ports(e0))
+	    continue;
+	w.ahead[w.nahead].ind = i;
+	w.ahead[w.nahead++].cnt = cnt;
+    }
+
+    /* fill in the rank boxes the workers share */
+    for (r = GD_minrank(g); r < GD_maxrank(g); r++)
+	rank_box(sp, g, r);
+
+    w.g = g;
+    w.sp = sp;
+    w.edges = edges;
+    w.nboxes = nboxes;
+    w.et = et;
+    w.nchunk = MIN(w.nahead, 4 * nthreads);
+    gvrunwork(w.nchunk, nthreads, route_chunk, &w);
+    *nahead = w.nahead;
+    return w.ahead;
+}
+
+static void free_ahead(ahead_t * ahead, int nahead)
+{
+    int i, j;
+
+    for (i = 0; i < nahead; i++) {
+	for (j = 0; j < ahead[i].n; j++) {
+	    free(ahead[i].routes[j].boxes);
+	    free(ahead[i].routes[j].ps);
+	}
+	free(ahead[i].routes);
+    }
+    free(ahead);
+}
+
+/* same_end:
+ * Return true if routesplines treats the ends p and q of a path alike.
+ */
+static boolean same_end(port * p, port * q)
+{
+    return !memcmp(&p->p, &q->p, sizeof(pointf))
+	&& (p->constrained == q->constrained)
+	&& (!p->constrained || (p->theta == q->theta));
+}
+
+/* route_path:
+ * Route P with routesplines or, if polyline is true, routepolylines.
+ * When routing ahead, keep the route for the group of edges being
+ * routed. Otherwise, if the route kept next for the group was made
+ * from exactly the path P, use it instead, leaving P as routesplines
+ * would.
+ */
+static pointf *route_path(spline_info_t * sp, path * P, int *npoints,
+			  int polyline)
+{
+    ahead_t *a = sp->Ahead;
+    route_t *r;
+    pointf *ps;
+
+    if (a && sp->Trial) {
+	a->routes = ALLOC(a->n + 1, a->routes, route_t);
+	r = &a->routes[a->n++];
+	r->start = P->start;
+	r->end = P->end;
+	r->nbox = P->nbox;
+	r->polyline = polyline;
+	r->boxes = N_GNEW(2 * P->nbox, boxf);
+	memcpy(r->boxes, P->boxes, P->nbox * sizeof(boxf));
+	r->ps = NULL;
+	r->pn = -1;
+	*npoints = 0;
+	if ((ps = tryroutesplines(P, npoints, polyline))) {
+	    memcpy(r->boxes + P->nbox, P->boxes, P->nbox * sizeof(boxf));
+	    r->sp = P->start.p;
+	    r->ep = P->end.p;
+	    r->pn = *npoints;
+	    r->ps = N_GNEW(r->pn, pointf);
+	    memcpy(r->ps, ps, r->pn * sizeof(pointf));
+	}
+	return ps;
+    }
+    if (a && (a->next < a->n)) {
+	r = &a->routes[a->next++];
+	if ((r->pn >= 0) && (r->polyline == polyline)
+	    && (r->nbox == P->nbox)
+	    && same_end(&r->start, &P->start) && same_end(&r->end, &P->end)
+	    && !memcmp(r->boxes, P->boxes, P->nbox * sizeof(boxf))) {
+	    memcpy(P->boxes, r->boxes + r->nbox, r->nbox * sizeof(boxf));
+	    P->start.p = r->sp;
+	    P->end.p = r->ep;
+	    *npoints = r->pn;
+	    return r->ps;
+	}
+    }
+    if (polyline)
+	return routepolylines(P, npoints);
+    return routesplines(P, npoints);
+}
+
 /* _dot_splines:
  * Main spline routing code.
  * The normalize parameter allows this function to be called by the
@@ -252,16 +509,13 @@ setEdgeLabelPos (graph_t * g)
  */
 static void _dot_splines(graph_t * g, int normalize)
 {
-    int i, j, k, n_nodes, n_edges, ind, cnt;
+    int i, j, k, n_nodes, n_edges, ind, cnt, nahead;
     node_t *n;
-    Agedgeinfo_t fwdedgeai, fwdedgebi;
-    Agedgepair_t fwdedgea, fwdedgeb;
-    edge_t *e, *e0, *e1, *ea, *eb, *le0, *le1, **edges = NULL;
+    edge_t *e, *e0, **edges = NULL;
     path *P = NULL;
     spline_info_t sd;
+    ahead_t *ahead;
     int et = EDGE_TYPE(g);
-    fwdedgea.out.base.data = (Agrec_t*)&fwdedgeai;
-    fwdedgeb.out.base.data = (Agrec_t*)&fwdedgebi;
 
     if (et == ET_NONE) return; 
     if (et == ET_CURVED) {
@@ -289,6 +543,8 @@ static void _dot_splines(graph_t * g, int normalize)
     /* FlatHeight = 2 * GD_nodesep(g); */
     sd.Splinesep = GD_nodesep(g) / 4;
     sd.Multisep = GD_nodesep(g);
+    sd.Ahead = NULL;
+    sd.Trial = FALSE;
     edges = N_NEW(CHUNK, edge_t *);
 
     /* compute boundaries and list of splines */
@@ -376,41 +632,28 @@ static void _dot_splines(graph_t * g, int normalize)
 	}
     }
 
-    for (i = 0; i < n_edges;) {
-	ind = i;
-	le0 = getmainedge((e0 = edges[i++]));
-	if (ED_tail_port(e0).defined || ED_head_port(e0).defined) {
-	    ea = e0;
-	} else {
-	    ea =  le0;
-	}
-	if (ED_tree_index(ea) & BWDEDGE) {
-	    MAKEFWDEDGE(&fwdedgea.out, ea);
-	    ea = &fwdedgea.out;
-	}
-	for (cnt = 1; i < n_edges; cnt++, i++) {
-	    if (le0 != (le1 = getmainedge((e1 = edges[i]))))
-		break;
-	    if (ED_adjacent(e0)) continue; /* all flat adjacent edges at once */
-	    if (ED_tail_port(e1).defined || ED_head_port(e1).defined) {
-		    eb = e1;
-	    } else {
-		    eb = le1;
-	    }
-	    if (ED_tree_index(eb) & BWDEDGE) {
-		MAKEFWDEDGE(&fwdedgeb.out, eb);
-		eb = &fwdedgeb.out;
+    nahead = 0;
+    ahead = NULL;
+    if (((et == ET_SPLINE) || (et == ET_PLINE)) && !Verbose
+	&& ((k = gvworkers(g)) > 1))
+	ahead = route_ahead(g, &sd, edges, n_edges, n_nodes + 20 * 2 * NSUB,
+			    et, k, &nahead);
+
+    for (i = 0, k = 0; i < n_edges;) {
+	if (((et == ET_SPLINE) || (et == ET_PLINE)) && gvtimedout(g)) {
+	    /* out of time: route the other edges as line segments, which
+	     * need the edge labels in place
+	     */
+	    et = ET_LINE;
+	    for (n = GD_nlist(g); n; n = ND_next(n)) {
+		if ((ND_node_type(n) == VIRTUAL) && (ND_label(n)))
+		    place_vnlabel(n);
 	    }
-	    if (portcmp(ED_tail_port(ea), ED_tail_port(eb)))
-		break;
-	    if (portcmp(ED_head_port(ea), ED_head_port(eb)))
-		break;
-	    if ((ED_tree_index(e0) & EDGETYPEMASK) == FLATEDGE
-		&& ED_label(e0) != ED_label(e1))
-		break;
-	    if (ED_tree_index(edges[i]) & MAINGRAPH)	/* Aha! -C is on */
-		break;
 	}
+	ind = i;
+	e0 = edges[i];
+	cnt = edge_group(edges, i, n_edges);
+	i += cnt;
 
 	if (et == ET_CURVED) {
 	    int ii;
@@ -455,9 +698,16 @@ static void _dot_splines(graph_t * g, int normalize)
 	else if (ND_rank(agtail(e0)) == ND_rank(aghead(e0))) {
 	    make_flat_edge(g, &sd, P, edges, ind, cnt, et);
 	}
-	else
+	else {
+	    while ((k < nahead) && (ahead[k].ind < ind))
+		k++;
+	    if ((k < nahead) && (ahead[k].ind == ind))
+		sd.Ahead = &ahead[k];
 	    make_regular_edge(g, &sd, P, edges, ind, cnt, et);
+	    sd.Ahead = NULL;
+	}
     }
+    free_ahead(ahead, nahead);
 
     /* place regular edge labels */
     for (n = GD_nlist(g); n; n = ND_next(n)) {
@@ -1747,7 +1997,7 @@ make_regular_edge(graph_t* g, spline_info_t* sp, path * P, edge_t ** edges, int
     fwdedgeb.out.base.data = (Agrec_t*)&fwdedgebi;
     fwdedge.out.base.data = (Agrec_t*)&fwdedgei;
 
-    if (!pointfs) {
+    if (!pointfs && !sp->Trial) {
 	pointfs = N_GNEW(NUMPTS, pointf);
    	pointfs2 = N_GNEW(NUMPTS, pointf);
 	numpts = NUMPTS;
@@ -1836,9 +2086,9 @@ make_regular_edge(graph_t* g, spline_info_t* sp, path * P, edge_t ** edges, int
 	        hend.boxes[hend.boxn++] = b;
 	    P->end.theta = M_PI / 2, P->end.constrained = TRUE;
 	    completeregularpath(P, segfirst, e, &tend, &hend, boxes, boxn, 1);
-	    if (splines) ps = routesplines(P, &pn);
+	    if (splines) ps = route_path(sp, P, &pn, FALSE);
 	    else {
-		ps = routepolylines (P, &pn);
+		ps = route_path(sp, P, &pn, TRUE);
 		if ((et == ET_LINE) && (pn > 4)) {
 		    ps[1] = ps[0];
 		    ps[3] = ps[2] = ps[pn-1];
@@ -1848,18 +2098,23 @@ make_regular_edge(graph_t* g, spline_info_t* sp, path * P, edge_t ** edges, int
 	    if (pn == 0)
 	        return;
 	
-	    if (pointn + pn > numpts) {
-                /* This should be enough to include 3 extra points added by
-                 * straight_path below.
-                 */
-		numpts = 2*(pointn+pn); 
-		pointfs = RALLOC(numpts, pointfs, pointf);
-	    }
-	    for (i = 0; i < pn; i++) {
-		pointfs[pointn++] = ps[i];
+	    if (sp->Trial) {
+		/* leave the points, and the slack, to the edge's turn */
+		for (e = ND_out(hn).list[0]; sl--; e = ND_out(aghead(e)).list[0]);
+	    } else {
+		if (pointn + pn > numpts) {
+		    /* This should be enough to include 3 extra points added by
+		     * straight_path below.
+		     */
+		    numpts = 2*(pointn+pn); 
+		    pointfs = RALLOC(numpts, pointfs, pointf);
+		}
+		for (i = 0; i < pn; i++) {
+		    pointfs[pointn++] = ps[i];
+		}
+		e = straight_path(ND_out(hn).list[0], sl, pointfs, &pointn);
+		recover_slack(segfirst, P);
 	    }
-	    e = straight_path(ND_out(hn).list[0], sl, pointfs, &pointn);
-	    recover_slack(segfirst, P);
 	    segfirst = e;
 	    tn = agtail(e);
 	    hn = aghead(e);
@@ -1884,8 +2139,7 @@ make_regular_edge(graph_t* g, spline_info_t* sp, path * P, edge_t ** edges, int
 	    hend.boxes[hend.boxn++] = b;
 	completeregularpath(P, segfirst, e, &tend, &hend, boxes, boxn,
 	    		longedge);
-	if (splines) ps = routesplines(P, &pn);
-	else ps = routepolylines (P, &pn);
+	ps = route_path(sp, P, &pn, !splines);
 	if ((et == ET_LINE) && (pn > 4)) {
 	    /* Here we have used the polyline case to handle
 	     * an edge between two nodes on adjacent ranks. If the
@@ -1895,7 +2149,7 @@ make_regular_edge(graph_t* g, spline_info_t* sp, path * P, edge_t ** edges, int
 	    ps[3] = ps[2] = ps[pn-1];
 	    pn = 4;
         }
-	if (pn == 0)
+	if ((pn == 0) || sp->Trial)
 	    return;
 	if (pointn + pn > numpts) {
 	    numpts = 2*(pointn+pn); 
@@ -0,0 +1,511 @@
+/* $Id$ $Revision$ */
+/* vim:set shiftwidth=4 ts=8: */
+
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: See CVS logs. Details at http://www.graphviz.org/
+ *************************************************************************/
+
+
+/*
+ * Incremental layout, used by dot when incremental=true.
+ * The previous layout of each node is read from its rank, order and pos
+ * attributes, as left by an earlier run of dot, and kept in ND_prior_rank
+ * and ND_prior_x. Cycles are broken as they were, network simplex starts
+ * from the previous ranks, which are kept unless it finds shorter ones,
+ * build_ranks starts from the previous order, and mincross only reorders
+ * the ranks holding dirty nodes or their edges. A node is dirty if it
+ * has no previous layout, if the graph's change log (see agopenchanges)
+ * has touched it, or if it has an edge without a pos attribute in a
+ * graph whose edges have one, i.e., an edge added since the output.
+ * Once ranked, a node that left its previous rank counts as dirty too.
+ */
+
+#include "dot.h"
+
+#define RANKTOL 0.5		/* pos coordinates of nodes of the same rank */
+
+typedef struct {
+    node_t *n;
+    double y;
+} prior_y_t;
+
+static int ycmpf(const void *x, const void *y)
+{
+    double a = ((prior_y_t *) x)->y, b = ((prior_y_t *) y)->y;
+
+    return (a < b) - (a > b);	/* highest first */
+}
+
+/* ranks_from_pos:
+ * Number the ranks of nodes that have a position but no rank attribute,
+ * from their y coordinates in the layout's own frame. Ranks with only
+ * virtual nodes leave no trace there, so these ranks may be closer than
+ * the old ones; seed_ranks makes up the difference.
+ */
+static void ranks_from_pos(prior_y_t * ys, int nys)
+{
+    int i, r;
+
+    qsort(ys, nys, sizeof(prior_y_t), ycmpf);
+    for (r = i = 0; i < nys; i++) {
+	if ((i > 0) && (ys[i - 1].y - ys[i].y > RANKTOL))
+	    r++;
+	if (!(ND_prior(ys[i].n) & PRIOR_RANK)) {
+	    ND_prior_rank(ys[i].n) = r;
+	    ND_prior(ys[i].n) |= PRIOR_RANK;
+	}
+    }
+}
+
+/* guess_x:
+ * Place a node without a previous position among its neighbors.
+ */
+static void guess_x(graph_t * g, node_t * n)
+{
+    edge_t *e;
+    node_t *m;
+    double x = 0;
+    int cnt = 0;
+
+    for (e = agfstedge(g, n); e; e = agnxtedge(g, e, n)) {
+	m = (agtail(e) == n) ? aghead(e) : agtail(e);
+	if ((m != n) && (ND_prior(m) & PRIOR_X)) {
+	    x += ND_prior_x(m);
+	    cnt++;
+	}
+    }
+    if (cnt) {
+	ND_prior_x(n) = x / cnt;
+	ND_prior(n) |= PRIOR_X;
+    }
+}
+
+/* dot_prior:
+ * If g is to be laid out incrementally, flag it so, read the previous
+ * layout of its nodes and mark the dirty ones. Return TRUE in that case.
+ */
+int dot_prior(graph_t * g)
+{
+    graph_t *root = agroot(g);
+    Agsym_t *N_rnk, *N_ord, *N_ps, *E_ps;
+    Agchangelog_t *log;
+    Agnodeset_t *changed;
+    prior_y_t *ys;
+    node_t *n;
+    edge_t *e;
+    pointf p;
+    int nys, r;
+
+    if (!mapbool(agget(root, "incremental")))
+	return FALSE;
+    GD_flags(g) |= INCREMENTAL;
+
+    N_rnk = agattr(root, AGNODE, "rank", NULL);
+    N_ord = agattr(root, AGNODE, "order", NULL);
+    N_ps = agattr(root, AGNODE, "pos", NULL);
+    E_ps = agattr(root, AGEDGE, "pos", NULL);
+    ys = N_NEW(agnnodes(g) + 1, prior_y_t);
+    nys = 0;
+    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	ND_prior(n) = 0;
+	if (N_rnk && (sscanf(agxget(n, N_rnk), "%d", &r) == 1)) {
+	    ND_prior_rank(n) = r;
+	    ND_prior(n) |= PRIOR_RANK;
+	}
+	if (N_ps && (sscanf(agxget(n, N_ps), "%lf,%lf", &p.x, &p.y) == 2)) {
+	    p = cwrotatepf(p, 90 * GD_rankdir(g));
+	    ND_prior_x(n) = p.x;
+	    ND_prior(n) |= PRIOR_X;
+	    ys[nys].n = n;
+	    ys[nys++].y = p.y;
+	} else if (N_ord && (sscanf(agxget(n, N_ord), "%d", &r) == 1)) {
+	    ND_prior_x(n) = r;
+	    ND_prior(n) |= PRIOR_X;
+	}
+    }
+    ranks_from_pos(ys, nys);
+    free(ys);
+
+    log = agchanges(root);
+    changed = (log ? agchangednodes(log) : NULL);
+    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	if (((ND_prior(n) & (PRIOR_RANK | PRIOR_X)) != (PRIOR_RANK | PRIOR_X))
+	    || (changed && agnodesetmember(changed, n)))
+	    ND_prior(n) |= PRIOR_DIRTY;
+	if (!E_ps)
+	    continue;
+	for (e = agfstout(g, n); e; e = agnxtout(g, e)) {
+	    if (*agxget(e, E_ps) == '\0') {
+		ND_prior(agtail(e)) |= PRIOR_DIRTY;
+		ND_prior(aghead(e)) |= PRIOR_DIRTY;
+	    }
+	}
+    }
+    if (changed)
+	agnodesetfree(changed);
+
+    for (nys = 0, n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	if (!(ND_prior(n) & PRIOR_X))
+	    guess_x(g, n);
+	if (ND_prior(n) & PRIOR_DIRTY)
+	    nys++;
+    }
+    if (Verbose)
+	fprintf(stderr, "incremental: %d of %d nodes changed\n", nys,
+		agnnodes(g));
+    return TRUE;
+}
+
+#define IS_MIN(n) ((ND_ranktype(n) == MINRANK) || (ND_ranktype(n) == SOURCERANK))
+#define IS_MAX(n) ((ND_ranktype(n) == MAXRANK) || (ND_ranktype(n) == SINKRANK))
+
+/* prior_reverse:
+ * Reverse the edges of the component in GD_nlist(g) that went up in the
+ * previous layout, so cycles are broken as they were before. What cycles
+ * remain are left to acyclic. Edges are never turned out of a max set or
+ * into a min set, as minmax_edges2 relies on there being none.
+ */
+void prior_reverse(graph_t * g)
+{
+    node_t *n, *h;
+    edge_t *e;
+    int i;
+
+    for (n = GD_nlist(g); n; n = ND_next(n)) {
+	if ((ND_node_type(n) != NORMAL) || !(ND_prior(n) & PRIOR_RANK))
+	    continue;
+	for (i = 0; (e = ND_out(n).list[i]); i++) {
+	    h = aghead(e);
+	    if ((ND_node_type(h) == NORMAL) && (ND_prior(h) & PRIOR_RANK)
+		&& (ND_prior_rank(h) < ND_prior_rank(n))
+		&& !IS_MAX(h) && !IS_MIN(n)) {
+		reverse_edge(e);
+		i--;
+	    }
+	}
+    }
+}
+
+/* seed_ranks:
+ * Set the ranks of the component in GD_nlist(g) to its nodes' previous
+ * ranks, pushed down where needed to satisfy every edge. New nodes go
+ * just below their predecessors or, lacking any, just above their
+ * successors. Return FALSE, leaving every rank 0, if there is a cycle.
+ */
+static boolean seed_ranks(graph_t * g)
+{
+    node_t *n, *v, **queue;
+    edge_t *e;
+    int i, cnt, head, tail, r, minr;
+
+    for (cnt = 0, n = GD_nlist(g); n; n = ND_next(n))
+	cnt++;
+    queue = N_NEW(cnt, node_t *);
+    head = tail = 0;
+    for (n = GD_nlist(g); n; n = ND_next(n)) {
+	ND_low(n) = ND_in(n).size;	/* in edges not yet ranked */
+	if (ND_low(n) == 0)
+	    queue[tail++] = n;
+    }
+    minr = INT_MAX;
+    while (head < tail) {
+	v = queue[head++];
+	if ((ND_node_type(v) == NORMAL) && (ND_prior(v) & PRIOR_RANK))
+	    r = ND_prior_rank(v);
+	else if (ND_in(v).size)
+	    r = INT_MIN;
+	else {
+	    r = INT_MAX;
+	    for (i = 0; (e = ND_out(v).list[i]); i++) {
+		n = aghead(e);
+		if ((ND_node_type(n) == NORMAL) && (ND_prior(n) & PRIOR_RANK))
+		    r = MIN(r, ND_prior_rank(n) - ED_minlen(e));
+	    }
+	    if (r == INT_MAX)
+		r = 0;
+	}
+	for (i = 0; (e = ND_in(v).list[i]); i++)
+	    r = MAX(r, ND_rank(agtail(e)) + ED_minlen(e));
+	ND_rank(v) = r;
+	if (ND_node_type(v) == NORMAL)
+	    minr = MIN(minr, r);
+	for (i = 0; (e = ND_out(v).list[i]); i++)
+	    if (--ND_low(aghead(e)) == 0)
+		queue[tail++] = aghead(e);
+    }
+    free(queue);
+
+    /* as network simplex does, put the first real node on rank 0 */
+    if (minr == INT_MAX)
+	minr = 0;
+    for (n = GD_nlist(g); n; n = ND_next(n))
+	ND_rank(n) = ((tail == cnt) ? ND_rank(n) - minr : 0);
+    return (tail == cnt);
+}
+
+static double rank_cost(graph_t * g)
+{
+    node_t *n;
+    edge_t *e;
+    double cost = 0;
+    int i;
+
+    for (n = GD_nlist(g); n; n = ND_next(n))
+	for (i = 0; (e = ND_out(n).list[i]); i++)
+	    cost += ED_weight(e) * (double) (ND_rank(aghead(e)) - ND_rank(n));
+    return cost;
+}
+
+/* prior_rank:
+ * Rank the component in GD_nlist(g) as rank does, but starting network
+ * simplex from the previous ranks. Its optimum is seldom unique, and
+ * balancing moves nodes about, so if the previous ranks turn out to be
+ * as short, they are kept as they were.
+ */
+void prior_rank(graph_t * g, int balance, int maxiter)
+{
+    node_t *n;
+    int *seed, i, cnt;
+    double cost;
+
+    if (!seed_ranks(g)) {
+	rank(g, balance, maxiter);
+	return;
+    }
+    for (cnt = 0, n = GD_nlist(g); n; n = ND_next(n))
+	cnt++;
+    seed = N_NEW(cnt, int);
+    for (i = 0, n = GD_nlist(g); n; n = ND_next(n))
+	seed[i++] = ND_rank(n);
+    cost = rank_cost(g);
+
+    rank(g, balance, maxiter);
+    if (cost <= rank_cost(g))
+	for (i = 0, n = GD_nlist(g); n; n = ND_next(n))
+	    ND_rank(n) = seed[i++];
+    free(seed);
+}
+
+/* cluster_x:
+ * The mean previous position of the nodes of a cluster.
+ */
+static boolean cluster_x(graph_t * clust, double *x)
+{
+    node_t *n;
+    double sum = 0;
+    int cnt = 0;
+
+    for (n = agfstnode(clust); n; n = agnxtnode(clust, n)) {
+	if (ND_prior(n) & PRIOR_X) {
+	    sum += ND_prior_x(n);
+	    cnt++;
+	}
+    }
+    if (cnt)
+	*x = sum / cnt;
+    return (cnt > 0);
+}
+
+static boolean end_x(node_t * n, double *x)
+{
+    if (ND_node_type(n) == NORMAL) {
+	*x = ND_prior_x(n);
+	return ((ND_prior(n) & PRIOR_X) != 0);
+    }
+    if ((ND_ranktype(n) == CLUSTER) && ND_clust(n))
+	return cluster_x(ND_clust(n), x);
+    return FALSE;
+}
+
+/* prior_x:
+ * The previous position of a node in build_ranks: that of a real node,
+ * the mean of a cluster's for its skeleton, and for a virtual node of
+ * an edge, the one on the line between the edge's previous ends.
+ */
+static boolean prior_x(node_t * v, double *x)
+{
+    node_t *t, *h;
+    double xt, xh;
+    boolean bt, bh;
+
+    if ((ND_node_type(v) == NORMAL) || (ND_ranktype(v) == CLUSTER))
+	return end_x(v, x);
+    t = h = v;
+    while ((ND_node_type(t) == VIRTUAL) && (ND_ranktype(t) != CLUSTER)
+	   && (ND_in(t).size == 1))
+	t = agtail(ND_in(t).list[0]);
+    while ((ND_node_type(h) == VIRTUAL) && (ND_ranktype(h) != CLUSTER)
+	   && (ND_out(h).size == 1))
+	h = aghead(ND_out(h).list[0]);
+    bt = ((t != v) && end_x(t, &xt));
+    bh = ((h != v) && end_x(h, &xh));
+    if (bt && bh)
+	*x = xt + (xh - xt) * (ND_rank(v) - ND_rank(t))
+	    / (double) (ND_rank(h) - ND_rank(t));
+    else if (bt || bh)
+	*x = (bt ? xt : xh);
+    return (bt || bh);
+}
+
+typedef struct {
+    node_t *n;
+    double x;
+    int i;
+} prior_key_t;
+
+static int keycmpf(const void *x, const void *y)
+{
+    const prior_key_t *a = (const prior_key_t *) x;
+    const prior_key_t *b = (const prior_key_t *) y;
+
+    if (a->x != b->x)
+	return (a->x > b->x) - (a->x < b->x);
+    return a->i - b->i;
+}
+
+/* prior_order:
+ * Sort the ranks of g, as just installed by build_ranks, by previous
+ * position. A node with none stays right after the node it followed.
+ */
+void prior_order(graph_t * g)
+{
+    prior_key_t *keys;
+    node_t **vlist;
+    double x, last;
+    int i, n, r;
+
+    for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
+	n = GD_rank(g)[r].n;
+	vlist = GD_rank(g)[r].v;
+	if (n < 2)
+	    continue;
+	keys = N_NEW(n, prior_key_t);
+	last = -MAXDOUBLE;
+	for (i = 0; i < n; i++) {
+	    if (prior_x(vlist[i], &x))
+		last = x;
+	    keys[i].n = vlist[i];
+	    keys[i].x = last;
+	    keys[i].i = i;
+	}
+	qsort(keys, n, sizeof(prior_key_t), keycmpf);
+	for (i = 0; i < n; i++) {
+	    vlist[i] = keys[i].n;
+	    ND_order(vlist[i]) = i;
+	}
+	free(keys);
+    }
+}
+
+typedef struct {
+    int prior, rank;
+} rank_map_t;
+
+static int mapcmpf(const void *x, const void *y)
+{
+    const rank_map_t *a = (const rank_map_t *) x;
+    const rank_map_t *b = (const rank_map_t *) y;
+
+    if (a->prior != b->prior)
+	return (a->prior > b->prior) - (a->prior < b->prior);
+    return (a->rank > b->rank) - (a->rank < b->rank);
+}
+
+static int priorcmpf(const void *x, const void *y)
+{
+    int a = ((const rank_map_t *) x)->prior;
+    int b = ((const rank_map_t *) y)->prior;
+
+    return (a > b) - (a < b);
+}
+
+/* rank_map:
+ * Return the rank that most of the nodes of each previous rank now hold,
+ * sorted by previous rank, and set *np to their number. Previous ranks
+ * read from pos may be closer than the new ones, so the map need not be
+ * the identity, but it must keep the ranks in order; a previous rank
+ * that does not is mapped to none.
+ */
+static rank_map_t *rank_map(graph_t * g, int *np)
+{
+    rank_map_t *m;
+    node_t *n;
+    int i, j, k, cnt, best, last;
+
+    m = N_NEW(agnnodes(g) + 1, rank_map_t);
+    for (cnt = 0, n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	if (ND_prior(n) & PRIOR_RANK) {
+	    m[cnt].prior = ND_prior_rank(n);
+	    m[cnt++].rank = ND_rank(n);
+	}
+    }
+    qsort(m, cnt, sizeof(rank_map_t), mapcmpf);
+    last = INT_MIN;
+    for (i = k = 0; i < cnt; k++) {
+	m[k].prior = m[i].prior;
+	for (best = 0; (i < cnt) && (m[i].prior == m[k].prior); i = j) {
+	    for (j = i; (j < cnt) && (m[j].prior == m[i].prior)
+		 && (m[j].rank == m[i].rank); j++);
+	    if (j - i > best) {
+		best = j - i;
+		m[k].rank = m[i].rank;
+	    }
+	}
+	if (m[k].rank > last)
+	    last = m[k].rank;
+	else
+	    m[k].rank = INT_MIN;
+    }
+    *np = k;
+    return m;
+}
+
+/* moved:
+ * Return TRUE if ranking moved n off the rank its previous rank maps to.
+ */
+static boolean moved(node_t * n, rank_map_t * m, int nm)
+{
+    rank_map_t key, *p;
+
+    if (!(ND_prior(n) & PRIOR_RANK))
+	return FALSE;
+    key.prior = ND_prior_rank(n);
+    p = bsearch(&key, m, nm, sizeof(rank_map_t), priorcmpf);
+    return (!p || (p->rank != ND_rank(n)));
+}
+
+/* dirty_ranks:
+ * Return a flag per rank of g, from GD_minrank(g), set if a dirty node
+ * or one of its edges lies on the rank. A node that ranking moved off
+ * its previous rank counts as dirty: its new rank mixes old nodes with
+ * ones pushed down.
+ */
+char *dirty_ranks(graph_t * g)
+{
+    char *dirty = N_NEW(GD_maxrank(g) - GD_minrank(g) + 1, char);
+    rank_map_t *m;
+    node_t *n;
+    edge_t *e;
+    int r, lo, hi, nm;
+
+    m = rank_map(g, &nm);
+    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	if (!(ND_prior(n) & PRIOR_DIRTY) && !moved(n, m, nm))
+	    continue;
+	dirty[ND_rank(n) - GD_minrank(g)] = TRUE;
+	for (e = agfstedge(g, n); e; e = agnxtedge(g, e, n)) {
+	    lo = MIN(ND_rank(agtail(e)), ND_rank(aghead(e)));
+	    hi = MAX(ND_rank(agtail(e)), ND_rank(aghead(e)));
+	    for (r = lo; r <= hi; r++)
+		dirty[r - GD_minrank(g)] = TRUE;
+	}
+    }
+    free(m);
+    return dirty;
+}
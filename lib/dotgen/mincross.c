@@ -39,6 +39,7 @@ static void init_mccomp(graph_t * g, int c);
 static void cleanup2(graph_t * g, int nc);
 static int mincross_clust(graph_t * par, graph_t * g, int);
 static int mincross(graph_t * g, int startpass, int endpass, int);
+static int mincross_search(graph_t * g, int doBalance);
 static void mincross_step(graph_t * g, int pass);
 static void mincross_options(graph_t * g);
 static void save_best(graph_t * g);
@@ -61,14 +62,35 @@ void node_in_root_vlist(node_t * n);
 
 
 	/* mincross parameters */
-static int MinQuit;
-static double Convergence;
-
-static graph_t *Root;
-static int GlobalMinRank, GlobalMaxRank;
-static edge_t **TE_list;
-static int *TI_list;
-static boolean ReMincross;
+static GVTLS int MinQuit;
+static GVTLS int MaxPass;
+static GVTLS double Convergence;
+
+	/* per layout; components may be laid out on several threads */
+static GVTLS graph_t *Root;
+static GVTLS int GlobalMinRank, GlobalMaxRank;
+static GVTLS edge_t **TE_list;
+static GVTLS int *TI_list;
+static GVTLS boolean ReMincross;
+static GVTLS int *Count, C;	/* rcross work space */
+
+	/* transpose work space: the edges of the nodes of a rank, sorted */
+typedef struct {
+    int pos;			/* order of the other end */
+    double port;		/* port at the other end */
+    int wt;			/* crossing penalty */
+} adj_t;
+static GVTLS adj_t *Adj;
+static GVTLS int NAdj;
+static GVTLS int *Seg, NSeg;	/* in and out segments of Adj, by order */
+
+	/* independent searches for an order; see mincross_search */
+static GVTLS int MCStarts;	/* searches per component */
+static GVTLS int MCThreads;	/* threads they may use */
+static GVTLS double MCDeadline;	/* wall clock time to stop iterating, or 0 */
+static GVTLS unsigned int MCSeed;	/* if not 0, varies the initial order */
+static GVTLS char *Touched;	/* if set, the ranks mincross may reorder */
+#define TOUCHED(r) (!Touched || Touched[(r) - GD_minrank(Root)])
 
 #if DEBUG > 1
 static void indent(graph_t* g)
@@ -335,10 +357,15 @@ void dot_mincross(graph_t * g, int doBalance)
     char *s;
 
     init_mincross(g);
+    if (GD_flags(g) & INCREMENTAL)
+	Touched = dirty_ranks(g);
 
     for (nc = c = 0; c < GD_comp(g).size; c++) {
 	init_mccomp(g, c);
-	nc += mincross(g, 0, 2, doBalance);
+	if (MCStarts > 1)
+	    nc += mincross_search(g, doBalance);
+	else
+	    nc += mincross(g, 0, 2, doBalance);
     }
 
     merge2(g);
@@ -352,8 +379,10 @@ void dot_mincross(graph_t * g, int doBalance)
 #endif
     }
 
-    if ((GD_n_cluster(g) > 0)
-	&& (!(s = agget(g, "remincross")) || (mapbool(s)))) {
+    gvlock();
+    s = (GD_n_cluster(g) > 0) ? agget(g, "remincross") : NULL;
+    gvunlock();
+    if ((GD_n_cluster(g) > 0) && (!s || mapbool(s))) {
 	mark_lowclusters(g);
 	ReMincross = TRUE;
 	nc = mincross(g, 2, 2, doBalance);
@@ -363,6 +392,8 @@ void dot_mincross(graph_t * g, int doBalance)
 #endif
     }
     cleanup2(g, nc);
+    free(Touched);
+    Touched = NULL;
 }
 
 static adjmatrix_t *new_matrix(int i, int j)
@@ -757,13 +788,131 @@ static int balance(graph_t * g)
     return rv;
 }
 
+static int adjcmp(const void *x, const void *y)
+{
+    const adj_t *a = x, *b = y;
+
+    if (a->pos != b->pos)
+	return a->pos - b->pos;
+    if (a->port != b->port)
+	return (a->port > b->port) ? 1 : -1;
+    return 0;
+}
+
+/* add_adj:
+ * Append the far ends of the edges in l to Adj, sorted by order and
+ * port, and return the new length.
+ */
+static int add_adj(int n, edge_t ** l, int out)
+{
+    edge_t *e;
+    adj_t a;
+    int i, j, k;
+
+    for (i = n; (e = *l); l++, i++) {
+	if (out) {
+	    Adj[i].pos = ND_order(aghead(e));
+	    Adj[i].port = ED_head_port(e).p.x;
+	} else {
+	    Adj[i].pos = ND_order(agtail(e));
+	    Adj[i].port = ED_tail_port(e).p.x;
+	}
+	Adj[i].wt = ED_xpenalty(e);
+    }
+    if (i - n > 16)
+	qsort(Adj + n, i - n, sizeof(adj_t), adjcmp);
+    else
+	for (j = n + 1; j < i; j++) {
+	    a = Adj[j];
+	    for (k = j; k > n && adjcmp(&Adj[k - 1], &a) > 0; k--)
+		Adj[k] = Adj[k - 1];
+	    Adj[k] = a;
+	}
+    return i;
+}
+
+/* rank_adj:
+ * Make room in Adj for the edges of the nodes of rank r, and mark
+ * their lists as not yet made. The node in position i has its sorted
+ * in-edges from Seg[3i] to Seg[3i+1], and its out-edges from there to
+ * Seg[3i+2]. Transposing rank r only reorders rank r, so the lists stay
+ * sorted while it runs.
+ */
+static void rank_adj(graph_t * g, int r)
+{
+    int i, n, ne;
+    node_t *v;
+
+    n = GD_rank(g)[r].n;
+    ne = 0;
+    for (i = 0; i < n; i++) {
+	v = GD_rank(g)[r].v[i];
+	ne += ND_in(v).size + ND_out(v).size;
+    }
+    if (NAdj < ne) {
+	NAdj = ne;
+	Adj = ALLOC(NAdj, Adj, adj_t);
+    }
+    if (NSeg < 3 * n + 1) {
+	NSeg = 3 * n + 1;
+	Seg = ALLOC(NSeg, Seg, int);
+    }
+    for (i = 0; i < 3 * n; i++)
+	Seg[i] = -1;
+    Seg[3 * n] = 0;		/* where the next list goes */
+}
+
+/* node_adj:
+ * Make the lists of the node in position i of rank r, if need be,
+ * and return where they are.
+ */
+static int *node_adj(graph_t * g, int r, int i)
+{
+    int *s = Seg + 3 * i;
+    int *next = Seg + 3 * GD_rank(g)[r].n;
+    node_t *v;
+
+    if (s[0] < 0) {
+	v = GD_rank(g)[r].v[i];
+	s[0] = *next;
+	s[1] = add_adj(s[0], ND_in(v).list, 0);
+	s[2] = *next = add_adj(s[1], ND_out(v).list, 1);
+    }
+    return s;
+}
+
+/* adj_cross:
+ * The crossings between the edges in Adj[a0..a1) and Adj[b0..b1) of
+ * two nodes on the same rank, the first on the left: as in_cross and
+ * out_cross, but merging the sorted lists rather than trying each pair.
+ */
+static int adj_cross(int a0, int a1, int b0, int b1)
+{
+    int i, j, tot, below, cross;
+
+    tot = 0;
+    for (i = a0; i < a1; i++)
+	tot += Adj[i].wt;
+    cross = below = 0;
+    for (j = a0, i = b0; i < b1; i++) {
+	for (; j < a1 && adjcmp(&Adj[j], &Adj[i]) <= 0; j++)
+	    below += Adj[j].wt;
+	cross += (tot - below) * Adj[i].wt;
+    }
+    return cross;
+}
+
+/* below this many pairs of edges, in_cross and out_cross are as fast */
+#define MINMERGE 32
+
 static int transpose_step(graph_t * g, int r, int reverse)
 {
-    int i, c0, c1, rv;
+    int i, c0, c1, rv, t, *s, *s1;
     node_t *v, *w;
 
     rv = 0;
     GD_rank(g)[r].candidate = FALSE;
+    rank_adj(g, r);
     for (i = 0; i < GD_rank(g)[r].n - 1; i++) {
 	v = GD_rank(g)[r].v[i];
 	w = GD_rank(g)[r].v[i + 1];
@@ -771,16 +920,36 @@ static int transpose_step(graph_t * g, int r, int reverse)
 	if (left2right(g, v, w))
 	    continue;
 	c0 = c1 = 0;
-	if (r > 0) {
-	    c0 += in_cross(v, w);
-	    c1 += in_cross(w, v);
-	}
-	if (GD_rank(g)[r + 1].n > 0) {
-	    c0 += out_cross(v, w);
-	    c1 += out_cross(w, v);
+	if (ND_in(v).size * ND_in(w).size + ND_out(v).size * ND_out(w).size
+	    <= MINMERGE) {
+	    if (r > 0) {
+		c0 += in_cross(v, w);
+		c1 += in_cross(w, v);
+	    }
+	    if (GD_rank(g)[r + 1].n > 0) {
+		c0 += out_cross(v, w);
+		c1 += out_cross(w, v);
+	    }
+	} else {
+	    s = node_adj(g, r, i);
+	    s1 = node_adj(g, r, i + 1);
+	    if (r > 0) {
+		c0 += adj_cross(s[0], s[1], s1[0], s1[1]);
+		c1 += adj_cross(s1[0], s1[1], s[0], s[1]);
+	    }
+	    if (GD_rank(g)[r + 1].n > 0) {
+		c0 += adj_cross(s[1], s[2], s1[1], s1[2]);
+		c1 += adj_cross(s1[1], s1[2], s[1], s[2]);
+	    }
 	}
 	if ((c1 < c0) || ((c0 > 0) && reverse && (c1 == c0))) {
 	    exchange(v, w);
+	    s = Seg + 3 * i;
+	    for (t = 0; t < 3; t++) {
+		int x = s[t];
+		s[t] = s[t + 3];
+		s[t + 3] = x;
+	    }
 	    rv += (c0 - c1);
 	    GD_rank(Root)[r].valid = FALSE;
 	    GD_rank(g)[r].candidate = TRUE;
@@ -815,7 +984,7 @@ static void transpose(graph_t * g, int reverse)
 		delta += transpose_step(g, r, reverse);
 #endif
 	for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
-	    if (GD_rank(g)[r].candidate) {
+	    if (GD_rank(g)[r].candidate && TOUCHED(r)) {
 		delta += transpose_step(g, r, reverse);
 	    }
 	}
@@ -834,8 +1003,11 @@ static int mincross(graph_t * g, int startpass, int endpass, int doBalance)
     } else
 	cur_cross = best_cross = INT_MAX;
     for (pass = startpass; pass <= endpass; pass++) {
+	/* a previous order is the only start worth trying */
+	if (Touched && (pass == 1))
+	    continue;
 	if (pass <= 1) {
-	    maxthispass = MIN(4, MaxIter);
+	    maxthispass = MIN(4, MaxPass);
 	    if (g == dot_root(g))
 		build_ranks(g, pass);
 	    if (pass == 0)
@@ -848,7 +1020,7 @@ static int mincross(graph_t * g, int startpass, int endpass, int doBalance)
 	    }
 	    trying = 0;
 	} else {
-	    maxthispass = MaxIter;
+	    maxthispass = MaxPass;
 	    if (cur_cross > best_cross)
 		restore_best(g);
 	    cur_cross = best_cross;
@@ -863,8 +1035,12 @@ static int mincross(graph_t * g, int startpass, int endpass, int doBalance)
 		break;
 	    if (cur_cross == 0)
 		break;
+	    if ((MCDeadline && (wall_sec() > MCDeadline)) || gvtimedout(g))
+		break;
 	    mincross_step(g, iter);
-	    if ((cur_cross = ncross(g)) <= best_cross) {
+	    /* a previous order gives way only to a better one */
+	    if (((cur_cross = ncross(g)) < best_cross)
+		|| ((cur_cross == best_cross) && !Touched)) {
 		save_best(g);
 		if (cur_cross < Convergence * best_cross)
 		    trying = 0;
@@ -888,6 +1064,261 @@ static int mincross(graph_t * g, int startpass, int endpass, int doBalance)
     return best_cross;
 }
 
+/* Searches
+ * With mcstarts=K, a component without clusters or flat edges is ordered
+ * by K independent searches, and the order with the fewest crossings is
+ * kept. Search s runs mincross with MCSeed = s, so build_ranks starts it
+ * from a different initial order; search 0 is the usual one. Each search
+ * works on its own copy of the component's nodes, edges and ranks, so
+ * they can run on several threads, and ties go to the lowest search, so
+ * the result does not depend on the number of threads, unless mctime
+ * or maxtime stops the searches early. Clusters and flat edges are left alone, as
+ * their handling changes the graph itself.
+ */
+
+typedef struct {
+    graph_t *g;			/* the component, in GD_nlist(g) */
+    node_t **nodes;		/* its nodes; ND_low(n) is the index */
+    int nn, ne;
+    int *inedge;		/* per in edge, the index of its out edge */
+    int *rankn;			/* nodes per rank */
+    int doBalance;
+    int minquit, maxpass;
+    double convergence, deadline;
+    int *order;			/* nn orders found by each search */
+    int *cross;			/* crossings found by each search */
+} mcsearch_t;
+
+static int searchable(graph_t * g)
+{
+    node_t *n;
+
+    for (n = GD_nlist(g); n; n = ND_next(n))
+	if (ND_clust(n) || (ND_ranktype(n) == CLUSTER)
+	    || ND_flat_out(n).size || ND_flat_in(n).size)
+	    return FALSE;
+    return TRUE;
+}
+
+typedef struct {
+    edge_t *e;
+    int i;
+} edgeidx_t;
+
+static int edgeidxcmp(const void *x, const void *y)
+{
+    const edgeidx_t *a = (const edgeidx_t *) x;
+    const edgeidx_t *b = (const edgeidx_t *) y;
+
+    return (a->e > b->e) - (a->e < b->e);
+}
+
+/* mcsearch:
+ * Run search s of ms on a copy of the component, and record the order
+ * it found. If it runs on the thread of dot_mincross, that thread's work
+ * space is put back afterwards.
+ */
+static void mcsearch(void *state, int s)
+{
+    mcsearch_t *ms = (mcsearch_t *) state;
+    graph_t *g = ms->g, sg;
+    Agraphinfo_t gi;
+    Agnode_t *vn;
+    Agnodeinfo_t *vi;
+    Agedgepair_t *ve;
+    edge_t *e, **el, **ep;
+    node_t **vlist, *n;
+    rank_t *rank;
+    int i, j, k, r, *o, nn = ms->nn;
+    graph_t *root = Root, *dotroot;
+    int *tilist = TI_list, *count = Count, c = C;
+    adj_t *adj = Adj;
+    int nadj = NAdj, *seg = Seg, nseg = NSeg;
+
+    if ((s > 0) && ((ms->deadline && (wall_sec() > ms->deadline))
+		    || gvtimedout(g))) {
+	ms->cross[s] = INT_MAX;
+	return;
+    }
+
+    sg = *g;
+    gi = *(Agraphinfo_t *) AGDATA(g);
+    AGDATA(&sg) = (Agrec_t *) & gi;
+    rank = N_NEW(GD_maxrank(g) + 2, rank_t);	/* as allocate_ranks */
+    vlist = N_NEW(nn, node_t *);
+    for (k = 0, r = GD_minrank(g); r <= GD_maxrank(g); r++) {
+	rank[r] = GD_rank(g)[r];
+	rank[r].v = rank[r].av = vlist + k;
+	rank[r].n = 0;
+	rank[r].an = ms->rankn[r];
+	rank[r].valid = FALSE;
+	k += ms->rankn[r];
+    }
+    GD_rank(&sg) = rank;
+
+    vn = N_NEW(nn, Agnode_t);
+    vi = N_NEW(nn, Agnodeinfo_t);
+    for (i = 0; i < nn; i++) {
+	vn[i] = *ms->nodes[i];
+	vi[i] = *(Agnodeinfo_t *) AGDATA(ms->nodes[i]);
+	AGDATA(&vn[i]) = (Agrec_t *) & vi[i];
+	ND_next(&vn[i]) = (i + 1 < nn) ? &vn[i + 1] : NULL;
+	ND_prev(&vn[i]) = (i > 0) ? &vn[i - 1] : NULL;
+    }
+    GD_nlist(&sg) = vn;
+
+    /* the copies of the edges share their edge info, which is not changed */
+    ve = N_NEW(ms->ne + 1, Agedgepair_t);
+    ep = el = N_NEW(2 * (ms->ne + nn), edge_t *);
+    for (k = i = 0; i < nn; i++) {
+	n = ms->nodes[i];
+	ND_out(&vn[i]).list = ep;
+	for (j = 0; (e = ND_out(n).list[j]); j++, k++) {
+	    ve[k] = *(Agedgepair_t *) AGMKOUT(e);
+	    ve[k].out.node = &vn[ND_low(aghead(e))];
+	    ve[k].in.node = &vn[i];
+	    *ep++ = (AGTYPE(e) == AGINEDGE) ? &ve[k].in : &ve[k].out;
+	}
+	*ep++ = NULL;
+    }
+    for (k = i = 0; i < nn; i++) {
+	ND_in(&vn[i]).list = ep;
+	for (j = 0; j < ND_in(&vn[i]).size; j++, k++) {
+	    e = ND_in(ms->nodes[i]).list[j];
+	    *ep++ = (AGTYPE(e) == AGINEDGE) ? &ve[ms->inedge[k]].in
+					    : &ve[ms->inedge[k]].out;
+	}
+	*ep++ = NULL;
+    }
+
+    dotroot = dot_setroot(&sg);
+    Root = &sg;
+    MinQuit = ms->minquit;
+    MaxPass = ms->maxpass;
+    Convergence = ms->convergence;
+    MCDeadline = ms->deadline;
+    MCSeed = s;
+    ReMincross = FALSE;
+    TI_list = N_NEW(ms->ne + 1, int);
+    Count = NULL;
+    C = 0;
+    Adj = NULL;
+    NAdj = 0;
+    Seg = NULL;
+    NSeg = 0;
+
+    ms->cross[s] = mincross(&sg, 0, 2, ms->doBalance);
+    o = ms->order + s * nn;
+    for (i = 0; i < nn; i++)
+	o[i] = ND_order(&vn[i]);
+
+    free(TI_list);
+    free(Count);
+    free(Adj);
+    free(Seg);
+    TI_list = tilist;
+    Count = count;
+    C = c;
+    Adj = adj;
+    NAdj = nadj;
+    Seg = seg;
+    NSeg = nseg;
+    MCSeed = 0;
+    Root = root;
+    dot_setroot(dotroot);
+
+    free(rank);
+    free(vlist);
+    free(vn);
+    free(vi);
+    free(ve);
+    free(el);
+}
+
+/* mincross_search:
+ * Order the component in GD_nlist(g) by MCStarts searches, and return
+ * the crossings of the order kept.
+ */
+static int mincross_search(graph_t * g, int doBalance)
+{
+    mcsearch_t ms;
+    edgeidx_t *idx, key, *p;
+    node_t *n;
+    edge_t *e;
+    int i, j, k, r, s, best, *o;
+
+    if (!searchable(g))
+	return mincross(g, 0, 2, doBalance);
+
+    ms.g = g;
+    ms.doBalance = doBalance;
+    ms.minquit = MinQuit;
+    ms.maxpass = MaxPass;
+    ms.convergence = Convergence;
+    ms.deadline = MCDeadline;
+    ms.rankn = N_NEW(GD_maxrank(g) + 1, int);
+    for (ms.nn = ms.ne = 0, n = GD_nlist(g); n; n = ND_next(n)) {
+	ms.nn++;
+	ms.ne += ND_out(n).size;
+	ms.rankn[ND_rank(n)]++;
+    }
+    ms.nodes = N_NEW(ms.nn, node_t *);
+    for (i = 0, n = GD_nlist(g); n; n = ND_next(n)) {
+	ND_low(n) = i;
+	ms.nodes[i++] = n;
+    }
+
+    /* find each in edge among the out edges, to copy the in lists */
+    idx = N_NEW(ms.ne + 1, edgeidx_t);
+    for (k = i = 0; i < ms.nn; i++)
+	for (j = 0; (e = ND_out(ms.nodes[i]).list[j]); j++, k++) {
+	    idx[k].e = e;
+	    idx[k].i = k;
+	}
+    qsort(idx, ms.ne, sizeof(edgeidx_t), edgeidxcmp);
+    ms.inedge = N_NEW(ms.ne + 1, int);
+    for (k = i = 0; i < ms.nn; i++)
+	for (j = 0; (e = ND_in(ms.nodes[i]).list[j]); j++, k++) {
+	    key.e = e;
+	    p = (edgeidx_t *) bsearch(&key, idx, ms.ne, sizeof(edgeidx_t),
+				      edgeidxcmp);
+	    assert(p);
+	    ms.inedge[k] = p->i;
+	}
+    free(idx);
+
+    ms.order = N_NEW(MCStarts * ms.nn, int);
+    ms.cross = N_NEW(MCStarts, int);
+    gvrunwork(MCStarts, MCThreads, mcsearch, &ms);
+
+    best = 0;
+    for (s = 1; s < MCStarts; s++)
+	if (ms.cross[s] < ms.cross[best])
+	    best = s;
+    if (Verbose)
+	fprintf(stderr, "mincross: %d searches, best %d crossings from search %d\n",
+		MCStarts, ms.cross[best], best);
+
+    o = ms.order + best * ms.nn;
+    for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
+	GD_rank(g)[r].n = ms.rankn[r];
+	GD_rank(g)[r].valid = FALSE;
+    }
+    for (i = 0; i < ms.nn; i++) {
+	n = ms.nodes[i];
+	ND_order(n) = ND_low(n) = o[i];
+	GD_rank(g)[ND_rank(n)].v[o[i]] = n;
+    }
+    k = ms.cross[best];
+
+    free(ms.rankn);
+    free(ms.nodes);
+    free(ms.inedge);
+    free(ms.order);
+    free(ms.cross);
+    return k;
+}
+
 static void restore_best(graph_t * g)
 {
     node_t *n;
@@ -963,10 +1394,13 @@ static void merge2(graph_t * g)
 	for (i = 0; i < GD_rank(g)[r].n; i++) {
 	    v = GD_rank(g)[r].v[i];
 	    if (v == NULL) {
-		if (Verbose)
+		if (Verbose) {
+		    gvlock();
 		    fprintf(stderr,
 			    "merge2: graph %s, rank %d has only %d < %d nodes\n",
 			    agnameof(g), r, i, GD_rank(g)[r].n);
+		    gvunlock();
+		}
 		GD_rank(g)[r].n = i;
 		break;
 	    }
@@ -989,6 +1423,21 @@ static void cleanup2(graph_t * g, int nc)
 	free(TE_list);
 	TE_list = NULL;
     }
+    if (Count) {
+	free(Count);
+	Count = NULL;
+	C = 0;
+    }
+    if (Adj) {
+	free(Adj);
+	Adj = NULL;
+	NAdj = 0;
+    }
+    if (Seg) {
+	free(Seg);
+	Seg = NULL;
+	NSeg = 0;
+    }
     /* fix vlists of clusters */
     for (c = 1; c <= GD_n_cluster(g); c++)
 	rec_reset_vlists(GD_clust(g)[c]);
@@ -1010,9 +1459,12 @@ static void cleanup2(graph_t * g, int nc)
 	}
 	free_matrix(GD_rank(g)[r].flat);
     }
-    if (Verbose)
+    if (Verbose) {
+	gvlock();
 	fprintf(stderr, "mincross %s: %d crossings, %.2f secs.\n",
 		agnameof(g), nc, elapsed_sec());
+	gvunlock();
+    }
 }
 
 static node_t *neighbor(node_t * v, int dir)
@@ -1376,13 +1828,77 @@ void install_in_rank(graph_t * g, node_t * n)
  *	graphs such as trees are drawn with no crossings.  it tries searching
  *	in- and out-edges and takes the better of the two initial orderings.
  */
+/* mcrand:
+ * Return the next number of a search's random sequence.
+ */
+static unsigned int mcrand(unsigned int *state)
+{
+    unsigned int x = *state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return (*state = x);
+}
+
+/* shuffled_nlist:
+ * Return the nodes of g in random order, NULL terminated.
+ */
+static node_t **shuffled_nlist(graph_t * g, unsigned int *state)
+{
+    node_t *n, *t, **list;
+    int i, j, cnt;
+
+    for (cnt = 0, n = GD_nlist(g); n; n = ND_next(n))
+	cnt++;
+    list = N_NEW(cnt + 1, node_t *);
+    for (i = 0, n = GD_nlist(g); n; n = ND_next(n))
+	list[i++] = n;
+    for (i = cnt - 1; i > 0; i--) {
+	j = mcrand(state) % (i + 1);
+	t = list[i];
+	list[i] = list[j];
+	list[j] = t;
+    }
+    return list;
+}
+
+/* enqueue_rotated:
+ * Like enqueue_neighbors, but starting from a random edge of n0.
+ */
+static void enqueue_rotated(nodequeue * q, node_t * n0, int pass,
+			    unsigned int *state)
+{
+    elist *l = (pass == 0) ? &ND_out(n0) : &ND_in(n0);
+    node_t *n;
+    int i, i0;
+
+    if (l->size == 0)
+	return;
+    i0 = mcrand(state) % l->size;
+    for (i = 0; i < l->size; i++) {
+	n = (pass == 0) ? aghead(l->list[(i0 + i) % l->size])
+			: agtail(l->list[(i0 + i) % l->size]);
+	if (MARK(n) == FALSE) {
+	    MARK(n) = TRUE;
+	    enqueue(q, n);
+	}
+    }
+}
+
 void build_ranks(graph_t * g, int pass)
 {
-    int i, j;
-    node_t *n, *n0;
+    int i, j, k;
+    node_t *n, *n0, **perm;
     edge_t **otheredges;
     nodequeue *q;
+    unsigned int state;
 
+    /* a seeded search starts from the sources, or sinks, in random
+     * order, and visits their neighbors in rotated order
+     */
+    state = MCSeed * 2654435761u;
+    perm = (MCSeed ? shuffled_nlist(g, &state) : NULL);
     q = new_queue(GD_n_nodes(g));
     for (n = GD_nlist(g); n; n = ND_next(n))
 	MARK(n) = FALSE;
@@ -1402,7 +1918,8 @@ void build_ranks(graph_t * g, int pass)
     for (i = GD_minrank(g); i <= GD_maxrank(g); i++)
 	GD_rank(g)[i].n = 0;
 
-    for (n = GD_nlist(g); n; n = ND_next(n)) {
+    for (k = 0, n = (perm ? perm[0] : GD_nlist(g)); n;
+	 n = (perm ? perm[++k] : ND_next(n))) {
 	otheredges = ((pass == 0) ? ND_in(n).list : ND_out(n).list);
 	if (otheredges[0] != NULL)
 	    continue;
@@ -1412,7 +1929,10 @@ void build_ranks(graph_t * g, int pass)
 	    while ((n0 = dequeue(q))) {
 		if (ND_ranktype(n0) != CLUSTER) {
 		    install_in_rank(g, n0);
-		    enqueue_neighbors(q, n0, pass);
+		    if (perm)
+			enqueue_rotated(q, n0, pass, &state);
+		    else
+			enqueue_neighbors(q, n0, pass);
 		} else {
 		    install_cluster(g, n0, pass, q);
 		}
@@ -1432,10 +1952,13 @@ void build_ranks(graph_t * g, int pass)
 		exchange(vlist[j], vlist[n - j]);
 	}
     }
+    if (GD_flags(dot_root(g)) & INCREMENTAL)
+	prior_order(g);
 
     if ((g == dot_root(g)) && ncross(g) > 0)
 	transpose(g, FALSE);
     free_queue(q);
+    free(perm);
 }
 
 void enqueue_neighbors(nodequeue * q, node_t * n0, int pass)
@@ -1492,6 +2015,27 @@ static int postorder(graph_t * g, node_t * v, node_t ** list, int r)
     return cnt;
 }
 
+/* flat_ordered:
+ * Return TRUE if every flat edge of rank r of g already runs left to right.
+ */
+static boolean flat_ordered(graph_t * g, int r)
+{
+    int i, j;
+    node_t *v;
+    edge_t *e;
+
+    for (i = 0; i < GD_rank(g)[r].n; i++) {
+	v = GD_rank(g)[r].v[i];
+	if (ND_flat_out(v).list == NULL)
+	    continue;
+	for (j = 0; (e = ND_flat_out(v).list[j]); j++) {
+	    if ((ND_order(aghead(e)) < ND_order(agtail(e))) != GD_flip(g))
+		return FALSE;
+	}
+    }
+    return TRUE;
+}
+
 static void flat_reorder(graph_t * g)
 {
     int i, j, r, pos, n_search, local_in_cnt, local_out_cnt, base_order;
@@ -1503,6 +2047,8 @@ static void flat_reorder(graph_t * g)
 	return;
     for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
 	if (GD_rank(g)[r].n == 0) continue;
+	/* keep a previous order that needs no change */
+	if (!TOUCHED(r) && flat_ordered(g, r)) continue;
 	base_order = ND_order(GD_rank(g)[r].v[0]);
 	for (i = 0; i < GD_rank(g)[r].n; i++)
 	    MARK(GD_rank(g)[r].v[i]) = FALSE;
@@ -1660,6 +2206,8 @@ static void mincross_step(graph_t * g, int pass)
     }
 
     for (r = first; r != last + dir; r += dir) {
+	if (!TOUCHED(r))
+	    continue;
 	other = r - dir;
 	hasfixed = medians(g, r, other);
 	reorder(g, r, reverse, hasfixed);
@@ -1692,37 +2240,44 @@ static int local_cross(elist l, int dir)
     return cross;
 }
 
+/* rcross:
+ * Count the crossings between ranks r and r+1. The edges are taken in
+ * the order of their tails, and Count holds a Fenwick tree of the
+ * penalties of the edges seen so far, by the order of their heads, so
+ * the penalty of those an edge crosses is a prefix sum away.
+ */
 static int rcross(graph_t * g, int r)
 {
-    static int *Count, C;
-    int top, bot, cross, max, i, k;
+    int top, bot, cross, tot, n, i, k, j;
     node_t **rtop, *v;
 
     cross = 0;
-    max = 0;
+    tot = 0;
     rtop = GD_rank(g)[r].v;
+    n = GD_rank(g)[r + 1].n;
 
     if (C <= GD_rank(Root)[r + 1].n) {
 	C = GD_rank(Root)[r + 1].n + 1;
 	Count = ALLOC(C, Count, int);
     }
 
-    for (i = 0; i < GD_rank(g)[r + 1].n; i++)
+    for (i = 0; i <= n; i++)
 	Count[i] = 0;
 
     for (top = 0; top < GD_rank(g)[r].n; top++) {
 	register edge_t *e;
-	if (max > 0) {
+	if (tot > 0) {
 	    for (i = 0; (e = ND_out(rtop[top]).list[i]); i++) {
-		for (k = ND_order(aghead(e)) + 1; k <= max; k++)
-		    cross += Count[k] * ED_xpenalty(e);
+		k = 0;
+		for (j = ND_order(aghead(e)) + 1; j > 0; j -= j & -j)
+		    k += Count[j];
+		cross += (tot - k) * ED_xpenalty(e);
 	    }
 	}
 	for (i = 0; (e = ND_out(rtop[top]).list[i]); i++) {
-	    register int inv = ND_order(aghead(e));
-	    if (inv > max)
-		max = inv;
-	    Count[inv] += ED_xpenalty(e);
+	    for (j = ND_order(aghead(e)) + 1; j <= n; j += j & -j)
+		Count[j] += ED_xpenalty(e);
+	    tot += ED_xpenalty(e);
 	}
     }
     for (top = 0; top < GD_rank(g)[r].n; top++) {
@@ -1954,14 +2509,32 @@ static void mincross_options(graph_t * g)
 
     /* set default values */
     MinQuit = 8;
-    MaxIter = 24;
+    MaxPass = 24;
     Convergence = .995;
+    MCStarts = 1;
+    MCThreads = 1;
+    MCDeadline = 0;
+    MCSeed = 0;
 
+    gvlock();
     p = agget(g, "mclimit");
     if (p && ((f = atof(p)) > 0.0)) {
 	MinQuit = MAX(1, MinQuit * f);
-	MaxIter = MAX(1, MaxIter * f);
-    }
+	MaxPass = MAX(1, MaxPass * f);
+    }
+    p = agget(g, "mcstarts");
+    if (p && (atoi(p) > 1))
+	MCStarts = atoi(p);
+    p = agget(g, "mctime");
+    if (p && ((f = atof(p)) > 0.0))
+	MCDeadline = wall_sec() + f;
+    /* a component already laid out by a worker gets no more threads */
+    if ((MCStarts > 1) && (dot_root(g) == GD_dotroot(agroot(g))))
+	MCThreads = gvworkers(g);
+    gvunlock();
+    /* the searches would start from other orders than the previous one */
+    if (GD_flags(g) & INCREMENTAL)
+	MCStarts = 1;
 }
 
 #ifdef DEBUG
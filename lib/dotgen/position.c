@@ -24,7 +24,9 @@
 #include "aspect.h"
 
 static int nsiter2(graph_t * g);
-static void create_aux_edges(graph_t * g);
+static int usebk(graph_t * g);
+static void create_aux_edges(graph_t * g, int pairs);
+static void make_edge_pairs(graph_t * g);
 static void remove_aux_edges(graph_t * g);
 static void set_xcoords(graph_t * g);
 static void set_ycoords(graph_t * g);
@@ -119,6 +121,8 @@ connectGraph (graph_t* g)
 
 void dot_position(graph_t * g, aspect_t* asp)
 {
+    int bk;
+
     if (GD_nlist(g) == NULL)
 	return;			/* ignore empty graph */
     mark_lowclusters(g);	/* we could remove from splines.c now */
@@ -128,8 +132,13 @@ void dot_position(graph_t * g, aspect_t* asp)
     expand_leaves(g);
     if (flat_edges(g))
 	set_ycoords(g);
-    create_aux_edges(g);
-    if (rank(g, 2, nsiter2(g))) { /* LR balance == 2 */
+    bk = usebk(g);
+    create_aux_edges(g, !bk);
+    if (bk && bk_xcoords(g)) {
+	make_edge_pairs(g);	/* fall back to network simplex */
+	bk = FALSE;
+    }
+    if (!bk && rank(g, 2, nsiter2(g))) { /* LR balance == 2 */
 	connectGraph (g);
 	assert(rank(g, 2, nsiter2(g)) == 0);
     }
@@ -145,11 +154,28 @@ static int nsiter2(graph_t * g)
     int maxiter = INT_MAX;
     char *s;
 
-    if ((s = agget(g, "nslimit")))
+    gvlock();
+    s = agget(g, "nslimit");
+    gvunlock();
+    if (s)
 	maxiter = atof(s) * agnnodes(g);
     return maxiter;
 }
 
+/* usebk:
+ * Return true if g asks for the x coordinates of Brandes and Koepf
+ * rather than those of network simplex.
+ */
+static int usebk(graph_t * g)
+{
+    char *s;
+
+    gvlock();
+    s = agget(g, "xmethod");
+    gvunlock();
+    return (s && streq(s, "bk"));
+}
+
 static int go(node_t * u, node_t * v)
 {
     int i;
@@ -537,11 +563,12 @@ static void compress_graph(graph_t * g)
     make_aux_edge(GD_ln(g), GD_rn(g), x, 1000);
 }
 
-static void create_aux_edges(graph_t * g)
+static void create_aux_edges(graph_t * g, int pairs)
 {
     allocate_aux_edges(g);
     make_LR_constraints(g);
-    make_edge_pairs(g);
+    if (pairs)
+	make_edge_pairs(g);
     pos_clusters(g);
     compress_graph(g);
 }
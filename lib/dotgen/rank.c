@@ -393,7 +393,10 @@ void rank1(graph_t * g)
 	maxiter = atof(s) * agnnodes(g);
     for (c = 0; c < GD_comp(g).size; c++) {
 	GD_nlist(g) = GD_comp(g).list[c];
-	rank(g, (GD_n_cluster(g) == 0 ? 1 : 0), maxiter);	/* TB balance */
+	if (GD_flags(dot_root(g)) & INCREMENTAL)
+	    prior_rank(g, (GD_n_cluster(g) == 0 ? 1 : 0), maxiter);
+	else
+	    rank(g, (GD_n_cluster(g) == 0 ? 1 : 0), maxiter);	/* TB balance */
     }
 }
 
@@ -1004,36 +1007,49 @@ static void reverse_edge2(graph_t * g, edge_t * e)
     agdelete(g, e);
 }
 
-static void dfs(graph_t * g, node_t * v)
+/* The marks of the depth-first search that breaks cycles in the
+ * constraint graph are kept in a side table, indexed by the dense
+ * node numbers the graph is opened with.
+ */
+typedef struct {
+    boolean mark, onstack;
+} cyclemark_t;
+
+static void dfs(graph_t * g, node_t * v, cyclemark_t * marks)
 {
     edge_t *e, *f;
     node_t *w;
+    cyclemark_t *mv = &marks[agnodeindex(v)], *mw;
 
-    if (ND_mark(v))
+    if (mv->mark)
 	return;
-    ND_mark(v) = TRUE;
-    ND_onstack(v) = TRUE;
+    mv->mark = TRUE;
+    mv->onstack = TRUE;
     for (e = agfstout(g, v); e; e = f) {
 	f = agnxtout(g, e);
 	w = aghead(e);
-	if (ND_onstack(w))
+	mw = &marks[agnodeindex(w)];
+	if (mw->onstack)
 	    reverse_edge2(g, e);
 	else {
-	    if (ND_mark(w) == FALSE)
-		dfs(g, w);
+	    if (mw->mark == FALSE)
+		dfs(g, w, marks);
 	}
     }
-    ND_onstack(v) = FALSE;
+    mv->onstack = FALSE;
 }
 
 static void break_cycles(graph_t * g)
 {
     node_t *n;
+    Agsidetab_t *tab;
+    cyclemark_t *marks;
 
+    tab = agsidetab(g, AGNODE, sizeof(cyclemark_t));
+    marks = agsidearray(tab);
     for (n = agfstnode(g); n; n = agnxtnode(g, n))
-	ND_mark(n) = ND_onstack(n) = FALSE;
-    for (n = agfstnode(g); n; n = agnxtnode(g, n))
-	dfs(g, n);
+	dfs(g, n, marks);
+    agsidetabfree(tab);
 }
 /* setMinMax:
  * This will only be called with the root graph or a cluster
@@ -1198,9 +1214,12 @@ void dot2_rank(graph_t * g, aspect_t* asp)
     int ncc, maxiter = INT_MAX;
     char *s;
     graph_t *Xg;
+    Agdisc_t Xdisc;
 
     Last_node = NULL;
-    Xg = agopen("level assignment constraints", Agstrictdirected, 0);
+    Xdisc = AgDefaultDisc;
+    Xdisc.id = &AgDenseIdDisc;
+    Xg = agopen("level assignment constraints", Agstrictdirected, &Xdisc);
     agbindrec(Xg,"level graph rec",sizeof(Agraphinfo_t),TRUE);
     agpushdisc(Xg,&mydisc,infosizes);
 
@@ -1228,7 +1247,12 @@ void dot2_rank(graph_t * g, aspect_t* asp)
 	ssize = atoi(s);
     else
 	ssize = -1;
+    /* Xg shares the time budget of g */
+    GD_gvc(Xg) = GD_gvc(agroot(g));
+    GD_deadline(Xg) = GD_deadline(agroot(g));
+    GD_timedout(Xg) = GD_timedout(agroot(g));
     rank2(Xg, 1, maxiter, ssize);
+    GD_timedout(agroot(g)) = GD_timedout(Xg);
 /* fastgr(Xg); */
     readout_levels(g, Xg, ncc);
 #ifdef DEBUG
@@ -66,6 +66,11 @@ extern int gvLayout(GVC_t *gvc, graph_t *g, const char *engine);
 /* Compute a layout using layout engine from command line args */
 extern int gvLayoutJobs(GVC_t *gvc, graph_t *g);
 
+/* Have layouts poll cancel(data), from any of their threads; once it
+ * returns non-zero, they finish quickly with what they have, as when
+ * the graph's maxtime runs out. NULL stops polling. */
+extern void gvSetLayoutCancel(GVC_t *gvc, int (*cancel)(void *data), void *data);
+
 /* Render layout into string attributes of the graph */
 extern void attach_attrs(graph_t *g);
 
@@ -91,6 +91,10 @@ extern "C" {
         /* externally provided write() displine */
 	size_t (*write_fn) (GVJ_t *job, const char *s, size_t len);
 
+	/* polled by layouts, see gvSetLayoutCancel() */
+	int (*cancel_fn) (void *data);
+	void *cancel_data;
+
 	/* fonts and textlayout */
 	Dtdisc_t textfont_disc;
 	Dt_t *textfont_dt;
@@ -24,11 +24,15 @@
 #include "cgraph.h"
 #include "gvcproc.h"
 #include "gvc.h"
+#include "memory.h"
 
 extern void graph_init(Agraph_t *g, boolean use_rankdir);
 extern void graph_cleanup(Agraph_t *g);
 extern void gv_fixLocale (int set);
 extern void gv_initShapes (void);
+extern void gv_memreport(Agraph_t *g, char *phase);
+extern double late_double(void *obj, Agsym_t *attr, double def, double low);
+extern double wall_sec(void);
 
 int gvlayout_select(GVC_t * gvc, const char *layout)
 {
@@ -57,6 +61,7 @@ int gvLayoutJobs(GVC_t * gvc, Agraph_t * g)
     gvlayout_engine_t *gvle;
     char *p;
     int rc;
+    double maxtime;
 
     agbindrec(g, "Agraphinfo_t", sizeof(Agraphinfo_t), TRUE);
     GD_gvc(g) = gvc;
@@ -78,7 +83,13 @@ int gvLayoutJobs(GVC_t * gvc, Agraph_t * g)
 	return -1;
 
     gv_fixLocale (1);
+    gvmemphase(GVMEM_LAYOUT);
+    if (gvc->common.verbose)
+	gvmemcount(NULL, TRUE);
     graph_init(g, gvc->layout.features->flags & LAYOUT_USES_RANKDIR);
+    maxtime = late_double(g, agfindgraphattr(g, "maxtime"), 0.0, 0.0);
+    GD_deadline(agroot(g)) = (maxtime > 0) ? wall_sec() + maxtime : 0;
+    GD_timedout(agroot(g)) = FALSE;
     GD_drawing(agroot(g)) = GD_drawing(g);
     gv_initShapes ();
     if (gvle && gvle->layout) {
@@ -88,10 +99,21 @@ int gvLayoutJobs(GVC_t * gvc, Agraph_t * g)
 	if (gvle->cleanup)
 	    GD_cleanup(g) = gvle->cleanup;
     }
+    if (gvc->common.verbose)
+	gv_memreport(g, "gvLayoutJobs");
     gv_fixLocale (0);
     return 0;
 }
 
+/* gvSetLayoutCancel:
+ * Set the function layouts poll to learn if they should stop early.
+ */
+void gvSetLayoutCancel(GVC_t * gvc, int (*cancel)(void *data), void *data)
+{
+    gvc->cancel_fn = cancel;
+    gvc->cancel_data = data;
+}
+
 /* gvFreeLayout:
  * Free layout resources.
  * First, if the graph has a layout-specific cleanup function attached,
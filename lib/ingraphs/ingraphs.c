@@ -16,8 +16,16 @@
  * Written by Emden Gansner
  */
 
+#include "config.h"
+
 #include <stdio.h>
 #include <stdlib.h>
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
 
 #define FREE_STATE 1
 
@@ -26,6 +34,7 @@ typedef struct {
 } Agraph_t;
 
 extern void agsetfile(char *);
+extern int agreseterrors(void);
 
 #include "ingraphs.h"
 
@@ -60,19 +69,13 @@ static void nextFile(ingraph_state * sp)
     sp->fp = rv;
 }
 
-/* nextGraph:
- * Read and return next graph; return NULL if done.
+/* readGraph:
  * Read graph from currently open file. If none, open next file.
  */
-Agraph_t *nextGraph(ingraph_state * sp)
+static Agraph_t *readGraph(ingraph_state * sp)
 {
     Agraph_t *g;
 
-    if (sp->ingraphs) {
-	g = (Agraph_t*)(sp->u.Graphs[sp->ctr]);
-	if (g) sp->ctr++;
-	return g;
-    }
     if (sp->fp == NULL)
 	nextFile(sp);
     g = NULL;
@@ -87,6 +90,196 @@ Agraph_t *nextGraph(ingraph_state * sp)
     return g;
 }
 
+#ifdef HAVE_PTHREAD
+/* Prefetching
+ * A reader thread opens the files and parses graphs ahead of the
+ * caller, holding up to qsize of them in a ring. The reader works on a
+ * copy of the state, and each graph is queued with the file counter and
+ * error count as they were after it was read, so that fileName and
+ * errors describe the last graph returned, as they do without
+ * prefetching. The end of input is queued as a NULL graph.
+ */
+typedef struct {
+    Agraph_t *g;
+    int ctr;
+    int errors;
+} pfitem;
+
+typedef struct {
+    ingraph_state rd;		/* state used by the reader */
+    pfitem *q;
+    int qsize;
+    int head;
+    int cnt;
+    int stop;			/* set when the reader should quit */
+    closegfn closef;
+    pthread_t tid;
+    pthread_mutex_t lock;
+    pthread_cond_t notempty;
+    pthread_cond_t notfull;
+} prefetch_t;
+
+static void *reader(void *arg)
+{
+    prefetch_t *pf = (prefetch_t *) arg;
+    Agraph_t *g;
+    pfitem *it;
+
+    do {
+	g = readGraph(&pf->rd);
+	/* Parse errors are recorded per thread, so the caller cannot
+	 * see them with agerrors; count them with the input errors.
+	 */
+	if (agreseterrors())
+	    pf->rd.errors++;
+	pthread_mutex_lock(&pf->lock);
+	while (pf->cnt == pf->qsize && !pf->stop)
+	    pthread_cond_wait(&pf->notfull, &pf->lock);
+	if (pf->stop) {
+	    pthread_mutex_unlock(&pf->lock);
+	    if (g && pf->closef)
+		pf->closef(g);
+	    break;
+	}
+	it = pf->q + (pf->head + pf->cnt) % pf->qsize;
+	it->g = g;
+	it->ctr = pf->rd.ctr;
+	it->errors = pf->rd.errors;
+	pf->cnt++;
+	pthread_cond_signal(&pf->notempty);
+	pthread_mutex_unlock(&pf->lock);
+    } while (g);
+    return NULL;
+}
+
+/* nextPrefetched:
+ * Return the next queued graph, waiting for the reader if necessary.
+ * The final NULL is left in the queue, so later calls also return NULL.
+ */
+static Agraph_t *nextPrefetched(ingraph_state * sp)
+{
+    prefetch_t *pf = (prefetch_t *) sp->pf;
+    pfitem it;
+
+    pthread_mutex_lock(&pf->lock);
+    while (pf->cnt == 0)
+	pthread_cond_wait(&pf->notempty, &pf->lock);
+    it = pf->q[pf->head];
+    if (it.g) {
+	pf->head = (pf->head + 1) % pf->qsize;
+	pf->cnt--;
+	pthread_cond_signal(&pf->notfull);
+    }
+    pthread_mutex_unlock(&pf->lock);
+    sp->ctr = it.ctr;
+    sp->errors = it.errors;
+    return it.g;
+}
+
+/* stopPrefetch:
+ * Stop the reader, waiting for it to finish the graph it is reading,
+ * and release the graphs that were read but not returned.
+ */
+static void stopPrefetch(ingraph_state * sp)
+{
+    prefetch_t *pf = (prefetch_t *) sp->pf;
+    int i;
+
+    pthread_mutex_lock(&pf->lock);
+    pf->stop = 1;
+    pthread_cond_signal(&pf->notfull);
+    pthread_mutex_unlock(&pf->lock);
+    pthread_join(pf->tid, NULL);
+
+    for (i = 0; i < pf->cnt; i++) {
+	Agraph_t *g = pf->q[(pf->head + i) % pf->qsize].g;
+	if (g && pf->closef)
+	    pf->closef(g);
+    }
+    if (pf->rd.u.Files && pf->rd.fp)
+	pf->rd.fns->closef(pf->rd.fp);
+    pthread_cond_destroy(&pf->notfull);
+    pthread_cond_destroy(&pf->notempty);
+    pthread_mutex_destroy(&pf->lock);
+    free(pf->q);
+    free(pf);
+    sp->pf = NULL;
+}
+#endif
+
+/* ingPrefetch:
+ * Read up to n graphs ahead on a separate thread, so that parsing
+ * overlaps with whatever the caller does with the previous graph.
+ * Graphs are still returned in input order. If closef is non-NULL, it
+ * is used to free graphs read ahead but not returned when the state is
+ * closed early. This must be called before the first call to nextGraph,
+ * and the readf function must be safe to run on another thread while
+ * the caller works on other graphs; for cgraph, this means no changes
+ * to the default attributes of new graphs. Parse errors on the reader
+ * thread are counted in errors, as they are not visible to agerrors.
+ * Return 0 on success; -1 if prefetching is not possible, or would not
+ * help because there is a single processor, in which case graphs are
+ * read as before.
+ */
+int ingPrefetch(ingraph_state * sp, int n, closegfn closef)
+{
+#ifdef HAVE_PTHREAD
+    prefetch_t *pf;
+
+    if (sp->ingraphs || sp->pf || sp->ctr || sp->fp || n <= 0)
+	return -1;
+#ifdef _SC_NPROCESSORS_ONLN
+    if (sysconf(_SC_NPROCESSORS_ONLN) < 2)
+	return -1;
+#endif
+    if (!(pf = (prefetch_t *) calloc(1, sizeof(prefetch_t))))
+	return -1;
+    if (!(pf->q = (pfitem *) calloc(n + 1, sizeof(pfitem)))) {
+	free(pf);
+	return -1;
+    }
+    /* one more slot than asked for, for the final NULL */
+    pf->qsize = n + 1;
+    pf->closef = closef;
+    pf->rd = *sp;
+    pf->rd.heap = 0;
+    pthread_mutex_init(&pf->lock, NULL);
+    pthread_cond_init(&pf->notempty, NULL);
+    pthread_cond_init(&pf->notfull, NULL);
+    if (pthread_create(&pf->tid, NULL, reader, pf)) {
+	pthread_cond_destroy(&pf->notfull);
+	pthread_cond_destroy(&pf->notempty);
+	pthread_mutex_destroy(&pf->lock);
+	free(pf->q);
+	free(pf);
+	return -1;
+    }
+    sp->pf = pf;
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+/* nextGraph:
+ * Read and return next graph; return NULL if done.
+ */
+Agraph_t *nextGraph(ingraph_state * sp)
+{
+    Agraph_t *g;
+
+    if (sp->ingraphs) {
+	g = (Agraph_t*)(sp->u.Graphs[sp->ctr]);
+	if (g) sp->ctr++;
+	return g;
+    }
+#ifdef HAVE_PTHREAD
+    if (sp->pf)
+	return nextPrefetched(sp);
+#endif
+    return readGraph(sp);
+}
+
 /* new_ing:
  * Create new ingraph state. If sp is non-NULL, we
  * assume user is supplying memory.
@@ -114,6 +307,7 @@ new_ing(ingraph_state * sp, char **files, Agraph_t** graphs, ingdisc * disc)
     sp->ctr = 0;
     sp->errors = 0;
     sp->fp = NULL;
+    sp->pf = NULL;
     sp->fns = (ingdisc *) malloc(sizeof(ingdisc));
     if (!sp->fns) {
 	fprintf(stderr, "ingraphs: out of memory\n");
@@ -185,6 +379,10 @@ ingraph_state *newIngraph(ingraph_state * sp, char **files, opengfn opf)
  */
 void closeIngraph(ingraph_state * sp)
 {
+#ifdef HAVE_PTHREAD
+    if (sp->pf)
+	stopPrefetch(sp);
+#endif
     if (!sp->ingraphs && sp->u.Files && sp->fp)
 	sp->fns->closef(sp->fp);
     free(sp->fns);
@@ -214,5 +412,3 @@ char *fileName(ingraph_state * sp)
     } else
 	return "<stdin>";
 }
-
-#include "config.h"
@@ -27,6 +27,7 @@ extern "C" {
 #endif
 
     typedef Agraph_t *(*opengfn) (FILE *);
+    typedef int (*closegfn) (Agraph_t *);
 
     typedef struct {
 	void *(*openf) (char *);
@@ -46,11 +47,13 @@ extern "C" {
 	ingdisc *fns;
 	char heap;
 	int errors;
+	void *pf;		/* prefetch state, if any */
     } ingraph_state;
 
     extern ingraph_state *newIngraph(ingraph_state *, char **, opengfn);
     extern ingraph_state *newIng(ingraph_state *, char **, ingdisc *);
     extern ingraph_state *newIngGraphs(ingraph_state *, Agraph_t**, ingdisc *);
+    extern int ingPrefetch(ingraph_state *, int, closegfn);
     extern void closeIngraph(ingraph_state * sp);
     extern Agraph_t *nextGraph(ingraph_state *);
     extern char *fileName(ingraph_state *);
@@ -58,16 +58,21 @@ int user_pos(attrsym_t * posptr, attrsym_t * pinptr, node_t * np, int nG)
 {
     double *pvec;
     char *p, c;
-    double z;
+    double z, pt[3];
+    char next[3];
+    int cnt;
 
     if (posptr == NULL)
 	return FALSE;
     pvec = ND_pos(np);
     p = agxget(np, posptr);
     if (p[0]) {
-	c = '\0';
-	if ((Ndim >= 3) && 
-            (sscanf(p, "%lf,%lf,%lf%c", pvec, pvec+1, pvec+2, &c) >= 3)){
+	cnt = agxgetpoint(np, posptr, pt, next);
+	if ((Ndim >= 3) && (cnt >= 3)) {
+	    pvec[0] = pt[0];
+	    pvec[1] = pt[1];
+	    pvec[2] = pt[2];
+	    c = next[2];
 	    ND_pinned(np) = P_SET;
 	    if (PSinputscale > 0.0) {
 		int i;
@@ -76,11 +81,14 @@ int user_pos(attrsym_t * posptr, attrsym_t * pinptr, node_t * np, int nG)
 	    }
 	    if (Ndim > 3)
 		jitter_d(np, nG, 3);
-	    if ((c == '!') || (pinptr && mapbool(agxget(np, pinptr))))
+	    if ((c == '!') || (pinptr && agxgetbool(np, pinptr, FALSE)))
 		ND_pinned(np) = P_PIN;
 	    return TRUE;
 	}
-	else if (sscanf(p, "%lf,%lf%c", pvec, pvec + 1, &c) >= 2) {
+	else if (cnt >= 2) {
+	    pvec[0] = pt[0];
+	    pvec[1] = pt[1];
+	    c = next[1];
 	    ND_pinned(np) = P_SET;
 	    if (PSinputscale > 0.0) {
 		int i;
@@ -88,7 +96,7 @@ int user_pos(attrsym_t * posptr, attrsym_t * pinptr, node_t * np, int nG)
 		    pvec[i] = pvec[i] / PSinputscale;
 	    }
 	    if (Ndim > 2) {
-		if (N_z && (p = agxget(np, N_z)) && (sscanf(p,"%lf",&z) == 1)) { 
+		if (N_z && agxgetdouble(np, N_z, &z)) { 
 		    if (PSinputscale > 0.0) {
 			pvec[2] = z / PSinputscale;
 		    }
@@ -99,7 +107,7 @@ int user_pos(attrsym_t * posptr, attrsym_t * pinptr, node_t * np, int nG)
 		else
 		    jitter3d(np, nG);
 	    }
-	    if ((c == '!') || (pinptr && mapbool(agxget(np, pinptr))))
+	    if ((c == '!') || (pinptr && agxgetbool(np, pinptr, FALSE)))
 		ND_pinned(np) = P_PIN;
 	    return TRUE;
 	} else
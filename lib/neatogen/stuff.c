@@ -117,7 +117,7 @@ static int lenattr(edge_t* e, Agsym_t* index, double* val)
     s = agxget(e, index);
     if (*s == '\0') return 1;
 
-    if ((sscanf(s, "%lf", val) < 1) || (*val < 0) || ((*val == 0) && !Nop)) {
+    if (!agxgetdouble(e, index, val) || (*val < 0) || ((*val == 0) && !Nop)) {
 	agerr(AGWARN, "bad edge len \"%s\"", s);
 	return 2;
     }
@@ -44,6 +44,9 @@ extern "C" {
 /* function to convert a polyline into a spline representation */
     extern void make_polyline(Ppolyline_t line, Ppolyline_t* sline);
 
+/* free the work space the functions above keep in the calling thread */
+    extern void Pfreespace(void);
+
 #undef extern
 
 #ifdef __cplusplus
@@ -38,6 +38,17 @@ extern "C" {
 #endif
 #endif
 /*end visual studio*/
+	/* storage class for work space that each thread keeps for itself */
+#ifndef GVTLS
+#if defined(_MSC_VER)
+#define GVTLS __declspec(thread)
+#elif defined(__GNUC__) || defined(__SUNPRO_C) || defined(__INTEL_COMPILER)
+#define GVTLS __thread
+#else
+#define GVTLS _Thread_local
+#endif
+#endif
+
 	typedef double COORD;
     extern COORD area2(Ppoint_t, Ppoint_t, Ppoint_t);
     extern int wind(Ppoint_t a, Ppoint_t b, Ppoint_t c);
@@ -47,6 +58,8 @@ extern "C" {
     int in_poly(Ppoly_t argpoly, Ppoint_t q);
     Ppoly_t copypoly(Ppoly_t);
     void freepoly(Ppoly_t);
+    void freeshortest(void);
+    void freeroute(void);
 
 #undef extern
 #ifdef __cplusplus
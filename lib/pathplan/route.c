@@ -58,7 +58,7 @@ typedef struct elist_t {
     struct elist_t *next, *prev;
 } elist_t;
 
-static jmp_buf jbuf;
+static GVTLS jmp_buf jbuf;
 
 #if 0
 static p2e_t *p2es;
@@ -69,8 +69,11 @@ static int p2en;
 static elist_t *elist;
 #endif
 
-static Ppoint_t *ops;
-static int opn, opl;
+static GVTLS Ppoint_t *ops;
+static GVTLS int opn, opl;
+
+static GVTLS tna_t *tnas;
+static GVTLS int tnan;
 
 static int reallyroutespline(Pedge_t *, int,
 			     Ppoint_t *, int, Ppoint_t, Ppoint_t);
@@ -195,6 +198,17 @@ int Proutespline(Pedge_t * edges, int edgen, Ppolyline_t input,
     return 0;
 }
 
+/* freeroute:
+ * Free the work space of Proutespline in the calling thread.
+ */
+void freeroute(void)
+{
+    free(ops);
+    ops = NULL, opn = 0;
+    free(tnas);
+    tnas = NULL, tnan = 0;
+}
+
 static int reallyroutespline(Pedge_t * edges, int edgen,
 			     Ppoint_t * inps, int inpn, Ppoint_t ev0,
 			     Ppoint_t ev1)
@@ -204,9 +218,6 @@ static int reallyroutespline(Pedge_t * edges, int edgen,
     double maxd, d, t;
     int maxi, i, spliti;
 
-    static tna_t *tnas;
-    static int tnan;
-
     if (tnan < inpn) {
 	if (!tnas) {
 	    if (!(tnas = malloc(sizeof(tna_t) * inpn)))
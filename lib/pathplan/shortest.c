@@ -70,17 +70,17 @@ typedef struct deque_t {
     int pnlpn, fpnlpi, lpnlpi, apex;
 } deque_t;
 
-static jmp_buf jbuf;
-static pointnlink_t *pnls, **pnlps;
-static int pnln, pnll;
+static GVTLS jmp_buf jbuf;
+static GVTLS pointnlink_t *pnls, **pnlps;
+static GVTLS int pnln, pnll;
 
-static triangle_t *tris;
-static int trin, tril;
+static GVTLS triangle_t *tris;
+static GVTLS int trin, tril;
 
-static deque_t dq;
+static GVTLS deque_t dq;
 
-static Ppoint_t *ops;
-static int opn;
+static GVTLS Ppoint_t *ops;
+static GVTLS int opn;
 
 static void triangulate(pointnlink_t **, int);
 static int isdiagonal(int, int, pointnlink_t **, int);
@@ -301,6 +301,22 @@ int Pshortestpath(Ppoly_t * polyp, Ppoint_t * eps, Ppolyline_t * output)
     return 0;
 }
 
+/* freeshortest:
+ * Free the work space of Pshortestpath in the calling thread.
+ */
+void freeshortest(void)
+{
+    free(pnls);
+    free(pnlps);
+    pnls = NULL, pnlps = NULL, pnln = 0;
+    free(tris);
+    tris = NULL, trin = 0;
+    free(dq.pnlps);
+    dq.pnlps = NULL, dq.pnlpn = 0;
+    free(ops);
+    ops = NULL, opn = 0;
+}
+
 /* triangulate polygon */
 static void triangulate(pointnlink_t ** pnlps, int pnln)
 {
@@ -76,13 +76,14 @@ int Ppolybarriers(Ppoly_t ** polys, int npolys, Pedge_t ** barriers,
     return 1;
 }
 
+static GVTLS int isz = 0;
+static GVTLS Ppoint_t* ispline = 0;
+
 /* make_polyline:
  */
 void
 make_polyline(Ppolyline_t line, Ppolyline_t* sline)
 {
-    static int isz = 0;
-    static Ppoint_t* ispline = 0;
     int i, j;
     int npts = 4 + 3*(line.pn-2);
 
@@ -105,3 +106,15 @@ make_polyline(Ppolyline_t line, Ppolyline_t* sline)
     sline->ps = ispline;
 }
 
+/* Pfreespace:
+ * Free the work space that Pshortestpath, Proutespline and make_polyline
+ * keep between calls in the calling thread, as a thread should before
+ * it finishes. The functions allocate it again as they need it.
+ */
+void Pfreespace(void)
+{
+    freeshortest();
+    freeroute();
+    free(ispline);
+    ispline = 0, isz = 0;
+}
@@ -136,12 +136,12 @@ SparseMatrix_import_dot (Agraph_t* g, int dim, real **label_sizes, real **x, int
 {
   SparseMatrix A = 0;
   Agnode_t* n;
-  Agedge_t* e;
-  Agsym_t *sym, *symD = NULL;
+  Agcsr_t *csr;
+  Agsym_t *symD = NULL;
   Agsym_t *psym;
   int nnodes;
   int nedges;
-  int i, row;
+  int i, k, row;
   int* I;
   int* J;
   real *val, *valD = NULL;
@@ -191,30 +191,25 @@ SparseMatrix_import_dot (Agraph_t* g, int dim, real **label_sizes, real **x, int
     val = N_NEW(nedges, real);
   }
 
-  sym = agattr(g, AGEDGE, "weight", NULL);
+  csr = agcsr(g, "weight", 1);
   if (D) {
     symD = agattr(g, AGEDGE, "len", NULL);
     valD = N_NEW(nedges, real);
   }
   i = 0;
-  for (n = agfstnode (g); n; n = agnxtnode (g, n)) {
+  for (row = 0; row < csr->nnodes; row++) {
+    n = csr->node[row];
     if (edge_label_nodes && strncmp(agnameof(n), "|edgelabel|",11)==0) nedge_nodes++;
-    row = ND_id(n);
-    for (e = agfstout (g, n); e; e = agnxtout (g, e)) {
+    for (k = csr->out[row]; k < csr->out[row+1]; k++) {
       I[i] = row;
-      J[i] = ND_id(aghead(e));
+      J[i] = csr->out_adj[k];
 
       /* edge weight */
-      if (sym) {
-        if (sscanf (agxget(e,sym), "%lf", &v) != 1) v = 1;
-      } else {
-        v = 1;
-      }
-      val[i] = v;
+      val[i] = csr->out_wt ? csr->out_wt[k] : 1;
 
       /* edge length */
       if (symD) {
-        if (sscanf (agxget (e, symD), "%lf", &v) != 1) {
+        if (sscanf (agxget (csr->out_edge[k], symD), "%lf", &v) != 1) {
           v = 72;
         } else {
           v *= 72;/* len is specified in inch. Convert to points */
@@ -227,6 +222,7 @@ SparseMatrix_import_dot (Agraph_t* g, int dim, real **label_sizes, real **x, int
       i++;
     }
   }
+  agcsrfree(csr);
   
   if (edge_label_nodes) {
     *edge_label_nodes = MALLOC(sizeof(int)*nedge_nodes);
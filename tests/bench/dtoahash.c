@@ -0,0 +1,129 @@
+/* Microbenchmarks for cdt
+ * Time the ordered set, the chained hash and the open hash on
+ * insertions, successful and failed searches and deletions, and the
+ * two string hashes. Only the timings are reported; the checks are in
+ * tests/unit_tests/lib/cdt.
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cdt.h"
+
+/* an object keyed by an int, with its own link */
+typedef struct {
+    Dtlink_t link;
+    int key;
+} ient_t;
+
+static Dtdisc_t IntDisc = {
+    offsetof(ient_t, key),
+    sizeof(int),
+    offsetof(ient_t, link),
+    NULL, NULL, NULL, NULL, NULL, NULL
+};
+
+/* strings held by the dictionary */
+static Dtdisc_t StrDisc = {
+    0, 0, -1,
+    NULL, NULL, NULL, NULL, NULL, NULL
+};
+
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static void bench_ints(const char *name, Dtmethod_t * meth, int n)
+{
+    ient_t *ents = calloc(n, sizeof(ient_t));
+    Dt_t *d = dtopen(&IntDisc, meth);
+    double t0, t1, t2, t3;
+    int i, k, found = 0;
+
+    for (i = 0; i < n; i++)
+	ents[i].key = (int) (((unsigned) i * 2654435761u) >> 1);
+    t0 = now();
+    for (i = 0; i < n; i++)
+	dtinsert(d, &ents[i]);
+    t1 = now();
+    for (i = 0; i < n; i++) {
+	found += (dtmatch(d, &ents[i].key) != NULL);
+	k = ents[i].key + 1;
+	found += (dtmatch(d, &k) != NULL);
+    }
+    t2 = now();
+    for (i = 0; i < n; i++)
+	dtdelete(d, &ents[i]);
+    t3 = now();
+    printf("%-8s int keys x%d: insert %.3fs, search %.3fs, "
+	   "delete %.3fs (%d found)\n", name, n, t1 - t0, t2 - t1,
+		t3 - t2, found);
+    dtclose(d);
+    free(ents);
+}
+
+static void bench_strs(const char *name, Dtmethod_t * meth, char **keys,
+		       int n)
+{
+    Dt_t *d = dtopen(&StrDisc, meth);
+    double t0, t1, t2;
+    int i, r, found = 0;
+
+    t0 = now();
+    for (i = 0; i < n; i++)
+	dtinsert(d, keys[i]);
+    t1 = now();
+    for (r = 0; r < 4; r++)
+	for (i = 0; i < n; i++)
+	    found += (dtmatch(d, keys[(i * 7919) % n]) != NULL);
+    t2 = now();
+    printf("%-8s string keys x%d: insert %.3fs, "
+	   "4 scattered searches %.3fs (%d found)\n", name, n, t1 - t0,
+	   t2 - t1, found);
+    dtclose(d);
+}
+
+int main(void)
+{
+    enum { N = 200000 };
+    char **keys = malloc(N * sizeof(char *));
+    char buf[64];
+    double t0, t1, t2;
+    unsigned int h = 0;
+    int i, r;
+
+    bench_ints("Dtoset", Dtoset, N);
+    bench_ints("Dtset", Dtset, N);
+    bench_ints("Dtoahash", Dtoahash, N);
+
+    for (i = 0; i < N; i++) {
+	sprintf(buf, "node_%d_in_some_cluster", i * 37);
+	keys[i] = strdup(buf);
+    }
+    bench_strs("Dtoset", Dtoset, keys, N);
+    bench_strs("Dtset", Dtset, keys, N);
+    bench_strs("Dtoahash", Dtoahash, keys, N);
+
+    t0 = now();
+    for (r = 0; r < 10; r++)
+	for (i = 0; i < N; i++)
+	    h += dtstrhash(0, keys[i], 0);
+    t1 = now();
+    for (r = 0; r < 10; r++)
+	for (i = 0; i < N; i++)
+	    h += dtwordhash(0, keys[i], 0);
+    t2 = now();
+    printf("hashing %d strings: dtstrhash %.3fs, dtwordhash %.3fs "
+	   "(%u)\n", 10 * N, t1 - t0, t2 - t1, h);
+
+    for (i = 0; i < N; i++)
+	free(keys[i]);
+    free(keys);
+    return 0;
+}
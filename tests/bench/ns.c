@@ -0,0 +1,153 @@
+/* Benchmark for network simplex
+ * Time the solver on large generated DAGs and on the larger graphs
+ * shipped in graphs/directed. Only the timings are reported; the checks
+ * are in tests/unit_tests/lib/common.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "config.h"
+#include "render.h"
+#include "ns.h"
+
+/* a small deterministic generator, so runs can be compared */
+static unsigned int rnd(unsigned int *seed)
+{
+    *seed = *seed * 1103515245 + 12345;
+    return (*seed >> 8) & 0xffffff;
+}
+
+/* a connected DAG with n nodes and about (1 + extra) * n edges;
+ * edges go from lower to higher numbered nodes
+ */
+static nsgraph_t *gendag(int n, int extra, unsigned int seed)
+{
+    int ne = (n - 1) + extra * n;
+    nsgraph_t *ns = ns_open(n, ne);
+    int e, a, b;
+
+    for (e = 0; e < n - 1; e++) {
+	ns->tail[e] = rnd(&seed) % (e + 1);
+	ns->head[e] = e + 1;
+    }
+    for (; e < ne; e++) {
+	a = rnd(&seed) % n;
+	b = rnd(&seed) % n;
+	if (a == b)
+	    b = (a + 1) % n;
+	ns->tail[e] = MIN(a, b);
+	ns->head[e] = MAX(a, b);
+    }
+    for (e = 0; e < ne; e++) {
+	ns->minlen[e] = rnd(&seed) % 3;
+	ns->weight[e] = 1 + rnd(&seed) % 5;
+    }
+    for (a = 0; a < n; a++)
+	ns->normal[a] = 1;
+    ns_adjacency(ns);
+    return ns;
+}
+
+/* a DAG with the nodes and edges of the graph in file name, keeping
+ * the edges that go forward in node order, and a root with a slack
+ * edge to every node so that it is connected
+ */
+static nsgraph_t *readdag(const char *name)
+{
+    char path[1024];
+    Agraph_t *g;
+    Agnode_t *n;
+    Agedge_t *e;
+    nsgraph_t *ns;
+    FILE *fp;
+    int ne;
+
+    snprintf(path, sizeof(path), "%s/directed/%s", GRAPHS_DIR, name);
+    if (!(fp = fopen(path, "r")))
+	return NULL;
+    g = agread(fp, NULL);
+    fclose(fp);
+    if (!g)
+	return NULL;
+    ne = 0;
+    for (n = agfstnode(g); n; n = agnxtnode(g, n))
+	for (e = agfstout(g, n); e; e = agnxtout(g, e))
+	    if (AGSEQ(agtail(e)) < AGSEQ(aghead(e)))
+		ne++;
+    ns = ns_open(agnnodes(g) + 1, ne + agnnodes(g));
+    ne = 0;
+    for (n = agfstnode(g); n; n = agnxtnode(g, n))
+	for (e = agfstout(g, n); e; e = agnxtout(g, e))
+	    if (AGSEQ(agtail(e)) < AGSEQ(aghead(e))) {
+		ns->tail[ne] = AGSEQ(agtail(e)) - 1;
+		ns->head[ne] = AGSEQ(aghead(e)) - 1;
+		ns->minlen[ne] = ns->weight[ne] = 1;
+		ne++;
+	    }
+    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	ns->tail[ne] = agnnodes(g);
+	ns->head[ne] = AGSEQ(n) - 1;
+	ns->minlen[ne] = ns->weight[ne] = 0;
+	ne++;
+    }
+    memset(ns->normal, 1, agnnodes(g));
+    agclose(g);
+    ns_adjacency(ns);
+    return ns;
+}
+
+static long cost(nsgraph_t * ns)
+{
+    long c = 0;
+    int e;
+
+    for (e = 0; e < ns->nedges; e++)
+	c += (long) ns->weight[e] *
+	    (ns->rank[ns->head[e]] - ns->rank[ns->tail[e]]);
+    return c;
+}
+
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static void bench_solve(const char *name, nsgraph_t * ns)
+{
+    double t0, t1;
+    int rv;
+
+    if (!ns) {
+	fprintf(stderr, "%s: not found\n", name);
+	return;
+    }
+    t0 = now();
+    rv = ns_solve(ns, 1, INT_MAX, 30);
+    t1 = now();
+    printf("%-16s %7d nodes %7d edges: %.3fs (rv %d, cost %ld)\n",
+	   name, ns->nnodes, ns->nedges, t1 - t0, rv, cost(ns));
+    ns_close(ns);
+}
+
+int main(void)
+{
+    static const char *files[] = {
+	"awilliams.gv", "jsort.gv", "proc3d.gv", "crazy.gv", "sdh.gv",
+	"ldbxtried.gv", NULL
+    };
+    char name[32];
+    int i, n;
+
+    for (n = 1000; n <= 4000; n *= 2) {
+	snprintf(name, sizeof(name), "dag%d", n);
+	bench_solve(name, gendag(n, 2, 1));
+    }
+    for (i = 0; files[i]; i++)
+	bench_solve(files[i], readdag(files[i]));
+    return 0;
+}
@@ -0,0 +1,81 @@
+from subprocess import Popen, PIPE
+import os.path, re, shlex
+
+# Laying out a graph with incremental=true from dot's own -Tdot output,
+# unchanged, should keep every rank and the order of nodes within it.
+
+graphs = [
+    'abstract',
+    'alf',
+    'clust4',
+    'clust5',
+    'fig6',
+    'fsm',
+    'mike',
+    'pgram',
+    'pmpipe',
+    'switch',
+    'train11',
+    'unix',
+    'world'
+]
+
+graphs_dir = os.path.abspath('../../../graphs/directed')
+
+def run_dot(args, input_graph):
+    process = Popen(['dot'] + args, stdin=PIPE, stdout=PIPE)
+    output = process.communicate(input = input_graph)[0]
+    if process.wait() != 0:
+        print('An error occurred while running dot ' + ' '.join(args))
+        exit(1)
+    return output
+
+# Return the rank of each node, and its place within the rank, from
+# -Tplain output. Ranks run along y, or along x if rankdir is LR or RL.
+def ranks_and_orders(plain, rankdir):
+    pos = {}
+    for line in plain.decode('latin1').splitlines():
+        fields = shlex.split(line)
+        if fields and fields[0] == 'node':
+            x, y = float(fields[2]), float(fields[3])
+            pos[fields[1]] = (y, x) if rankdir in ('LR', 'RL') else (x, y)
+    levels = sorted(set(round(y, 2) for x, y in pos.values()))
+    layout = {}
+    for r, level in enumerate(levels):
+        nodes = sorted((x, n) for n, (x, y) in pos.items()
+                       if round(y, 2) == level)
+        for i, (x, n) in enumerate(nodes):
+            layout[n] = (r, i)
+    return layout
+
+failures = 0
+for graph in graphs:
+    with open(os.path.join(graphs_dir, graph + '.gv'), 'rb') as f:
+        source = f.read()
+    m = re.search(r'rankdir\s*=\s*"?(\w+)', source.decode('latin1'))
+    rankdir = m.group(1).upper() if m else 'TB'
+
+    if not os.path.exists('output'):
+        os.makedirs('output')
+    previous_file = 'output/' + graph + '.gv'
+    before = ranks_and_orders(
+        run_dot(['-Tdot', '-o', previous_file, '-Tplain'], source), rankdir)
+    with open(previous_file, 'rb') as f:
+        previous = f.read()
+    after = ranks_and_orders(
+        run_dot(['-Gincremental=true', '-Tplain'], previous), rankdir)
+
+    moved = sorted(n for n in before if before[n] != after.get(n))
+    if moved:
+        print('Failure: ' + graph + ' - moved ' + ', '.join(moved))
+        failures += 1
+    else:
+        print('Success: ' + graph)
+
+print('')
+print('Results for "incremental" regression test:')
+print('    Number of tests: ' + str(len(graphs)))
+print('    Number of failures: ' + str(failures))
+
+if not failures == 0:
+    exit(1)
@@ -2,3 +2,7 @@
 
 cd shapes
 python shapes.py
+
+cd ..
+cd incremental
+python incremental.py
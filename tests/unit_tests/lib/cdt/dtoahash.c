@@ -0,0 +1,202 @@
+#include <criterion/criterion.h>
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cdt.h"
+
+/* an object keyed by an int, with its own link */
+typedef struct {
+    Dtlink_t link;
+    int key;
+} ient_t;
+
+static Dtdisc_t IntDisc = {
+    offsetof(ient_t, key),
+    sizeof(int),
+    offsetof(ient_t, link),
+    NULL, NULL, NULL, NULL, NULL, NULL
+};
+
+static void freestr(Dt_t * d, void *obj, Dtdisc_t * disc)
+{
+    free(obj);
+}
+
+/* strings owned by the dictionary */
+static Dtdisc_t OwnStrDisc = {
+    0, 0, -1,
+    NULL, freestr, NULL, NULL, NULL, NULL
+};
+
+/* a small deterministic generator, so failures can be reproduced */
+static unsigned int Seed;
+static unsigned int rnd(void)
+{
+    Seed = Seed * 1103515245 + 12345;
+    return (Seed >> 8) & 0xffffff;
+}
+
+/* check that walking d visits each of the cnt members of in[] once */
+static void check_walk(Dt_t * d, const char *in, int n, int cnt)
+{
+    char *seen = calloc(n, 1);
+    ient_t *e;
+    int k = 0;
+
+    for (e = dtfirst(d); e; e = dtnext(d, e)) {
+	cr_assert(e->key >= 0 && e->key < n);
+	cr_assert(in[e->key] && !seen[e->key]);
+	seen[e->key] = 1;
+	k++;
+    }
+    cr_assert_eq(k, cnt);
+    cr_assert_eq(dtsize(d), cnt);
+    free(seen);
+}
+
+/* random inserts, deletes and searches agree with an array of flags */
+Test(dtoahash, random_ops)
+{
+    enum { N = 5000, OPS = 200000 };
+    ient_t *ents = calloc(N, sizeof(ient_t));
+    char *in = calloc(N, 1);
+    Dt_t *d = dtopen(&IntDisc, Dtoahash);
+    int i, k, cnt = 0;
+
+    for (i = 0; i < N; i++)
+	ents[i].key = i;
+    Seed = 1;
+    for (i = 0; i < OPS; i++) {
+	k = rnd() % N;
+	switch (rnd() % 3) {
+	case 0:
+	    cr_assert_eq(dtinsert(d, &ents[k]), &ents[k]);
+	    cnt += !in[k];
+	    in[k] = 1;
+	    break;
+	case 1:
+	    cr_assert_eq(dtdelete(d, &ents[k]), in[k] ? &ents[k] : NULL);
+	    cnt -= in[k];
+	    in[k] = 0;
+	    break;
+	default:
+	    cr_assert_eq(dtmatch(d, &k), in[k] ? &ents[k] : NULL);
+	    break;
+	}
+    }
+    check_walk(d, in, N, cnt);
+
+    /* deleting while walking, as cgraph does */
+    {
+	ient_t *e, *next;
+	for (e = dtfirst(d); e; e = next) {
+	    next = dtnext(d, e);
+	    if (e->key % 2) {
+		dtdelete(d, e);
+		in[e->key] = 0;
+		cnt--;
+	    }
+	}
+    }
+    check_walk(d, in, N, cnt);
+
+    dtclose(d);
+    free(in);
+    free(ents);
+}
+
+/* contents survive method changes, extraction, flattening and renewal */
+Test(dtoahash, conversions)
+{
+    enum { N = 3000 };
+    ient_t *ents = calloc(N, sizeof(ient_t));
+    char *in = calloc(N, 1);
+    Dt_t *d = dtopen(&IntDisc, Dtoset);
+    Dtlink_t *list, *l;
+    ient_t *e;
+    int i, k;
+
+    for (i = 0; i < N; i++) {
+	ents[i].key = i * 7 % N;
+	dtinsert(d, &ents[i]);
+	in[i] = 1;
+    }
+    dtmethod(d, Dtoahash);
+    check_walk(d, in, N, N);
+    dtmethod(d, Dtset);
+    check_walk(d, in, N, N);
+    dtmethod(d, Dtoahash);
+    check_walk(d, in, N, N);
+
+    k = 0;
+    for (l = dtflatten(d); l; l = dtlink(d, l))
+	k++;
+    cr_assert_eq(k, N);
+    check_walk(d, in, N, N);
+
+    list = dtextract(d);
+    cr_assert_eq(dtsize(d), 0);
+    cr_assert_null(dtfirst(d));
+    dtrestore(d, list);
+    check_walk(d, in, N, N);
+
+    /* change a key in place */
+    k = 5;
+    e = dtmatch(d, &k);
+    cr_assert_not_null(e);
+    e->key = N;
+    cr_assert_eq(dtrenew(d, e), e);
+    k = 5;
+    cr_assert_null(dtmatch(d, &k));
+    k = N;
+    cr_assert_eq(dtmatch(d, &k), e);
+    cr_assert_eq(dtdelete(d, e), e);
+    in[5] = 0;
+    check_walk(d, in, N, N - 1);
+
+    dtmethod(d, Dtoset);
+    check_walk(d, in, N, N - 1);
+    dtclose(d);
+    free(in);
+    free(ents);
+}
+
+/* held strings are found by content, and freed when cleared */
+Test(dtoahash, strings)
+{
+    Dt_t *d = dtopen(&OwnStrDisc, Dtoahash);
+    char buf[64];
+    int i;
+
+    for (i = 0; i < 10000; i++) {
+	sprintf(buf, "key number %d", i);
+	dtinsert(d, strdup(buf));
+    }
+    for (i = 0; i < 10000; i++) {
+	sprintf(buf, "key number %d", i);
+	cr_assert_not_null(dtmatch(d, buf));
+	sprintf(buf, "key number %d ", i);
+	cr_assert_null(dtmatch(d, buf));
+    }
+    dtclear(d);
+    cr_assert_eq(dtsize(d), 0);
+    dtclose(d);
+}
+
+/* dtwordhash depends on the bytes of a string, and its length */
+Test(dtwordhash, values)
+{
+    char a[] = "a string long enough to take several words";
+    char b[sizeof(a) + 8];
+
+    memcpy(b + 3, a, sizeof(a));
+    cr_assert_eq(dtwordhash(0, a, 0), dtwordhash(0, b + 3, 0));
+    cr_assert_eq(dtwordhash(0, a, 0), dtwordhash(0, a, (int)strlen(a)));
+    cr_assert(dtwordhash(0, a, 0) != dtwordhash(0, a, (int)strlen(a) - 1));
+    cr_assert(dtwordhash(0, a, 8) != dtwordhash(0, a, 9));
+    cr_assert(dtwordhash(0, "", 0) != dtwordhash(0, "a", 0));
+    cr_assert(dtwordhash(1, a, 0) != dtwordhash(0, a, 0));
+}
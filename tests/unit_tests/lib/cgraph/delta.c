@@ -0,0 +1,208 @@
+#include <criterion/criterion.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cgraph.h"
+
+/* a graph a -> b twice, b -> c with key k, c -> d */
+static Agraph_t *mkgraph(void)
+{
+    Agraph_t *g = agopen("g", Agdirected, NULL);
+    Agnode_t *a = agnode(g, "a", 1), *b = agnode(g, "b", 1);
+    Agnode_t *c = agnode(g, "c", 1), *d = agnode(g, "d", 1);
+
+    agattr(g, AGNODE, "color", "");
+    agattr(g, AGEDGE, "color", "");
+    agedge(g, a, b, NULL, 1);
+    agedge(g, a, b, NULL, 1);
+    agedge(g, b, c, "k", 1);
+    agedge(g, c, d, NULL, 1);
+    return g;
+}
+
+/* the name of n, or % if it has none of its own */
+static char *name(Agnode_t * n)
+{
+    char *s = agnameof(n);
+
+    return (s[0] == '%') ? "%" : s;
+}
+
+/* dump the nodes and edges of g, with their colors, in order */
+static void dump(Agraph_t * g, char *buf, size_t size)
+{
+    Agnode_t *n;
+    Agedge_t *e;
+    size_t len = 0;
+    char *key;
+
+    buf[0] = '\0';
+    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	len += snprintf(buf + len, size - len, "%s[%s]\n", name(n),
+			agget(n, "color"));
+	for (e = agfstout(g, n); e; e = agnxtout(g, e)) {
+	    key = agnameof(e);
+	    len += snprintf(buf + len, size - len, "  -> %s key=%s [%s]\n",
+			    name(aghead(e)),
+			    (key && key[0] != '%') ? key : "",
+			    agget(e, "color"));
+	}
+    }
+    cr_assert_lt(len, size);
+}
+
+/* write the changes to src since its checkpoint as a delta, apply it to
+ * dst, and check that the two are the same
+ */
+static void sync(Agraph_t * src, Agchangelog_t * log, Agraph_t * dst,
+		 int binary)
+{
+    static char want[4096], got[4096];
+    FILE *fp = tmpfile();
+    char *delta;
+    long len;
+
+    cr_assert_not_null(fp);
+    cr_assert_eq(agwritedelta(log, fp, binary), 0);
+    len = ftell(fp);
+    rewind(fp);
+    delta = malloc(len + 1);
+    cr_assert_eq(fread(delta, 1, len, fp), (size_t) len);
+    fclose(fp);
+    cr_assert_geq(agapplydelta(dst, delta, len), 0);
+    free(delta);
+    agcheckpoint(log);
+
+    dump(src, want, sizeof(want));
+    dump(dst, got, sizeof(got));
+    cr_assert_str_eq(got, want);
+    cr_assert_eq(agnedges(dst), agnedges(src));
+}
+
+static void roundtrip(int binary)
+{
+    Agraph_t *src = mkgraph(), *dst = mkgraph();
+    Agchangelog_t *log = agopenchanges(src);
+    Agnode_t *a = agnode(src, "a", 0), *b = agnode(src, "b", 0);
+    Agnode_t *c = agnode(src, "c", 0), *d = agnode(src, "d", 0);
+    Agnode_t *x;
+    Agedge_t *e, *f;
+
+    /* modify a node and an anonymous edge */
+    agset(a, "color", "red");
+    agset(agedge(src, a, b, NULL, 0), "color", "red");
+    sync(src, log, dst, binary);
+
+    /* modify the second of two parallel anonymous edges */
+    e = agnxtout(src, agfstout(src, a));
+    cr_assert_eq(aghead(e), b);
+    agset(e, "color", "blue");
+    sync(src, log, dst, binary);
+
+    /* modify a keyed edge, and add one with the same key elsewhere */
+    agset(agedge(src, b, c, "k", 0), "color", "green");
+    agset(agedge(src, c, d, "k", 1), "color", "green");
+    sync(src, log, dst, binary);
+
+    /* add a node and anonymous edges, one of them set and then left */
+    x = agnode(src, "x", 1);
+    agset(x, "color", "gray");
+    agset(agedge(src, d, x, NULL, 1), "color", "gray");
+    f = agedge(src, x, a, NULL, 1);
+    agset(f, "color", "gray");
+    agset(f, "color", "");
+    sync(src, log, dst, binary);
+
+    /* delete the first parallel edge, and the new edge x -> a */
+    agdeledge(src, agfstout(src, a));
+    agdeledge(src, agfstout(src, x));
+    sync(src, log, dst, binary);
+
+    /* delete a keyed edge, and an edge made and deleted in between */
+    agdeledge(src, agedge(src, b, c, "k", 0));
+    agdeledge(src, agedge(src, c, a, NULL, 1));
+    sync(src, log, dst, binary);
+
+    /* delete a node with its edges */
+    agdelnode(src, c);
+    sync(src, log, dst, binary);
+    cr_assert_null(agnode(dst, "c", 0));
+
+    agclose(src);
+    agclose(dst);
+}
+
+Test(delta, text)
+{
+    roundtrip(0);
+}
+
+Test(delta, binary)
+{
+    roundtrip(1);
+}
+
+/* anonymous nodes are deleted by position, as their names come from IDs
+ * that another copy need not share
+ */
+static void anonymous(int binary)
+{
+    Agraph_t *src = mkgraph(), *dst = mkgraph();
+    Agchangelog_t *log;
+    Agnode_t *u;
+    char buf[64];
+
+    /* src uses up an ID that dst does not */
+    agdelnode(src, agnode(src, NULL, 1));
+    agset(agnode(src, NULL, 1), "color", "red");
+    agset(agnode(src, NULL, 1), "color", "blue");
+    agset(agnode(dst, NULL, 1), "color", "red");
+    agset(agnode(dst, NULL, 1), "color", "blue");
+    snprintf(buf, sizeof(buf), "%s",
+	     agnameof(agnxtnode(src, agnode(src, "d", 0))));
+    cr_assert_str_neq(buf, agnameof(agnxtnode(dst, agnode(dst, "d", 0))));
+    log = agopenchanges(src);
+
+    /* delete the second anonymous node, then the first */
+    u = agnxtnode(src, agnxtnode(src, agnode(src, "d", 0)));
+    cr_assert_str_eq(agget(u, "color"), "blue");
+    agdelnode(src, u);
+    sync(src, log, dst, binary);
+    cr_assert_eq(agnnodes(dst), 5);
+
+    agdelnode(src, agnxtnode(src, agnode(src, "d", 0)));
+    sync(src, log, dst, binary);
+    cr_assert_eq(agnnodes(dst), 4);
+
+    agclose(src);
+    agclose(dst);
+}
+
+Test(delta, anonymous_text)
+{
+    anonymous(0);
+}
+
+Test(delta, anonymous_binary)
+{
+    anonymous(1);
+}
+
+Test(delta, modify_does_not_create)
+{
+    Agraph_t *g = mkgraph();
+    static char delta[] = "edge a b [color=red];\n"
+	"edge a b 1 [color=blue];\n" "new edge a b [color=green];\n";
+    static char missing[] = "edge a b 3 [color=red];\n";
+
+    cr_assert_eq(agapplydelta(g, delta, strlen(delta)), 3);
+    cr_assert_eq(agnedges(g), 5);
+    cr_assert_str_eq(agget(agfstout(g, agnode(g, "a", 0)), "color"), "red");
+
+    /* there is no fourth edge from a to b to modify */
+    cr_assert_eq(agapplydelta(g, missing, strlen(missing)), -1);
+    cr_assert_eq(agnedges(g), 5);
+    agclose(g);
+}
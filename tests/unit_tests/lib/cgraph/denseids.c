@@ -0,0 +1,37 @@
+#include <criterion/criterion.h>
+
+#include "cgraph.h"
+
+static Agraph_t *opendense(void)
+{
+    static Agdisc_t disc;
+
+    disc = AgDefaultDisc;
+    disc.id = &AgDenseIdDisc;
+    return agopen("g", Agdirected, &disc);
+}
+
+Test(denseids, shared_edge_keys)
+{
+    Agraph_t *g = opendense();
+    Agnode_t *a = agnode(g, "a", 1), *b = agnode(g, "b", 1);
+    Agnode_t *c = agnode(g, "c", 1), *d = agnode(g, "d", 1);
+    Agedge_t *ab, *cd, *e;
+
+    ab = agedge(g, a, b, "x", 1);
+    cd = agedge(g, c, d, "x", 1);
+    cr_assert_neq(agedgeindex(ab), agedgeindex(cd));
+    cr_assert_eq(agedge(g, a, b, "x", 1), ab);
+    cr_assert_eq(agedge(g, c, d, "x", 0), cd);
+    cr_assert_null(agedge(g, b, a, "x", 0));
+    cr_assert_str_eq(agnameof(cd), "x");
+
+    /* the freed index must not be one ab still holds */
+    agdeledge(g, cd);
+    e = agedge(g, c, d, NULL, 1);
+    cr_assert_neq(agedgeindex(e), agedgeindex(ab));
+    cr_assert_null(agnameof(e));
+    cr_assert_str_eq(agnameof(ab), "x");
+    cr_assert_eq(agindexbound(g, AGEDGE), 2);
+    agclose(g);
+}
@@ -0,0 +1,201 @@
+#include <criterion/criterion.h>
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cgraph.h"
+
+#define NTHREADS	16
+#define NGRAPHS		8	/* distinct graphs per thread */
+#define NROUNDS		25
+
+/* the source of graph j of thread t */
+static char *source(int t, int j)
+{
+    static const char fmt[] =
+	"digraph G%d_%d {\n"
+	"  graph [rankdir=LR, label=\"thread %d\"];\n"
+	"  node [shape=box];\n"
+	"  a%d -> b%d [weight=%d, label=\"a \\\"quoted\\\" label\"];\n"
+	"  b%d -> c -> d [color=red];\n"
+	"  c [label=<<b>html %d</b>>];\n"
+	"  subgraph cluster_%d { e -> f; f -> a%d; }\n"
+	"  \"node with spaces\" -> sink;\n"
+	"}\n";
+    char *s = malloc(sizeof(fmt) + 16 * 12);
+
+    sprintf(s, fmt, t, j, t, j, j, t + j, j, t * j, t, j);
+    return s;
+}
+
+/* write g out as a string, and close it */
+static char *tostring(Agraph_t * g)
+{
+    FILE *fp;
+    char *s;
+    long len;
+
+    fp = tmpfile();
+    agwrite(g, fp);
+    agclose(g);
+    len = ftell(fp);
+    rewind(fp);
+    s = malloc(len + 1);
+    s[fread(s, 1, len, fp)] = '\0';
+    fclose(fp);
+    return s;
+}
+
+/* parse src and write it back out as a string */
+static char *roundtrip(const char *src)
+{
+    Agraph_t *g;
+
+    if (!(g = agmemread(src)))
+	return NULL;
+    return tostring(g);
+}
+
+typedef struct {
+    int t;
+    char *src[NGRAPHS];
+    char *expect[NGRAPHS];
+    int failures;
+    int errors;
+} job_t;
+
+static void *worker(void *arg)
+{
+    job_t *job = arg;
+    char *s, *msg;
+    int i, j;
+
+    for (i = 0; i < NROUNDS; i++) {
+	for (j = 0; j < NGRAPHS; j++) {
+	    s = roundtrip(job->src[j]);
+	    if (!s || strcmp(s, job->expect[j]))
+		job->failures++;
+	    free(s);
+	}
+	/* a syntax error is recorded for this thread only */
+	if (agmemread("digraph { a -> }"))
+	    job->failures++;
+	if (!(msg = aglasterr()) || !strstr(msg, "syntax error"))
+	    job->failures++;
+	free(msg);
+	job->errors += agerrors();
+	agreseterrors();
+    }
+    return NULL;
+}
+
+/* write the graphs of job to a file, one after another */
+static FILE *concat(job_t * job)
+{
+    FILE *fp = tmpfile();
+    int j;
+
+    for (j = 0; j < NGRAPHS; j++)
+	fputs(job->src[j], fp);
+    rewind(fp);
+    return fp;
+}
+
+/* check the next graph g read from the concatenation of job's graphs */
+static void check(job_t * job, int j, Agraph_t * g)
+{
+    char *s = tostring(g);
+
+    if (j >= NGRAPHS || strcmp(s, job->expect[j]))
+	job->failures++;
+    free(s);
+}
+
+/* Read the graphs back from a stream, through the thread's own stream
+ * context, and from a mapped file. Each graph ends by pushing back an
+ * end token, and the scanner is kept from one agread to the next.
+ */
+static void *stream_worker(void *arg)
+{
+    job_t *job = arg;
+    Agmmap_t *m;
+    Agraph_t *g;
+    FILE *fp;
+    int i, j;
+
+    for (i = 0; i < NROUNDS; i++) {
+	fp = concat(job);
+	for (j = 0; (g = agread(fp, NIL(Agdisc_t *))); j++)
+	    check(job, j, g);
+	if (j != NGRAPHS)
+	    job->failures++;
+	fclose(fp);
+
+	fp = concat(job);
+	if (!(m = agmmapopen(fp)))
+	    job->failures++;
+	else {
+	    for (j = 0; (g = agmmapread(m, NIL(Agdisc_t *))); j++)
+		check(job, j, g);
+	    if (j != NGRAPHS)
+		job->failures++;
+	    agmmapclose(m);
+	}
+	fclose(fp);
+	job->errors += agerrors();
+	agreseterrors();
+    }
+    return NULL;
+}
+
+/* run worker on NTHREADS threads, each with graphs of its own */
+static void run(void *(*worker) (void *), int nerrors)
+{
+    pthread_t tid[NTHREADS];
+    job_t job[NTHREADS];
+    int i, j;
+
+    /* expected output, produced on one thread */
+    for (i = 0; i < NTHREADS; i++) {
+	job[i].t = i;
+	job[i].failures = job[i].errors = 0;
+	for (j = 0; j < NGRAPHS; j++) {
+	    job[i].src[j] = source(i, j);
+	    job[i].expect[j] = roundtrip(job[i].src[j]);
+	    cr_assert_not_null(job[i].expect[j]);
+	}
+    }
+    cr_assert_eq(agerrors(), 0);
+
+    for (i = 0; i < NTHREADS; i++)
+	cr_assert_eq(pthread_create(&tid[i], NULL, worker, &job[i]), 0);
+    for (i = 0; i < NTHREADS; i++)
+	pthread_join(tid[i], NULL);
+
+    for (i = 0; i < NTHREADS; i++) {
+	cr_expect_eq(job[i].failures, 0, "thread %d: %d failures", i,
+		     job[i].failures);
+	cr_expect_eq(job[i].errors, nerrors);
+	for (j = 0; j < NGRAPHS; j++) {
+	    free(job[i].src[j]);
+	    free(job[i].expect[j]);
+	}
+    }
+
+    /* none of the threads' errors are seen here */
+    cr_expect_eq(agerrors(), 0);
+}
+
+Test(cgraph, concurrent_read_write)
+{
+    agseterr(AGMAX);		/* keep messages for aglasterr */
+    run(worker, NROUNDS * AGERR);
+    agseterr(AGWARN);
+}
+
+Test(cgraph, concurrent_stream_read)
+{
+    run(stream_worker, 0);
+}
@@ -0,0 +1,141 @@
+#include <criterion/criterion.h>
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+#include "render.h"
+#include "ns.h"
+
+/* a small deterministic generator, so failures can be reproduced */
+static unsigned int rnd(unsigned int *seed)
+{
+    *seed = *seed * 1103515245 + 12345;
+    return (*seed >> 8) & 0xffffff;
+}
+
+/* a connected DAG with n nodes and about (1 + extra) * n edges;
+ * edges go from lower to higher numbered nodes
+ */
+static nsgraph_t *gendag(int n, int extra, unsigned int seed)
+{
+    int ne = (n - 1) + extra * n;
+    nsgraph_t *ns = ns_open(n, ne);
+    int e, a, b;
+
+    for (e = 0; e < n - 1; e++) {
+	ns->tail[e] = rnd(&seed) % (e + 1);
+	ns->head[e] = e + 1;
+    }
+    for (; e < ne; e++) {
+	a = rnd(&seed) % n;
+	b = rnd(&seed) % n;
+	if (a == b)
+	    b = (a + 1) % n;
+	ns->tail[e] = MIN(a, b);
+	ns->head[e] = MAX(a, b);
+    }
+    for (e = 0; e < ne; e++) {
+	ns->minlen[e] = rnd(&seed) % 3;
+	ns->weight[e] = 1 + rnd(&seed) % 5;
+    }
+    for (a = 0; a < n; a++)
+	ns->normal[a] = 1;
+    ns_adjacency(ns);
+    return ns;
+}
+
+static int feasible(nsgraph_t * ns)
+{
+    int e;
+
+    for (e = 0; e < ns->nedges; e++)
+	if (ns->rank[ns->head[e]] - ns->rank[ns->tail[e]] < ns->minlen[e])
+	    return 0;
+    return 1;
+}
+
+static long cost(nsgraph_t * ns)
+{
+    long c = 0;
+    int e;
+
+    for (e = 0; e < ns->nedges; e++)
+	c += (long) ns->weight[e] *
+	    (ns->rank[ns->head[e]] - ns->rank[ns->tail[e]]);
+    return c;
+}
+
+/* solutions are feasible, and no worse than the longest path ranking */
+Test(ns, generated)
+{
+    int i, n, rv;
+    long c0;
+    nsgraph_t *ns;
+
+    for (i = 0; i < 100; i++) {
+	n = 2 + i * 7;
+	ns = gendag(n, i % 4, i + 1);
+	rv = ns_solve(ns, 0, 0, 30);
+	cr_assert_eq(rv, 0);
+	cr_assert(feasible(ns));
+	c0 = cost(ns);
+	rv = ns_solve(ns, i % 3, INT_MAX, i % 5 ? 30 : -1);
+	cr_assert_eq(rv, 0);
+	cr_assert(feasible(ns));
+	cr_assert_leq(cost(ns), c0);
+	ns_close(ns);
+    }
+}
+
+/* a graph in two pieces is reported, not solved */
+Test(ns, disconnected)
+{
+    nsgraph_t *ns = ns_open(4, 2);
+
+    ns->tail[0] = 0;
+    ns->head[0] = 1;
+    ns->tail[1] = 2;
+    ns->head[1] = 3;
+    ns->minlen[0] = ns->minlen[1] = 1;
+    ns->weight[0] = ns->weight[1] = 1;
+    ns_adjacency(ns);
+    cr_assert_eq(ns_solve(ns, 0, INT_MAX, 30), 1);
+    ns_close(ns);
+}
+
+#define NTHREADS 4
+
+static void *solve(void *arg)
+{
+    nsgraph_t *ns = arg;
+    int *rv = malloc(sizeof(int));
+
+    *rv = ns_solve(ns, 1, INT_MAX, 30);
+    return rv;
+}
+
+/* separate problems solved at once give the same ranks as alone */
+Test(ns, concurrent)
+{
+    nsgraph_t *ns[NTHREADS], *ref;
+    pthread_t tid[NTHREADS];
+    void *rv;
+    int i;
+
+    for (i = 0; i < NTHREADS; i++)
+	ns[i] = gendag(3000, 2, 7);
+    for (i = 0; i < NTHREADS; i++)
+	pthread_create(&tid[i], NULL, solve, ns[i]);
+    ref = gendag(3000, 2, 7);
+    cr_assert_eq(ns_solve(ref, 1, INT_MAX, 30), 0);
+    for (i = 0; i < NTHREADS; i++) {
+	pthread_join(tid[i], &rv);
+	cr_assert_eq(*(int *) rv, 0);
+	free(rv);
+	cr_assert_arr_eq(ns[i]->rank, ref->rank, ref->nnodes * sizeof(int));
+	ns_close(ns[i]);
+    }
+    ns_close(ref);
+}